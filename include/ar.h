@@ -45,3 +45,28 @@ struct	ar_hdr
 	char	fmag[2];
 };
 #define	SAR_HDR	(SARNAME+44)
+
+/*
+ * Go archives begin with a __.SYMDEF member holding an index of the
+ * archive.  It starts with ARINDEX, followed by 4-byte little-endian
+ * words: the header fields below, then a table of members, a hash
+ * table of symbols, the symbols themselves and their names.
+ * Symbols are grouped by member, in archive order, and each hash
+ * bucket holds the number, plus one, of the first symbol in its
+ * chain.  The member is padded with zeros, leaving room for
+ * pack to add to the index without moving the rest of the archive.
+ * An index whose archive size does not match the file is stale.
+ */
+#define	ARINDEX	"goindex1"
+#define	SARINDEX	8
+
+#define	AIused		(SARINDEX+0*4)	/* bytes of the member in use */
+#define	AIarsize	(SARINDEX+1*4)	/* size of the archive indexed */
+#define	AInmember	(SARINDEX+2*4)
+#define	AInsym		(SARINDEX+3*4)
+#define	AInhash		(SARINDEX+4*4)	/* a power of two */
+#define	AIhdr		(SARINDEX+5*4)	/* offset of object header line in names, or ~0 */
+#define	SAIHDR		(SARINDEX+6*4)
+
+#define	SAIMEMBER	(2*4)		/* archive offset of header, first symbol */
+#define	SAISYM		(4*4)		/* name offset, member, next in chain, type */
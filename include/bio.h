@@ -40,6 +40,7 @@ typedef	struct	Biobuf	Biobuf;
 enum
 {
 	Bsize		= 8*1024,
+	Bmapmax		= 1<<30,	/* largest file Binitmap maps */
 	Bungetsize	= 4,		/* space for ungetc */
 	Bmagic		= 0x314159,
 	Beof		= -1,
@@ -67,6 +68,7 @@ struct	Biobuf
 	unsigned char*	bbuf;		/* pointer to beginning of buffer */
 	unsigned char*	ebuf;		/* pointer to end of buffer */
 	unsigned char*	gbuf;		/* pointer to good data in buf */
+	unsigned char*	map;		/* whole file, if mapped by Binitmap */
 	unsigned char	b[Bungetsize+Bsize];
 };
 
@@ -84,19 +86,25 @@ struct	Biobuf
 	(bp)->rdline
 #define	BFILDES(bp)\
 	(bp)->fid
+#define	BMAPPED(bp)\
+	((bp)->map != 0)
 
 int	Bbuffered(Biobuf*);
 Biobuf*	Bfdopen(int, int);
+Biobuf*	Bfdopenmap(int, int);
 int	Bfildes(Biobuf*);
 int	Bflush(Biobuf*);
 int	Bgetc(Biobuf*);
 int	Bgetd(Biobuf*, double*);
 long	Bgetrune(Biobuf*);
+void*	Bgetspan(Biobuf*, long);
 int	Binit(Biobuf*, int, int);
+int	Binitmap(Biobuf*, int, int);
 int	Binits(Biobuf*, int, int, unsigned char*, int);
 int	Blinelen(Biobuf*);
 vlong	Boffset(Biobuf*);
 Biobuf*	Bopen(char*, int);
+Biobuf*	Bopenmap(char*, int);
 int	Bprint(Biobuf*, char*, ...);
 int	Bputc(Biobuf*, int);
 int	Bputrune(Biobuf*, long);
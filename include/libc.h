@@ -60,8 +60,10 @@ extern	char*	strecpy(char*, char*, char*);
 extern  int tokenize(char*, char**, int);
 
 extern  double  p9cputime(void);
+extern  vlong   p9nsec(void);
 #ifndef NOPLAN9DEFINES
 #define cputime     p9cputime
+#define nsec        p9nsec
 #endif
 /*
  * one-of-a-kind
@@ -294,6 +296,16 @@ extern	char*	getgoarch(void);
 extern	char*	getgoroot(void);
 extern	char*	getgoversion(void);
 
+/*
+ * output written through a memory map, and work spread
+ * over threads.  Where these are not available, mapwrite
+ * returns nil and parfor runs on the calling thread.
+ */
+extern	void*	mapwrite(int, vlong, vlong);
+extern	void	unmapwrite(void*, vlong, vlong);
+extern	int	nworker(void);
+extern	void	parfor(int, void(*)(void*, int), void*);
+
 #ifdef _WIN32
 
 #ifndef _WIN64
@@ -0,0 +1,13 @@
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#include "/sys/include/bio.h"
+
+// Additions to libbio, provided on Plan 9 by ../../src/lib9/plan9.c.
+#define	BMAPPED(bp)	0
+
+Biobuf*	Bfdopenmap(int, int);
+void*	Bgetspan(Biobuf*, long);
+int	Binitmap(Biobuf*, int, int);
+Biobuf*	Bopenmap(char*, int);
@@ -14,3 +14,9 @@ char*	getgoos(void);
 char*	getgoarch(void);
 char*	getgoroot(void);
 char*	getgoversion(void);
+
+// Additions to lib9, provided on Plan 9 by ../../src/lib9/plan9.c.
+void*	mapwrite(int, vlong, vlong);
+void	unmapwrite(void*, vlong, vlong);
+int	nworker(void);
+void	parfor(int, void(*)(void*, int), void*);
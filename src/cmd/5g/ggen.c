@@ -659,3 +659,17 @@ clearfat(Node *nl)
 	regfree(&dst);
 	regfree(&nz);
 }
+
+void
+gjmptab(Node *idx)
+{
+	USED(idx);
+	fatal("gjmptab");
+}
+
+Prog*
+gjmpcase(void)
+{
+	fatal("gjmpcase");
+	return P;
+}
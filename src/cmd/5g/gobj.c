@@ -167,6 +167,14 @@ zaddr(Biobuf *b, Addr *a, int s)
 	}
 }
 
+/*
+ * dumpfuncs writes all the functions at once.
+ */
+void
+emitfuncs(void)
+{
+}
+
 void
 dumpfuncs(void)
 {
@@ -91,27 +91,27 @@ struct	Rgn
 
 EXTERN	int32	exregoffset;		// not set
 EXTERN	int32	exfregoffset;		// not set
-EXTERN	Reg*	firstr;
-EXTERN	Reg*	lastr;
+EXTERN	THREAD	Reg*	firstr;
+EXTERN	THREAD	Reg*	lastr;
 EXTERN	Reg	zreg;
-EXTERN	Reg*	freer;
-EXTERN	Reg**	rpo2r;
-EXTERN	Rgn	region[NRGN];
-EXTERN	Rgn*	rgp;
-EXTERN	int	nregion;
-EXTERN	int	nvar;
-EXTERN	int32	regbits;
-EXTERN	int32	exregbits;
-EXTERN	Bits	externs;
-EXTERN	Bits	params;
-EXTERN	Bits	consts;
-EXTERN	Bits	addrs;
-EXTERN	Bits	ovar;
-EXTERN	int	change;
-EXTERN	int32	maxnr;
-EXTERN	int32*	idom;
-
-EXTERN	struct
+EXTERN	THREAD	Reg*	freer;
+EXTERN	THREAD	Reg**	rpo2r;
+EXTERN	THREAD	Rgn	region[NRGN];
+EXTERN	THREAD	Rgn*	rgp;
+EXTERN	THREAD	int	nregion;
+EXTERN	THREAD	int	nvar;
+EXTERN	THREAD	int32	regbits;
+EXTERN	THREAD	int32	exregbits;
+EXTERN	THREAD	Bits	externs;
+EXTERN	THREAD	Bits	params;
+EXTERN	THREAD	Bits	consts;
+EXTERN	THREAD	Bits	addrs;
+EXTERN	THREAD	Bits	ovar;
+EXTERN	THREAD	int	change;
+EXTERN	THREAD	int32	maxnr;
+EXTERN	THREAD	int32*	idom;
+
+EXTERN	THREAD	struct
 {
 	int32	ncvtreg;
 	int32	nspill;
@@ -126,7 +126,8 @@ EXTERN	struct
  */
 Reg*	rega(void);
 int	rcmp(const void*, const void*);
-void	regopt(Prog*);
+void	regopt(Prog*, Addr*, int);
+void	regoptinit(void);
 void	addmove(Reg*, int, int, int);
 Bits	mkvar(Reg *r, Adr *a);
 void	prop(Reg*, Bits, Bits);
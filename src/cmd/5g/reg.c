@@ -76,24 +76,17 @@ rcmp(const void *a1, const void *a2)
 }
 
 static void
-setoutvar(void)
+setoutvar(Addr *out, int nout)
 {
-	Type *t;
-	Node *n;
 	Addr a;
-	Iter save;
 	Bits bit;
-	int z;
+	int i, z;
 
-	t = structfirst(&save, getoutarg(curfn->type));
-	while(t != T) {
-		n = nodarg(t, 1);
-		a = zprog.from;
-		naddr(n, &a, 0);
+	for(i=0; i<nout; i++) {
+		a = out[i];
 		bit = mkvar(R, &a);
 		for(z=0; z<BITS; z++)
 			ovar.b[z] |= bit.b[z];
-		t = structnext(&save);
 	}
 //if(bany(ovar))
 //print("ovar = %Q\n", ovar);
@@ -170,8 +163,10 @@ static char* regname[] = {
 	".F15",
 };
 
+static Node*	regnode[NREGVAR];
+
 void
-regopt(Prog *firstp)
+regopt(Prog *firstp, Addr *out, int nout)
 {
 	Reg *r, *r1;
 	Prog *p;
@@ -179,15 +174,10 @@ regopt(Prog *firstp)
 	uint32 vreg;
 	Bits bit;
 	
-	if(first == 0) {
-		fmtinstall('Q', Qconv);
-	}
-	
 	fixjmp(firstp);
 
-	first++;
 	if(debug['K']) {
-		if(first != 13)
+		if(++first != 13)
 			return;
 //		debug['R'] = 2;
 //		debug['P'] = 2;
@@ -217,7 +207,7 @@ regopt(Prog *firstp)
 	nvar = NREGVAR;
 	memset(var, 0, NREGVAR*sizeof var[0]);
 	for(i=0; i<NREGVAR; i++)
-		var[i].node = newname(lookup(regname[i]));
+		var[i].node = regnode[i];
 
 	regbits = RtoB(REGSP)|RtoB(REGLINK)|RtoB(REGPC);
 	for(z=0; z<BITS; z++) {
@@ -229,7 +219,7 @@ regopt(Prog *firstp)
 	}
 
 	// build list of return variables
-	setoutvar();
+	setoutvar(out, nout);
 
 	/*
 	 * pass 1
@@ -1542,19 +1532,35 @@ BtoF(int32 b)
 
 static Sym*	symlist[10];
 
+/*
+ * Set up what regopt and noreturn share between functions.
+ * Called before any regopt, so that they only read it.
+ */
+void
+regoptinit(void)
+{
+	int i;
+
+	if(symlist[0] != S)
+		return;
+	fmtinstall('Q', Qconv);
+	for(i=0; i<NREGVAR; i++)
+		regnode[i] = newname(lookup(regname[i]));
+	symlist[0] = pkglookup("panicindex", runtimepkg);
+	symlist[1] = pkglookup("panicslice", runtimepkg);
+	symlist[2] = pkglookup("throwinit", runtimepkg);
+	symlist[3] = pkglookup("panic", runtimepkg);
+	symlist[4] = pkglookup("panicwrap", runtimepkg);
+}
+
 int
 noreturn(Prog *p)
 {
 	Sym *s;
 	int i;
 
-	if(symlist[0] == S) {
-		symlist[0] = pkglookup("panicindex", runtimepkg);
-		symlist[1] = pkglookup("panicslice", runtimepkg);
-		symlist[2] = pkglookup("throwinit", runtimepkg);
-		symlist[3] = pkglookup("panic", runtimepkg);
-		symlist[4] = pkglookup("panicwrap", runtimepkg);
-	}
+	if(symlist[0] == S)
+		regoptinit();
 
 	s = p->to.sym;
 	if(s == S)
@@ -138,6 +138,7 @@ struct	Sym
 	uchar	leaf;
 	uchar	stkcheck;
 	uchar	hide;
+	uchar	reflectmethod;	// calls reflect Method or MethodByName
 	int32	dynid;
 	int32	plt;
 	int32	got;
@@ -147,7 +148,6 @@ struct	Sym
 	int32	align;	// if non-zero, required alignment in bytes
 	uchar	special;
 	uchar	fnptr;	// used as fn ptr
-	Sym*	hash;	// in hash table
 	Sym*	allsym;	// in all symbol list
 	Sym*	next;	// in text or data list
 	Sym*	sub;	// in SSUB list
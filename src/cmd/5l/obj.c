@@ -244,42 +244,63 @@ main(int argc, char *argv[])
 
 	addlibpath("command line", "command line", argv[0], "main");
 	loadlib();
+	endphase("loadlib");
 
 	// mark some functions that are only referenced after linker code editing
 	if(debug['F'])
 		mark(rlookup("_sfloat", 0));
 	deadcode();
+	endphase("deadcode");
 	if(textp == nil) {
 		diag("no code");
 		errorexit();
 	}
 
 	patch();
+	endphase("patch");
 	if(debug['p'])
 		if(debug['1'])
 			doprof1();
 		else
 			doprof2();
 	doelf();
+	endphase("doelf");
 	follow();
+	endphase("follow");
 	softfloat();
+	endphase("softfloat");
 	noops();
+	endphase("noops");
 	dostkcheck();
+	endphase("dostkcheck");
 	span();
+	endphase("span");
 	addexport();
+	endphase("addexport");
 	// textaddress() functionality is handled in span()
 	pclntab();
+	endphase("pclntab");
+	functab();
+	endphase("functab");
 	symtab();
+	endphase("symtab");
 	dodata();
+	endphase("dodata");
 	address();
+	endphase("address");
 	doweak();
+	endphase("doweak");
 	reloc();
+	endphase("reloc");
 	asmb();
+	endphase("asmb");
 	undef();
+	endphase("undef");
 
 	if(debug['c'])
 		print("ARM size = %d\n", armsize);
 	if(debug['v']) {
+		phasestats();
 		Bprint(&bso, "%5.2f cpu time\n", cputime());
 		Bprint(&bso, "%d sizeof adr\n", sizeof(Adr));
 		Bprint(&bso, "%d sizeof prog\n", sizeof(Prog));
@@ -289,27 +310,27 @@ main(int argc, char *argv[])
 }
 
 static void
-zaddr(Biobuf *f, Adr *a, Sym *h[])
+zaddr(Objbuf *f, Adr *a, Sym *h[])
 {
 	int i, c;
 	int32 l;
 	Sym *s;
 	Auto *u;
 
-	a->type = BGETC(f);
-	a->reg = BGETC(f);
-	c = BGETC(f);
+	a->type = OGETC(f);
+	a->reg = OGETC(f);
+	c = OGETC(f);
 	if(c < 0 || c > NSYM){
 		print("sym out of range: %d\n", c);
-		Bputc(f, ALAST+1);
+		f->p = f->ep;
 		return;
 	}
 	a->sym = h[c];
-	a->name = BGETC(f);
+	a->name = OGETC(f);
 
 	if((schar)a->reg < 0 || a->reg > NREG) {
 		print("register out of range %d\n", a->reg);
-		Bputc(f, ALAST+1);
+		f->p = f->ep;
 		return;	/*  force real diagnostic */
 	}
 
@@ -327,7 +348,7 @@ zaddr(Biobuf *f, Adr *a, Sym *h[])
 	switch(a->type) {
 	default:
 		print("unknown type %d\n", a->type);
-		Bputc(f, ALAST+1);
+		f->p = f->ep;
 		return;	/*  force real diagnostic */
 
 	case D_NONE:
@@ -339,27 +360,27 @@ zaddr(Biobuf *f, Adr *a, Sym *h[])
 
 	case D_REGREG:
 	case D_REGREG2:
-		a->offset = BGETC(f);
+		a->offset = OGETC(f);
 		break;
 
 	case D_CONST2:
-		a->offset2 = Bget4(f);	// fall through
+		a->offset2 = Oget4(f);	// fall through
 	case D_BRANCH:
 	case D_OREG:
 	case D_CONST:
 	case D_OCONST:
 	case D_SHIFT:
-		a->offset = Bget4(f);
+		a->offset = Oget4(f);
 		break;
 
 	case D_SCONST:
 		a->sval = mal(NSNAME);
-		Bread(f, a->sval, NSNAME);
+		Oread(f, a->sval, NSNAME);
 		break;
 
 	case D_FCONST:
-		a->ieee.l = Bget4(f);
-		a->ieee.h = Bget4(f);
+		a->ieee.l = Oget4(f);
+		a->ieee.h = Oget4(f);
 		break;
 	}
 	s = a->sym;
@@ -395,7 +416,7 @@ nopout(Prog *p)
 }
 
 void
-ldobj1(Biobuf *f, char *pkg, int64 len, char *pn)
+ldobj1(Objbuf *f, char *pkg, char *pn)
 {
 	int32 ipc;
 	Prog *p;
@@ -404,13 +425,11 @@ ldobj1(Biobuf *f, char *pkg, int64 len, char *pn)
 	uint32 sig;
 	char *name;
 	int ntext;
-	int32 eof;
 	char src[1024], *x;
 	Prog *lastp;
 
 	lastp = nil;
 	ntext = 0;
-	eof = Boffset(f) + len;
 	src[0] = 0;
 
 newloop:
@@ -421,34 +440,29 @@ newloop:
 	skip = 0;
 
 loop:
-	if(f->state == Bracteof || Boffset(f) >= eof)
+	if(f->p >= f->ep)
 		goto eof;
-	o = BGETC(f);
+	o = OGETC(f);
 	if(o == Beof)
 		goto eof;
 
 	if(o <= AXXX || o >= ALAST) {
-		diag("%s:#%lld: opcode out of range: %#ux", pn, Boffset(f), o);
+		diag("%s:#%lld: opcode out of range: %#ux", pn, Ooffset(f), o);
 		print("	probably not a .5 file\n");
 		errorexit();
 	}
 	if(o == ANAME || o == ASIGNAME) {
 		sig = 0;
 		if(o == ASIGNAME)
-			sig = Bget4(f);
-		v = BGETC(f); /* type */
-		o = BGETC(f); /* sym */
+			sig = Oget4(f);
+		v = OGETC(f); /* type */
+		o = OGETC(f); /* sym */
 		r = 0;
 		if(v == D_STATIC)
 			r = version;
-		name = Brdline(f, '\0');
-		if(name == nil) {
-			if(Blinelen(f) > 0) {
-				fprint(2, "%s: name too long\n", pn);
-				errorexit();
-			}
+		name = Ordstr(f);
+		if(name == nil)
 			goto eof;
-		}
 		x = expandpkg(name, pkg);
 		s = lookup(x, r);
 		if(x != name)
@@ -487,9 +501,9 @@ loop:
 
 	p = mal(sizeof(Prog));
 	p->as = o;
-	p->scond = BGETC(f);
-	p->reg = BGETC(f);
-	p->line = Bget4(f);
+	p->scond = OGETC(f);
+	p->reg = OGETC(f);
+	p->line = Oget4(f);
 
 	zaddr(f, &p->from, h);
 	zaddr(f, &p->to, h);
@@ -524,7 +538,7 @@ loop:
 			cursym->autom = curauto;
 		curauto = 0;
 		cursym = nil;
-		if(Boffset(f) == eof)
+		if(f->p == f->ep)
 			return;
 		goto newloop;
 
@@ -616,6 +630,8 @@ loop:
 		autosize += 4;
 		s->type = STEXT;
 		s->text = p;
+		if(p->reg & REFLECTMETHOD)
+			s->reflectmethod = 1;
 		s->value = pc;
 		lastp = p;
 		p->pc = pc;
@@ -600,7 +600,10 @@ agen(Node *n, Node *res)
 
 		// explicit check for nil if array is large enough
 		// that we might derive too big a pointer.
-		if(isfixedarray(nl->type) && nl->type->width >= unmappedzero) {
+		if(isfixedarray(nl->type) && nl->type->width >= unmappedzero && nl->op == OIND && nl->nonnil) {
+			if(debug['C'])
+				warnl(n->lineno, "nil check eliminated");
+		} else if(isfixedarray(nl->type) && nl->type->width >= unmappedzero) {
 			regalloc(&n4, types[tptr], &n3);
 			gmove(&n3, &n4);
 			n4.op = OINDREG;
@@ -748,7 +751,10 @@ agen(Node *n, Node *res)
 		if(n->xoffset != 0) {
 			// explicit check for nil if struct is large enough
 			// that we might derive too big a pointer.
-			if(nl->type->type->width >= unmappedzero) {
+			if(nl->type->type->width >= unmappedzero && n->nonnil) {
+				if(debug['C'])
+					warnl(n->lineno, "nil check eliminated");
+			} else if(nl->type->type->width >= unmappedzero) {
 				regalloc(&n1, types[tptr], res);
 				gmove(res, &n1);
 				n1.op = OINDREG;
@@ -45,7 +45,7 @@ struct	Prog
 
 EXTERN	int32	dynloc;
 EXTERN	uchar	reg[D_NONE];
-EXTERN	int32	pcloc;		// instruction counter
+EXTERN	THREAD	int32	pcloc;		// instruction counter
 EXTERN	Strlit	emptystring;
 extern	char*	anames[];
 EXTERN	Prog	zprog;
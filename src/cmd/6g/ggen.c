@@ -1068,3 +1068,28 @@ clearfat(Node *nl)
 	restx(&n1, &oldn1);
 	restx(&ax, &oldax);
 }
+
+/*
+ * generate a jump through a table indexed by idx,
+ * which has been checked against the table size.
+ * the entries, made by gjmpcase, follow it.
+ */
+void
+gjmptab(Node *idx)
+{
+	Node r;
+
+	regalloc(&r, types[TUINT64], N);
+	cgen(idx, &r);
+	gins(ACASE, &r, N);
+	regfree(&r);
+}
+
+/*
+ * generate a jump table entry, to be patched like a jump.
+ */
+Prog*
+gjmpcase(void)
+{
+	return gbranch(ABCASE, T, 0);
+}
@@ -217,18 +217,32 @@ zsymaddr(Addr *a, int *new)
 	return zsym(a->sym, t, new);
 }
 
-void
-dumpfuncs(void)
+static int	zsymdone;	// zsym state is live
+static int32	objpc;		// pc of the next Prog written
+static Biobuf*	fnbuf;		// functions written before dumpobj
+static int	fnfd;
+
+/*
+ * write the Progs of the finished plists to b
+ * and free them.  pcs are numbered across all
+ * plists of the object, whatever the batch.
+ */
+static void
+writefuncs(Biobuf *b)
 {
 	Plist *pl;
 	int sf, st, gf, gt, new;
 	Sym *s;
 	Prog *p;
+	Biobuf *ob;
 
-	zsymreset();
+	if(!zsymdone) {
+		zsymreset();
+		zsymdone = 1;
+	}
 
 	// fix up pc
-	pcloc = 0;
+	pcloc = objpc;
 	for(pl=plist; pl!=nil; pl=pl->link) {
 		if(isblank(pl->name))
 			continue;
@@ -238,6 +252,11 @@ dumpfuncs(void)
 				pcloc++;
 		}
 	}
+	objpc = pcloc;
+
+	// zsym writes its names to bout
+	ob = bout;
+	bout = b;
 
 	// put out functions
 	for(pl=plist; pl!=nil; pl=pl->link) {
@@ -269,16 +288,69 @@ dumpfuncs(void)
 				break;
 			}
 
-			Bputc(bout, p->as);
-			Bputc(bout, p->as>>8);
-			Bputc(bout, p->lineno);
-			Bputc(bout, p->lineno>>8);
-			Bputc(bout, p->lineno>>16);
-			Bputc(bout, p->lineno>>24);
-			zaddr(bout, &p->from, sf, gf);
-			zaddr(bout, &p->to, st, gt);
+			Bputc(b, p->as);
+			Bputc(b, p->as>>8);
+			Bputc(b, p->lineno);
+			Bputc(b, p->lineno>>8);
+			Bputc(b, p->lineno>>16);
+			Bputc(b, p->lineno>>24);
+			zaddr(b, &p->from, sf, gf);
+			zaddr(b, &p->to, st, gt);
 		}
 	}
+	bout = ob;
+
+	for(pl=plist; pl!=nil; pl=pl->link)
+		afree(&pl->arena);
+	plist = nil;
+	plast = nil;
+	pc = P;
+}
+
+/*
+ * write out the functions finished so far.
+ * the object file is not open until dumpobj,
+ * so they go to a temporary file that dumpfuncs
+ * copies into place.
+ */
+void
+emitfuncs(void)
+{
+	char *file;
+
+	if(fnbuf == nil) {
+		file = smprint("%s.fn", outfile);
+		fnfd = create(file, ORDWR|ORCLOSE, 0600);
+		if(fnfd < 0) {
+			flusherrors();
+			print("can't create %s: %r\n", file);
+			errorexit();
+		}
+		free(file);
+		fnbuf = mal(sizeof *fnbuf);
+		Binit(fnbuf, fnfd, OWRITE);
+	}
+	writefuncs(fnbuf);
+}
+
+void
+dumpfuncs(void)
+{
+	char buf[8192];
+	int n;
+
+	if(fnbuf != nil) {
+		Bflush(fnbuf);
+		seek(fnfd, 0, 0);
+		while((n = read(fnfd, buf, sizeof buf)) > 0)
+			Bwrite(bout, buf, n);
+		if(n < 0)
+			fatal("reading functions: %r");
+		Bterm(fnbuf);
+		close(fnfd);
+		fnbuf = nil;
+	}
+	writefuncs(bout);
 }
 
 int
@@ -73,7 +73,7 @@ prog(int as)
 		p->link = dpc;
 	} else {
 		p = pc;
-		pc = mal(sizeof(*pc));
+		pc = amal(progarena, sizeof(*pc));
 		clearp(pc);
 		p->link = pc;
 	}
@@ -165,7 +165,8 @@ newplist(void)
 		plast->link = pl;
 	plast = pl;
 
-	pc = mal(sizeof(*pc));
+	progarena = &pl->arena;
+	pc = amal(progarena, sizeof(*pc));
 	clearp(pc);
 	pl->firstpc = pc;
 
@@ -1121,7 +1122,8 @@ naddr(Node *n, Addr *a, int canemitcode)
 		a->type = n->val.u.reg+D_INDIR;
 		a->sym = n->sym;
 		a->offset = n->xoffset;
-		checkoffset(a, canemitcode);
+		if(!n->nonnil)
+			checkoffset(a, canemitcode);
 		break;
 
 	case OPARAM:
@@ -2002,6 +2004,13 @@ odot:
 		n1.xoffset = -(oary[i]+1);
 	}
 
+	// the last pointer in the chain is n->left.
+	if(n->op == ODOTPTR && n->nonnil) {
+		n1.nonnil = 1;
+		if(debug['C'] && n1.xoffset >= unmappedzero)
+			warnl(n->lineno, "nil check eliminated");
+	}
+
 	a->type = D_NONE;
 	a->index = D_NONE;
 	naddr(&n1, a, 1);
@@ -2064,7 +2073,10 @@ oindex:
 			o |= OAddable;
 	}
 
-	if(!(o & ODynam) && l->type->width >= unmappedzero && l->op == OIND) {
+	if(!(o & ODynam) && l->type->width >= unmappedzero && l->op == OIND && l->nonnil) {
+		if(debug['C'])
+			warnl(n->lineno, "nil check eliminated");
+	} else if(!(o & ODynam) && l->type->width >= unmappedzero && l->op == OIND) {
 		// cannot rely on page protections to
 		// catch array ptr == 0, so dereference.
 		n2 = *reg;
@@ -37,19 +37,12 @@
 #define	REGBITS	((uint32)0xffffffff)
 #define	P2R(p)	(Reg*)(p->reg)
 
-static	int	first	= 1;
-
 Reg*
 rega(void)
 {
 	Reg *r;
 
-	r = freer;
-	if(r == R) {
-		r = mal(sizeof(*r));
-	} else
-		freer = r->link;
-
+	r = amal(&regarena, sizeof(*r));
 	*r = zreg;
 	return r;
 }
@@ -70,24 +63,17 @@ rcmp(const void *a1, const void *a2)
 }
 
 static void
-setoutvar(void)
+setoutvar(Addr *out, int nout)
 {
-	Type *t;
-	Node *n;
 	Addr a;
-	Iter save;
 	Bits bit;
-	int z;
+	int i, z;
 
-	t = structfirst(&save, getoutarg(curfn->type));
-	while(t != T) {
-		n = nodarg(t, 1);
-		a = zprog.from;
-		naddr(n, &a, 0);
+	for(i=0; i<nout; i++) {
+		a = out[i];
 		bit = mkvar(R, &a);
 		for(z=0; z<BITS; z++)
 			ovar.b[z] |= bit.b[z];
-		t = structnext(&save);
 	}
 //if(bany(&ovar))
 //print("ovars = %Q\n", ovar);
@@ -151,10 +137,13 @@ static char* regname[] = {
 	".X15",
 };
 
+static Node*	regnode[NREGVAR];
+
 static void fixjmp(Prog*);
+static void fixtab(Prog*);
 
 void
-regopt(Prog *firstp)
+regopt(Prog *firstp, Addr *out, int nout)
 {
 	Reg *r, *r1;
 	Prog *p;
@@ -162,12 +151,6 @@ regopt(Prog *firstp)
 	uint32 vreg;
 	Bits bit;
 
-	if(first) {
-		fmtinstall('Q', Qconv);
-		exregoffset = D_R15;
-		first = 0;
-	}
-
 	fixjmp(firstp);
 
 	// count instructions
@@ -192,7 +175,7 @@ regopt(Prog *firstp)
 	nvar = NREGVAR;
 	memset(var, 0, NREGVAR*sizeof var[0]);
 	for(i=0; i<NREGVAR; i++)
-		var[i].node = newname(lookup(regname[i]));
+		var[i].node = regnode[i];
 
 	regbits = RtoB(D_SP);
 	for(z=0; z<BITS; z++) {
@@ -204,7 +187,7 @@ regopt(Prog *firstp)
 	}
 
 	// build list of return variables
-	setoutvar();
+	setoutvar(out, nout);
 
 	/*
 	 * pass 1
@@ -781,10 +764,11 @@ brk:
 				p->to.branch = p->to.branch->link;
 	}
 
-	if(lastr != R) {
-		lastr->link = freer;
-		freer = firstr;
-	}
+	fixtab(firstp);
+
+	afree(&regarena);
+	firstr = R;
+	lastr = R;
 
 	if(debug['R']) {
 		if(ostats.ncvtreg ||
@@ -824,7 +808,7 @@ addmove(Reg *r, int bn, int rn, int f)
 	Adr *a;
 	Var *v;
 
-	p1 = mal(sizeof(*p1));
+	p1 = amal(progarena, sizeof(*p1));
 	clearp(p1);
 	p1->loc = 9999;
 
@@ -1206,11 +1190,8 @@ loopit(Reg *r, int32 nr)
 	Reg *r1;
 	int32 i, d, me;
 
-	if(nr > maxnr) {
-		rpo2r = mal(nr * sizeof(Reg*));
-		idom = mal(nr * sizeof(int32));
-		maxnr = nr;
-	}
+	rpo2r = amal(&regarena, nr * sizeof(Reg*));
+	idom = amal(&regarena, nr * sizeof(int32));
 
 	d = postorder(r, rpo2r, 0);
 	if(d > nr)
@@ -1677,19 +1658,36 @@ dumpit(char *str, Reg *r0)
 
 static Sym*	symlist[10];
 
+/*
+ * Set up what regopt and noreturn share between functions.
+ * Called before any regopt, so that they only read it.
+ */
+void
+regoptinit(void)
+{
+	int i;
+
+	if(symlist[0] != S)
+		return;
+	fmtinstall('Q', Qconv);
+	exregoffset = D_R15;
+	for(i=0; i<NREGVAR; i++)
+		regnode[i] = newname(lookup(regname[i]));
+	symlist[0] = pkglookup("panicindex", runtimepkg);
+	symlist[1] = pkglookup("panicslice", runtimepkg);
+	symlist[2] = pkglookup("throwinit", runtimepkg);
+	symlist[3] = pkglookup("panic", runtimepkg);
+	symlist[4] = pkglookup("panicwrap", runtimepkg);
+}
+
 int
 noreturn(Prog *p)
 {
 	Sym *s;
 	int i;
 
-	if(symlist[0] == S) {
-		symlist[0] = pkglookup("panicindex", runtimepkg);
-		symlist[1] = pkglookup("panicslice", runtimepkg);
-		symlist[2] = pkglookup("throwinit", runtimepkg);
-		symlist[3] = pkglookup("panic", runtimepkg);
-		symlist[4] = pkglookup("panicwrap", runtimepkg);
-	}
+	if(symlist[0] == S)
+		regoptinit();
 
 	s = p->to.sym;
 	if(s == S)
@@ -1819,3 +1817,80 @@ fixjmp(Prog *firstp)
 		print("\n");
 	}
 }
+
+/*
+ * the entries of a jump table must be contiguous,
+ * but regopt sees each entry as a branch that can
+ * fall through to the next and may have put moves
+ * between them.  take the moves out of the table:
+ * an entry that had moves before it jumps to a copy
+ * of them, placed after the table, followed by a
+ * jump to the entry's target.
+ */
+static void
+fixtab(Prog *firstp)
+{
+	Prog *p, *q, *e, *m, *m0, *ml, *t, *t0, *tl, *j;
+
+	for(p=firstp; p!=P; p=p->link) {
+		if(p->as != ACASE)
+			continue;
+		m0 = P;
+		ml = P;
+		t0 = P;
+		tl = P;
+		e = p;
+		for(q=p->link; q!=P; q=q->link) {
+			if(q->as == ABCASE) {
+				if(m0 != P) {
+					t = P;
+					for(m=m0;; m=m->link) {
+						j = amal(progarena, sizeof(*j));
+						*j = *m;
+						j->link = P;
+						if(t == P)
+							t = j;
+						if(t0 == P)
+							t0 = j;
+						else
+							tl->link = j;
+						tl = j;
+						if(m == ml)
+							break;
+					}
+					j = amal(progarena, sizeof(*j));
+					clearp(j);
+					j->as = AJMP;
+					j->lineno = q->lineno;
+					j->to = q->to;
+					tl->link = j;
+					tl = j;
+					q->to.branch = t;
+				}
+				e->link = q;
+				e = q;
+				continue;
+			}
+			if(q->loc != 9999)
+				break;
+			// a move inserted by regopt.
+			// look ahead for another entry.
+			for(m=q; m->link!=P && m->link->loc==9999; m=m->link)
+				;
+			if(m->link == P || m->link->as != ABCASE)
+				break;
+			if(m0 == P)
+				m0 = q;
+			else
+				ml->link = q;
+			ml = m;
+			q = m;
+		}
+		if(m0 != P)
+			ml->link = P;
+		if(t0 != P) {
+			tl->link = e->link;
+			e->link = t0;
+		}
+	}
+}
@@ -147,12 +147,12 @@ struct	Sym
 	uchar	special;
 	uchar	stkcheck;
 	uchar	hide;
+	uchar	reflectmethod;	// calls reflect Method or MethodByName
 	int32	dynid;
 	int32	sig;
 	int32	plt;
 	int32	got;
 	int32	align;	// if non-zero, required alignment in bytes
-	Sym*	hash;	// in hash table
 	Sym*	allsym;	// in all symbol list
 	Sym*	next;	// in text or data list
 	Sym*	sub;	// in SSUB list
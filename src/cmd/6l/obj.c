@@ -74,7 +74,7 @@ Header headers[] = {
 void
 usage(void)
 {
-	fprint(2, "usage: 6l [-options] [-E entry] [-H head] [-I interpreter] [-L dir] [-T text] [-R rnd] [-r path] [-o out] main.6\n");
+	fprint(2, "usage: 6l [-options] [-E entry] [-F feedback] [-H head] [-k symorder] [-I interpreter] [-L dir] [-T text] [-R rnd] [-r path] [-o out] main.6\n");
 	exits("usage");
 }
 
@@ -113,6 +113,12 @@ main(int argc, char *argv[])
 	case 'H':
 		HEADTYPE = headtype(EARGF(usage()));
 		break;
+	case 'F':
+		pgofile = EARGF(usage());
+		break;
+	case 'k':
+		symorder = EARGF(usage());
+		break;
 	case 'I':
 		debug['I'] = 1; // denote cmdline interpreter override
 		interpreter = EARGF(usage());
@@ -265,14 +271,21 @@ main(int argc, char *argv[])
 
 	addlibpath("command line", "command line", argv[0], "main");
 	loadlib();
+	endphase("loadlib");
 	deadcode();
+	endphase("deadcode");
 	patch();
+	endphase("patch");
 	follow();
+	endphase("follow");
 	doelf();
+	endphase("doelf");
 	if(HEADTYPE == Hdarwin)
 		domacho();
 	dostkoff();
+	endphase("dostkoff");
 	dostkcheck();
+	endphase("dostkcheck");
 	paramspace = "SP";	/* (FP) now (SP) on output */
 	if(debug['p'])
 		if(debug['1'])
@@ -280,19 +293,33 @@ main(int argc, char *argv[])
 		else
 			doprof2();
 	span();
+	endphase("span");
 	if(HEADTYPE == Hwindows)
 		dope();
 	addexport();
+	endphase("addexport");
 	textaddress();
+	endphase("textaddress");
 	pclntab();
+	endphase("pclntab");
+	functab();
+	endphase("functab");
 	symtab();
+	endphase("symtab");
 	dodata();
+	endphase("dodata");
 	address();
+	endphase("address");
 	doweak();
+	endphase("doweak");
 	reloc();
+	endphase("reloc");
 	asmb();
+	endphase("asmb");
 	undef();
+	endphase("undef");
 	if(debug['v']) {
+		phasestats();
 		Bprint(&bso, "%5.2f cpu time\n", cputime());
 		Bprint(&bso, "%d symbols\n", nsymbol);
 		Bprint(&bso, "%d sizeof adr\n", sizeof(Adr));
@@ -304,37 +331,37 @@ main(int argc, char *argv[])
 }
 
 static Sym*
-zsym(char *pn, Biobuf *f, Sym *h[])
+zsym(char *pn, Objbuf *f, Sym *h[])
 {	
 	int o;
 	
-	o = BGETC(f);
+	o = OGETC(f);
 	if(o < 0 || o >= NSYM || h[o] == nil)
 		mangle(pn);
 	return h[o];
 }
 
 static void
-zaddr(char *pn, Biobuf *f, Adr *a, Sym *h[])
+zaddr(char *pn, Objbuf *f, Adr *a, Sym *h[])
 {
 	int t;
 	int32 l;
 	Sym *s;
 	Auto *u;
 
-	t = BGETC(f);
+	t = OGETC(f);
 	a->index = D_NONE;
 	a->scale = 0;
 	if(t & T_INDEX) {
-		a->index = BGETC(f);
-		a->scale = BGETC(f);
+		a->index = OGETC(f);
+		a->scale = OGETC(f);
 	}
 	a->offset = 0;
 	if(t & T_OFFSET) {
-		a->offset = Bget4(f);
+		a->offset = Oget4(f);
 		if(t & T_64) {
 			a->offset &= 0xFFFFFFFFULL;
-			a->offset |= (vlong)Bget4(f) << 32;
+			a->offset |= (vlong)Oget4(f) << 32;
 		}
 	}
 	a->sym = S;
@@ -342,16 +369,16 @@ zaddr(char *pn, Biobuf *f, Adr *a, Sym *h[])
 		a->sym = zsym(pn, f, h);
 	a->type = D_NONE;
 	if(t & T_FCONST) {
-		a->ieee.l = Bget4(f);
-		a->ieee.h = Bget4(f);
+		a->ieee.l = Oget4(f);
+		a->ieee.h = Oget4(f);
 		a->type = D_FCONST;
 	} else
 	if(t & T_SCONST) {
-		Bread(f, a->scon, NSNAME);
+		Oread(f, a->scon, NSNAME);
 		a->type = D_SCONST;
 	}
 	if(t & T_TYPE)
-		a->type = BGETC(f);
+		a->type = OGETC(f);
 	if(a->type < 0 || a->type >= D_SIZE)
 		mangle(pn);
 	adrgotype = S;
@@ -405,7 +432,7 @@ nopout(Prog *p)
 }
 
 void
-ldobj1(Biobuf *f, char *pkg, int64 len, char *pn)
+ldobj1(Objbuf *f, char *pkg, char *pn)
 {
 	vlong ipc;
 	Prog *p;
@@ -414,13 +441,11 @@ ldobj1(Biobuf *f, char *pkg, int64 len, char *pn)
 	uint32 sig;
 	char *name, *x;
 	int ntext;
-	vlong eof;
 	char src[1024];
 	Prog *lastp;
 
 	lastp = nil;
 	ntext = 0;
-	eof = Boffset(f) + len;
 	src[0] = 0;
 
 newloop:
@@ -432,16 +457,16 @@ newloop:
 	mode = 64;
 
 loop:
-	if(f->state == Bracteof || Boffset(f) >= eof)
+	if(f->p >= f->ep)
 		goto eof;
-	o = BGETC(f);
+	o = OGETC(f);
 	if(o == Beof)
 		goto eof;
-	o |= BGETC(f) << 8;
+	o |= OGETC(f) << 8;
 	if(o <= AXXX || o >= ALAST) {
 		if(o < 0)
 			goto eof;
-		diag("%s:#%lld: opcode out of range: %#ux", pn, Boffset(f), o);
+		diag("%s:#%lld: opcode out of range: %#ux", pn, Ooffset(f), o);
 		print("	probably not a .6 file\n");
 		errorexit();
 	}
@@ -449,20 +474,15 @@ loop:
 	if(o == ANAME || o == ASIGNAME) {
 		sig = 0;
 		if(o == ASIGNAME)
-			sig = Bget4(f);
-		v = BGETC(f);	/* type */
-		o = BGETC(f);	/* sym */
+			sig = Oget4(f);
+		v = OGETC(f);	/* type */
+		o = OGETC(f);	/* sym */
 		r = 0;
 		if(v == D_STATIC)
 			r = version;
-		name = Brdline(f, '\0');
-		if(name == nil) {
-			if(Blinelen(f) > 0) {
-				fprint(2, "%s: name too long\n", pn);
-				errorexit();
-			}
+		name = Ordstr(f);
+		if(name == nil)
 			goto eof;
-		}
 		x = expandpkg(name, pkg);
 		s = lookup(x, r);
 		if(x != name)
@@ -504,7 +524,7 @@ loop:
 
 	p = mal(sizeof(*p));
 	p->as = o;
-	p->line = Bget4(f);
+	p->line = Oget4(f);
 	p->back = 2;
 	p->mode = mode;
 	p->ft = 0;
@@ -546,7 +566,7 @@ loop:
 			cursym->autom = curauto;
 		curauto = 0;
 		cursym = nil;
-		if(Boffset(f) == eof)
+		if(f->p == f->ep)
 			return;
 		goto newloop;
 
@@ -626,6 +646,8 @@ loop:
 			textp = s;
 		etextp = s;
 		s->text = p;
+		if(p->from.scale & REFLECTMETHOD)
+			s->reflectmethod = 1;
 		cursym = s;
 		if(s->type != 0 && s->type != SXREF) {
 			if(p->from.scale & DUPOK) {
@@ -337,6 +337,17 @@ uchar	yjmp[] =
 	0
 };
 
+uchar	ycase[] =
+{
+	Ynone,	Yml,	Zo_m64,	2,
+	0
+};
+uchar	ybcase[] =
+{
+	Ynone,	Ybr,	Zpseudo,1,
+	0
+};
+
 uchar	yfmvd[] =
 {
 	Ym,	Yf0,	Zm_o,	2,
@@ -1296,6 +1307,9 @@ Optab optab[] =
 
 	{ AUNDEF,		ynone,	Px, 0x0f, 0x0b },
 
+	{ ACASE,	ycase,	Px, 0xff,(04) },
+	{ ABCASE,	ybcase,	Px },
+
 	{ AEND },
 	0
 };
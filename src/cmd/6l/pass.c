@@ -80,6 +80,7 @@ nofollow(int a)
 	case ARETFQ:
 	case ARETFW:
 	case AUNDEF:
+	case ACASE:
 		return 1;
 	}
 	return 0;
@@ -184,6 +185,22 @@ loop:
 	*last = p;
 	a = p->as;
 
+	if(a == ACASE) {
+		/*
+		 * the jump table must follow the indirect jump.
+		 * lay out the targets after it.
+		 */
+		for(q = p->link; q != P && q->as == ABCASE; q = q->link) {
+			q->mark = 1;
+			(*last)->link = q;
+			*last = q;
+		}
+		for(q = p->link; q != P && q->as == ABCASE; q = q->link)
+			if(!q->pcond->mark)
+				xfol(q->pcond, last);
+		return;
+	}
+
 	/* continue loop with what comes after p */
 	if(nofollow(a))
 		return;
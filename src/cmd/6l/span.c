@@ -179,12 +179,53 @@ span1(Sym *s)
 	}
 }
 
+/*
+ * ACASE R jumps through a table of the targets of the ABCASE
+ * instructions that follow it, indexed by R, which the compiler
+ * has already checked against the length of the table.
+ * The table goes in read-only data; it is filled in once the
+ * targets have their final pcs.
+ */
+static void
+casetab(Prog *p, int n)
+{
+	Sym *s;
+	char *name;
+
+	name = smprint("%s.jmptab%d", cursym->name, n);
+	s = lookup(name, cursym->version);
+	free(name);
+	s->type = SRODATA;
+	s->reachable = 1;
+	p->to.type = D_EXTERN;
+	p->to.sym = s;
+	p->to.offset = 0;
+	p->to.index = p->from.type;
+	p->to.scale = 8;
+	p->from.type = D_NONE;
+	p->ft = 0;
+	p->tt = 0;
+}
+
+static void
+filltabs(Sym *s)
+{
+	Prog *p, *q;
+
+	for(p = s->text; p != P; p = p->link) {
+		if(p->as != ACASE)
+			continue;
+		for(q = p->link; q != P && q->as == ABCASE; q = q->link)
+			addaddrplus(p->to.sym, s, q->pcond->pc);
+	}
+}
+
 void
 span(void)
 {
 	Prog *p, *q;
 	int32 v;
-	int n;
+	int n, ntab;
 
 	if(debug['v'])
 		Bprint(&bso, "%5.2f span\n", cputime());
@@ -195,7 +236,10 @@ span(void)
 		if(cursym->p != nil)
 			continue;
 		// TODO: move into span1
+		ntab = 0;
 		for(p = cursym->text; p != P; p = p->link) {
+			if(p->as == ACASE)
+				casetab(p, ntab++);
 			n = 0;
 			if(p->to.type == D_BRANCH)
 				if(p->pcond == P)
@@ -219,6 +263,8 @@ span(void)
 			}
 		}
 		span1(cursym);
+		if(ntab > 0)
+			filltabs(cursym);
 	}
 }
 
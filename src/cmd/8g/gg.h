@@ -55,7 +55,7 @@ enum
 
 EXTERN	int32	dynloc;
 EXTERN	uchar	reg[D_NONE];
-EXTERN	int32	pcloc;		// instruction counter
+EXTERN	THREAD	int32	pcloc;		// instruction counter
 EXTERN	Strlit	emptystring;
 extern	char*	anames[];
 EXTERN	Prog	zprog;
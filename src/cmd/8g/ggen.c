@@ -780,3 +780,17 @@ cgen_bmul(int op, Node *nl, Node *nr, Node *res)
 	regfree(&n1b);
 	regfree(&n2b);
 }
+
+void
+gjmptab(Node *idx)
+{
+	USED(idx);
+	fatal("gjmptab");
+}
+
+Prog*
+gjmpcase(void)
+{
+	fatal("gjmpcase");
+	return P;
+}
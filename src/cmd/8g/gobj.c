@@ -215,6 +215,14 @@ zsymaddr(Addr *a, int *new)
 	return zsym(a->sym, t, new);
 }
 
+/*
+ * dumpfuncs writes all the functions at once.
+ */
+void
+emitfuncs(void)
+{
+}
+
 void
 dumpfuncs(void)
 {
@@ -37,8 +37,6 @@
 #define	REGBITS	((uint32)0xff)
 #define	P2R(p)	(Reg*)(p->reg)
 
-static	int	first	= 1;
-
 static	void	fixjmp(Prog*);
 
 Reg*
@@ -72,24 +70,17 @@ rcmp(const void *a1, const void *a2)
 }
 
 static void
-setoutvar(void)
+setoutvar(Addr *out, int nout)
 {
-	Type *t;
-	Node *n;
 	Addr a;
-	Iter save;
 	Bits bit;
-	int z;
+	int i, z;
 
-	t = structfirst(&save, getoutarg(curfn->type));
-	while(t != T) {
-		n = nodarg(t, 1);
-		a = zprog.from;
-		naddr(n, &a, 0);
+	for(i=0; i<nout; i++) {
+		a = out[i];
 		bit = mkvar(R, &a);
 		for(z=0; z<BITS; z++)
 			ovar.b[z] |= bit.b[z];
-		t = structnext(&save);
 	}
 //if(bany(ovar))
 //print("ovars = %Q\n", ovar);
@@ -120,8 +111,10 @@ setaddrs(Bits bit)
 
 static char* regname[] = { ".ax", ".cx", ".dx", ".bx", ".sp", ".bp", ".si", ".di" };
 
+static Node*	regnode[NREGVAR];
+
 void
-regopt(Prog *firstp)
+regopt(Prog *firstp, Addr *out, int nout)
 {
 	Reg *r, *r1;
 	Prog *p;
@@ -129,12 +122,6 @@ regopt(Prog *firstp)
 	uint32 vreg;
 	Bits bit;
 
-	if(first) {
-		fmtinstall('Q', Qconv);
-		exregoffset = D_DI;	// no externals
-		first = 0;
-	}
-	
 	fixjmp(firstp);
 
 	// count instructions
@@ -159,7 +146,7 @@ regopt(Prog *firstp)
 	nvar = NREGVAR;
 	memset(var, 0, NREGVAR*sizeof var[0]);
 	for(i=0; i<NREGVAR; i++)
-		var[i].node = newname(lookup(regname[i]));
+		var[i].node = regnode[i];
 
 	regbits = RtoB(D_SP);
 	for(z=0; z<BITS; z++) {
@@ -171,7 +158,7 @@ regopt(Prog *firstp)
 	}
 
 	// build list of return variables
-	setoutvar();
+	setoutvar(out, nout);
 
 	/*
 	 * pass 1
@@ -1538,19 +1525,36 @@ dumpit(char *str, Reg *r0)
 
 static Sym*	symlist[10];
 
+/*
+ * Set up what regopt and noreturn share between functions.
+ * Called before any regopt, so that they only read it.
+ */
+void
+regoptinit(void)
+{
+	int i;
+
+	if(symlist[0] != S)
+		return;
+	fmtinstall('Q', Qconv);
+	exregoffset = D_DI;	// no externals
+	for(i=0; i<NREGVAR; i++)
+		regnode[i] = newname(lookup(regname[i]));
+	symlist[0] = pkglookup("panicindex", runtimepkg);
+	symlist[1] = pkglookup("panicslice", runtimepkg);
+	symlist[2] = pkglookup("throwinit", runtimepkg);
+	symlist[3] = pkglookup("panic", runtimepkg);
+	symlist[4] = pkglookup("panicwrap", runtimepkg);
+}
+
 int
 noreturn(Prog *p)
 {
 	Sym *s;
 	int i;
 
-	if(symlist[0] == S) {
-		symlist[0] = pkglookup("panicindex", runtimepkg);
-		symlist[1] = pkglookup("panicslice", runtimepkg);
-		symlist[2] = pkglookup("throwinit", runtimepkg);
-		symlist[3] = pkglookup("panic", runtimepkg);
-		symlist[4] = pkglookup("panicwrap", runtimepkg);
-	}
+	if(symlist[0] == S)
+		regoptinit();
 
 	s = p->to.sym;
 	if(s == S)
@@ -35,6 +35,7 @@
 #define NOSPLIT	(1<<2)
 #define RODATA	(1<<3)
 #define NOPTR	(1<<4)
+#define REFLECTMETHOD	(1<<5)
 
 enum	as
 {
@@ -129,6 +129,7 @@ struct	Sym
 	uchar	special;
 	uchar	stkcheck;
 	uchar	hide;
+	uchar	reflectmethod;	// calls reflect Method or MethodByName
 	int32	value;
 	int32	size;
 	int32	sig;
@@ -136,7 +137,6 @@ struct	Sym
 	int32	plt;
 	int32	got;
 	int32	align;	// if non-zero, required alignment in bytes
-	Sym*	hash;	// in hash table
 	Sym*	allsym;	// in all symbol list
 	Sym*	next;	// in text or data list
 	Sym*	sub;	// in sub list
@@ -79,7 +79,7 @@ Header headers[] = {
 void
 usage(void)
 {
-	fprint(2, "usage: 8l [-options] [-E entry] [-H head] [-I interpreter] [-L dir] [-T text] [-R rnd] [-r path] [-o out] main.8\n");
+	fprint(2, "usage: 8l [-options] [-E entry] [-F feedback] [-H head] [-k symorder] [-I interpreter] [-L dir] [-T text] [-R rnd] [-r path] [-o out] main.8\n");
 	exits("usage");
 }
 
@@ -118,6 +118,12 @@ main(int argc, char *argv[])
 	case 'H':
 		HEADTYPE = headtype(EARGF(usage()));
 		break;
+	case 'F':
+		pgofile = EARGF(usage());
+		break;
+	case 'k':
+		symorder = EARGF(usage());
+		break;
 	case 'I':
 		debug['I'] = 1; // denote cmdline interpreter override
 		interpreter = EARGF(usage());
@@ -292,32 +298,52 @@ main(int argc, char *argv[])
 
 	addlibpath("command line", "command line", argv[0], "main");
 	loadlib();
+	endphase("loadlib");
 	deadcode();
+	endphase("deadcode");
 	patch();
+	endphase("patch");
 	follow();
+	endphase("follow");
 	doelf();
+	endphase("doelf");
 	if(HEADTYPE == Hdarwin)
 		domacho();
 	if(HEADTYPE == Hwindows)
 		dope();
 	dostkoff();
+	endphase("dostkoff");
 	if(debug['p'])
 		if(debug['1'])
 			doprof1();
 		else
 			doprof2();
 	span();
+	endphase("span");
 	addexport();
+	endphase("addexport");
 	textaddress();
+	endphase("textaddress");
 	pclntab();
+	endphase("pclntab");
+	functab();
+	endphase("functab");
 	symtab();
+	endphase("symtab");
 	dodata();
+	endphase("dodata");
 	address();
+	endphase("address");
 	doweak();
+	endphase("doweak");
 	reloc();
+	endphase("reloc");
 	asmb();
+	endphase("asmb");
 	undef();
+	endphase("undef");
 	if(debug['v']) {
+		phasestats();
 		Bprint(&bso, "%5.2f cpu time\n", cputime());
 		Bprint(&bso, "%d symbols\n", nsymbol);
 		Bprint(&bso, "%d sizeof adr\n", sizeof(Adr));
@@ -329,54 +355,54 @@ main(int argc, char *argv[])
 }
 
 static Sym*
-zsym(char *pn, Biobuf *f, Sym *h[])
+zsym(char *pn, Objbuf *f, Sym *h[])
 {	
 	int o;
 	
-	o = BGETC(f);
+	o = OGETC(f);
 	if(o < 0 || o >= NSYM || h[o] == nil)
 		mangle(pn);
 	return h[o];
 }
 
 static void
-zaddr(char *pn, Biobuf *f, Adr *a, Sym *h[])
+zaddr(char *pn, Objbuf *f, Adr *a, Sym *h[])
 {
 	int t;
 	int32 l;
 	Sym *s;
 	Auto *u;
 
-	t = BGETC(f);
+	t = OGETC(f);
 	a->index = D_NONE;
 	a->scale = 0;
 	if(t & T_INDEX) {
-		a->index = BGETC(f);
-		a->scale = BGETC(f);
+		a->index = OGETC(f);
+		a->scale = OGETC(f);
 	}
 	a->type = D_NONE;
 	a->offset = 0;
 	if(t & T_OFFSET)
-		a->offset = Bget4(f);
+		a->offset = Oget4(f);
 	a->offset2 = 0;
 	if(t & T_OFFSET2) {
-		a->offset2 = Bget4(f);
+		a->offset2 = Oget4(f);
 		a->type = D_CONST2;
 	}
 	a->sym = S;
 	if(t & T_SYM)
 		a->sym = zsym(pn, f, h);
 	if(t & T_FCONST) {
-		a->ieee.l = Bget4(f);
-		a->ieee.h = Bget4(f);
+		a->ieee.l = Oget4(f);
+		a->ieee.h = Oget4(f);
 		a->type = D_FCONST;
 	} else
 	if(t & T_SCONST) {
-		Bread(f, a->scon, NSNAME);
+		Oread(f, a->scon, NSNAME);
 		a->type = D_SCONST;
 	}
 	if(t & T_TYPE)
-		a->type = BGETC(f);
+		a->type = OGETC(f);
 	adrgotype = S;
 	if(t & T_GOTYPE)
 		adrgotype = zsym(pn, f, h);
@@ -423,7 +449,7 @@ nopout(Prog *p)
 }
 
 void
-ldobj1(Biobuf *f, char *pkg, int64 len, char *pn)
+ldobj1(Objbuf *f, char *pkg, char *pn)
 {
 	int32 ipc;
 	Prog *p;
@@ -431,14 +457,12 @@ ldobj1(Biobuf *f, char *pkg, int64 len, char *pn)
 	Sym *h[NSYM], *s;
 	uint32 sig;
 	int ntext;
-	int32 eof;
 	char *name, *x;
 	char src[1024];
 	Prog *lastp;
 
 	lastp = nil;
 	ntext = 0;
-	eof = Boffset(f) + len;
 	src[0] = 0;
 
 
@@ -450,16 +474,16 @@ newloop:
 	skip = 0;
 
 loop:
-	if(f->state == Bracteof || Boffset(f) >= eof)
+	if(f->p >= f->ep)
 		goto eof;
-	o = BGETC(f);
+	o = OGETC(f);
 	if(o == Beof)
 		goto eof;
-	o |= BGETC(f) << 8;
+	o |= OGETC(f) << 8;
 	if(o <= AXXX || o >= ALAST) {
 		if(o < 0)
 			goto eof;
-		diag("%s:#%lld: opcode out of range: %#ux", pn, Boffset(f), o);
+		diag("%s:#%lld: opcode out of range: %#ux", pn, Ooffset(f), o);
 		print("	probably not a .%c file\n", thechar);
 		errorexit();
 	}
@@ -467,20 +491,15 @@ loop:
 	if(o == ANAME || o == ASIGNAME) {
 		sig = 0;
 		if(o == ASIGNAME)
-			sig = Bget4(f);
-		v = BGETC(f);	/* type */
-		o = BGETC(f);	/* sym */
+			sig = Oget4(f);
+		v = OGETC(f);	/* type */
+		o = OGETC(f);	/* sym */
 		r = 0;
 		if(v == D_STATIC)
 			r = version;
-		name = Brdline(f, '\0');
-		if(name == nil) {
-			if(Blinelen(f) > 0) {
-				fprint(2, "%s: name too long\n", pn);
-				errorexit();
-			}
+		name = Ordstr(f);
+		if(name == nil)
 			goto eof;
-		}
 		x = expandpkg(name, pkg);
 		s = lookup(x, r);
 		if(x != name)
@@ -522,7 +541,7 @@ loop:
 
 	p = mal(sizeof(*p));
 	p->as = o;
-	p->line = Bget4(f);
+	p->line = Oget4(f);
 	p->back = 2;
 	p->ft = 0;
 	p->tt = 0;
@@ -554,7 +573,7 @@ loop:
 			cursym->autom = curauto;
 		curauto = 0;
 		cursym = nil;
-		if(Boffset(f) == eof)
+		if(f->p == f->ep)
 			return;
 		goto newloop;
 
@@ -634,6 +653,8 @@ loop:
 			textp = s;
 		etextp = s;
 		s->text = p;
+		if(p->from.scale & REFLECTMETHOD)
+			s->reflectmethod = 1;
 		cursym = s;
 		if(s->type != 0 && s->type != SXREF) {
 			if(p->from.scale & DUPOK) {
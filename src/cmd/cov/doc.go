@@ -8,12 +8,19 @@ Cov is a rudimentary code coverage tool.
 
 Usage:
 	go tool cov [-lsv] [-g substring] [-m minlines] [6.out args]
+	go tool cov -p [-lsv] [-g substring] [-m minlines] profile...
 
 Given a command to run, it runs the command while tracking which
 sections of code have been executed.  When the command finishes,
 cov prints the line numbers of sections of code in the binary that
 were not executed.   With no arguments it assumes the command "6.out".
 
+With -p, cov instead reads the coverage profiles written by test
+binaries built with go test -cover (see go help testflag), adds up
+the counts for each basic block, and prints the line numbers of
+the blocks that never ran, followed by the fraction that did.
+Such profiles come from counters the compiler inserts, so the
+program runs at nearly full speed and no breakpoints are needed.
 
 The options are:
 
@@ -21,8 +28,11 @@ The options are:
 		print full path names instead of paths relative to the current directory
 	-s
 		show the source code that didn't execute, in addition to the line numbers.
+	-p
+		merge and report on coverage profiles
 	-v
-		print debugging information during the run.
+		print debugging information during the run;
+		with -p, print the count for every block.
 	-g substring
 		restrict the coverage analysis to functions or files whose names contain substring
 	-m minlines
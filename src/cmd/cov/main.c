@@ -19,6 +19,7 @@ void
 usage(void)
 {
 	fprint(2, "usage: cov [-lsv] [-g substring] [-m minlines] [6.out args...]\n");
+	fprint(2, "       cov -p [-lsv] [-g substring] [-m minlines] profile...\n");
 	fprint(2, "-g specifies pattern of interesting functions or files\n");
 	exits("usage");
 }
@@ -42,6 +43,9 @@ char *substring;
 char cwd[1000];
 int ncwd;
 int minlines = -1000;
+int profiles;	// -p: merge coverage profiles
+
+void	profile(int, char**);
 
 Tree breakpoints;	// code ranges not run
 
@@ -437,6 +441,9 @@ main(int argc, char **argv)
 	case 'n':
 		minlines = atoi(EARGF(usage()));
 		break;
+	case 'p':
+		profiles = 1;
+		break;
 	case 's':
 		doshowsrc = 1;
 		break;
@@ -450,6 +457,12 @@ main(int argc, char **argv)
 	getwd(cwd, sizeof cwd);
 	ncwd = strlen(cwd);
 
+	if(profiles) {
+		if(argc == 0)
+			usage();
+		profile(argc, argv);
+		exits(0);
+	}
 	if(argc == 0) {
 		*--argv = "6.out";
 	}
@@ -0,0 +1,159 @@
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+/*
+ * coverage profiles (-p).
+ *
+ * a program compiled with coverage counters (go test -cover)
+ * writes a profile giving the number of times each basic block ran:
+ *	go cover 1
+ *	/abs/path/file.go:line,eline count
+ *	...
+ * the counts for a block are summed over all the profiles named
+ * and the blocks that never ran are printed like the code that
+ * did not run in breakpoint mode.
+ */
+
+#include <u.h>
+#include <libc.h>
+#include <bio.h>
+#include "tree.h"
+
+extern int chatty;
+extern int doshowsrc;
+extern char *substring;
+extern int minlines;
+char*	shortname(char*);
+void	showsrc(char*, int, int);
+
+typedef struct Block Block;
+struct Block
+{
+	char*	file;
+	int	line;
+	int	eline;
+	uvlong	count;
+};
+
+static Tree blocks;
+
+/*
+ * comparison for Block structures, by file and lines.
+ * like rangecmp, it returns 1 if a sorts before b.
+ */
+static int
+blockcmp(void *va, void *vb)
+{
+	Block *a = va, *b = vb;
+	int c;
+
+	c = strcmp(a->file, b->file);
+	if(c != 0)
+		return -c;
+	if(a->line != b->line)
+		return a->line < b->line ? 1 : -1;
+	if(a->eline != b->eline)
+		return a->eline < b->eline ? 1 : -1;
+	return 0;
+}
+
+/*
+ * add count to the block at pos, "file:line,eline".
+ */
+static int
+addblock(char *pos, uvlong count)
+{
+	Block key, *b;
+	char *p, *q;
+
+	if((p = strrchr(pos, ':')) == nil || (q = strchr(p, ',')) == nil)
+		return -1;
+	*p++ = 0;
+	*q++ = 0;
+	key.file = pos;
+	key.line = atoi(p);
+	key.eline = atoi(q);
+	b = treeget(&blocks, &key);
+	if(b == nil) {
+		b = malloc(sizeof *b);
+		if(b == nil)
+			sysfatal("out of memory");
+		*b = key;
+		b->file = strdup(pos);
+		b->count = 0;
+		treeput(&blocks, b, b);
+	}
+	b->count += count;
+	return 0;
+}
+
+static void
+readprofile(char *name)
+{
+	Biobuf *bin;
+	char *line, *p;
+	int n;
+
+	if((bin = Bopen(name, OREAD)) == nil)
+		sysfatal("open %s: %r", name);
+	line = Brdstr(bin, '\n', 1);
+	if(line == nil || strcmp(line, "go cover 1") != 0)
+		sysfatal("%s: not a coverage profile", name);
+	free(line);
+	for(n=2; (line = Brdstr(bin, '\n', 1)) != nil; n++) {
+		if((p = strrchr(line, ' ')) == nil)
+			sysfatal("%s:%d: malformed line", name, n);
+		*p++ = 0;
+		if(addblock(line, strtoull(p, 0, 10)) < 0)
+			sysfatal("%s:%d: malformed block", name, n);
+		free(line);
+	}
+	Bterm(bin);
+}
+
+static int nblock;
+static int nran;
+
+static void
+walkblocks(TreeNode *t)
+{
+	Block *b;
+
+	if(t == nil)
+		return;
+	walkblocks(t->left);
+	b = t->key;
+	if(substring == nil || strstr(b->file, substring)) {
+		nblock++;
+		if(b->count > 0)
+			nran++;
+		if(chatty)
+			print("%s:%d,%d %llud\n", shortname(b->file), b->line, b->eline, b->count);
+		else if(b->count == 0 && b->eline+1-b->line >= minlines) {
+			if(b->line != b->eline)
+				print("%s:%d,%d\n", shortname(b->file), b->line, b->eline);
+			else
+				print("%s:%d\n", shortname(b->file), b->line);
+			if(doshowsrc)
+				showsrc(b->file, b->line, b->eline);
+		}
+	}
+	walkblocks(t->right);
+}
+
+/*
+ * merge the profiles named by argv and report on the result.
+ */
+void
+profile(int argc, char **argv)
+{
+	int i;
+
+	blocks.cmp = blockcmp;
+	for(i=0; i<argc; i++)
+		readprofile(argv[i]);
+	walkblocks(blocks.root);
+	if(nblock > 0)
+		print("%d of %d blocks run (%.1f%%)\n", nran, nblock, 100.0*nran/nblock);
+}
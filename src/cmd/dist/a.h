@@ -119,8 +119,10 @@ Time	mtime(char*);
 void	readfile(Buf*, char*);
 void	run(Buf *b, char *dir, int mode, char *cmd, ...);
 void	runv(Buf *b, char *dir, int mode, Vec *argv);
-void	bgrunv(char *dir, int mode, Vec *argv);
+int	bgrunv(char *dir, int mode, Vec *argv);
+void	bgsetmax(int);
 void	bgwait(void);
+int	bgwaitany(void);
 bool	streq(char*, char*);
 void	writefile(Buf*, char*, int);
 void	xatexit(void (*f)(void));
@@ -135,6 +137,8 @@ void	xmemmove(void*, void*, int);
 void	xmkdir(char *p);
 void	xmkdirall(char*);
 Time	xmtime(char *p);
+int	xncpu(void);
+Time	xnow(void);
 void	xprintf(char*, ...);
 void	xqsort(void*, int, int, int(*)(const void*, const void*));
 void	xreaddir(Vec *dst, char *dir);
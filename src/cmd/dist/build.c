@@ -475,7 +475,9 @@ static struct {
 	}},
 	{"cmd/5l", {
 		"../ld/data.c",
+		"../ld/decodesym.c",
 		"../ld/elf.c",
+		"../ld/functab.c",
 		"../ld/go.c",
 		"../ld/ldelf.c",
 		"../ld/ldmacho.c",
@@ -966,9 +968,12 @@ install(char *dir)
 
 	if(!islib && !isgo) {
 		// C binaries need the libraries explicitly, and -lm.
+		// lib9's worker threads need -lpthread.
 		vcopy(&link, lib.p, lib.len);
 		if(!streq(gohostos, "plan9"))
 			vadd(&link, "-lm");
+		if(!streq(gohostos, "plan9") && !streq(gohostos, "windows"))
+			vadd(&link, "-lpthread");
 	}
 
 	// Remove target before writing it.
@@ -1028,9 +1033,11 @@ shouldbuild(char *file, char *dir)
 
 	// On Plan 9, most of the libraries are already present.
 	// The main exception is libmach which has been modified
-	// in various places to support Go object files.
+	// in various places to support Go object files.  What the
+	// tools need from our lib9 and libbio beyond the native
+	// ones is in lib9/plan9.c.
 	if(streq(gohostos, "plan9")) {
-		if(streq(dir, "lib9") && !hassuffix(file, "lib9/goos.c"))
+		if(streq(dir, "lib9") && !hassuffix(file, "lib9/goos.c") && !hassuffix(file, "lib9/plan9.c"))
 			return 0;
 		if(streq(dir, "libbio"))
 			return 0;
@@ -1162,6 +1169,9 @@ static char *buildorder[] = {
 	"pkg/sort",
 	"pkg/container/heap",
 	"pkg/encoding/base64",
+	"pkg/hash",
+	"pkg/crypto",
+	"pkg/crypto/sha1",
 	"pkg/syscall",
 	"pkg/time",
 	"pkg/os",
@@ -1188,6 +1198,291 @@ static char *buildorder[] = {
 	"cmd/go",
 };
 
+// bootdeptab lists the directories that must be installed
+// before a directory with the given prefix in a parallel bootstrap.
+// A %s in a prefix or dependency stands for each of the
+// architecture letters in turn.  Dependencies that are not
+// being built are ignored.  In addition to these, a Go package
+// waits for the packages it imports.
+static struct {
+	char *prefix;  // prefix of target
+	char *dep[10];  // directories to install first
+} bootdeptab[] = {
+	{"cmd/", {
+		"lib9",
+		"libbio",
+		"libmach",
+	}},
+	{"cmd/%sa", {
+		"cmd/%sl",
+	}},
+	{"cmd/%sc", {
+		"cmd/cc",
+		"cmd/%sl",
+	}},
+	{"cmd/%sg", {
+		"cmd/gc",
+		"cmd/%sl",
+	}},
+	{"pkg/", {
+		"cmd/pack",
+		"cmd/%sa",
+		"cmd/%sc",
+		"cmd/%sg",
+	}},
+	{"cmd/go", {
+		"cmd/pack",
+		"cmd/%sg",
+		"cmd/%sl",
+	}},
+};
+
+// goimports adds to deps the directories of the packages
+// imported by the Go files in dir.
+static void
+goimports(Vec *deps, char *dir)
+{
+	int i, j, inblock, incomment;
+	char *p, *q;
+	Buf b, path, file;
+	Vec files, lines;
+
+	binit(&b);
+	binit(&path);
+	binit(&file);
+	vinit(&files);
+	vinit(&lines);
+
+	bpathf(&path, "%s/src/%s", goroot, dir);
+	xreaddir(&files, bstr(&path));
+	for(i=0; i<files.len; i++) {
+		if(!hassuffix(files.p[i], ".go"))
+			continue;
+		bpathf(&file, "%s/%s", bstr(&path), files.p[i]);
+		if(!shouldbuild(bstr(&file), dir))
+			continue;
+
+		// The imports follow the package clause, one per line,
+		// either alone or in a parenthesized block.
+		readfile(&b, bstr(&file));
+		splitlines(&lines, bstr(&b));
+		inblock = 0;
+		incomment = 0;
+		for(j=0; j<lines.len; j++) {
+			p = lines.p[j];
+			while(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+				p++;
+			if(incomment) {
+				if(xstrstr(p, "*/") != nil)
+					incomment = 0;
+				continue;
+			}
+			if(hasprefix(p, "/*")) {
+				if(xstrstr(p+2, "*/") == nil)
+					incomment = 1;
+				continue;
+			}
+			if(*p == '\0' || hasprefix(p, "//"))
+				continue;
+			if(inblock) {
+				if(*p == ')')
+					inblock = 0;
+			} else if(hasprefix(p, "package ")) {
+				continue;
+			} else if(hasprefix(p, "import")) {
+				p += 6;
+				while(*p == ' ' || *p == '\t')
+					p++;
+				if(*p == '(') {
+					inblock = 1;
+					p++;
+				}
+			} else
+				break;
+			p = xstrstr(p, "\"");
+			if(p == nil)
+				continue;
+			p++;
+			q = xstrstr(p, "\"");
+			if(q == nil)
+				continue;
+			bprintf(&b, "pkg/");
+			bwrite(&b, p, q-p);
+			vadd(deps, bstr(&b));
+		}
+	}
+
+	bfree(&b);
+	bfree(&path);
+	bfree(&file);
+	vfree(&files);
+	vfree(&lines);
+}
+
+// bootdeps replaces deps with the directories that must be
+// installed before dir in a parallel bootstrap.
+static void
+bootdeps(Vec *deps, char *dir)
+{
+	int i, j;
+	char *c, ch[2];
+	Buf b;
+
+	binit(&b);
+	vreset(deps);
+	ch[1] = '\0';
+	for(i=0; i<nelem(bootdeptab); i++) {
+		for(c=gochars; *c; c++) {
+			ch[0] = *c;
+			bprintf(&b, bootdeptab[i].prefix, ch);
+			if(!hasprefix(dir, bstr(&b)))
+				continue;
+			for(j=0; j<nelem(bootdeptab[i].dep) && bootdeptab[i].dep[j] != nil; j++)
+				vadd(deps, bprintf(&b, bootdeptab[i].dep[j], ch));
+		}
+	}
+	if(hasprefix(dir, "pkg/") || streq(dir, "cmd/go"))
+		goimports(deps, dir);
+	bfree(&b);
+}
+
+// A Target is a directory installed by installall.
+typedef struct Target Target;
+struct Target
+{
+	char *dir;
+	int *dep;  // targets to install first
+	int ndep;
+	int nwait;  // number of deps not yet installed
+	int job;  // bgrunv job number while running
+	int last;  // the dep that was installed last, or -1
+	bool started;
+	bool done;
+	Time start;
+	Time end;
+};
+
+// installall installs the directories in dirs, which must be listed
+// in dependency order.  If njob is more than one, it runs up to njob
+// copies of 'dist install' at once, each starting as soon as the
+// directories it depends on are installed.  With -v, installall
+// reports the critical path: the chain of dependent installs
+// that bounds how fast the build can go.
+static void
+installall(Vec *dirs, int njob)
+{
+	int i, j, k, m, n, nrun, ndone;
+	Target *targ, *t;
+	Time start, end, crit;
+	Vec deps, argv, path;
+	Buf b;
+
+	binit(&b);
+	vinit(&deps);
+	vinit(&argv);
+	vinit(&path);
+
+	n = dirs->len;
+	targ = xmalloc(n*sizeof targ[0]);
+	for(i=0; i<n; i++) {
+		t = &targ[i];
+		t->dir = dirs->p[i];
+		t->dep = xmalloc(n*sizeof t->dep[0]);
+		t->last = -1;
+		bootdeps(&deps, t->dir);
+		for(j=0; j<deps.len; j++) {
+			// Only directories listed earlier can be waited for.
+			k = find(deps.p[j], dirs->p, i);
+			for(m=0; m<t->ndep && t->dep[m] != k; m++)
+				;
+			if(k >= 0 && m == t->ndep)
+				t->dep[t->ndep++] = k;
+		}
+		t->nwait = t->ndep;
+	}
+
+	start = xnow();
+	if(njob <= 1) {
+		for(i=0; i<n; i++) {
+			targ[i].start = xnow();
+			install(targ[i].dir);
+			targ[i].end = xnow();
+		}
+	} else {
+		bgsetmax(njob);
+		nrun = 0;
+		ndone = 0;
+		while(ndone < n) {
+			for(i=0; i<n && nrun < njob; i++) {
+				t = &targ[i];
+				if(t->started || t->nwait > 0)
+					continue;
+				vreset(&argv);
+				vadd(&argv, argv0);
+				vadd(&argv, "install");
+				if(rebuildall)
+					vadd(&argv, "-a");
+				for(j=0; j<vflag; j++)
+					vadd(&argv, "-v");
+				vadd(&argv, t->dir);
+				t->started = 1;
+				t->start = xnow();
+				t->job = bgrunv(nil, CheckExit, &argv);
+				nrun++;
+			}
+			if(nrun == 0)
+				fatal("dependency cycle in bootstrap");
+			k = bgwaitany();
+			for(i=0; i<n; i++)
+				if(targ[i].started && !targ[i].done && targ[i].job == k)
+					break;
+			if(i == n)
+				fatal("bgwaitany: unexpected job %d", k);
+			t = &targ[i];
+			t->end = xnow();
+			t->done = 1;
+			nrun--;
+			ndone++;
+			for(j=0; j<n; j++)
+				for(k=0; k<targ[j].ndep; k++)
+					if(targ[j].dep[k] == i)
+						targ[j].nwait--;
+		}
+	}
+	end = xnow();
+
+	if(vflag) {
+		// Walk back from the last install to finish,
+		// following the dependency each one finished last.
+		k = 0;
+		for(i=0; i<n; i++) {
+			t = &targ[i];
+			for(j=0; j<t->ndep; j++)
+				if(t->last < 0 || targ[t->dep[j]].end > targ[t->last].end)
+					t->last = t->dep[j];
+			if(t->end > targ[k].end)
+				k = i;
+		}
+		crit = 0;
+		for(; k >= 0; k = targ[k].last) {
+			t = &targ[k];
+			crit += t->end - t->start;
+			vadd(&path, bprintf(&b, "\t%6.2fs %s\n", (t->end - t->start)/1e9, t->dir));
+		}
+		xprintf("critical path %.2fs of %.2fs total, %d jobs:\n", crit/1e9, (end - start)/1e9, njob);
+		for(i=path.len-1; i>=0; i--)
+			xprintf("%s", path.p[i]);
+	}
+
+	for(i=0; i<n; i++)
+		xfree(targ[i].dep);
+	xfree(targ);
+	bfree(&b);
+	vfree(&deps);
+	vfree(&argv);
+	vfree(&path);
+}
+
 // cleantab records the directories to clean in 'go clean'.
 // It is bigger than the buildorder because we clean all the
 // compilers but build only the $GOARCH ones.
@@ -1219,6 +1514,8 @@ static char *cleantab[] = {
 	"pkg/bufio",
 	"pkg/bytes",
 	"pkg/container/heap",
+	"pkg/crypto",
+	"pkg/crypto/sha1",
 	"pkg/encoding/base64",
 	"pkg/encoding/json",
 	"pkg/errors",
@@ -1230,6 +1527,7 @@ static char *cleantab[] = {
 	"pkg/go/parser",
 	"pkg/go/scanner",
 	"pkg/go/token",
+	"pkg/hash",
 	"pkg/io",
 	"pkg/io/ioutil",
 	"pkg/log",
@@ -1323,7 +1621,7 @@ usage(void)
 		"Commands are:\n"
 		"\n"
 		"banner         print installation banner\n"
-		"bootstrap      rebuild everything\n"
+		"bootstrap [-j n] rebuild everything (-j: run n installs at once)\n"
 		"clean          deletes all built files\n"
 		"env [-p]       print environment (-p: include $PATH)\n"
 		"install [dir]  install individual directory\n"
@@ -1395,16 +1693,26 @@ cmdenv(int argc, char **argv)
 void
 cmdbootstrap(int argc, char **argv)
 {
-	int i;
+	int i, njob;
 	Buf b;
-	char *oldgoos, *oldgoarch, *oldgochar;
+	Vec dirs;
+	char *p, *oldgoos, *oldgoarch, *oldgochar;
 
 	binit(&b);
+	vinit(&dirs);
 
+	njob = xncpu();
 	ARGBEGIN{
 	case 'a':
 		rebuildall = 1;
 		break;
+	case 'j':
+		p = EARGF(usage());
+		for(njob=0; *p >= '0' && *p <= '9'; p++)
+			njob = njob*10 + *p - '0';
+		if(*p != '\0' || njob < 1)
+			usage();
+		break;
 	case 'v':
 		vflag++;
 		break;
@@ -1434,10 +1742,11 @@ cmdbootstrap(int argc, char **argv)
 	xsetenv("GOOS", goos);
 
 	for(i=0; i<nelem(buildorder); i++) {
-		install(bprintf(&b, buildorder[i], gohostchar));
+		vadd(&dirs, bprintf(&b, buildorder[i], gohostchar));
 		if(!streq(oldgochar, gohostchar) && xstrstr(buildorder[i], "%s"))
-			install(bprintf(&b, buildorder[i], oldgochar));
+			vadd(&dirs, bprintf(&b, buildorder[i], oldgochar));
 	}
+	installall(&dirs, njob);
 
 	goos = oldgoos;
 	goarch = oldgoarch;
@@ -1450,6 +1759,7 @@ cmdbootstrap(int argc, char **argv)
 		install("pkg/runtime");
 
 	bfree(&b);
+	vfree(&dirs);
 }
 
 static char*
@@ -1491,6 +1801,9 @@ cmdinstall(int argc, char **argv)
 	int i;
 
 	ARGBEGIN{
+	case 'a':
+		rebuildall = 1;
+		break;
 	case 'v':
 		vflag++;
 		break;
@@ -28,6 +28,10 @@ xmain(int argc, char **argv)
 
 	if(argc <= 1)
 		usage();
+
+	// Record how we were invoked, so that a parallel
+	// bootstrap can run more copies of us.
+	argv0 = argv[0];
 	
 	for(i=0; i<nelem(cmdtab); i++) {
 		if(streq(cmdtab[i].name, argv[1])) {
@@ -91,7 +91,7 @@ xgetenv(Buf *b, char *name)
 		bwritestr(b, p);
 }
 
-static void genrun(Buf *b, char *dir, int mode, Vec *argv, int bg);
+static int genrun(Buf *b, char *dir, int mode, Vec *argv, int bg);
 
 // run runs the command named by cmd.
 // If b is not nil, run replaces b with the output of the command.
@@ -124,31 +124,48 @@ runv(Buf *b, char *dir, int mode, Vec *argv)
 }
 
 // bgrunv is like run but runs the command in the background.
+// It returns the job's number: bgrunv numbers the jobs it starts
+// 0, 1, 2, and so on.
 // bgwait waits for pending bgrunv to finish.
-void
+// bgwaitany waits for one of them and returns its number.
+int
 bgrunv(char *dir, int mode, Vec *argv)
 {
-	genrun(nil, dir, mode, argv, 0);
+	return genrun(nil, dir, mode, argv, 0);
 }
 
-#define MAXBG 4 /* maximum number of jobs to run at once */
+#define MAXBG 64 /* maximum number of jobs to run at once */
 
 static struct {
 	int pid;
 	int mode;
+	int id;
 	char *cmd;
 	Buf *b;
 } bg[MAXBG];
 static int nbg;
-static int maxnbg = nelem(bg);
+static int nbgid;
+static int maxnbg = 4;
 
-static void bgwait1(void);
+static int bgwait1(void);
+
+// bgsetmax sets the maximum number of background jobs
+// to run at once.
+void
+bgsetmax(int n)
+{
+	if(n < 1)
+		n = 1;
+	if(n > nelem(bg))
+		n = nelem(bg);
+	maxnbg = n;
+}
 
 // genrun is the generic run implementation.
-static void
+static int
 genrun(Buf *b, char *dir, int mode, Vec *argv, int wait)
 {
-	int i, p[2], pid;
+	int i, id, p[2], pid;
 	Buf b1, cmd;
 	char *q;
 
@@ -219,6 +236,10 @@ genrun(Buf *b, char *dir, int mode, Vec *argv, int wait)
 		fatal("bad bookkeeping");
 	bg[nbg].pid = pid;
 	bg[nbg].mode = mode;
+	id = -1;
+	if(!wait)
+		id = nbgid++;
+	bg[nbg].id = id;
 	bg[nbg].cmd = btake(&cmd);
 	bg[nbg].b = b;
 	nbg++;
@@ -228,14 +249,16 @@ genrun(Buf *b, char *dir, int mode, Vec *argv, int wait)
 
 	bfree(&cmd);
 	bfree(&b1);
+	return id;
 }
 
-// bgwait1 waits for a single background job.
-static void
+// bgwait1 waits for a single background job
+// and returns its number.
+static int
 bgwait1(void)
 {
 	Waitmsg *w;
-	int i, mode;
+	int i, id, mode;
 	char *cmd;
 	Buf *b;
 
@@ -251,6 +274,7 @@ bgwait1(void)
 ok:
 	cmd = bg[i].cmd;
 	mode = bg[i].mode;
+	id = bg[i].id;
 	bg[i].pid = 0;
 	b = bg[i].b;
 	bg[i].b = nil;
@@ -262,6 +286,7 @@ ok:
 		fatal("FAILED: %s", cmd);
 	}
 	xfree(cmd);
+	return id;
 }
 
 // bgwait waits for all the background jobs.
@@ -272,6 +297,16 @@ bgwait(void)
 		bgwait1();
 }
 
+// bgwaitany waits for one of the background jobs
+// and returns its number.
+int
+bgwaitany(void)
+{
+	if(nbg == 0)
+		fatal("bgwaitany: no background jobs");
+	return bgwait1();
+}
+
 // xgetwd replaces b with the current directory.
 void
 xgetwd(Buf *b)
@@ -396,7 +431,8 @@ xmkdir(char *p)
 		return;
 	fd = create(p, OREAD, 0777|DMDIR);
 	close(fd);
-	if(fd < 0)
+	// A parallel bootstrap may be creating p concurrently.
+	if(fd < 0 && !isdir(p))
 		fatal("mkdir %s", p);
 }
 
@@ -703,6 +739,29 @@ main(int argc, char **argv)
 	exits(nil);
 }
 
+// xnow returns the current time in nanoseconds.
+Time
+xnow(void)
+{
+	return nsec();
+}
+
+// xncpu returns the number of CPUs, or 1 if it cannot tell.
+int
+xncpu(void)
+{
+	int n;
+	Buf b;
+
+	binit(&b);
+	xgetenv(&b, "NPROC");
+	n = atoi(bstr(&b));
+	bfree(&b);
+	if(n < 1)
+		return 1;
+	return n;
+}
+
 // xqsort is a wrapper for the C standard qsort.
 void
 xqsort(void *data, int n, int elemsize, int (*cmp)(const void*, const void*))
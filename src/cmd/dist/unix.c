@@ -14,6 +14,7 @@
 #include <unistd.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 #include <sys/param.h>
 #include <sys/utsname.h>
@@ -99,7 +100,7 @@ xgetenv(Buf *b, char *name)
 		bwritestr(b, p);
 }
 
-static void genrun(Buf *b, char *dir, int mode, Vec *argv, int bg);
+static int genrun(Buf *b, char *dir, int mode, Vec *argv, int bg);
 
 // run runs the command named by cmd.
 // If b is not nil, run replaces b with the output of the command.
@@ -132,31 +133,48 @@ runv(Buf *b, char *dir, int mode, Vec *argv)
 }
 
 // bgrunv is like run but runs the command in the background.
+// It returns the job's number: bgrunv numbers the jobs it starts
+// 0, 1, 2, and so on.
 // bgwait waits for pending bgrunv to finish.
-void
+// bgwaitany waits for one of them and returns its number.
+int
 bgrunv(char *dir, int mode, Vec *argv)
 {
-	genrun(nil, dir, mode, argv, 0);
+	return genrun(nil, dir, mode, argv, 0);
 }
 
-#define MAXBG 4 /* maximum number of jobs to run at once */
+#define MAXBG 64 /* maximum number of jobs to run at once */
 
 static struct {
 	int pid;
 	int mode;
+	int id;
 	char *cmd;
 	Buf *b;
 } bg[MAXBG];
 static int nbg;
-static int maxnbg = nelem(bg);
+static int nbgid;
+static int maxnbg = 4;
+
+static int bgwait1(void);
 
-static void bgwait1(void);
+// bgsetmax sets the maximum number of background jobs
+// to run at once.
+void
+bgsetmax(int n)
+{
+	if(n < 1)
+		n = 1;
+	if(n > nelem(bg))
+		n = nelem(bg);
+	maxnbg = n;
+}
 
 // genrun is the generic run implementation.
-static void
+static int
 genrun(Buf *b, char *dir, int mode, Vec *argv, int wait)
 {
-	int i, p[2], pid;
+	int i, id, p[2], pid;
 	Buf cmd;
 	char *q;
 
@@ -219,6 +237,10 @@ genrun(Buf *b, char *dir, int mode, Vec *argv, int wait)
 		fatal("bad bookkeeping");
 	bg[nbg].pid = pid;
 	bg[nbg].mode = mode;
+	id = -1;
+	if(!wait)
+		id = nbgid++;
+	bg[nbg].id = id;
 	bg[nbg].cmd = btake(&cmd);
 	bg[nbg].b = b;
 	nbg++;
@@ -227,13 +249,15 @@ genrun(Buf *b, char *dir, int mode, Vec *argv, int wait)
 		bgwait();
 
 	bfree(&cmd);
+	return id;
 }
 
-// bgwait1 waits for a single background job.
-static void
+// bgwait1 waits for a single background job
+// and returns its number.
+static int
 bgwait1(void)
 {
-	int i, pid, status, mode;
+	int i, id, pid, status, mode;
 	char *cmd;
 	Buf *b;
 
@@ -250,6 +274,7 @@ bgwait1(void)
 ok:
 	cmd = bg[i].cmd;
 	mode = bg[i].mode;
+	id = bg[i].id;
 	bg[i].pid = 0;
 	b = bg[i].b;
 	bg[i].b = nil;
@@ -261,6 +286,7 @@ ok:
 		fatal("FAILED: %s", cmd);
 	}
 	xfree(cmd);
+	return id;
 }
 
 // bgwait waits for all the background jobs.
@@ -271,6 +297,16 @@ bgwait(void)
 		bgwait1();
 }
 
+// bgwaitany waits for one of the background jobs
+// and returns its number.
+int
+bgwaitany(void)
+{
+	if(nbg == 0)
+		fatal("bgwaitany: no background jobs");
+	return bgwait1();
+}
+
 // xgetwd replaces b with the current directory.
 void
 xgetwd(Buf *b)
@@ -330,6 +366,31 @@ mtime(char *p)
 	return (Time)st.st_mtime*1000000000LL;
 }
 
+// xnow returns the current time in nanoseconds.
+Time
+xnow(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, nil);
+	return (Time)tv.tv_sec*1000000000LL + (Time)tv.tv_usec*1000;
+}
+
+// xncpu returns the number of CPUs, or 1 if it cannot tell.
+int
+xncpu(void)
+{
+	long n;
+
+	n = -1;
+#ifdef _SC_NPROCESSORS_ONLN
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if(n < 1)
+		return 1;
+	return n;
+}
+
 // isabs reports whether p is an absolute path.
 bool
 isabs(char *p)
@@ -390,7 +451,9 @@ xmkdirall(char *p)
 		xmkdirall(p);
 		*q = '/';
 	}
-	xmkdir(p);
+	// A parallel bootstrap may be creating p concurrently.
+	if(mkdir(p, 0777) < 0 && !isdir(p))
+		fatal("mkdir %s: %s", p, strerror(errno));
 }
 
 // xremove removes the file p.
@@ -680,7 +743,7 @@ main(int argc, char **argv)
 	}
 
 	if(strcmp(gohostarch, "arm") == 0)
-		maxnbg = 1;
+		bgsetmax(1);
 
 	init();
 	xmain(argc, argv);
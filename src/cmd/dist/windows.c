@@ -242,7 +242,7 @@ run(Buf *b, char *dir, int mode, char *cmd, ...)
 	vfree(&argv);
 }
 
-static void genrun(Buf*, char*, int, Vec*, int);
+static int genrun(Buf*, char*, int, Vec*, int);
 
 void
 runv(Buf *b, char *dir, int mode, Vec *argv)
@@ -250,28 +250,41 @@ runv(Buf *b, char *dir, int mode, Vec *argv)
 	genrun(b, dir, mode, argv, 1);
 }
 
-void
+int
 bgrunv(char *dir, int mode, Vec *argv)
 {
-	genrun(nil, dir, mode, argv, 0);
+	return genrun(nil, dir, mode, argv, 0);
 }
 
-#define MAXBG 4 /* maximum number of jobs to run at once */
+#define MAXBG MAXIMUM_WAIT_OBJECTS /* maximum number of jobs to run at once */
 
 static struct {
 	PROCESS_INFORMATION pi;
 	int mode;
+	int id;
 	char *cmd;
 } bg[MAXBG];
 
 static int nbg;
+static int nbgid;
+static int maxnbg = 4;
 
-static void bgwait1(void);
+static int bgwait1(void);
 
-static void
+void
+bgsetmax(int n)
+{
+	if(n < 1)
+		n = 1;
+	if(n > nelem(bg))
+		n = nelem(bg);
+	maxnbg = n;
+}
+
+static int
 genrun(Buf *b, char *dir, int mode, Vec *argv, int wait)
 {
-	int i, j, nslash;
+	int i, j, id, nslash;
 	Buf cmd;
 	char *q;
 	Rune *rcmd, *rexe, *rdir;
@@ -279,7 +292,7 @@ genrun(Buf *b, char *dir, int mode, Vec *argv, int wait)
 	PROCESS_INFORMATION pi;
 	HANDLE p[2];
 
-	while(nbg >= nelem(bg))
+	while(nbg >= maxnbg)
 		bgwait1();
 
 	binit(&cmd);
@@ -346,7 +359,7 @@ genrun(Buf *b, char *dir, int mode, Vec *argv, int wait)
 
 	if(!CreateProcessW(rexe, rcmd, nil, nil, TRUE, 0, nil, rdir, &si, &pi)) {
 		if(mode!=CheckExit)
-			return;
+			return -1;
 		fatal("%s: %s", argv->p[0], errstr());
 	}
 	if(rexe != nil)
@@ -364,6 +377,10 @@ genrun(Buf *b, char *dir, int mode, Vec *argv, int wait)
 		fatal("bad bookkeeping");
 	bg[nbg].pi = pi;
 	bg[nbg].mode = mode;
+	id = -1;
+	if(!wait)
+		id = nbgid++;
+	bg[nbg].id = id;
 	bg[nbg].cmd = btake(&cmd);
 	nbg++;
 
@@ -371,6 +388,7 @@ genrun(Buf *b, char *dir, int mode, Vec *argv, int wait)
 		bgwait();
 
 	bfree(&cmd);
+	return id;
 }
 
 // closes the background job for bgwait1
@@ -387,10 +405,11 @@ bgwaitclose(int i)
 }
 
 // bgwait1 waits for a single background job
-static void
+// and returns its number
+static int
 bgwait1(void)
 {
-	int i, mode;
+	int i, id, mode;
 	char *cmd;
 	HANDLE bgh[MAXBG];
 	DWORD code;
@@ -406,19 +425,21 @@ bgwait1(void)
 
 	cmd = bg[i].cmd;
 	mode = bg[i].mode;
+	id = bg[i].id;
 	if(!GetExitCodeProcess(bg[i].pi.hProcess, &code)) {
 		bgwaitclose(i);
 		fatal("GetExitCodeProcess: %s", errstr());
-		return;
+		return -1;
 	}
 
 	if(mode==CheckExit && code != 0) {
 		bgwaitclose(i);
 		fatal("FAILED: %s", cmd);
-		return;
+		return -1;
 	}
 
 	bgwaitclose(i);
+	return id;
 }
 
 void
@@ -428,6 +449,14 @@ bgwait(void)
 		bgwait1();
 }
 
+int
+bgwaitany(void)
+{
+	if(nbg == 0)
+		fatal("bgwaitany: no background jobs");
+	return bgwait1();
+}
+
 // rgetwd returns a rune string form of the current directory's path.
 static Rune*
 rgetwd(void)
@@ -514,6 +543,26 @@ mtime(char *p)
 	return (Time)ft->dwLowDateTime + ((Time)ft->dwHighDateTime<<32);
 }
 
+Time
+xnow(void)
+{
+	FILETIME ft;
+
+	GetSystemTimeAsFileTime(&ft);
+	return ((Time)ft.dwLowDateTime + ((Time)ft.dwHighDateTime<<32))*100;
+}
+
+int
+xncpu(void)
+{
+	SYSTEM_INFO si;
+
+	GetSystemInfo(&si);
+	if(si.dwNumberOfProcessors < 1)
+		return 1;
+	return si.dwNumberOfProcessors;
+}
+
 bool
 isabs(char *p)
 {
@@ -568,7 +617,8 @@ xmkdir(char *p)
 	Rune *r;
 
 	torune(&r, p);
-	if(!CreateDirectoryW(r, nil))
+	// A parallel bootstrap may be creating p concurrently.
+	if(!CreateDirectoryW(r, nil) && !isdir(p))
 		fatal("mkdir %s: %s", p, errstr());
 	xfree(r);
 }
@@ -0,0 +1,504 @@
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Check elimination.
+//
+// Runs on the walked body of each function and marks index
+// expressions that cannot be out of range (OINDEX ->bounded) and
+// pointer dereferences that cannot be nil (ODOTPTR, OIND ->nonnil),
+// so that the back ends omit the explicit checks.
+//
+// Bounds: a loop
+//
+//	for i := k; i < len(x); i++ { ... x[i] ... }	// k >= 0
+//	for i := len(x)-k; i >= 0; i-- { ... x[i] ... }	// k >= 1
+//
+// in which neither i nor x is assigned keeps i in range for x
+// throughout the body.  The same holds for range loops, which walk
+// has lowered to the first form with a hidden index and length,
+// for copies of i made at the top of the body (the range variable),
+// and for fixed arrays when the bound is a constant.  The variables
+// must be locals whose address is not taken, so that only the
+// assignments in the loop can change them.
+//
+// Nil: a statement that dereferences a pointer variable faults if it
+// is nil, so the statements after it in the same block can skip the
+// explicit test that large offsets need, until the variable is
+// assigned again.  Labels start over, and a loop starts with what is
+// known before it minus what the loop assigns.
+//
+// The -C flag reports each eliminated check.
+
+#include <u.h>
+#include <libc.h>
+#include "go.h"
+
+enum
+{
+	Nnil = 32,
+};
+
+typedef	struct	Nilset	Nilset;
+struct	Nilset
+{
+	int	n;
+	Node*	v[Nnil];
+};
+
+static int
+islocal(Node *n)
+{
+	if(n == N || n->op != ONAME || n->addrtaken)
+		return 0;
+	return n->class == PAUTO || n->class == PPARAM;
+}
+
+static int nassignlist(NodeList*, Node*);
+
+// Count the statements in n that might assign v.
+static int
+nassign(Node *n, Node *v)
+{
+	int c;
+	NodeList *l;
+
+	if(n == N)
+		return 0;
+	c = 0;
+	switch(n->op) {
+	case OAS:
+	case OASOP:
+	case OADDR:
+	case ODCL:
+		if(n->left == v)
+			c++;
+		break;
+	case OAS2:
+	case OAS2FUNC:
+	case OAS2RECV:
+	case OAS2MAPR:
+	case OAS2DOTTYPE:
+	case ORANGE:
+		for(l=n->list; l; l=l->next)
+			if(l->n == v)
+				c++;
+		break;
+	}
+	return c +
+		nassign(n->left, v) +
+		nassign(n->right, v) +
+		nassignlist(n->list, v) +
+		nassignlist(n->rlist, v) +
+		nassignlist(n->ninit, v) +
+		nassign(n->ntest, v) +
+		nassign(n->nincr, v) +
+		nassignlist(n->nbody, v) +
+		nassignlist(n->nelse, v);
+}
+
+static int
+nassignlist(NodeList *l, Node *v)
+{
+	int c;
+
+	c = 0;
+	for(; l; l=l->next)
+		c += nassign(l->n, v);
+	return c;
+}
+
+static int
+intconst(Node *n, int64 *v)
+{
+	if(n == N || !smallintconst(n))
+		return 0;
+	*v = mpgetfix(n->val.u.xval);
+	return 1;
+}
+
+// Find the assignment that initializes iv before the loop n:
+// the last one in n's init list, or else the statement before n.
+static Node*
+findinit(Node *n, Node *prev, Node *iv, NodeList **rest)
+{
+	NodeList *l;
+	Node *init;
+
+	init = N;
+	*rest = nil;
+	for(l=n->ninit; l; l=l->next) {
+		if(l->n->op == OAS && l->n->left == iv) {
+			init = l->n;
+			*rest = l->next;
+		}
+	}
+	if(init == N && prev != N && prev->op == OAS && prev->left == iv)
+		init = prev;
+	return init;
+}
+
+// Loop facts: the variables iv are in [0, c) if c >= 0,
+// and in range for the variables x.
+typedef	struct	Bound	Bound;
+struct	Bound
+{
+	Node*	iv[8];
+	int	niv;
+	Node*	x[2];
+	int	nx;
+	int64	c;
+};
+
+static int
+inlist(Node **v, int n, Node *x)
+{
+	int i;
+
+	for(i=0; i<n; i++)
+		if(v[i] == x)
+			return 1;
+	return 0;
+}
+
+static void
+markindex(Node *n, Bound *b)
+{
+	NodeList *l;
+	Type *t;
+
+	if(n == N || n->op == OCLOSURE)
+		return;
+	if(n->op == OINDEX && !n->bounded && inlist(b->iv, b->niv, n->right)) {
+		t = n->left->type;
+		if(t != T && isptr[t->etype])
+			t = t->type;
+		if(inlist(b->x, b->nx, n->left) || (b->c >= 0 && isfixedarray(t) && t->bound >= b->c)) {
+			n->bounded = 1;
+			if(debug['C'])
+				warnl(n->lineno, "index bounds check eliminated");
+		}
+	}
+	markindex(n->left, b);
+	markindex(n->right, b);
+	for(l=n->list; l; l=l->next)
+		markindex(l->n, b);
+	for(l=n->rlist; l; l=l->next)
+		markindex(l->n, b);
+	for(l=n->ninit; l; l=l->next)
+		markindex(l->n, b);
+	markindex(n->ntest, b);
+	markindex(n->nincr, b);
+	for(l=n->nbody; l; l=l->next)
+		markindex(l->n, b);
+	for(l=n->nelse; l; l=l->next)
+		markindex(l->n, b);
+}
+
+// Record in b the variables assigned a copy of b->iv[0] by the
+// statements at the top of the loop body, before anything else
+// can have used them.  Returns 0 at the first other statement.
+static int
+aliases(NodeList *l, NodeList *body, Bound *b)
+{
+	NodeList *ll, *rl;
+	Node *r;
+
+	for(; l && b->niv < nelem(b->iv); l=l->next) {
+		r = l->n;
+		switch(r->op) {
+		case OBLOCK:
+			if(!aliases(r->list, body, b))
+				return 0;
+			continue;
+		case OAS:
+			if(r->right == b->iv[0] && islocal(r->left) && nassignlist(body, r->left) == 1) {
+				b->iv[b->niv++] = r->left;
+				continue;
+			}
+			// the range value temporary, v = *hp
+			if(islocal(r->left) && r->right != N && r->right->op == OIND && r->right->left->op == ONAME)
+				continue;
+			return 0;
+		case OAS2:
+			rl = r->rlist;
+			for(ll=r->list; ll && rl && b->niv < nelem(b->iv); ll=ll->next, rl=rl->next)
+				if(rl->n == b->iv[0] && islocal(ll->n) && nassignlist(body, ll->n) == 1)
+					b->iv[b->niv++] = ll->n;
+			continue;
+		}
+		return 0;
+	}
+	return 1;
+}
+
+static void
+bcefor(Node *n, Node *prev)
+{
+	Node *t, *incr, *init, *iv, *b, *x, *r;
+	NodeList *l, *rest;
+	int64 c, v;
+	Bound bd;
+
+	t = n->ntest;
+	incr = n->nincr;
+	if(t == N || incr == N)
+		return;
+	if(incr->op == OBLOCK && incr->list != nil && incr->list->next == nil)
+		incr = incr->list->n;
+	if(incr->op != OASOP || !islocal(incr->left) || incr->left->type->etype != TINT)
+		return;
+	if(!intconst(incr->right, &v) || v != 1)
+		return;
+	iv = incr->left;
+	init = findinit(n, prev, iv, &rest);
+	if(init == N)
+		return;
+
+	x = N;
+	c = -1;
+	switch(incr->etype) {
+	default:
+		return;
+
+	case OADD:
+		// for i := k; i < len(x); i++
+		if(t->op != OLT || t->left != iv)
+			return;
+		if(init->right != N && (!intconst(init->right, &v) || v < 0))
+			return;
+		b = t->right;
+		if(islocal(b)) {
+			// range loop: hidden length set in the init list
+			r = N;
+			for(l=n->ninit; l; l=l->next)
+				if(l->n->op == OAS && l->n->left == b)
+					r = l->n->right;
+			if(r == N || nassignlist(n->nbody, b))
+				return;
+			b = r;
+		}
+		if(b->op == OLEN && islocal(b->left))
+			x = b->left;
+		else if(!intconst(b, &c))
+			return;
+		break;
+
+	case OSUB:
+		// for i := len(x)-k; i >= 0; i--
+		if(t->op != OGE || t->left != iv || !intconst(t->right, &v) || v != 0)
+			return;
+		r = init->right;
+		if(r == N)
+			c = 1;
+		else if(intconst(r, &v))
+			c = v+1;
+		else if(r->op == OSUB && r->left->op == OLEN && islocal(r->left->left) &&
+			intconst(r->right, &v) && v >= 1 && !nassignlist(rest, r->left->left))
+			x = r->left->left;
+		else
+			return;
+		break;
+	}
+	if(nassignlist(n->nbody, iv))
+		return;
+	if(x != N && (nassignlist(n->nbody, x) || nassign(n->ntest, x) || nassign(n->nincr, x)))
+		return;
+
+	bd.c = c;
+	bd.nx = 0;
+	if(x != N) {
+		bd.x[bd.nx++] = x;
+		// range loop: x may be a hidden copy of the ranged slice y.
+		for(l=n->ninit; l; l=l->next) {
+			r = l->n;
+			if(r->op == OAS && r->left == x && islocal(r->right) &&
+			   nassignlist(l->next, r->right) == 0 && nassignlist(n->nbody, r->right) == 0)
+				bd.x[bd.nx++] = r->right;
+		}
+	}
+
+	// copies of i at the top of the body, like the range variable.
+	bd.iv[0] = iv;
+	bd.niv = 1;
+	aliases(n->nbody, n->nbody, &bd);
+
+	for(l=n->nbody; l; l=l->next)
+		markindex(l->n, &bd);
+}
+
+static void
+bcelist(NodeList *l)
+{
+	Node *n, *prev;
+
+	prev = N;
+	for(; l; l=l->next) {
+		n = l->n;
+		if(n == N)
+			continue;
+		bcelist(n->ninit);
+		if(n->op == OFOR)
+			bcefor(n, prev);
+		bcelist(n->list);
+		bcelist(n->nbody);
+		bcelist(n->nelse);
+		prev = n;
+	}
+}
+
+static void
+nilkill(Nilset *s, Node *n)
+{
+	int i;
+
+	for(i=0; i<s->n; )
+		if(nassign(n, s->v[i]))
+			s->v[i] = s->v[--s->n];
+		else
+			i++;
+}
+
+static void
+niladd(Nilset *s, Node *v)
+{
+	int i;
+
+	for(i=0; i<s->n; i++)
+		if(s->v[i] == v)
+			return;
+	if(s->n < Nnil)
+		s->v[s->n++] = v;
+}
+
+static int
+nilknown(Nilset *s, Node *v)
+{
+	int i;
+
+	for(i=0; i<s->n; i++)
+		if(s->v[i] == v)
+			return 1;
+	return 0;
+}
+
+// Mark the dereferences in n of variables known not to be nil.
+static void
+nilmark(Node *n, Nilset *s)
+{
+	NodeList *l;
+
+	if(n == N || n->op == OCLOSURE)
+		return;
+	if((n->op == ODOTPTR || n->op == OIND) && !n->nonnil && nilknown(s, n->left))
+		n->nonnil = 1;
+	nilmark(n->left, s);
+	nilmark(n->right, s);
+	for(l=n->list; l; l=l->next)
+		nilmark(l->n, s);
+	for(l=n->rlist; l; l=l->next)
+		nilmark(l->n, s);
+}
+
+// Add to s the variables that evaluating n always dereferences.
+static void
+nilgen(Node *n, Nilset *s)
+{
+	NodeList *l;
+
+	if(n == N)
+		return;
+	switch(n->op) {
+	case OCLOSURE:
+	case OADDR:	// &p.x computes an address without loading it
+		return;
+	case OANDAND:
+	case OOROR:
+		nilgen(n->left, s);
+		return;
+	case ODOTPTR:
+	case OIND:
+		if(islocal(n->left))
+			niladd(s, n->left);
+		break;
+	}
+	nilgen(n->left, s);
+	nilgen(n->right, s);
+	for(l=n->list; l; l=l->next)
+		nilgen(l->n, s);
+	for(l=n->rlist; l; l=l->next)
+		nilgen(l->n, s);
+}
+
+static Nilset nillist(NodeList *l, Nilset s);
+
+static Nilset
+nilstmt(Node *n, Nilset s)
+{
+	Nilset t;
+
+	s = nillist(n->ninit, s);
+	switch(n->op) {
+	case OLABEL:
+		s.n = 0;
+		break;
+
+	case OBLOCK:
+		s = nillist(n->list, s);
+		break;
+
+	case OIF:
+		nilmark(n->ntest, &s);
+		nilgen(n->ntest, &s);
+		nillist(n->nbody, s);
+		nillist(n->nelse, s);
+		nilkill(&s, n);
+		break;
+
+	case OFOR:
+		nilkill(&s, n);
+		nilmark(n->ntest, &s);
+		t = s;
+		nilgen(n->ntest, &t);
+		nillist(n->nbody, t);
+		nilmark(n->nincr, &t);	// continue skips the rest of the body
+		break;
+
+	case OSWITCH:
+	case OSELECT:
+	case OCASE:
+	case OXCASE:
+		nilkill(&s, n);
+		nilmark(n->ntest, &s);
+		nilmark(n->left, &s);
+		nillist(n->list, s);
+		nillist(n->nbody, s);
+		break;
+
+	default:
+		nilmark(n, &s);
+		nilgen(n, &s);
+		nilkill(&s, n);
+		break;
+	}
+	return s;
+}
+
+static Nilset
+nillist(NodeList *l, Nilset s)
+{
+	for(; l; l=l->next)
+		if(l->n != N)
+			s = nilstmt(l->n, s);
+	return s;
+}
+
+void
+bce(Node *fn)
+{
+	Nilset s;
+
+	bcelist(fn->nbody);
+	s.n = 0;
+	nillist(fn->nbody, s);
+}
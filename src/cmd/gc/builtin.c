@@ -7,6 +7,7 @@ char *runtimeimport =
 	"func @\"\".throwreturn()\n"
 	"func @\"\".throwinit()\n"
 	"func @\"\".panicwrap(? string, ? string, ? string)\n"
+	"func @\"\".coverregister(@\"\".counts []uint32, @\"\".pos string)\n"
 	"func @\"\".panic(? interface {})\n"
 	"func @\"\".recover(? *int32) (? interface {})\n"
 	"func @\"\".printbool(? bool)\n"
@@ -0,0 +1,277 @@
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+/*
+ * coverage counters (-c).
+ *
+ * before inlining, the statement lists of every function
+ * are split into basic blocks: a block ends after any
+ * statement that can transfer control and a new one begins
+ * at each label.  at the start of each block goes
+ *	cover·count[i] = 1
+ * where cover·count is a package-level [n]uint32,
+ * or with -c -c, to count the executions,
+ *	cover·count[i]++
+ * the store is cheaper: an increment in a tight loop
+ * waits on the previous iteration's increment.
+ * the init function registers the counters with the runtime,
+ * along with a string giving the source lines of each block:
+ *	runtime.coverregister(cover·count[:], "file:line,line\n...")
+ * testing writes them out for go tool cov -p.
+ *
+ * the increments are plain, not atomic: a lost update
+ * in a race does not change whether a block ran.
+ * the updates do not count against the inlining budget.
+ * files named *_test.go are not instrumented.
+ */
+
+#include	<u.h>
+#include	<libc.h>
+#include	"go.h"
+
+typedef struct Site Site;
+struct Site
+{
+	NodeList**	list;	// insert at the head of *list
+	NodeList*	after;	// or after this element
+	int32	lno;	// first and last line of block
+	int32	elno;
+};
+
+static	Site*	site;
+static	int	nsite;
+static	int	msite;
+static	Node*	counter;
+static	Fmt	posfmt;
+
+static	Site*	coverlist(NodeList**, int32, Site*);
+
+// file and line of lno, with the file name made absolute.
+static int
+coverline(int32 lno, char *file, int nfile)
+{
+	char buf[1024], *p;
+
+	snprint(buf, sizeof buf, "%L", lno);
+	// a //line directive shows as "line[file:line]"
+	if((p = strchr(buf, '[')) != nil)
+		*p = 0;
+	if((p = strrchr(buf, ':')) == nil)
+		return 0;
+	*p++ = 0;
+	if(buf[0] == '/' || (windows && buf[0] != 0 && buf[1] == ':'))
+		snprint(file, nfile, "%s", buf);
+	else
+		snprint(file, nfile, "%s/%s", pathname, buf);
+	return atoi(p);
+}
+
+static int
+istestfile(int32 lno)
+{
+	char file[1024];
+	int n;
+
+	coverline(lno, file, sizeof file);
+	n = strlen(file);
+	return n >= 8 && strcmp(file+n-8, "_test.go") == 0;
+}
+
+// record a block starting at the head of *lp or after the element after.
+static Site*
+newsite(NodeList **lp, NodeList *after, int32 lno)
+{
+	Site *s;
+
+	if(nsite >= msite) {
+		msite = msite*2 + 64;
+		site = realloc(site, msite*sizeof site[0]);
+		if(site == nil)
+			fatal("out of memory");
+	}
+	s = &site[nsite++];
+	s->list = lp;
+	s->after = after;
+	s->lno = lno;
+	s->elno = lno;
+	return s;
+}
+
+// can control leave the statement other than by falling
+// through to the next one?
+static int
+endsblock(Node *n)
+{
+	switch(n->op) {
+	case OIF:
+	case OFOR:
+	case ORANGE:
+	case OSWITCH:
+	case OSELECT:
+	case OGOTO:
+	case OBREAK:
+	case OCONTINUE:
+	case ORETURN:
+	case OFALL:
+	case OXFALL:
+	case OPANIC:
+		return 1;
+	}
+	return 0;
+}
+
+// the statement lists nested in n, each starting new blocks.
+static void
+coverstmt(Node *n)
+{
+	NodeList *l;
+
+	switch(n->op) {
+	case OIF:
+		coverlist(&n->nbody, n->lineno, nil);
+		if(n->nelse != nil)
+			coverlist(&n->nelse, n->lineno, nil);
+		break;
+	case OFOR:
+	case ORANGE:
+		coverlist(&n->nbody, n->lineno, nil);
+		break;
+	case OSWITCH:
+	case OSELECT:
+		for(l=n->list; l; l=l->next)
+			coverlist(&l->n->nbody, l->n->lineno, nil);
+		break;
+	}
+}
+
+// split the statements in *lp into blocks, continuing
+// the open block s, if any.  an empty list that does not
+// continue a block gets one of its own, at line lno.
+// returns the block still open at the end of the list.
+static Site*
+coverlist(NodeList **lp, int32 lno, Site *s)
+{
+	NodeList *l, *prev;
+	Node *n;
+
+	if(*lp == nil) {
+		if(s == nil)
+			newsite(lp, nil, lno);
+		return s;
+	}
+	prev = nil;
+	for(l=*lp; l; prev=l, l=l->next) {
+		n = l->n;
+		if(n->op == OLABEL) {
+			// count after the label, so that gotos count too.
+			// loops find their labels through defn, not position.
+			s = newsite(lp, l, n->lineno);
+			continue;
+		}
+		if(n->op == OBLOCK) {
+			// a plain { } block does not transfer control.
+			s = coverlist(&n->list, n->lineno, s);
+			continue;
+		}
+		if(s == nil)
+			s = newsite(lp, prev, n->lineno);
+		if(n->lineno > s->elno)
+			s->elno = n->lineno;
+		coverstmt(n);
+		if(endsblock(n))
+			s = nil;
+	}
+	return s;
+}
+
+void
+cover(NodeList *all)
+{
+	NodeList *l, *nl;
+	Node *n, *inc;
+	Site *s;
+	Type *t;
+	char file[1024];
+	int i, line, eline;
+
+	for(l=all; l; l=l->next) {
+		n = l->n;
+		if(n->op != ODCLFUNC || n->nbody == nil || istestfile(n->lineno))
+			continue;
+		coverlist(&n->nbody, n->lineno, nil);
+	}
+	if(nsite == 0)
+		return;
+
+	t = typ(TARRAY);
+	t->type = types[TUINT32];
+	t->bound = nsite;
+	counter = newname(lookup("cover·count"));
+	addvar(counter, t, PEXTERN);
+
+	fmtstrinit(&posfmt);
+	for(i=0; i<nsite; i++) {
+		s = &site[i];
+		line = coverline(s->lno, file, sizeof file);
+		eline = coverline(s->elno, file, sizeof file);
+		if(eline < line)
+			eline = line;
+		fmtprint(&posfmt, "%s:%d,%d\n", file, line, eline);
+
+		inc = nod(OINDEX, counter, nodintconst(i));
+		inc->bounded = 1;
+		if(debug['c'] > 1) {
+			inc = nod(OASOP, inc, nodintconst(1));
+			inc->etype = OADD;
+		} else
+			inc = nod(OAS, inc, nodintconst(1));
+		inc->lineno = s->lno;
+		typecheck(&inc, Etop);
+
+		nl = list1(inc);
+		if(s->after != nil) {
+			nl->next = s->after->next;
+			s->after->next = nl;
+			if((*s->list)->end == s->after)
+				(*s->list)->end = nl;
+		} else
+			*s->list = concat(nl, *s->list);
+	}
+}
+
+/*
+ * is n a counter update inserted by cover,
+ * here or in an imported inlinable body?
+ */
+int
+iscovercount(Node *n)
+{
+	if(n->op != OAS && n->op != OASOP)
+		return 0;
+	n = n->left;
+	if(n == N || n->op != OINDEX || n->left == N || n->left->sym == S)
+		return 0;
+	return strcmp(n->left->sym->name, "cover·count") == 0;
+}
+
+/*
+ * the call registering the counters, for the init function;
+ * N if there are none.
+ */
+Node*
+coverinit(void)
+{
+	Node *fn, *a;
+	Val v;
+
+	if(counter == N)
+		return N;
+	fn = syslook("coverregister", 0);
+	a = nod(OSLICE, counter, nod(OKEY, N, N));
+	v.ctype = CTSTR;
+	v.u.sval = strlit(fmtstrflush(&posfmt));
+	fn = nod(OCALL, fn, N);
+	fn->list = list(list1(a), nodlit(v));
+	return fn;
+}
@@ -170,6 +170,9 @@ declare(Node *n, int ctxt)
 	int gen;
 	static int typegen, vargen;
 
+	if(ctxt == PDISCARD)
+		return;
+
 	if(isblank(n))
 		return;
 
@@ -549,6 +552,13 @@ funchdr(Node *n)
 	n->outer = curfn;
 	curfn = n;
 
+	// an imported inlinable func, whose body keeps the
+	// lines it had in its source; see getlinepragma.
+	if(impinlfile != nil && n->op == ONAME) {
+		n->inlfile = impinlfile;
+		n->inlline = impinlline;
+	}
+
 	if(n->nname)
 		funcargs(n->nname->ntype);
 	else if (n->ntype)
@@ -669,6 +679,10 @@ funcbody(Node *n)
 		fatal("funcbody: dclcontext");
 	popdcl();
 	funcdepth--;
+	if(n->inlfile != nil && impinlfile != nil) {
+		n->endlineno = lineno;
+		impinlfile = nil;
+	}
 	curfn = n->outer;
 	n->outer = N;
 	if(funcdepth == 0)
@@ -40,6 +40,15 @@ Flags:
 		and diagnose any attempt to import a package that depends on it.
 	-D path
 		treat a relative import as relative to path
+	-c
+		record which basic blocks run in a package-level array
+		that the init function registers with the runtime;
+		-c -c counts the executions instead.  go test -cover
+		uses -c, see go tool cov -p
+	-F file
+		use the profile feedback in file, written by go tool prof -F,
+		to inline more at hot call sites and to move code the
+		profile never reached out of the way of the hot path
 	-L
 		show entire file path when printing line numbers in errors
 	-I dir1 -I dir2
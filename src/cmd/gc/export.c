@@ -8,6 +8,11 @@
 #include	"y.tab.h"
 
 static void	dumpexporttype(Type *t);
+static void	expbegin(int kind, Sym *s, char *name);
+static void	expend(void);
+static void	expprint(char *fmt, ...);
+static void	deptype(Type *t);
+static void	deplist(NodeList *l);
 
 // Mark n's symbol as exported
 void
@@ -84,7 +89,9 @@ dumppkg(Pkg *p)
 	suffix = "";
 	if(!p->direct)
 		suffix = " // indirect";
-	Bprint(bout, "\timport %s \"%Z\"%s\n", p->name, p->path, suffix);
+	expbegin('i', S, smprint("\"%Z\"", p->path));
+	expprint("\timport %s \"%Z\"%s\n", p->name, p->path, suffix);
+	expend();
 }
 
 // Look for anything we need for the inline body
@@ -109,8 +116,9 @@ reexportdep(Node *n)
 	case ONAME:
 		switch(n->class&~PHEAP) {
 		case PFUNC:
-			// methods will be printed along with their type
-			if(!n->type || n->type->thistuple > 0)
+			// methods will be printed along with their type,
+			// which n->left is in a method expression T.m.
+			if(!n->type || n->type->thistuple > 0 || n->left && n->left->op == OTYPE)
 				break;
 			// fallthrough
 		case PEXTERN:
@@ -179,10 +187,42 @@ dumpexportconst(Sym *s)
 	t = n->type;	// may or may not be specified
 	dumpexporttype(t);
 
+	expbegin('c', s, nil);
+	deptype(t);
 	if(t != T && !isideal(t))
-		Bprint(bout, "\tconst %#S %#T = %#V\n", s, t, &n->val);
+		expprint("\tconst %#S %#T = %#V\n", s, t, &n->val);
 	else
-		Bprint(bout, "\tconst %#S = %#V\n", s, &n->val);
+		expprint("\tconst %#S = %#V\n", s, &n->val);
+	expend();
+}
+
+/*
+ * an inlinable body keeps the lines of its source: put the
+ * position of fn's header before it, for getlinepragma in
+ * the importer, and have Hconv put each statement on its line.
+ */
+static void
+expinlpos(Node *fn)
+{
+	char *file;
+	int32 line, end;
+
+	explineno = 0;
+	file = fn->inlfile;
+	line = fn->inlline;
+	end = fn->endlineno;
+	if(fn->defn != N) {
+		if(file == nil)
+			file = linefile(fn->lineno, &line);
+		end = fn->defn->endlineno;
+	}
+	if(file == nil || line <= 0 || end < fn->lineno)
+		return;
+	if(file[0] != '/' && file[1] != ':')
+		file = smprint("%s/%s", pathname, file);
+	Bprint(bout, "\t//line %s:%d\n", file, line);
+	explineno = fn->lineno;
+	explimit = end;
 }
 
 static void
@@ -202,17 +242,26 @@ dumpexportvar(Sym *s)
 	dumpexporttype(t);
 
 	if(t->etype == TFUNC && n->class == PFUNC) {
-		if (n->inl) {
+		expbegin('f', s, nil);
+		deptype(t);
+		if (n->inl && n->inlcost <= inlbudget) {
 			// when lazily typechecking inlined bodies, some re-exported ones may not have been typechecked yet.
 			// currently that can leave unresolved ONONAMEs in import-dot-ed packages in the wrong package
 			if(debug['l'] < 2)
 				typecheckinl(n);
-			Bprint(bout, "\tfunc %#S%#hT { %#H }\n", s, t, n->inl);
+			expinlpos(n);
+			expprint("\tfunc %#S%#hT { %#H }\n", s, t, n->inl);
+			explineno = 0;
+			deplist(n->inl);
 			reexportdeplist(n->inl);
 		} else
-			Bprint(bout, "\tfunc %#S%#hT\n", s, t);
-	} else
-		Bprint(bout, "\tvar %#S %#T\n", s, t);
+			expprint("\tfunc %#S%#hT\n", s, t);
+	} else {
+		expbegin('v', s, nil);
+		deptype(t);
+		expprint("\tvar %#S %#T\n", s, t);
+	}
+	expend();
 }
 
 static int
@@ -259,19 +308,27 @@ dumpexporttype(Type *t)
 		m[i++] = f;
 	qsort(m, n, sizeof m[0], methcmp);
 
-	Bprint(bout, "\ttype %#S %#lT\n", t->sym, t);
+	expbegin('t', t->sym, nil);
+	deptype(t->type);
+	deptype(t->down);
+	expprint("\ttype %#S %#lT\n", t->sym, t);
 	for(i=0; i<n; i++) {
 		f = m[i];
-		if (f->type->nname && f->type->nname->inl) { // nname was set by caninl
+		deptype(f->type);
+		if (f->type->nname && f->type->nname->inl && f->type->nname->inlcost <= inlbudget) { // nname was set by caninl
 			// when lazily typechecking inlined bodies, some re-exported ones may not have been typechecked yet.
 			// currently that can leave unresolved ONONAMEs in import-dot-ed packages in the wrong package
 			if(debug['l'] < 2)
 				typecheckinl(f->type->nname);
-			Bprint(bout, "\tfunc (%#T) %#hhS%#hT { %#H }\n", getthisx(f->type)->type, f->sym, f->type, f->type->nname->inl);
+			expinlpos(f->type->nname);
+			expprint("\tfunc (%#T) %#hhS%#hT { %#H }\n", getthisx(f->type)->type, f->sym, f->type, f->type->nname->inl);
+			explineno = 0;
+			deplist(f->type->nname->inl);
 			reexportdeplist(f->type->nname->inl);
 		} else
-			Bprint(bout, "\tfunc (%#T) %#hhS%#hT\n", getthisx(f->type)->type, f->sym, f->type);
+			expprint("\tfunc (%#T) %#hhS%#hT\n", getthisx(f->type)->type, f->sym, f->type);
 	}
+	expend();
 }
 
 static void
@@ -310,6 +367,244 @@ dumpsym(Sym *s)
 	}
 }
 
+/*
+ * export index.
+ *
+ * the exports are followed by an index of the declarations
+ * in them, so that an importer can parse only the declarations
+ * it refers to and the linker can check that the packages
+ * agree without parsing any of them.
+ *
+ *	$$  // index
+ *	version nent { kind name off len hash ndep { dep } }
+ *
+ * kind is one of 'i', 'c', 'v', 'f' and 't', for the import,
+ * const, var, func and type declarations; the methods of a type
+ * are part of its declaration.  name is the name as written in
+ * the declaration, or the quoted path of an import.  off and len
+ * give the declaration's place in the text that follows the
+ * package line, and hash is the 32-bit FNV-1a hash of that text.
+ * the deps are the entries for the names the declaration uses.
+ *
+ * numbers are unsigned varints and a string is its length and
+ * its bytes.  the index is written on a single line: the bytes
+ * 0, 1 and \n are written as 1 followed by the byte plus '@'.
+ */
+enum
+{
+	Indexversion	= 1,
+	Fnvoffset	= 2166136261U,
+	Fnvprime	= 16777619,
+};
+
+typedef	struct	Expent	Expent;
+struct	Expent
+{
+	int	kind;
+	char*	name;
+	Sym*	sym;
+	vlong	off;
+	vlong	len;
+	uint32	hash;
+	Sym**	dep;
+	int	ndep;
+	int	mdep;
+};
+
+static	Expent*	expent;
+static	int	nexpent;
+static	int	mexpent;
+static	int	curexp = -1;
+static	vlong	expbase;
+
+static void
+expbegin(int kind, Sym *s, char *name)
+{
+	Expent *e;
+
+	if(nexpent >= mexpent) {
+		mexpent = 2*mexpent + 64;
+		expent = realloc(expent, mexpent*sizeof expent[0]);
+		if(expent == nil)
+			fatal("out of memory");
+	}
+	curexp = nexpent++;
+	e = &expent[curexp];
+	memset(e, 0, sizeof *e);
+	e->kind = kind;
+	e->sym = s;
+	e->name = name;
+	if(name == nil)
+		e->name = smprint("%#S", s);
+	e->off = Boffset(bout) - expbase;
+	e->hash = Fnvoffset;
+}
+
+static void
+expend(void)
+{
+	Expent *e;
+
+	e = &expent[curexp];
+	e->len = Boffset(bout) - expbase - e->off;
+	curexp = -1;
+}
+
+// print to the export data, adding the text
+// to the hash of the current declaration.
+static void
+expprint(char *fmt, ...)
+{
+	va_list arg;
+	char *p;
+	uchar *q;
+	uint32 h;
+
+	va_start(arg, fmt);
+	p = vsmprint(fmt, arg);
+	va_end(arg);
+	if(p == nil)
+		fatal("out of memory");
+	if(curexp >= 0) {
+		// the newlines that keep the lines of an inlinable
+		// body do not change the declaration.
+		h = expent[curexp].hash;
+		for(q=(uchar*)p; *q; q++)
+			if(*q != '\n')
+				h = (h ^ *q) * Fnvprime;
+		expent[curexp].hash = h;
+	}
+	Bwrite(bout, p, strlen(p));
+	free(p);
+}
+
+static void
+expdep(Sym *s)
+{
+	Expent *e;
+	int i;
+
+	if(s == S || curexp < 0)
+		return;
+	e = &expent[curexp];
+	for(i=0; i<e->ndep; i++)
+		if(e->dep[i] == s)
+			return;
+	if(e->ndep >= e->mdep) {
+		e->mdep = 2*e->mdep + 8;
+		e->dep = realloc(e->dep, e->mdep*sizeof e->dep[0]);
+		if(e->dep == nil)
+			fatal("out of memory");
+	}
+	e->dep[e->ndep++] = s;
+}
+
+// the named types used by t.
+static void
+deptype(Type *t)
+{
+	for(; t != T; t = t->down) {
+		if(t->sym != S && t->etype != TFIELD) {
+			expdep(t->sym);
+			return;
+		}
+		if(t->trecur)
+			return;
+		t->trecur = 1;
+		deptype(t->type);
+		t->trecur = 0;
+	}
+}
+
+static void depnode(Node*);
+
+static void
+deplist(NodeList *l)
+{
+	for(; l; l=l->next)
+		depnode(l->n);
+}
+
+// the names and types used by an inlined body.
+static void
+depnode(Node *n)
+{
+	if(n == N)
+		return;
+	if(n->op == ONAME && ((n->class&~PHEAP) == PEXTERN || n->class == PFUNC))
+		expdep(n->sym);
+	deptype(n->type);
+	depnode(n->left);
+	depnode(n->right);
+	deplist(n->list);
+	deplist(n->rlist);
+	deplist(n->ninit);
+	depnode(n->ntest);
+	depnode(n->nincr);
+	deplist(n->nbody);
+	deplist(n->nelse);
+}
+
+static void
+ixputc(int c)
+{
+	c &= 0xff;
+	if(c == 0 || c == 1 || c == '\n') {
+		Bputc(bout, 1);
+		c += '@';
+	}
+	Bputc(bout, c);
+}
+
+static void
+ixputv(uvlong v)
+{
+	while(v >= 0x80) {
+		ixputc(v | 0x80);
+		v >>= 7;
+	}
+	ixputc(v);
+}
+
+static void
+dumpindex(void)
+{
+	Expent *e;
+	char *p;
+	int i, j, n, *dep;
+
+	for(i=0; i<nexpent; i++)
+		if(expent[i].sym != S)
+			expent[i].sym->expidx = i+1;
+
+	ixputv(Indexversion);
+	ixputv(nexpent);
+	dep = nil;
+	for(i=0; i<nexpent; i++) {
+		e = &expent[i];
+		ixputc(e->kind);
+		ixputv(strlen(e->name));
+		for(p=e->name; *p; p++)
+			ixputc(*p);
+		ixputv(e->off);
+		ixputv(e->len);
+		for(j=0; j<4; j++)
+			ixputc(e->hash >> (8*j));
+
+		dep = realloc(dep, (e->ndep+1)*sizeof dep[0]);
+		if(dep == nil)
+			fatal("out of memory");
+		n = 0;
+		for(j=0; j<e->ndep; j++)
+			if(e->dep[j]->expidx > 0 && e->dep[j]->expidx != i+1)
+				dep[n++] = e->dep[j]->expidx - 1;
+		ixputv(n);
+		for(j=0; j<n; j++)
+			ixputv(dep[j]);
+	}
+	free(dep);
+}
+
 void
 dumpexport(void)
 {
@@ -323,6 +618,7 @@ dumpexport(void)
 	if(safemode)
 		Bprint(bout, " safe");
 	Bprint(bout, "\n");
+	expbase = Boffset(bout);
 
 	for(i=0; i<nelem(phash); i++)
 		for(p=phash[i]; p; p=p->link)
@@ -334,6 +630,8 @@ dumpexport(void)
 		dumpsym(l->n->sym);
 	}
 
+	Bprint(bout, "\n$$  // index\n");
+	dumpindex();
 	Bprint(bout, "\n$$  // local types\n\n$$\n");   // 6l expects this. (see ld/go.c)
 
 	lineno = lno;
@@ -343,6 +641,323 @@ dumpexport(void)
  * import
  */
 
+/*
+ * the names written after a dot in the files being compiled.
+ * an import needs only the declarations with these names,
+ * the declarations they use, and init.
+ * a dot import can use any name, which is noted as nil.
+ */
+static	char**	reftab;
+static	int	nref;
+static	int	mref;
+static	int	refall;
+
+static uint32
+refhash(char *s, int n)
+{
+	uint32 h;
+
+	h = Fnvoffset;
+	while(n-- > 0)
+		h = (h ^ (uchar)*s++) * Fnvprime;
+	return h;
+}
+
+static int
+reflookup(char *s, int n)
+{
+	uint32 h;
+	char *r;
+
+	h = refhash(s, n) & (mref-1);
+	for(; (r = reftab[h]) != nil; h = (h+1) & (mref-1))
+		if(strncmp(r, s, n) == 0 && r[n] == '\0')
+			break;
+	return h;
+}
+
+void
+importref(char *s, int n)
+{
+	char **old;
+	int i, m;
+
+	if(s == nil) {
+		refall = 1;
+		return;
+	}
+	if(2*(nref+1) > mref) {
+		old = reftab;
+		m = mref;
+		mref = 2*mref;
+		if(mref == 0)
+			mref = 1024;
+		reftab = mal(mref*sizeof reftab[0]);
+		for(i=0; i<m; i++)
+			if(old[i] != nil)
+				reftab[reflookup(old[i], strlen(old[i]))] = old[i];
+	}
+	i = reflookup(s, n);
+	if(reftab[i] != nil)
+		return;
+	reftab[i] = mal(n+1);
+	memmove(reftab[i], s, n);
+	nref++;
+}
+
+typedef	struct	Impent	Impent;
+struct	Impent
+{
+	int	kind;
+	char*	name;
+	int	nname;
+	uvlong	off;
+	uvlong	len;
+	uchar*	dep;	// ndep varints
+	int	ndep;
+	int	keep;
+};
+
+typedef	struct	Ixread	Ixread;
+struct	Ixread
+{
+	uchar*	p;
+	uchar*	ep;
+	int	err;
+};
+
+static uvlong
+ixgetv(Ixread *r)
+{
+	uvlong v;
+	int c, s;
+
+	v = 0;
+	for(s=0; s<64; s+=7) {
+		if(r->p >= r->ep) {
+			r->err = 1;
+			return 0;
+		}
+		c = *r->p++;
+		v |= (uvlong)(c&0x7f) << s;
+		if(!(c&0x80))
+			return v;
+	}
+	r->err = 1;
+	return 0;
+}
+
+// does the declaration named name, as written in the
+// export data, have a name the files being compiled use?
+static int
+isref(char *name, int n)
+{
+	char *p;
+
+	for(p=name+n; p>name && p[-1]!='.'; p--)
+		;
+	n -= p - name;
+	if(n == 4 && strncmp(p, "init", 4) == 0)
+		return 1;
+	return reftab[reflookup(p, n)] != nil;
+}
+
+// keep the declarations used by the files being compiled,
+// using the index in ix.  return 0 if the index is bad.
+static int
+selectexports(Impent **entp, int *nentp, char *ix, uvlong ntext)
+{
+	Ixread r;
+	Impent *ent, *e;
+	uchar *p, *q;
+	int i, j, n, *stack, nstack;
+	uvlong d;
+
+	// undo the escapes, in place.
+	p = (uchar*)ix;
+	for(q=p; *q; q++) {
+		if(*q == 1 && q[1] != '\0')
+			*p++ = *++q - '@';
+		else
+			*p++ = *q;
+	}
+	r.p = (uchar*)ix;
+	r.ep = p;
+	r.err = 0;
+
+	if(ixgetv(&r) != Indexversion)
+		return 0;
+	n = ixgetv(&r);
+	if(r.err || n < 0 || n > r.ep - r.p)
+		return 0;
+	ent = mal(n*sizeof ent[0]);
+	for(i=0; i<n && !r.err; i++) {
+		e = &ent[i];
+		if(r.p >= r.ep)
+			return 0;
+		e->kind = *r.p++;
+		e->nname = ixgetv(&r);
+		if(r.err || e->nname > r.ep - r.p)
+			return 0;
+		e->name = (char*)r.p;
+		r.p += e->nname;
+		e->off = ixgetv(&r);
+		e->len = ixgetv(&r);
+		if(e->off > ntext || e->len > ntext - e->off)
+			return 0;
+		r.p += 4;	// hash, for the linker
+		e->ndep = ixgetv(&r);
+		e->dep = r.p;
+		for(j=0; j<e->ndep && !r.err; j++)
+			if(ixgetv(&r) >= n)
+				return 0;
+	}
+	if(r.err)
+		return 0;
+
+	stack = mal(n*sizeof stack[0]);
+	nstack = 0;
+	for(i=0; i<n; i++) {
+		e = &ent[i];
+		if(e->kind == 'i' || isref(e->name, e->nname)) {
+			e->keep = 1;
+			stack[nstack++] = i;
+		}
+	}
+	while(nstack > 0) {
+		e = &ent[stack[--nstack]];
+		r.p = e->dep;
+		for(j=0; j<e->ndep; j++) {
+			d = ixgetv(&r);
+			if(!ent[d].keep) {
+				ent[d].keep = 1;
+				stack[nstack++] = d;
+			}
+		}
+	}
+	*entp = ent;
+	*nentp = n;
+	return 1;
+}
+
+/*
+ * the next line of b, including the newline, and its length.
+ * the line is in b's buffer unless it is too long for it;
+ * then it is allocated and *freep is set.
+ */
+static char*
+rdline(Biobuf *b, int *np, int *freep)
+{
+	char *p;
+
+	*freep = 0;
+	p = Brdline(b, '\n');
+	if(p != nil) {
+		*np = Blinelen(b);
+		return p;
+	}
+	if(Blinelen(b) == 0)
+		return nil;
+	p = Brdstr(b, '\n', 0);
+	if(p == nil)
+		return nil;
+	*freep = 1;
+	*np = strlen(p);
+	return p;
+}
+
+/*
+ * read the export data from b, which is positioned before it,
+ * up to and including its index.  return the text for the parser:
+ * the package line, the declarations the files being compiled
+ * may use, and the closing $$.  return nil if there is no export data.
+ */
+char*
+readexports(Biobuf *b)
+{
+	char *line, *pkg, *text, *ix, *out, *p;
+	Impent *ent;
+	int i, n, end, mustfree;
+	vlong ntext, mtext;
+
+	// skip to the $$ that starts the exports
+	// and the package line that follows.
+	for(;;) {
+		line = rdline(b, &n, &mustfree);
+		if(line == nil)
+			return nil;
+		for(i=0; i+1<n; i++)
+			if(line[i] == '$' && line[i+1] == '$')
+				break;
+		if(mustfree)
+			free(line);
+		if(i+1 < n)
+			break;
+	}
+	do {
+		pkg = Brdstr(b, '\n', 0);
+		if(pkg == nil)
+			return nil;
+	} while(pkg[0] == '\n');
+
+	// the declarations end at the next $$,
+	// which may introduce the index.
+	text = nil;
+	ntext = 0;
+	mtext = 0;
+	ix = nil;
+	end = 0;
+	while((line = rdline(b, &n, &mustfree)) != nil) {
+		if(n >= 2 && line[0] == '$' && line[1] == '$') {
+			if(n >= 12 && strncmp(line, "$$  // index", 12) == 0)
+				ix = Brdstr(b, '\n', 1);
+			if(mustfree)
+				free(line);
+			end = 1;
+			break;
+		}
+		if(ntext+n+1 > mtext) {
+			mtext = 2*mtext + n + 4096;
+			text = realloc(text, mtext);
+			if(text == nil)
+				fatal("out of memory");
+		}
+		memmove(text+ntext, line, n);
+		ntext += n;
+		if(mustfree)
+			free(line);
+	}
+
+	ent = nil;
+	n = 0;
+	if(ix != nil && nref > 0 && !refall && !selectexports(&ent, &n, ix, ntext))
+		ent = nil;
+
+	out = mal(strlen(pkg) + ntext + 4);
+	strcpy(out, pkg);
+	p = out + strlen(out);
+	if(ent == nil) {
+		memmove(p, text, ntext);
+		p += ntext;
+	} else {
+		for(i=0; i<n; i++) {
+			if(ent[i].keep) {
+				memmove(p, text+ent[i].off, ent[i].len);
+				p += ent[i].len;
+			}
+		}
+	}
+	if(end)
+		strcpy(p, "$$\n");
+	else
+		*p = '\0';
+
+	free(pkg);
+	free(text);
+	free(ix);
+	return out;
+}
+
 /*
  * return the sym for ss, which should match lexical
  */
@@ -98,23 +98,24 @@ setfmode(unsigned long *flags)
 	return fm;
 }
 
-// Fmt "%L": Linenumbers
+typedef	struct	Linepos	Linepos;
+struct	Linepos
+{
+	Hist*	incl;	/* start of this include file */
+	int32	idel;	/* delta line number to apply to include */
+	Hist*	line;	/* start of this #line directive */
+	int32	ldel;	/* delta line number to apply to #line */
+};
+
+// Fill a with the stack of files open at absolute line lno,
+// outermost first, and return its depth.
 static int
-Lconv(Fmt *fp)
+linestack(int32 lno, Linepos *a)
 {
-	struct
-	{
-		Hist*	incl;	/* start of this include file */
-		int32	idel;	/* delta line number to apply to include */
-		Hist*	line;	/* start of this #line directive */
-		int32	ldel;	/* delta line number to apply to #line */
-	} a[HISTSZ];
-	int32 lno, d;
-	int i, n;
+	int32 d;
+	int n;
 	Hist *h;
 
-	lno = va_arg(fp->args, int32);
-
 	n = 0;
 	for(h=hist; h!=H; h=h->link) {
 		if(h->offset < 0)
@@ -127,6 +128,13 @@ Lconv(Fmt *fp)
 				if(n > 0 && n < HISTSZ) {
 					a[n-1].line = h;
 					a[n-1].ldel = h->line - h->offset + 1;
+				} else if(n == 0) {
+					// outside all files: the block of
+					// an inlined body, see inl.c
+					a[n].incl = h;
+					a[n].idel = h->line - h->offset + 1;
+					a[n].line = 0;
+					n++;
 				}
 			} else {
 				// beginning of file
@@ -149,7 +157,40 @@ Lconv(Fmt *fp)
 
 	if(n > HISTSZ)
 		n = HISTSZ;
+	return n;
+}
 
+// Return the file of absolute line lno, setting *line
+// to the line in it, or nil if lno is in no file.
+char*
+linefile(int32 lno, int32 *line)
+{
+	Linepos a[HISTSZ], *p;
+	int n;
+
+	n = linestack(lno, a);
+	if(n == 0)
+		return nil;
+	p = &a[n-1];
+	if(p->line) {
+		*line = lno - p->ldel + 1;
+		return p->line->name;
+	}
+	*line = lno - p->idel + 1;
+	return p->incl->name;
+}
+
+// Fmt "%L": Linenumbers
+static int
+Lconv(Fmt *fp)
+{
+	Linepos a[HISTSZ];
+	int32 lno;
+	int i, n;
+
+	lno = va_arg(fp->args, int32);
+
+	n = linestack(lno, a);
 	for(i=n-1; i>=0; i--) {
 		if(i != n-1) {
 			if(fp->flags & ~(FmtWidth|FmtPrec))
@@ -796,7 +837,12 @@ stmtfmt(Fmt *f, Node *n)
 
 	switch(n->op){
 	case ODCL:
-		fmtprint(f, "var %S %T", n->left->sym, n->left->type);
+		// a local of an imported body that was never
+		// typechecked, being exported again, has only its ntype.
+		if(n->left->type == T && n->left->ntype != N)
+			fmtprint(f, "var %S %N", n->left->sym, n->left->ntype);
+		else
+			fmtprint(f, "var %S %T", n->left->sym, n->left->type);
 		break;
 
 	case ODCLFIELD:
@@ -807,6 +853,10 @@ stmtfmt(Fmt *f, Node *n)
 		break;
 
 	case OAS:
+		// x = <N> zero initializing assignments come from var
+		// declarations; the ODCL printed as a var regenerates them.
+		if(n->right == N && fmtmode == FExp)
+			break;
 		if(n->colas && !complexinit)
 			fmtprint(f, "%N := %N", n->left, n->right);
 		else
@@ -1580,7 +1630,7 @@ static int
 Hconv(Fmt *fp)
 {
 	NodeList *l;
-	int r, sm;
+	int r, sm, nl;
 	unsigned long sf;
 	char *sep;
 
@@ -1598,7 +1648,14 @@ Hconv(Fmt *fp)
 	else if(fp->flags & FmtComma)
 		sep = ", ";
 
+	// the statements of an exported inlinable body go on
+	// the lines they had in the source, see export.c
+	nl = fmtmode == FExp && explineno != 0 && !(fp->flags & FmtComma);
+
 	for(;l; l=l->next) {
+		if(nl && l->n->lineno <= explimit)
+			for(; explineno < l->n->lineno; explineno++)
+				r += fmtstrcpy(fp, "\n");
 		r += fmtprint(fp, "%N", l->n);
 		if(l->next)
 			r += fmtstrcpy(fp, sep);
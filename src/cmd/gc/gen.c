@@ -264,6 +264,7 @@ gen(Node *n)
 	Prog *scontin, *sbreak;
 	Prog *p1, *p2, *p3;
 	Label *lab;
+	NodeList *l;
 	int32 wasregalloc;
 
 	lno = setlineno(n);
@@ -336,6 +337,25 @@ gen(Node *n)
 			lab->gotopc = gjmp(lab->gotopc);
 		break;
 
+	case OJMPTAB:
+		// the table entries are resolved like the gotos in n->list.
+		// the goto for the last entry is repeated after the table,
+		// so that the optimizer sees where the last entry leads.
+		gjmptab(n->left);
+		for(l=n->list; l; l=l->next) {
+			p1 = gjmpcase();
+			lab = newlab(l->n);
+			if(lab->labelpc != P)
+				patch(p1, lab->labelpc);
+			else {
+				if(lab->gotopc != P)
+					patch(p1, lab->gotopc);
+				lab->gotopc = p1;
+			}
+		}
+		gen(n->list->end->n);
+		break;
+
 	case OBREAK:
 		if(n->left != N) {
 			lab = n->left->sym->label;
@@ -410,7 +430,7 @@ gen(Node *n)
 		p1 = gjmp(P);			//		goto test
 		p2 = gjmp(P);			// p2:		goto else
 		patch(p1, pc);				// test:
-		bgen(n->ntest, 0, 0, p2);			//		if(!test) goto p2
+		bgen(n->ntest, 0, -n->likely, p2);		//		if(!test) goto p2
 		genlist(n->nbody);				//		then
 		p3 = gjmp(P);			//		goto done
 		patch(p2, pc);				// else:
@@ -14,6 +14,14 @@
 #define	EXTERN	extern
 #endif
 
+// THREAD marks the state private to each thread
+// running the register optimizer; see finishfuncs.
+#if defined(__GNUC__) || defined(__clang__)
+#define	THREAD	__thread
+#else
+#define	THREAD
+#endif
+
 #undef	BUFSIZ
 
 // The parser's maximum stack size.
@@ -27,7 +35,7 @@ enum
 	NHUNK		= 50000,
 	BUFSIZ		= 8192,
 	NSYMB		= 500,
-	NHASH		= 1024,
+	NHASH		= 1024,	// initial size of the symbol table
 	STRINGSZ	= 200,
 	MAXALIGN	= 7,
 	UINF		= 100,
@@ -209,6 +217,22 @@ struct InitPlan
 	int cap;
 };
 
+/*
+ * A call expanded by the inliner.  The callee's body keeps its
+ * own lines, moved to the block of absolute lines [lo, hi] that
+ * the history maps to its source file; lineno is the line of
+ * the call, which may itself be in the block of another Inlcall.
+ */
+typedef	struct	Inlcall	Inlcall;
+struct	Inlcall
+{
+	Inlcall*	link;
+	Sym*	sym;	// the callee's text symbol
+	int32	lo;
+	int32	hi;
+	int32	lineno;
+};
+
 enum
 {
 	EscUnknown,
@@ -238,6 +262,7 @@ struct	Node
 	uchar	trecur;		// to detect loops
 	uchar	etype;		// op for OASOP, etype for OTYPE, exclam for export
 	uchar	bounded;	// bounds check unnecessary
+	uchar	nonnil;		// ODOTPTR, OIND: nil check unnecessary
 	uchar	class;		// PPARAM, PAUTO, PEXTERN, etc
 	uchar	method;		// OCALLMETH name
 	uchar	embedded;	// ODCLFIELD embedded type
@@ -257,6 +282,9 @@ struct	Node
 	uchar	implicit;
 	uchar	addrtaken;	// address taken, even if not moved to heap
 	uchar	dupok;	// duplicate definitions ok (for func)
+	uchar	reflectmethod;	// calls reflect Method or MethodByName (for func)
+	uchar	inlvisit;	// ODCLFUNC already considered by caninl
+	schar	likely;	// likeliness of if statement
 
 	// most nodes
 	Type*	type;
@@ -271,6 +299,10 @@ struct	Node
 	NodeList*	cvars;	// closure params
 	NodeList*	dcl;	// autodcl for this func/closure
 	NodeList*	inl;	// copy of the body for use in inlining
+	Inlcall*	inlcall;	// ODCLFUNC: calls inlined into it, for the line tables
+	char*	inlfile;	// file of the header of inl
+	int32	inlline;	// line in inlfile of the header of inl
+	int32	inlcost;	// hairyness of inl
 
 	// OLITERAL/OREGISTER
 	Val	val;
@@ -302,13 +334,16 @@ struct	Node
 
 	// Escape analysis.
 	NodeList* escflowsrc;	// flow(this, src)
-	int	escloopdepth;	// -1: global, 0: not set, function top level:1, increased inside function for every loop or label to mark scopes
 
 	Sym*	sym;		// various
+	vlong	xoffset;
+
+	// The 32-bit fields come last, after the 64-bit ones,
+	// so that the compiler has no padding to insert.
+	int	escloopdepth;	// -1: global, 0: not set, function top level:1, increased inside function for every loop or label to mark scopes
 	int32	vargen;		// unique name for OTYPE/ONAME
 	int32	lineno;
 	int32	endlineno;
-	vlong	xoffset;
 	int32	stkdelta;	// offset added by stack frame compaction phase.
 	int32	ostk;
 	int32	iota;
@@ -355,6 +390,7 @@ struct	Sym
 	uchar	sym;		// huffman encoding in object file
 	Sym*	link;
 	int32	npkg;	// number of imported packages with this name
+	int32	expidx;	// 1 + index of declaration in export index
 
 	// saved and restored by dcopy
 	Pkg*	pkg;
@@ -389,6 +425,19 @@ struct	Iter
 	Node*	n;
 };
 
+/*
+ * An Arena hands out memory that is all freed at once.
+ * The backend keeps each function's Progs in one,
+ * so they can be freed once the function is written out.
+ */
+typedef	struct	Arena	Arena;
+struct	Arena
+{
+	char*	hunk;	// free space in the current block
+	int32	nhunk;
+	char*	blk;	// blocks, chained through their first word
+};
+
 typedef	struct	Hist	Hist;
 struct	Hist
 {
@@ -467,6 +516,7 @@ enum
 	OFOR,
 	OGOTO,
 	OIF,
+	OJMPTAB,	// goto list[left], for switch
 	OLABEL,
 	OPROC,
 	ORANGE,
@@ -576,6 +626,8 @@ enum
 	PPARAMREF,	// param passed by reference
 	PFUNC,
 
+	PDISCARD,	// discard during parse of duplicate import
+
 	PHEAP = 1<<7,
 };
 
@@ -617,7 +669,7 @@ struct	Var
 	char	addr;
 };
 
-EXTERN	Var	var[NVAR];
+EXTERN	THREAD	Var	var[NVAR];
 
 typedef	struct	Typedef	Typedef;
 struct	Typedef
@@ -653,6 +705,8 @@ struct	Io
 	int	peekc;
 	int	peekc1;	// second peekc for ...
 	char*	cp;	// used for content when bin==nil
+	char*	ep;	// end of content if the file is in memory
+	char*	buf;	// copy of the file, to free
 	int	importsafe;
 };
 
@@ -748,9 +802,16 @@ EXTERN	int32	prevlineno;
 EXTERN	char*	pathname;
 EXTERN	Hist*	hist;
 EXTERN	Hist*	ehist;
+EXTERN	int32	implineno;	// newlines read in the current import
+EXTERN	char*	impinlfile;	// //line of the inlinable func being imported
+EXTERN	int32	impinlline;
+EXTERN	int32	impinlbase;	// implineno at its header
+EXTERN	int32	explineno;	// line reached by an exported inlinable body
+EXTERN	int32	explimit;	// its last line
 
 EXTERN	char*	infile;
 EXTERN	char*	outfile;
+EXTERN	char*	pgofile;
 EXTERN	Biobuf*	bout;
 EXTERN	int	nerrors;
 EXTERN	int	nsavederrors;
@@ -760,7 +821,10 @@ EXTERN	char	namebuf[NSYMB];
 EXTERN	char	lexbuf[NSYMB];
 EXTERN	char	litbuf[NSYMB];
 EXTERN	char	debug[256];
-EXTERN	Sym*	hash[NHASH];
+EXTERN	int	inlbudget;	// maximum hairyness of an inlinable body
+EXTERN	int	pgoloaded;	// profile feedback read by -F
+EXTERN	Sym**	hash;		// symbol table: nhash chains, grown by pkglookup
+EXTERN	uint32	nhash;
 EXTERN	Sym*	importmyname;	// my name for package
 EXTERN	Pkg*	localpkg;	// package being compiled
 EXTERN	Pkg*	importpkg;	// package being imported
@@ -832,7 +896,7 @@ EXTERN	int32	blockgen;		// max block number
 EXTERN	int32	block;			// current block number
 EXTERN	int	hasdefer;		// flag that curfn has defer statetment
 
-EXTERN	Node*	curfn;
+EXTERN	THREAD	Node*	curfn;
 
 EXTERN	int	widthptr;
 
@@ -842,9 +906,9 @@ EXTERN	Node*	nblank;
 extern	int	thechar;
 extern	char*	thestring;
 
-EXTERN	char*	hunk;
-EXTERN	int32	nhunk;
-EXTERN	int32	thunk;
+EXTERN	THREAD	char*	hunk;
+EXTERN	THREAD	int32	nhunk;
+EXTERN	THREAD	int32	thunk;
 
 EXTERN	int	funcdepth;
 EXTERN	int	typecheckok;
@@ -866,6 +930,11 @@ void	resumecheckwidth(void);
 uint32	rnd(uint32 o, uint32 r);
 void	typeinit(void);
 
+/*
+ *	bce.c
+ */
+void	bce(Node *fn);
+
 /*
  *	bits.c
  */
@@ -909,6 +978,13 @@ int	smallintconst(Node *n);
 Val	toint(Val v);
 Mpflt*	truncfltlit(Mpflt *oldv, Type *t);
 
+/*
+ *	cover.c
+ */
+void	cover(NodeList *all);
+Node*	coverinit(void);
+int	iscovercount(Node *n);
+
 /*
  *	cplx.c
  */
@@ -972,10 +1048,12 @@ int	exportname(char *s);
 void	exportsym(Node *n);
 void    importconst(Sym *s, Type *t, Node *n);
 void	importimport(Sym *s, Strlit *z);
+void	importref(char *s, int n);
 Sym*    importsym(Sym *s, int op);
 void    importtype(Type *pt, Type *t);
 void    importvar(Sym *s, Type *t);
 Type*	pkgtype(Sym *s);
+char*	readexports(Biobuf *b);
 
 /*
  *	fmt.c
@@ -983,6 +1061,7 @@ Type*	pkgtype(Sym *s);
 void	fmtinstallgo(void);
 void	dump(char *s, Node *n);
 void	dumplist(char *s, NodeList *l);
+char*	linefile(int32 lno, int32 *line);
 
 /*
  *	gen.c
@@ -1011,6 +1090,7 @@ Sym*	renameinit(void);
  *	inl.c
  */
 void	caninl(Node *fn);
+Pkg*	fnpkg(Node *fn);
 void	inlcalls(Node *fn);
 void	typecheckinl(Node *fn);
 
@@ -1102,11 +1182,24 @@ void	dumpobj(void);
 void	ieeedtod(uint64 *ieee, double native);
 Sym*	stringsym(char*, int);
 
+/*
+ *	opt.c
+ */
+void	optimize(Node *fn);
+
 /*
  *	order.c
  */
 void	order(Node *fn);
 
+/*
+ *	pgo.c
+ */
+int	pgohotcall(Node *caller, Node *callee);
+int	pgohotfunc(Node *fn);
+void	pgolayout(Node *fn);
+void	pgoload(char *file);
+
 /*
  *	range.c
  */
@@ -1144,9 +1237,11 @@ int	stataddr(Node *nam, Node *n);
 Node*	adddot(Node *n);
 int	adddot1(Sym *s, Type *t, int d, Type **save, int ignorecase);
 void	addinit(Node**, NodeList*);
+void	afree(Arena *a);
 Type*	aindex(Node *b, Type *t);
 int	algtype(Type *t);
 int	algtype1(Type *t, Type **bad);
+void*	amal(Arena *a, int32 n);
 void	argtype(Node *on, Type *t);
 Node*	assignconv(Node *n, Type *t, char *context);
 int	assignop(Type *src, Type *dst, char **why);
@@ -1190,6 +1285,7 @@ int	isnilinter(Type *t);
 int	isptrto(Type *t, int et);
 int	isslice(Type *t);
 int	istype(Type *t, int et);
+void	addhist(char *file, int32 line, int32 off);
 void	linehist(char *file, int32 off, int relative);
 NodeList*	list(NodeList *l, Node *n);
 NodeList*	list1(Node *n);
@@ -1197,6 +1293,7 @@ void	listsort(NodeList**, int(*f)(Node*, Node*));
 Node*	liststmt(NodeList *l);
 NodeList*	listtreecopy(NodeList *l);
 Sym*	lookup(char *name);
+Sym*	lookuph(char *name, uint32 sum);
 void*	mal(int32 n);
 Type*	maptype(Type *key, Type *val);
 Type*	methtype(Type *t, int mustname);
@@ -1292,10 +1389,12 @@ struct	Plist
 	Prog*	firstpc;
 	int	recur;
 	Plist*	link;
+	Arena	arena;	// holds the Progs, if the backend uses it
 };
 
 EXTERN	Plist*	plist;
 EXTERN	Plist*	plast;
+EXTERN	THREAD	Arena*	progarena;	// arena for new Progs of curfn
 
 EXTERN	Prog*	continpc;
 EXTERN	Prog*	breakpc;
@@ -1317,6 +1416,7 @@ void	cgen_ret(Node *n);
 void	clearfat(Node *n);
 void	compile(Node*);
 void	defframe(Prog*);
+void	finishfuncs(void);
 int	dgostringptr(Sym*, int off, char *str);
 int	dgostrlitptr(Sym*, int off, Strlit*);
 int	dstringptr(Sym *s, int off, char *str);
@@ -1324,6 +1424,7 @@ int	dsymptr(Sym *s, int off, Sym *x, int xoff);
 int	duintxx(Sym *s, int off, uint64 v, int wid);
 void	dumpdata(void);
 void	dumpfuncs(void);
+void	emitfuncs(void);
 void	fixautoused(Prog*);
 void	gdata(Node*, Node*, int);
 void	gdatacomplex(Node*, Mpcplx*);
@@ -1332,6 +1433,8 @@ void	genembedtramp(Type*, Type*, Sym*, int iface);
 void	ggloblnod(Node *nam, int32 width);
 void	ggloblsym(Sym *s, int32 width, int dupok);
 Prog*	gjmp(Prog*);
+Prog*	gjmpcase(void);
+void	gjmptab(Node*);
 void	gused(Node*);
 int	isfat(Type*);
 void	markautoused(Prog*);
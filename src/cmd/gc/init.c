@@ -32,6 +32,7 @@ renameinit(void)
  *			throw();			(5)
  *		}
  *		initdone· = 1;				(6)
+ *		coverregister(...) // if -c		(6a)
  *		// over all matching imported symbols
  *			<pkg>.init()			(7)
  *		{ <init stmts> }			(8)
@@ -64,6 +65,10 @@ anyinit(NodeList *n)
 	if(strcmp(localpkg->name, "main") == 0)
 		return 1;
 
+	// are there coverage counters to register
+	if(debug['c'])
+		return 1;
+
 	// is there an explicit init function
 	snprint(namebuf, sizeof(namebuf), "init·1");
 	s = lookup(namebuf);
@@ -71,7 +76,7 @@ anyinit(NodeList *n)
 		return 1;
 
 	// are there any imported init functions
-	for(h=0; h<NHASH; h++)
+	for(h=0; h<nhash; h++)
 	for(s = hash[h]; s != S; s = s->link) {
 		if(s->name[0] != 'i' || strcmp(s->name, "init") != 0)
 			continue;
@@ -142,8 +147,13 @@ fninit(NodeList *n)
 	a = nod(OAS, gatevar, nodintconst(1));
 	r = list(r, a);
 
+	// (6a)
+	a = coverinit();
+	if(a != N)
+		r = list(r, a);
+
 	// (7)
-	for(h=0; h<NHASH; h++)
+	for(h=0; h<nhash; h++)
 	for(s = hash[h]; s != S; s = s->link) {
 		if(s->name[0] != 'i' || strcmp(s->name, "init") != 0)
 			continue;
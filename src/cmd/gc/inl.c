@@ -11,11 +11,26 @@
 // making 1 the default and -l disable.  -ll and more is useful to flush out bugs.
 // These additional levels (beyond -l) may be buggy and are not supported.
 //      0: disabled
-//      1: 40-nodes leaf functions, oneliners, lazy typechecking (default)
+//      1: functions within the budget, lazy typechecking (default)
 //      2: early typechecking of all imported bodies 
 //      3: 
-//      4: allow non-leaf functions , (breaks runtime.Caller)
-//      5: transitive inlining
+//
+// A function is inlinable if its body, with the bodies of any inlinable
+// functions it calls counted in, stays within inlbudget nodes (-b, default 40).
+// Calls to other functions cost Callcost nodes and stay calls.  Simple for
+// loops are allowed; range, labels, goto and recover are not.
+//
+// An inlined body keeps its own lines: each expansion gets a block of
+// absolute line numbers past the end of the source, which the history maps
+// to the callee's file (see inlblock), and an Inlcall on the caller recording
+// the block and the line of the call.  dumpobj writes these out for the
+// linker, which turns them into the pc/inline table that lets runtime·Caller
+// and tracebacks show a frame for every inlined call.
+//
+// With profile feedback (-F), callees of hot call edges get a budget of
+// PgoBudget times inlbudget.  A body that only fits in the larger budget is
+// expanded at hot call sites and at the sites inside other inlined bodies,
+// but not exported, so that it never grows code that the profile says is cold.
 //
 //  At some point this may get another default and become switch-offable with -N.
 //
@@ -25,6 +40,7 @@
 // TODO:
 //   - inline functions with ... args
 //   - handle T.meth(f()) with func f() (t T, arg, arg, )
+//   - range loops and labeled statements
 
 #include <u.h>
 #include <libc.h>
@@ -35,6 +51,7 @@ static Node*	inlcopy(Node *n);
 static NodeList* inlcopylist(NodeList *ll);
 static int	ishairy(Node *n, int *budget);
 static int	ishairylist(NodeList *ll, int *budget); 
+static Node*	inlcallee(Node *n);
 
 // Used by inlcalls
 static void	inlnodelist(NodeList *l);
@@ -46,16 +63,26 @@ static Node*	newlabel(void);
 static Node*	inlsubst(Node *n);
 static NodeList* inlsubstlist(NodeList *l);
 
-static void	setlno(Node*, int);
+static Inlcall*	inlblock(Node *fn, Node *call);
+static int32	inlline(int32 lno);
 
 // Used during inlsubst[list]
 static Node *inlfn;		// function currently being inlined
+static Inlcall *inlpos;		// its block of lines, or nil
+static int32 inlcallno;		// line of the call, used without a block
 static Node *inlretlabel;	// target of the goto substituted in place of a return
 static NodeList *inlretvars;	// temp out variables
+static int inlnest;		// expanding calls inside an inlined body
+
+enum
+{
+	PgoBudget = 8,
+	Callcost = 10,	// budget charged for a call left in a body
+};
 
 // Get the function's package.  For ordinary functions it's on the ->sym, but for imported methods
 // the ->sym can be re-used in the local package, so peel it off the receiver's type.
-static Pkg*
+Pkg*
 fnpkg(Node *fn)
 {
 	Type *rcvr;
@@ -82,7 +109,9 @@ typecheckinl(Node *fn)
 	Pkg *pkg;
 	int save_safemode, lno;
 
-	if(fn->typecheck)
+	// fn->typecheck is also set by typechecking a reference
+	// to fn, so look at the body instead.
+	if(fn->inl == nil || fn->inl->n->typecheck == 1)
 		return;
 
 	lno = setlineno(fn);
@@ -112,21 +141,29 @@ typecheckinl(Node *fn)
 }
 
 // Caninl determines whether fn is inlineable. Currently that means:
-// fn is exactly 1 statement, either a return or an assignment, and
-// some temporary constraints marked TODO.  If fn is inlineable, saves
-// fn->nbody in fn->inl and substitutes it with a copy.
+// fn's body, including the bodies of the inlineable functions it calls,
+// fits in inlbudget nodes, and some temporary constraints marked TODO.
+// If fn is inlineable, saves fn->nbody in fn->inl and substitutes it with a copy.
+// Caninl may be called more than once for the same function; local callees
+// are analysed on demand so that declaration order does not matter.
 void
 caninl(Node *fn)
 {
 	Node *savefn;
 	Type *t;
-	int budget;
+	int budget, max;
+	char *file;
+	int32 line, end;
 
 	if(fn->op != ODCLFUNC)
 		fatal("caninl %N", fn);
 	if(!fn->nname)
 		fatal("caninl no nname %+N", fn);
 
+	if(fn->inlvisit)
+		return;
+	fn->inlvisit = 1;
+
 	// If fn has no body (is defined outside of Go), cannot inline it.
 	if(fn->nbody == nil)
 		return;
@@ -136,14 +173,28 @@ caninl(Node *fn)
 		if(t->isddd)
 			return;
 
-	budget = 40;  // allowed hairyness
-	if(ishairylist(fn->nbody, &budget))
-		return;
+	// the copy of the body gets one block of lines, so a //line
+	// directive inside it would leave its positions wrong.
+	if(fn->endlineno > fn->lineno) {
+		file = linefile(fn->lineno, &line);
+		if(file != linefile(fn->endlineno, &end) || end - line != fn->endlineno - fn->lineno)
+			return;
+	}
 
 	savefn = curfn;
 	curfn = fn;
 
+	max = inlbudget;
+	if(pgohotfunc(fn))
+		max *= PgoBudget;
+	budget = max;  // allowed hairyness
+	if(ishairylist(fn->nbody, &budget)) {
+		curfn = savefn;
+		return;
+	}
+
 	fn->nname->inl = fn->nbody;
+	fn->nname->inlcost = max - budget;
 	fn->nbody = inlcopylist(fn->nname->inl);
 	// nbody will have been typechecked, so we can set this:
 	fn->typecheck = 1;
@@ -173,43 +224,65 @@ ishairylist(NodeList *ll, int* budget)
 static int
 ishairy(Node *n, int *budget)
 {
+	Node *fn;
+
 	if(!n)
 		return 0;
 
 	// Things that are too hairy, irrespective of the budget
 	switch(n->op) {
-	case OCALL:
 	case OCALLFUNC:
-	case OCALLINTER:
 	case OCALLMETH:
+		// Calls to inlineable functions cost the callee's body,
+		// which will be expanded in place.
+		fn = inlcallee(n);
+		if(fn != N) {
+			if(ishairylist(fn->inl, budget))
+				return 1;
+			break;
+		}
+		// runtime.Callers counts real frames, so its
+		// caller must keep one.
+		if(n->op == OCALLFUNC && n->left->op == ONAME && n->left->class == PFUNC &&
+		   n->left->sym->pkg == runtimepkg && strcmp(n->left->sym->name, "Callers") == 0)
+			return 1;
+		// fallthrough
+	case OCALL:
+	case OCALLINTER:
 	case OPANIC:
+		*budget -= Callcost;
+		break;
+
 	case ORECOVER:
-		if(debug['l'] < 4)
+		// only works when called by the deferred function itself
+		return 1;
+
+	case OBREAK:
+	case OCONTINUE:
+		// labels would be duplicated by a second expansion in the same function
+		if(n->left != N)
 			return 1;
 		break;
 
 	case OCLOSURE:
 	case ORANGE:
-	case OFOR:
 	case OSELECT:
 	case OSWITCH:
 	case OPROC:
 	case ODEFER:
-	case ODCL:	// declares locals as globals b/c of @"". qualification
+	case OLABEL:
+	case OGOTO:
 	case ODCLTYPE:  // can't print yet
 	case ODCLCONST:  // can't print yet
 		return 1;
 
 		break;
-	case OAS:
-		// x = <N> zero initializing assignments aren't representible in export yet.
-		// alternatively we may just skip them in printing and hope their DCL printed
-		// as a var will regenerate it
-		if(n->right == N)
-			return 1;
-		break;
 	}
 
+	// coverage counters (-c) should not change what gets inlined.
+	if(iscovercount(n))
+		return 0;
+
 	(*budget)--;
 
 	return  *budget < 0 ||
@@ -224,6 +297,44 @@ ishairy(Node *n, int *budget)
 		ishairylist(n->nelse, budget);
 }
 
+// Inlcallee returns the function called by the OCALLFUNC or OCALLMETH n
+// if it has an inlineable body, running caninl first on local functions
+// that have not been looked at yet, and typechecking imported bodies.
+static Node*
+inlcallee(Node *n)
+{
+	Node *fn;
+	Pkg *pkg;
+
+	fn = N;
+	switch(n->op) {
+	case OCALLFUNC:
+		if(n->left->op != ONAME)
+			return N;
+		fn = n->left;
+		if(!fn->inl && fn->left && fn->left->op == OTYPE && fn->right && fn->right->op == ONAME)  // methods called as functions
+			fn = fn->sym->def;
+		break;
+	case OCALLMETH:
+		if(n->left->type == T)
+			return N;
+		fn = n->left->type->nname;
+		break;
+	}
+	if(fn == N)
+		return N;
+
+	if(fn->defn != N && fn->defn->op == ODCLFUNC)
+		caninl(fn->defn);
+	if(fn->inl == nil)
+		return N;
+
+	pkg = fnpkg(fn);
+	if(pkg != localpkg && pkg != nil && debug['l'] < 2)
+		typecheckinl(fn);
+	return fn;
+}
+
 // Inlcopy and inlcopylist recursively copy the body of a function.
 // Any name-like node of non-local class is marked for re-export by adding it to
 // the exportlist.
@@ -530,6 +641,7 @@ mkinlcall1(Node **np, Node *fn)
 	Node *n, *call, *saveinlfn, *as, *m;
 	NodeList *dcl, *ll, *ninit, *body;
 	Type *t;
+	Inlcall *saveinlpos;
 
 	if (fn->inl == nil)
 		return;
@@ -537,6 +649,10 @@ mkinlcall1(Node **np, Node *fn)
 	if (fn == curfn || fn->defn == curfn)
 		return;
 
+	// bodies over the budget are only worth it at hot call sites.
+	if(!inlnest && fn->inlcost > inlbudget && !pgohotcall(curfn, fn))
+		return;
+
 	if(debug['l']<2)
 		typecheckinl(fn);
 
@@ -566,6 +682,9 @@ mkinlcall1(Node **np, Node *fn)
 	// Make temp names to use instead of the originals
 	for(ll = dcl; ll; ll=ll->next)
 		if(ll->n->op == ONAME) {
+			// locals of imported bodies are only declared with a type
+			if(ll->n->type == T && ll->n->ntype != N)
+				typecheck(&ll->n, Erv);
 			ll->n->inlvar = inlvar(ll->n);
 			ninit = list(ninit, nod(ODCL, ll->n->inlvar, N));  // otherwise gen won't emit the allocations for heapallocs
 			if (ll->n->class == PPARAMOUT)  // we rely on the order being correct here
@@ -640,7 +759,11 @@ mkinlcall1(Node **np, Node *fn)
 	}
 
 	inlretlabel = newlabel();
+	saveinlpos = inlpos;
+	inlpos = inlblock(fn, n);
+	inlcallno = n->lineno;
 	body = inlsubstlist(fn->inl);
+	inlpos = saveinlpos;
 
 	body = list(body, nod(OGOTO, inlretlabel, N));	// avoid 'not used' when function doesnt have return
 	body = list(body, nod(OLABEL, inlretlabel, N));
@@ -654,20 +777,21 @@ mkinlcall1(Node **np, Node *fn)
 	call->type = n->type;
 	call->typecheck = 1;
 
-	setlno(call, n->lineno);
-
 	*np = call;
 
 	inlfn =	saveinlfn;
 
-	// transitive inlining
+	// transitive inlining: caninl counted the bodies of the inlineable
+	// functions fn calls, so expand them too.
 	// TODO do this pre-expansion on fn->inl directly.  requires
 	// either supporting exporting statemetns with complex ninits
 	// or saving inl and making inlinl
-	if(debug['l'] >= 5) {
+	{
 		body = fn->inl;
 		fn->inl = nil;	// prevent infinite recursion
+		inlnest++;
 		inlnodelist(call->nbody);
+		inlnest--;
 		for(ll=call->nbody; ll; ll=ll->next)
 			if(ll->n->op == OINLCALL)
 				inlconv2stmt(ll->n);
@@ -694,6 +818,7 @@ inlvar(Node *var)
 	n->type = var->type;
 	n->class = PAUTO;
 	n->used = 1;
+	n->typecheck = 1;	// the copied body is not typechecked again
 	n->curfn = curfn;   // the calling function, not the called one
 	curfn->dcl = list(curfn->dcl, n);
 	return n;
@@ -710,6 +835,7 @@ retvar(Type *t, int i)
 	n->type = t->type;
 	n->class = PAUTO;
 	n->used = 1;
+	n->typecheck = 1;
 	n->curfn = curfn;   // the calling function, not the called one
 	curfn->dcl = list(curfn->dcl, n);
 	return n;
@@ -748,6 +874,7 @@ inlsubst(Node *n)
 {
 	Node *m, *as;
 	NodeList *ll;
+	int32 lno;
 
 	if(n == N)
 		return N;
@@ -771,6 +898,8 @@ inlsubst(Node *n)
 		// Since we don't handle bodies with closures, this return is guaranteed to belong to the current inlined function.
 
 //		dump("Return before substitution", n);
+		lno = lineno;
+		lineno = inlline(n->lineno);
 		m = nod(OGOTO, inlretlabel, N);
 		m->ninit  = inlsubstlist(n->ninit);
 
@@ -786,6 +915,7 @@ inlsubst(Node *n)
 
 		typechecklist(m->ninit, Etop);
 		typecheck(&m, Etop);
+		lineno = lno;
 //		dump("Return after substitution", m);
 		return m;
 	}
@@ -793,6 +923,7 @@ inlsubst(Node *n)
 
 	m = nod(OXXX, N, N);
 	*m = *n;
+	m->lineno = inlline(n->lineno);
 	m->ninit = nil;
 	
 	if(n->op == OCLOSURE)
@@ -811,31 +942,60 @@ inlsubst(Node *n)
 	return m;
 }
 
-// Plaster over linenumbers
-static void
-setlnolist(NodeList *ll, int lno)
+// Inlblock gives the copy of fn's body made for the call n a block of
+// absolute lines of its own, past those of the source, in which line
+// lo is the line of fn's header in its file, and records it in curfn's
+// Inlcalls.  Without a known position for fn it returns nil, and the
+// body gets the line of the call, as if it were part of the caller.
+static Inlcall*
+inlblock(Node *fn, Node *n)
 {
-	for(;ll;ll=ll->next)
-		setlno(ll->n, lno);
+	static int32 next;
+	Inlcall *ic;
+	int32 end;
+
+	if(fn->inlfile == nil && fn->defn != N)
+		fn->inlfile = linefile(fn->lineno, &fn->inlline);
+	if(fn->inlfile == nil || fn->inlline <= 0)
+		return nil;
+
+	if(fn->defn != N)
+		end = fn->defn->endlineno;
+	else
+		end = fn->endlineno;
+	if(end < fn->lineno)
+		end = fn->lineno;
+	if(next <= lexlineno)
+		next = lexlineno + 1;
+
+	ic = mal(sizeof *ic);
+	if(n->op == OCALLMETH)
+		ic->sym = n->left->right->sym;	// see cgen_callmeth
+	else
+		ic->sym = n->left->sym;
+	ic->lo = next;
+	ic->hi = next + end - fn->lineno;
+	ic->lineno = n->lineno;
+	ic->link = curfn->inlcall;
+	curfn->inlcall = ic;
+
+	addhist(fn->inlfile, ic->lo, fn->inlline);
+	addhist(nil, ic->hi+1, 0);
+	next = ic->hi + 2;
+	return ic;
 }
 
-static void
-setlno(Node *n, int lno)
+// The line in the block of the body being substituted
+// that corresponds to line lno of the original.
+static int32
+inlline(int32 lno)
 {
-	if(!n)
-		return;
-
-	// don't clobber names, unless they're freshly synthesized
-	if(n->op != ONAME || n->lineno == 0)
-		n->lineno = lno;
-	
-	setlno(n->left, lno);
-	setlno(n->right, lno);
-	setlnolist(n->list, lno);
-	setlnolist(n->rlist, lno);
-	setlnolist(n->ninit, lno);
-	setlno(n->ntest, lno);
-	setlno(n->nincr, lno);
-	setlnolist(n->nbody, lno);
-	setlnolist(n->nelse, lno);
+	int32 d;
+
+	if(inlpos == nil)
+		return inlcallno;
+	d = lno - inlfn->lineno;
+	if(d < 0 || d > inlpos->hi - inlpos->lo)
+		d = 0;
+	return inlpos->lo + d;
 }
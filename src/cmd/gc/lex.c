@@ -28,6 +28,10 @@ static int32	getr(void);
 static int	escchar(int, int*, vlong*);
 static void	addidir(char*);
 static int	getlinepragma(void);
+static void	scanrefs(char*);
+static void	loadsrc(Biobuf*);
+static void	skiprun(int);
+static char*	getrun(char*, char*, int, uint32*);
 static char *goos, *goarch, *goroot;
 
 // Compiler experiments.
@@ -122,6 +126,22 @@ yy_isalnum(int c)
 #define isalnum use_yy_isalnum_instead_of_isalnum
 
 #define	DBG	if(!debug['x']){}else print
+
+/*
+ * classes of source bytes, for the loops that
+ * scan a file in memory a run at a time.
+ */
+enum
+{
+	Cident	= 1<<0,	// ASCII letter, digit or _
+	Cdigit	= 1<<1,
+	Chex	= 1<<2,
+	Cblank	= 1<<3,	// space, tab, \r
+	Ctext	= 1<<4,	// ASCII other than NUL and \n, in comments
+};
+
+static uchar	ctab[256];
+
 enum
 {
 	EOF		= -1,
@@ -148,13 +168,18 @@ usage(void)
 	// -y print declarations in cannedimports (used with -d)
 	// -% print non-static initializers
 	// -+ indicate that the runtime is being compiled
+	print("  -C report eliminated bounds and nil checks\n");
 	print("  -D PATH interpret local imports relative to this import path\n");
+	print("  -F file read profile feedback from file (see go tool prof -F)\n");
 	print("  -I DIR search for packages in DIR\n");
 	print("  -L show full path in file:line prints\n");
 	print("  -N disable optimizations\n");
 	print("  -S print the assembly language\n");
+	print("  -T disable the tree optimizer (CSE, code motion, dead stores)\n");
 	print("  -V print the compiler version\n");
 	print("  -W print the parse tree after typing\n");
+	print("  -b N inlining budget, in nodes (default 40)\n");
+	print("  -c instrument basic blocks with coverage counters (-c -c counts runs)\n");
 	print("  -d print declarations\n");
 	print("  -e no limit on number of errors printed\n");
 	print("  -f print stack frame structure\n");
@@ -224,6 +249,8 @@ main(int argc, char *argv[])
 	setexp();
 
 	outfile = nil;
+	pgofile = nil;
+	inlbudget = 40;
 	ARGBEGIN {
 	default:
 		c = ARGC();
@@ -243,6 +270,14 @@ main(int argc, char *argv[])
 		safemode = 1;
 		break;
 
+	case 'b':
+		inlbudget = atoi(EARGF(usage()));
+		break;
+
+	case 'F':
+		pgofile = EARGF(usage());
+		break;
+
 	case 'D':
 		localimport = EARGF(usage());
 		break;
@@ -291,6 +326,9 @@ main(int argc, char *argv[])
 	if(widthptr == 0)
 		fatal("betypeinit failed");
 
+	if(pgofile != nil)
+		pgoload(pgofile);
+
 	lexinit();
 	typeinit();
 	lexinit1();
@@ -301,16 +339,22 @@ main(int argc, char *argv[])
 	nerrors = 0;
 	lexlineno = 1;
 
+	// note the names the files use after a dot, so that
+	// imports can skip the declarations they cannot use.
+	for(i=0; i<argc; i++)
+		scanrefs(argv[i]);
+
 	for(i=0; i<argc; i++) {
 		infile = argv[i];
 		linehist(infile, 0, 0);
 
 		curio.infile = infile;
-		curio.bin = Bopen(infile, OREAD);
+		curio.bin = Bopenmap(infile, OREAD);
 		if(curio.bin == nil) {
 			print("open %s: %r\n", infile);
 			errorexit();
 		}
+		loadsrc(curio.bin);
 		curio.peekc = 0;
 		curio.peekc1 = 0;
 		curio.nlsemi = 0;
@@ -325,6 +369,9 @@ main(int argc, char *argv[])
 		linehist(nil, 0, 0);
 		if(curio.bin != nil)
 			Bterm(curio.bin);
+		free(curio.buf);
+		curio.buf = nil;
+		curio.ep = nil;
 	}
 	testdclstack();
 	mkpackage(localpkg->name);	// final import not used checks
@@ -367,7 +414,15 @@ main(int argc, char *argv[])
 	if(nsavederrors+nerrors)
 		errorexit();
 
-	// Phase 4: Inlining
+	// Coverage counters go in before inlining copies function bodies.
+	if(debug['c'])
+		cover(xtop);
+
+	// Phase 4: Profile feedback and inlining
+	for(l=xtop; l; l=l->next)
+		if(l->n->op == ODCLFUNC)
+			pgolayout(l->n);
+
 	if(debug['l'] > 1) {
 		// Typecheck imported function bodies if debug['l'] > 1,
 		// otherwise lazily when used or re-exported.
@@ -580,7 +635,6 @@ importfile(Val *f, int line)
 {
 	Biobuf *imp;
 	char *file, *p, *q;
-	int32 c;
 	int len;
 	Strlit *path;
 	char *cleanbuf, *prefix;
@@ -654,7 +708,7 @@ importfile(Val *f, int line)
 	}
 	importpkg = mkpkg(path);
 
-	imp = Bopen(namebuf, OREAD);
+	imp = Bopenmap(namebuf, OREAD);
 	if(imp == nil) {
 		yyerror("can't open import: \"%Z\": %r", f->u.sval);
 		errorexit();
@@ -689,32 +743,116 @@ importfile(Val *f, int line)
 	linehist(file + len - path->len - 2, -1, 1);	// acts as #pragma lib
 
 	/*
-	 * position the input right
-	 * after $$ and return
+	 * read the export data and give the parser
+	 * the declarations these files may use.
 	 */
+	p = readexports(imp);
+	Bterm(imp);
+	if(p == nil) {
+		yyerror("no import in \"%Z\"", f->u.sval);
+		fakeimport();
+		return;
+	}
+
 	pushedio = curio;
-	curio.bin = imp;
+	curio.bin = nil;
+	curio.cp = p;
+	curio.ep = nil;
 	curio.peekc = 0;
 	curio.peekc1 = 0;
 	curio.infile = file;
 	curio.nlsemi = 0;
 	typecheckok = 1;
+}
 
-	for(;;) {
-		c = getc();
-		if(c == EOF)
-			break;
-		if(c != '$')
+/*
+ * note the names that follow a dot in file.
+ * they are the only names it can use from an imported
+ * package, unless it imports one with a dot.
+ * errors are left for the parser to report.
+ */
+static void
+scanrefs(char *file)
+{
+	Biobuf *b;
+	char buf[NSYMB];
+	int c, c1, dot, n;
+
+	b = Bopenmap(file, OREAD);
+	if(b == nil)
+		return;
+	dot = 0;
+	c = Bgetc(b);
+	while(c != Beof) {
+		if(c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+			c = Bgetc(b);
 			continue;
-		c = getc();
-		if(c == EOF)
-			break;
-		if(c != '$')
+		}
+		if(c == '/') {
+			c = Bgetc(b);
+			if(c == '/') {
+				while(c != Beof && c != '\n')
+					c = Bgetc(b);
+				continue;
+			}
+			if(c == '*') {
+				c1 = 0;
+				while((c = Bgetc(b)) != Beof && (c1 != '*' || c != '/'))
+					c1 = c;
+				if(c != Beof)
+					c = Bgetc(b);
+				continue;
+			}
+			dot = 0;
 			continue;
-		return;
+		}
+		if(c == '"' || c == '\'' || c == '`') {
+			if(dot && c == '"')
+				importref(nil, 0);	// import . "path"
+			dot = 0;
+			c1 = c;
+			while((c = Bgetc(b)) != Beof && c != c1) {
+				if(c == '\\' && c1 != '`')
+					c = Bgetc(b);
+				if(c == Beof || (c == '\n' && c1 != '`'))
+					break;
+			}
+			if(c != Beof)
+				c = Bgetc(b);
+			continue;
+		}
+		if(c == '.') {
+			dot = 1;
+			c = Bgetc(b);
+			continue;
+		}
+		if(yy_isdigit(c)) {
+			while(c != Beof && (yy_isalnum(c) || c == '.'))
+				c = Bgetc(b);
+			dot = 0;
+			continue;
+		}
+		if(yy_isalpha(c) || c == '_' || c >= Runeself) {
+			n = 0;
+			while(c != Beof && (yy_isalnum(c) || c == '_' || c >= Runeself)) {
+				if(n < sizeof buf)
+					buf[n] = c;
+				n++;
+				c = Bgetc(b);
+			}
+			if(dot) {
+				if(n <= sizeof buf)
+					importref(buf, n);
+				else
+					importref(nil, 0);
+			}
+			dot = 0;
+			continue;
+		}
+		dot = 0;
+		c = Bgetc(b);
 	}
-	yyerror("no import in \"%Z\"", f->u.sval);
-	unimportfile();
+	Bterm(b);
 }
 
 void
@@ -723,7 +861,7 @@ unimportfile(void)
 	if(curio.bin != nil) {
 		Bterm(curio.bin);
 		curio.bin = nil;
-	} else
+	} else if(incannedimport)
 		lexlineno--;	// re correct sys.6 line number
 
 	curio = pushedio;
@@ -743,6 +881,7 @@ cannedimports(char *file, char *cp)
 	curio.peekc1 = 0;
 	curio.infile = file;
 	curio.cp = cp;
+	curio.ep = nil;
 	curio.nlsemi = 0;
 	curio.importsafe = 0;
 
@@ -775,7 +914,8 @@ struct Loophack {
 static int32
 _yylex(void)
 {
-	int c, c1, clen, escflag, ncp;
+	int c, c1, clen, escflag, ncp, ascii;
+	uint32 sum;
 	vlong v;
 	char *cp, *ep;
 	Rune rune;
@@ -786,6 +926,7 @@ _yylex(void)
 	prevlineno = lineno;
 
 l0:
+	skiprun(Cblank);
 	c = getc();
 	if(yy_isspace(c)) {
 		if(c == '\n' && curio.nlsemi) {
@@ -797,6 +938,8 @@ l0:
 	}
 
 	lineno = lexlineno;	/* start of token */
+	if(impinlfile != nil)
+		lineno += implineno - impinlbase;
 
 	if(c >= Runeself) {
 		/* all multibyte runes are alpha */
@@ -956,6 +1099,7 @@ l0:
 					ungetc(c);
 					goto l0;
 				}
+				skiprun(Ctext);
 				c = getr();
 			}
 		}
@@ -1183,8 +1327,12 @@ asop:
 talph:
 	/*
 	 * cp is set to lexbuf and some
-	 * prefix has been stored
+	 * prefix has been stored.
+	 * sum adds up the bytes for lookuph
+	 * while the name is all ASCII.
 	 */
+	sum = 0;
+	ascii = 1;
 	for(;;) {
 		if(cp+10 >= ep) {
 			yyerror("identifier too long");
@@ -1197,16 +1345,23 @@ talph:
 			if(!isalpharune(rune) && !isdigitrune(rune) && (importpkg == nil || rune != 0xb7))
 				yyerror("invalid identifier character 0x%ux", rune);
 			cp += runetochar(cp, &rune);
+			ascii = 0;
 		} else if(!yy_isalnum(c) && c != '_')
 			break;
-		else
+		else {
 			*cp++ = c;
+			sum = sum*PRIME1 + c;
+			cp = getrun(cp, ep, Cident, &sum);
+		}
 		c = getc();
 	}
 	*cp = 0;
 	ungetc(c);
 
-	s = lookup(lexbuf);
+	if(ascii)
+		s = lookuph(lexbuf, sum);
+	else
+		s = lookup(lexbuf);
 	switch(s->lexical) {
 	case LIGNORE:
 		goto l0;
@@ -1233,6 +1388,7 @@ tnum:
 				errorexit();
 			}
 			*cp++ = c;
+			cp = getrun(cp, ep, Cdigit, nil);
 			c = getc();
 			if(yy_isdigit(c))
 				continue;
@@ -1248,6 +1404,7 @@ tnum:
 				errorexit();
 			}
 			*cp++ = c;
+			cp = getrun(cp, ep, Chex, nil);
 			c = getc();
 			if(yy_isdigit(c))
 				continue;
@@ -1322,6 +1479,7 @@ casedot:
 			errorexit();
 		}
 		*cp++ = c;
+		cp = getrun(cp, ep, Cdigit, nil);
 		c = getc();
 		if(!yy_isdigit(c))
 			break;
@@ -1418,6 +1576,7 @@ getlinepragma(void)
 	int i, c, n;
 	char *cp, *ep, *linep;
 	Hist *h;
+	static char *impfile;
 
 	for(i=0; i<5; i++) {
 		c = getr();
@@ -1459,6 +1618,17 @@ getlinepragma(void)
 	if(n <= 0)
 		goto out;
 
+	if(pushedio.bin != nil) {
+		// in import data it gives the position of the
+		// inlinable func that follows; see funchdr.
+		if(impfile == nil || strcmp(impfile, lexbuf) != 0)
+			impfile = strdup(lexbuf);
+		impinlfile = impfile;
+		impinlline = n;
+		impinlbase = implineno;
+		goto out;
+	}
+
 	// try to avoid allocating file name over and over
 	for(h=hist; h!=H; h=h->link) {
 		if(h->name != nil && strcmp(h->name, lexbuf) == 0) {
@@ -1522,7 +1692,11 @@ getc(void)
 		goto check;
 	}
 	
-	if(curio.bin == nil) {
+	if(curio.ep != nil) {
+		c = EOF;
+		if(curio.cp < curio.ep)
+			c = *curio.cp++ & 0xff;
+	} else if(curio.bin == nil) {
 		c = *curio.cp & 0xff;
 		if(c != 0)
 			curio.cp++;
@@ -1545,6 +1719,8 @@ check:
 	case '\n':
 		if(pushedio.bin == nil)
 			lexlineno++;
+		else
+			implineno++;
 		break;
 	}
 	return c;
@@ -1555,8 +1731,12 @@ ungetc(int c)
 {
 	curio.peekc1 = curio.peekc;
 	curio.peekc = c;
-	if(c == '\n' && pushedio.bin == nil)
-		lexlineno--;
+	if(c == '\n') {
+		if(pushedio.bin == nil)
+			lexlineno--;
+		else
+			implineno--;
+	}
 }
 
 static int32
@@ -1590,6 +1770,101 @@ loop:
 	return rune;
 }
 
+/*
+ * put the source in b in memory, for getc and the
+ * run loops to read directly: the mapping Bopenmap
+ * made if it could, else a copy of the file.
+ */
+static void
+loadsrc(Biobuf *b)
+{
+	char *p;
+	long n, m, r;
+
+	curio.buf = nil;
+	if(BMAPPED(b)) {
+		n = Bbuffered(b);
+		p = Bgetspan(b, n);
+		if(p != nil) {
+			curio.cp = p;
+			curio.ep = p + n;
+			return;
+		}
+	}
+
+	n = 0;
+	m = 64*1024;
+	p = malloc(m);
+	for(;;) {
+		if(p == nil) {
+			flusherrors();
+			yyerror("out of memory");
+			errorexit();
+		}
+		r = Bread(b, p+n, m-n);
+		if(r <= 0)
+			break;
+		n += r;
+		if(n == m) {
+			m *= 2;
+			p = realloc(p, m);
+		}
+	}
+	curio.buf = p;
+	curio.cp = p;
+	curio.ep = p + n;
+}
+
+/*
+ * skip the run of bytes of class cl
+ * next in a source file in memory.
+ */
+static void
+skiprun(int cl)
+{
+	uchar *p, *e;
+
+	if(curio.ep == nil || curio.peekc != 0)
+		return;
+	p = (uchar*)curio.cp;
+	e = (uchar*)curio.ep;
+	while(p < e && (ctab[*p] & cl))
+		p++;
+	curio.cp = (char*)p;
+}
+
+/*
+ * copy to cp the run of bytes of class cl next in a
+ * source file in memory, leaving room for the checks
+ * against ep, and return the new cp.
+ * if sum is not nil, add the bytes into it.
+ */
+static char*
+getrun(char *cp, char *ep, int cl, uint32 *sum)
+{
+	uchar *p, *e;
+	uint32 h;
+
+	if(curio.ep == nil || curio.peekc != 0)
+		return cp;
+	p = (uchar*)curio.cp;
+	e = (uchar*)curio.ep;
+	ep -= 11;
+	if(sum != nil) {
+		h = *sum;
+		while(p < e && cp < ep && (ctab[*p] & cl)) {
+			h = h*PRIME1 + *p;
+			*cp++ = *p++;
+		}
+		*sum = h;
+	} else {
+		while(p < e && cp < ep && (ctab[*p] & cl))
+			*cp++ = *p++;
+	}
+	curio.cp = (char*)p;
+	return cp;
+}
+
 static int
 escchar(int e, int *escflg, vlong *val)
 {
@@ -1795,6 +2070,19 @@ lexinit(void)
 	int etype;
 	Val v;
 
+	for(i=0; i<nelem(ctab); i++) {
+		if(i < Runeself && i != 0 && i != '\n')
+			ctab[i] |= Ctext;
+		if(i < Runeself && (yy_isalnum(i) || i == '_'))
+			ctab[i] |= Cident;
+		if(yy_isdigit(i))
+			ctab[i] |= Cdigit|Chex;
+		if((i >= 'a' && i <= 'f') || (i >= 'A' && i <= 'F'))
+			ctab[i] |= Chex;
+		if(i == ' ' || i == '\t' || i == '\r')
+			ctab[i] |= Cblank;
+	}
+
 	/*
 	 * initialize basic types array
 	 * initialize known symbols
@@ -2176,7 +2464,7 @@ mkpackage(char* pkgname)
 	} else {
 		if(strcmp(pkgname, localpkg->name) != 0)
 			yyerror("package %s; expected %s", pkgname, localpkg->name);
-		for(h=0; h<NHASH; h++) {
+		for(h=0; h<nhash; h++) {
 			for(s = hash[h]; s != S; s = s->link) {
 				if(s->def == N || s->pkg != localpkg)
 					continue;
@@ -12,6 +12,7 @@
 
 static	void	outhist(Biobuf *b);
 static	void	dumpglobls(void);
+static	void	dumpinlcalls(void);
 
 void
 dumpobj(void)
@@ -33,7 +34,9 @@ dumpobj(void)
 
 	dumpglobls();
 	dumptypestructs();
+	dumpinlcalls();
 	dumpdata();
+	finishfuncs();
 	dumpfuncs();
 
 	Bterm(bout);
@@ -63,6 +66,39 @@ dumpglobls(void)
 	}
 }
 
+/*
+ * the calls inlined into each function, for the linker's
+ * pc/inline table (see ../ld/functab.c): in f·inl, for each
+ * call, the block of lines of the copied body, the line of
+ * the call, a word of padding and the callee's text symbol.
+ */
+static void
+dumpinlcalls(void)
+{
+	NodeList *l;
+	Node *fn;
+	Inlcall *ic;
+	Sym *s;
+	int off;
+
+	for(l=xtop; l; l=l->next) {
+		fn = l->n;
+		if(fn->op != ODCLFUNC || fn->inlcall == nil || fn->nbody == nil || isblank(fn->nname))
+			continue;
+		snprint(namebuf, sizeof(namebuf), "%s·inl", fn->nname->sym->name);
+		s = pkglookup(namebuf, fn->nname->sym->pkg);
+		off = 0;
+		for(ic=fn->inlcall; ic; ic=ic->link) {
+			off = duint32(s, off, ic->lo);
+			off = duint32(s, off, ic->hi);
+			off = duint32(s, off, ic->lineno);
+			off = duint32(s, off, 0);
+			off = dsymptr(s, off, ic->sym, 0);
+		}
+		ggloblsym(s, off, fn->dupok);
+	}
+}
+
 void
 Bputname(Biobuf *b, Sym *s)
 {
@@ -0,0 +1,1322 @@
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Tree optimizer.
+//
+// Runs on the walked body of each function, after bce and before
+// code generation, and removes redundant computation:
+//
+//	- common subexpressions: a pure expression computed again while
+//	  the variables and memory it reads are unchanged is replaced by
+//	  a temporary set where it was first computed, or by the
+//	  variable it was first assigned to;
+//	- loop invariants: a pure expression in a loop that cannot fault
+//	  and reads no variable the loop assigns is computed once,
+//	  before the loop;
+//	- copies: after x = y, reads of x use y until either changes;
+//	- dead code: assignments of pure values to locals that are never
+//	  read, and the arm of an if statement that a constant test
+//	  never runs.
+//
+// This is not the SSA back end with linear-scan allocation that was
+// once planned: there is no SSA form, no dataflow over a control flow
+// graph, and registers are still allocated by ../6g/reg.c.
+//
+// Every assignment to a variable starts a new value of it, as in SSA
+// form.  The pass does not build that form explicitly; instead it
+// tracks which values are available along the structured control
+// flow of the tree: a statement dominates the statements after it in
+// its list and everything nested in them, a label starts over, and
+// a loop starts with what is available before it minus what the
+// loop changes.  New temporaries are set in the init list of the
+// statement that first needs them, or of the loop they are hoisted
+// out of, and are left to the back end's registerizer.
+//
+// Only locals whose address is never taken are tracked as variables.
+// Loads through pointers, of globals and of slice elements are
+// available until the next store to memory or call.
+//
+// The -T flag turns the pass off, for comparison.
+
+#include <u.h>
+#include <libc.h>
+#include "go.h"
+
+enum
+{
+	Nvar	= 8,	// variables per value
+	Nstack	= 256,	// available values
+	Nloop	= 16,	// loop nesting
+	Nhash	= 1024,
+
+	// visit flags
+	Fnew	= 1<<0,	// may compute new values before the statement
+	Fsafe	= 1<<1,	// only new values that can be computed early
+	Fnoload	= 1<<2,	// statement calls out: leave loads alone
+
+	// kinds of available value
+	Kexpr	= 0,	// expr, kept in a new temporary
+	Khold,		// expr, already held in variable holder
+	Kcopy,		// variable expr, equal to variable holder
+};
+
+typedef	struct	Info	Info;
+struct	Info
+{
+	Node*	var[Nvar];	// variables read
+	int	nvar;
+	int	cost;		// operations
+	uchar	load;		// reads memory
+	uchar	fault;		// can panic
+};
+
+typedef	struct	Avail	Avail;
+struct	Avail
+{
+	int	kind;
+	Node*	expr;
+	Node**	slot;		// Kexpr: first occurrence
+	Node*	where;		// Kexpr: statement whose init sets tmp
+	Node*	holder;
+	Node*	tmp;
+	Info	info;
+	int	depth;		// loop depth at which the value is set
+	int	nuse;
+	uchar	dead;
+	uchar	hoist;
+};
+
+typedef	struct	Use	Use;
+struct	Use
+{
+	Node**	slot;
+	int	a;
+};
+
+typedef	struct	Loop	Loop;
+struct	Loop
+{
+	Node*	n;
+	NodeList*	var;	// variables assigned in the loop
+	uchar	all;		// might assign any variable
+	uchar	mem;		// stores to memory or calls out
+};
+
+typedef	struct	Count	Count;
+struct	Count
+{
+	Node*	v;
+	int	n;
+	Count*	link;
+};
+
+static	Avail*	avail;
+static	int	navail;
+static	int	mavail;
+static	int	stack[Nstack];
+static	int	nstack;
+static	Use*	uses;
+static	int	nuses;
+static	int	muses;
+static	Loop	loops[Nloop];
+static	int	nloop;
+static	Node*	stmt;
+static	NodeList*	shared[Nhash];
+static	NodeList*	addressed[Nhash];
+static	NodeList*	declared[Nhash];
+static	Count*	reads[Nhash];
+
+static void optlist(NodeList*);
+static void optstmt(Node*);
+
+static uint32
+ptrhash(Node *n)
+{
+	return ((uintptr)n >> 4) % Nhash;
+}
+
+static int
+inset(NodeList **h, Node *n)
+{
+	NodeList *l;
+
+	for(l=h[ptrhash(n)]; l; l=l->next)
+		if(l->n == n)
+			return 1;
+	return 0;
+}
+
+static void
+addset(NodeList **h, Node *n)
+{
+	uint32 i;
+
+	if(inset(h, n))
+		return;
+	i = ptrhash(n);
+	h[i] = list(h[i], n);
+}
+
+// The variable that n names; copies of an ONAME share their orig.
+static Node*
+vark(Node *n)
+{
+	if(n->orig != N)
+		return n->orig;
+	return n;
+}
+
+// The variable that an assignment to n changes, or N if it stores
+// to memory.
+static Node*
+base(Node *n)
+{
+	for(;;) {
+		switch(n->op) {
+		case ONAME:
+			return n;
+		case ODOT:
+			n = n->left;
+			continue;
+		case OINDEX:
+			if(isfixedarray(n->left->type)) {
+				n = n->left;
+				continue;
+			}
+			break;
+		}
+		return N;
+	}
+}
+
+static int
+local(Node *n)
+{
+	Node *v;
+
+	if(n == N || n->op != ONAME || n->addrtaken || isblank(n))
+		return 0;
+	// the result slots that nodarg makes for return are PPARAM,
+	// with the declared result, if any, as orig.
+	v = vark(n);
+	if(v->addrtaken || (v->class != PAUTO && v->class != PPARAM))
+		return 0;
+	return inset(declared, v) && !inset(addressed, v);
+}
+
+static int
+simple(Type *t)
+{
+	if(t == T)
+		return 0;
+	return isint[t->etype] || isfloat[t->etype] || isptr[t->etype] || t->etype == TUNSAFEPTR;
+}
+
+static int
+hasvar(Info *in, Node *v)
+{
+	int i;
+
+	v = vark(v);
+	for(i=0; i<in->nvar; i++)
+		if(in->var[i] == v)
+			return 1;
+	return 0;
+}
+
+static int
+infovar(Info *in, Node *v)
+{
+	if(hasvar(in, v))
+		return 1;
+	if(in->nvar >= Nvar)
+		return 0;
+	in->var[in->nvar++] = vark(v);
+	return 1;
+}
+
+// Is n an expression without side effects other than a panic?
+// Records what it reads in in.
+static int
+pure(Node *n, Info *in)
+{
+	Type *t;
+
+	if(n == N)
+		return 1;
+	if(n->ninit != nil || inset(shared, n))
+		return 0;
+	switch(n->op) {
+	case OLITERAL:
+		return 1;
+
+	case ONAME:
+		if(local(n))
+			return infovar(in, n);
+		if(n->class == PEXTERN) {
+			in->load = 1;
+			return 1;
+		}
+		return 0;
+
+	case OADD:
+	case OSUB:
+	case OMUL:
+	case OAND:
+	case OOR:
+	case OXOR:
+	case OANDNOT:
+	case OLSH:
+	case ORSH:
+	case ODIV:
+	case OMOD:
+		if(!simple(n->type))
+			return 0;
+		if((n->op == ODIV || n->op == OMOD) && isint[n->type->etype])
+			in->fault = 1;
+		in->cost++;
+		return pure(n->left, in) && pure(n->right, in);
+
+	case OMINUS:
+	case OCOM:
+	case OPLUS:
+	case OCONV:
+		if(!simple(n->type) || !simple(n->left->type))
+			return 0;
+		in->cost++;
+		return pure(n->left, in);
+
+	case OCONVNOP:
+		if(!simple(n->type) || !simple(n->left->type))
+			return 0;
+		return pure(n->left, in);
+
+	case OLEN:
+	case OCAP:
+		t = n->left->type;
+		if(t == T || (!isslice(t) && t->etype != TSTRING))
+			return 0;
+		return pure(n->left, in);
+
+	case ODOT:
+		return pure(n->left, in);
+
+	case ODOTPTR:
+	case OIND:
+		in->cost++;
+		in->load = 1;
+		in->fault = 1;
+		return pure(n->left, in);
+
+	case OINDEX:
+		t = n->left->type;
+		if(t == T || t->etype == TMAP)
+			return 0;
+		in->cost++;
+		if(!n->bounded)
+			in->fault = 1;
+		// string bytes never change; local arrays are variables.
+		if(t->etype != TSTRING && !(isfixedarray(t) && local(base(n->left))))
+			in->load = 1;
+		return pure(n->left, in) && pure(n->right, in);
+	}
+	return 0;
+}
+
+static int
+candidate(Node *n, Info *in)
+{
+	return n->op != ONAME && n->op != OLITERAL && simple(n->type) && in->cost > 0;
+}
+
+// Might evaluating n call out or store to memory?
+static int
+hascall(Node *n)
+{
+	if(n == N)
+		return 0;
+	if(n->ninit != nil)
+		return 1;
+	switch(n->op) {
+	default:
+		return 1;
+	case ONAME:
+	case OLITERAL:
+		return 0;
+	case OADD:
+	case OSUB:
+	case OMUL:
+	case ODIV:
+	case OMOD:
+	case OAND:
+	case OOR:
+	case OXOR:
+	case OANDNOT:
+	case OLSH:
+	case ORSH:
+	case OMINUS:
+	case OCOM:
+	case OPLUS:
+	case ONOT:
+	case OANDAND:
+	case OOROR:
+	case OEQ:
+	case ONE:
+	case OLT:
+	case OLE:
+	case OGE:
+	case OGT:
+	case OCONV:
+	case OCONVNOP:
+	case OLEN:
+	case OCAP:
+	case ODOT:
+	case ODOTPTR:
+	case OIND:
+	case OINDEX:
+	case OADDR:
+	case OPAREN:
+		break;
+	}
+	if(n->op == OINDEX && n->left->type != T && n->left->type->etype == TMAP)
+		return 1;
+	return hascall(n->left) || (n->op != ODOT && n->op != ODOTPTR && hascall(n->right));
+}
+
+static int
+samelit(Node *a, Node *b)
+{
+	double x, y;
+
+	if(a->val.ctype != b->val.ctype)
+		return 0;
+	switch(a->val.ctype) {
+	case CTINT:
+	case CTRUNE:
+		return mpcmpfixfix(a->val.u.xval, b->val.u.xval) == 0;
+	case CTFLT:
+		// +0 and -0 compare equal but are different values.
+		x = mpgetflt(a->val.u.fval);
+		y = mpgetflt(b->val.u.fval);
+		return memcmp(&x, &y, sizeof x) == 0;
+	case CTBOOL:
+		return a->val.u.bval == b->val.u.bval;
+	case CTNIL:
+		return 1;
+	case CTSTR:
+		return cmpslit(a, b) == 0;
+	}
+	return 0;
+}
+
+static int
+same(Node *a, Node *b)
+{
+	if(a == b)
+		return 1;
+	if(a == N || b == N || a->op != b->op || a->type != b->type)
+		return 0;
+	switch(a->op) {
+	case ONAME:
+		return vark(a) == vark(b);
+	case OLITERAL:
+		return samelit(a, b);
+	case ODOT:
+	case ODOTPTR:
+		return a->xoffset == b->xoffset && same(a->left, b->left);
+	}
+	return same(a->left, b->left) && same(a->right, b->right);
+}
+
+static int
+push(int kind, Node *expr, Node *holder, Info *in)
+{
+	Avail *a;
+
+	if(nstack >= Nstack)
+		return -1;
+	if(navail >= mavail) {
+		mavail = mavail*2 + 64;
+		a = mal(mavail*sizeof a[0]);
+		if(navail > 0)
+			memmove(a, avail, navail*sizeof a[0]);
+		avail = a;
+	}
+	a = &avail[navail];
+	memset(a, 0, sizeof *a);
+	a->kind = kind;
+	a->expr = expr;
+	a->holder = holder;
+	a->info = *in;
+	a->depth = nloop;
+	stack[nstack++] = navail;
+	return navail++;
+}
+
+static int
+use(Node **slot, int a)
+{
+	Use *u;
+
+	if(nuses >= muses) {
+		muses = muses*2 + 64;
+		u = mal(muses*sizeof u[0]);
+		if(nuses > 0)
+			memmove(u, uses, nuses*sizeof u[0]);
+		uses = u;
+	}
+	uses[nuses].slot = slot;
+	uses[nuses].a = a;
+	nuses++;
+	avail[a].nuse++;
+	return avail[a].depth;
+}
+
+static int
+findavail(Node *n, Info *in, int fl)
+{
+	int i;
+	Avail *a;
+
+	if((fl & Fnoload) && in->load)
+		return -1;
+	for(i=nstack-1; i>=0; i--) {
+		a = &avail[stack[i]];
+		if(!a->dead && a->kind != Kcopy && same(a->expr, n))
+			return stack[i];
+	}
+	return -1;
+}
+
+static int
+lookcopy(Node *n)
+{
+	int i;
+	Avail *a;
+
+	for(i=nstack-1; i>=0; i--) {
+		a = &avail[stack[i]];
+		if(!a->dead && a->kind == Kcopy && vark(a->expr) == vark(n))
+			return stack[i];
+	}
+	return -1;
+}
+
+static void
+killvar(Node *v)
+{
+	int i;
+	Avail *a;
+
+	for(i=0; i<nstack; i++) {
+		a = &avail[stack[i]];
+		if(hasvar(&a->info, v))
+			a->dead = 1;
+	}
+}
+
+static void
+killmem(void)
+{
+	int i;
+	Avail *a;
+
+	for(i=0; i<nstack; i++) {
+		a = &avail[stack[i]];
+		if(a->info.load)
+			a->dead = 1;
+	}
+}
+
+static void
+killall(void)
+{
+	int i;
+
+	for(i=0; i<nstack; i++)
+		avail[stack[i]].dead = 1;
+}
+
+// Record the effect of an assignment to n.
+static void
+store(Node *n)
+{
+	Node *b;
+
+	b = base(n);
+	if(local(b))
+		killvar(b);
+	else if(b == N || !isblank(b))
+		killmem();
+}
+
+static int
+loopassigns(Loop *lp, Info *in)
+{
+	NodeList *l;
+
+	if(lp->all)
+		return 1;
+	for(l=lp->var; l; l=l->next)
+		if(hasvar(in, l->n))
+			return 1;
+	return 0;
+}
+
+// The outermost loop depth to which a value that reads in and
+// reuses values set at depth d can be hoisted.
+static int
+hoistdepth(Info *in, int d)
+{
+	int i;
+
+	if(d < 0)
+		d = 0;
+	for(i=nloop-1; i>=d; i--)
+		if(loopassigns(&loops[i], in))
+			return i+1;
+	return d;
+}
+
+static int visit(Node**, int);
+
+static int
+visitkids(Node *n, int fl)
+{
+	int d, d1;
+
+	d = visit(&n->left, fl);
+	if(n->op != ODOT && n->op != ODOTPTR) {
+		d1 = visit(&n->right, fl);
+		if(d1 > d)
+			d = d1;
+	}
+	return d;
+}
+
+// Visit the value *np of the current statement: replace it if it is
+// available, else make it available.  Returns the deepest loop depth
+// at which a value it reuses is set, or -1.
+static int
+visit(Node **np, int fl)
+{
+	Node *n;
+	Info in;
+	int a, d, d1, k;
+
+	n = *np;
+	if(n == N || inset(shared, n))
+		return -1;
+	if(n->op == ONAME) {
+		a = lookcopy(n);
+		if(a >= 0)
+			return use(np, a);
+		return -1;
+	}
+	memset(&in, 0, sizeof in);
+	if(!pure(n, &in)) {
+		if(n->ninit != nil)
+			return -1;
+		switch(n->op) {
+		case OANDAND:
+		case OOROR:
+			// the right side runs only sometimes.
+			d = visit(&n->left, fl);
+			d1 = visit(&n->right, fl|Fsafe);
+			if(d1 > d)
+				d = d1;
+			return d;
+		case OEQ:
+		case ONE:
+		case OLT:
+		case OLE:
+		case OGE:
+		case OGT:
+		case ONOT:
+		case OADD:
+		case OSUB:
+		case OMUL:
+		case ODIV:
+		case OMOD:
+		case OAND:
+		case OOR:
+		case OXOR:
+		case OANDNOT:
+		case OLSH:
+		case ORSH:
+		case OMINUS:
+		case OCOM:
+		case OPLUS:
+		case OCONV:
+		case OCONVNOP:
+		case OLEN:
+		case OCAP:
+		case ODOT:
+		case ODOTPTR:
+		case OIND:
+		case OINDEX:
+			return visitkids(n, fl);
+		}
+		return -1;
+	}
+	if(!candidate(n, &in) || ((fl & Fnoload) && in.load))
+		return visitkids(n, fl);
+
+	a = findavail(n, &in, fl);
+	if(a >= 0)
+		return use(np, a);
+
+	d = visitkids(n, fl);
+
+	// make it available: hoist it out of loops that do not
+	// change it if that is safe, else set it before the statement.
+	if((in.load || in.fault) && (fl & Fsafe))
+		return d;
+	k = nloop;
+	if(!in.load && !in.fault)
+		k = hoistdepth(&in, d);
+	if(k >= nloop && !(fl & Fnew))
+		return d;
+	a = push(Kexpr, n, N, &in);
+	if(a < 0)
+		return d;
+	avail[a].slot = np;
+	if(k < nloop) {
+		avail[a].where = loops[k].n;
+		avail[a].depth = k;
+		avail[a].hoist = 1;
+	} else
+		avail[a].where = stmt;
+	if(avail[a].depth > d)
+		d = avail[a].depth;
+	return d;
+}
+
+// Visit the values in the assigned expression *np.
+static void
+visitlv(Node **np, int fl)
+{
+	Node *n;
+
+	n = *np;
+	if(n == N || inset(shared, n))
+		return;
+	switch(n->op) {
+	case ODOT:
+		visitlv(&n->left, fl);
+		break;
+	case OINDEX:
+		if(isfixedarray(n->left->type))
+			visitlv(&n->left, fl);
+		else
+			visit(&n->left, fl);
+		visit(&n->right, fl);
+		break;
+	case ODOTPTR:
+	case OIND:
+		visit(&n->left, fl);
+		break;
+	}
+}
+
+// After l = r, l holds r.
+static void
+hold(Node *l, Node *r)
+{
+	Info in;
+	int a;
+
+	if(!local(l) || r == N || inset(shared, r))
+		return;
+	memset(&in, 0, sizeof in);
+	if(r->op == ONAME) {
+		if(!local(r) || vark(r) == vark(l) || r->type != l->type)
+			return;
+		a = lookcopy(r);
+		if(a >= 0 && avail[a].holder->type == l->type)
+			r = avail[a].holder;
+		infovar(&in, l);
+		infovar(&in, r);
+		push(Kcopy, l, r, &in);
+		return;
+	}
+	if(!pure(r, &in) || !candidate(r, &in) || r->type != l->type)
+		return;
+	if(hasvar(&in, l) || !infovar(&in, l))
+		return;
+	push(Khold, r, l, &in);
+}
+
+static void
+loopstore(Loop *lp, Node *n)
+{
+	Node *b;
+	NodeList *l;
+
+	b = base(n);
+	if(local(b)) {
+		for(l=lp->var; l; l=l->next)
+			if(vark(l->n) == vark(b))
+				return;
+		lp->var = list(lp->var, b);
+	} else if(b == N || !isblank(b))
+		lp->mem = 1;
+}
+
+static void loopscanlist(Loop*, NodeList*);
+
+// Record in lp what n changes.
+static void
+loopscan(Loop *lp, Node *n)
+{
+	NodeList *l;
+
+	if(n == N)
+		return;
+	switch(n->op) {
+	default:
+		lp->all = 1;
+		lp->mem = 1;
+		break;
+
+	case OAS:
+	case OASOP:
+	case ODCL:
+		loopstore(lp, n->left);
+		break;
+
+	case OAS2:
+	case OAS2FUNC:
+	case OAS2RECV:
+	case OAS2MAPR:
+	case OAS2DOTTYPE:
+		for(l=n->list; l; l=l->next)
+			loopstore(lp, l->n);
+		lp->mem = 1;
+		break;
+
+	case OCALLFUNC:
+	case OCALLMETH:
+	case OCALLINTER:
+	case OPROC:
+	case ODEFER:
+	case OPANIC:
+	case OPRINT:
+	case OPRINTN:
+	case OCLOSE:
+	case OCOPY:
+	case ODELETE:
+	case OSEND:
+	case ORECV:
+	case ORECOVER:
+		lp->mem = 1;
+		break;
+
+	case ONAME:
+	case OLITERAL:
+	case OTYPE:
+	case OINDREG:
+	case OADD:
+	case OSUB:
+	case OMUL:
+	case ODIV:
+	case OMOD:
+	case OAND:
+	case OOR:
+	case OXOR:
+	case OANDNOT:
+	case OLSH:
+	case ORSH:
+	case OMINUS:
+	case OCOM:
+	case OPLUS:
+	case ONOT:
+	case OANDAND:
+	case OOROR:
+	case OEQ:
+	case ONE:
+	case OLT:
+	case OLE:
+	case OGE:
+	case OGT:
+	case OCONV:
+	case OCONVNOP:
+	case OLEN:
+	case OCAP:
+	case ODOT:
+	case ODOTPTR:
+	case OIND:
+	case OINDEX:
+	case OADDR:
+	case OPAREN:
+	case OBLOCK:
+	case OIF:
+	case OFOR:
+	case OLABEL:
+	case OGOTO:
+	case OBREAK:
+	case OCONTINUE:
+	case ORETURN:
+	case OEMPTY:
+	case OFALL:
+	case ODCLCONST:
+	case ODCLTYPE:
+		break;
+	}
+	loopscan(lp, n->left);
+	loopscan(lp, n->right);
+	loopscan(lp, n->ntest);
+	loopscan(lp, n->nincr);
+	loopscanlist(lp, n->list);
+	loopscanlist(lp, n->rlist);
+	loopscanlist(lp, n->ninit);
+	loopscanlist(lp, n->nbody);
+	loopscanlist(lp, n->nelse);
+}
+
+static void
+loopscanlist(Loop *lp, NodeList *l)
+{
+	for(; l; l=l->next)
+		loopscan(lp, l->n);
+}
+
+static void
+optfor(Node *n)
+{
+	Loop *lp;
+	Avail *a;
+	int i, s, fl;
+
+	if(nloop >= Nloop) {
+		killall();
+		s = nstack;
+		optlist(n->nbody);
+		nstack = s;
+		killall();
+		return;
+	}
+	lp = &loops[nloop];
+	memset(lp, 0, sizeof *lp);
+	lp->n = n;
+	loopscan(lp, n->ntest);
+	loopscan(lp, n->nincr);
+	loopscanlist(lp, n->nbody);
+
+	// what the loop changes is not available at its head.
+	for(i=0; i<nstack; i++) {
+		a = &avail[stack[i]];
+		if(loopassigns(lp, &a->info) || (a->info.load && lp->mem))
+			a->dead = 1;
+	}
+	nloop++;
+
+	// the test runs every time around: only hoist from it.
+	fl = 0;
+	if(hascall(n->ntest))
+		fl |= Fsafe|Fnoload;
+	stmt = n;
+	visit(&n->ntest, fl);
+
+	s = nstack;
+	optlist(n->nbody);
+	nstack = s;
+	optstmt(n->nincr);
+	nstack = s;
+	nloop--;
+}
+
+static void
+optstmt(Node *n)
+{
+	NodeList *l;
+	int fl, s;
+
+	if(n == N)
+		return;
+	optlist(n->ninit);
+	stmt = n;
+	switch(n->op) {
+	default:
+		killall();
+		break;
+
+	case OEMPTY:
+	case OFALL:
+	case ODCLCONST:
+	case ODCLTYPE:
+	case OGOTO:
+	case OBREAK:
+	case OCONTINUE:
+	case ORETURN:
+		break;
+
+	case OLABEL:
+		killall();
+		break;
+
+	case OBLOCK:
+		optlist(n->list);
+		break;
+
+	case ODCL:
+		store(n->left);
+		break;
+
+	case OAS:
+	case OASOP:
+		fl = Fnew;
+		if(hascall(n->left) || hascall(n->right))
+			fl |= Fsafe|Fnoload;
+		visit(&n->right, fl);
+		visitlv(&n->left, fl);
+		if(fl & Fnoload)
+			killmem();
+		store(n->left);
+		if(n->op == OAS)
+			hold(n->left, n->right);
+		break;
+
+	case OAS2:
+	case OAS2FUNC:
+	case OAS2RECV:
+	case OAS2MAPR:
+	case OAS2DOTTYPE:
+		killmem();
+		for(l=n->list; l; l=l->next)
+			store(l->n);
+		break;
+
+	case OCALLFUNC:
+	case OCALLMETH:
+	case OCALLINTER:
+	case OPROC:
+	case ODEFER:
+	case OPANIC:
+	case OPRINT:
+	case OPRINTN:
+	case OCLOSE:
+	case OCOPY:
+	case ODELETE:
+	case OSEND:
+	case ORECV:
+	case ORECOVER:
+		killmem();
+		break;
+
+	case OIF:
+		fl = Fnew;
+		if(hascall(n->ntest))
+			fl |= Fsafe|Fnoload;
+		visit(&n->ntest, fl);
+		if(fl & Fnoload)
+			killmem();
+		s = nstack;
+		optlist(n->nbody);
+		nstack = s;
+		optlist(n->nelse);
+		nstack = s;
+		break;
+
+	case OFOR:
+		optfor(n);
+		break;
+
+	case OSWITCH:
+	case OSELECT:
+		killall();
+		s = nstack;
+		optlist(n->nbody);
+		nstack = s;
+		killall();
+		break;
+	}
+}
+
+static void
+optlist(NodeList *l)
+{
+	for(; l; l=l->next)
+		optstmt(l->n);
+}
+
+static void prescanlist(NodeList*);
+
+// Find the nodes reachable twice, which must not be rewritten,
+// and the variables whose address is taken.
+static void
+prescan(Node *n)
+{
+	Node *b;
+
+	if(n == N)
+		return;
+	if(n->op != ONAME && n->op != OLITERAL && n->op != OTYPE) {
+		if(n->walkgen == walkgen) {
+			addset(shared, n);
+			return;
+		}
+		n->walkgen = walkgen;
+	}
+	if(n->op == OADDR) {
+		b = base(n->left);
+		if(b != N)
+			addset(addressed, vark(b));
+	}
+	prescan(n->left);
+	prescan(n->right);
+	prescan(n->ntest);
+	prescan(n->nincr);
+	prescanlist(n->list);
+	prescanlist(n->rlist);
+	prescanlist(n->ninit);
+	prescanlist(n->nbody);
+	prescanlist(n->nelse);
+}
+
+static void
+prescanlist(NodeList *l)
+{
+	for(; l; l=l->next)
+		prescan(l->n);
+}
+
+static int
+haslabel(Node *n)
+{
+	NodeList *l;
+
+	if(n == N)
+		return 0;
+	switch(n->op) {
+	case OLABEL:
+	case OGOTO:
+		return 1;
+	case OBREAK:
+	case OCONTINUE:
+		if(n->left != N)
+			return 1;
+		break;
+	}
+	if(haslabel(n->left) || haslabel(n->right) || haslabel(n->ntest) || haslabel(n->nincr))
+		return 1;
+	for(l=n->list; l; l=l->next)
+		if(haslabel(l->n))
+			return 1;
+	for(l=n->ninit; l; l=l->next)
+		if(haslabel(l->n))
+			return 1;
+	for(l=n->nbody; l; l=l->next)
+		if(haslabel(l->n))
+			return 1;
+	for(l=n->nelse; l; l=l->next)
+		if(haslabel(l->n))
+			return 1;
+	return 0;
+}
+
+static int
+haslabellist(NodeList *l)
+{
+	for(; l; l=l->next)
+		if(haslabel(l->n))
+			return 1;
+	return 0;
+}
+
+static void foldlist(NodeList*);
+
+// Replace if statements with constant tests by the arm that runs,
+// unless the other arm has labels or jumps that checklabels needs.
+static void
+fold(Node *n)
+{
+	NodeList *live, *dead;
+
+	if(n == N)
+		return;
+	if(n->op == OIF && n->ntest != N && n->ntest->op == OLITERAL && n->ntest->val.ctype == CTBOOL) {
+		live = n->nbody;
+		dead = n->nelse;
+		if(!n->ntest->val.u.bval) {
+			live = n->nelse;
+			dead = n->nbody;
+		}
+		if(!haslabellist(dead)) {
+			n->op = OBLOCK;
+			n->list = live;
+			n->ntest = N;
+			n->nbody = nil;
+			n->nelse = nil;
+		}
+	}
+	foldlist(n->ninit);
+	foldlist(n->list);
+	foldlist(n->nbody);
+	foldlist(n->nelse);
+	if(n->op == OFOR)
+		fold(n->nincr);
+}
+
+static void
+foldlist(NodeList *l)
+{
+	for(; l; l=l->next)
+		fold(l->n);
+}
+
+static Count*
+readcount(Node *v)
+{
+	Count *c;
+	uint32 h;
+
+	v = vark(v);
+	h = ptrhash(v);
+	for(c=reads[h]; c; c=c->link)
+		if(c->v == v)
+			return c;
+	c = mal(sizeof *c);
+	c->v = v;
+	c->link = reads[h];
+	reads[h] = c;
+	return c;
+}
+
+static void countlist(NodeList*);
+
+// Count the reads of each local variable.
+static void
+countreads(Node *n)
+{
+	if(n == N)
+		return;
+	if(n->op == ONAME) {
+		if(local(n))
+			readcount(n)->n++;
+		return;
+	}
+	if((n->op == OAS && n->left != N && n->left->op == ONAME) || n->op == ODCL) {
+		// a plain assignment does not read its target.
+	} else
+		countreads(n->left);
+	countreads(n->right);
+	countreads(n->ntest);
+	countreads(n->nincr);
+	countlist(n->list);
+	countlist(n->rlist);
+	countlist(n->ninit);
+	countlist(n->nbody);
+	countlist(n->nelse);
+}
+
+static void
+countlist(NodeList *l)
+{
+	for(; l; l=l->next)
+		countreads(l->n);
+}
+
+static int deadlist(NodeList*);
+
+// Remove the assignments of pure values to variables never read.
+static int
+dead(Node *n)
+{
+	Info in;
+	Node *r;
+	int c;
+
+	if(n == N)
+		return 0;
+	c = 0;
+	if(n->op == OAS && local(n->left) && readcount(n->left)->n == 0) {
+		r = n->right;
+		memset(&in, 0, sizeof in);
+		if(r == N || r->op == ONAME || r->op == OLITERAL || (pure(r, &in) && !in.fault)) {
+			n->op = OEMPTY;
+			n->left = N;
+			n->right = N;
+			c++;
+		}
+	}
+	c += dead(n->ntest);
+	c += dead(n->nincr);
+	c += deadlist(n->list);
+	c += deadlist(n->ninit);
+	c += deadlist(n->nbody);
+	c += deadlist(n->nelse);
+	return c;
+}
+
+static int
+deadlist(NodeList *l)
+{
+	int c;
+
+	c = 0;
+	for(; l; l=l->next)
+		c += dead(l->n);
+	return c;
+}
+
+void
+optimize(Node *fn)
+{
+	Avail *a;
+	Node *as;
+	NodeList *l;
+	int i, pass;
+
+	navail = 0;
+	nstack = 0;
+	nuses = 0;
+	nloop = 0;
+	memset(shared, 0, sizeof shared);
+	memset(addressed, 0, sizeof addressed);
+	memset(declared, 0, sizeof declared);
+	for(l=fn->dcl; l; l=l->next)
+		if(l->n->op == ONAME)
+			addset(declared, vark(l->n));
+
+	foldlist(fn->nbody);
+
+	walkgen++;
+	prescanlist(fn->enter);
+	prescanlist(fn->nbody);
+	prescanlist(fn->exit);
+
+	optlist(fn->nbody);
+
+	// set the temporaries and rewrite the uses.
+	for(i=0; i<navail; i++) {
+		a = &avail[i];
+		if(a->kind != Kexpr || (a->nuse == 0 && !a->hoist))
+			continue;
+		if(debug['m'] > 1)
+			warnl(a->expr->lineno, a->hoist ? "loop invariant %N hoisted" : "common subexpression %N", a->expr);
+		a->tmp = temp(a->expr->type);
+		as = nod(OAS, a->tmp, a->expr);
+		as->typecheck = 1;
+		ullmancalc(as);
+		a->where->ninit = list(a->where->ninit, as);
+		*a->slot = a->tmp;
+	}
+	for(i=0; i<nuses; i++) {
+		a = &avail[uses[i].a];
+		if(a->kind == Kexpr)
+			*uses[i].slot = a->tmp;
+		else
+			*uses[i].slot = a->holder;
+	}
+
+	for(pass=0; pass<4; pass++) {
+		memset(reads, 0, sizeof reads);
+		countlist(fn->enter);
+		countlist(fn->nbody);
+		countlist(fn->exit);
+		if(deadlist(fn->nbody) == 0)
+			break;
+	}
+}
@@ -9,6 +9,33 @@
 
 static void allocauto(Prog* p);
 
+enum
+{
+	NFNBATCH	= 128,	// functions to queue before finishing them
+};
+
+/*
+ * A function compiled but not yet finished:
+ * the register optimizer and frame layout
+ * are left to finishfuncs.
+ */
+typedef struct Fnopt Fnopt;
+struct Fnopt
+{
+	Node*	fn;
+	Plist*	pl;
+	Prog*	ptxt;
+	Addr*	out;	// results, for regopt
+	int	nout;
+	int	opt;	// run regopt
+	int32	stksize;
+	int32	maxarg;
+};
+
+static	Fnopt*	fnopt;
+static	int	nfnopt;
+static	int	mfnopt;
+
 void
 compile(Node *fn)
 {
@@ -18,7 +45,8 @@ compile(Node *fn)
 	int32 lno;
 	Type *t;
 	Iter save;
-	vlong oldstksize;
+	Fnopt *f;
+	int i;
 
 	if(newproc == N) {
 		newproc = sysfunc("newproc");
@@ -63,6 +91,10 @@ compile(Node *fn)
 	walk(curfn);
 	if(nerrors != 0)
 		goto ret;
+	if(!debug['N'])
+		bce(curfn);
+	if(!debug['N'] && !debug['T'] && thechar == '6')
+		optimize(curfn);
 
 	continpc = P;
 	breakpc = P;
@@ -76,6 +108,8 @@ compile(Node *fn)
 	ptxt = gins(ATEXT, isblank(curfn->nname) ? N : curfn->nname, &nod1);
 	if(fn->dupok)
 		ptxt->TEXTFLAG = DUPOK;
+	if(fn->reflectmethod)
+		ptxt->TEXTFLAG = (fn->dupok ? DUPOK : 0) | REFLECTMETHOD;
 	afunclit(&ptxt->from);
 
 	ginit();
@@ -114,26 +148,118 @@ compile(Node *fn)
 	pc->as = ARET;	// overwrite AEND
 	pc->lineno = lineno;
 
-	if(!debug['N'] || debug['R'] || debug['P']) {
-		regopt(ptxt);
+	if(nfnopt == mfnopt) {
+		mfnopt = 2*mfnopt + 64;
+		fnopt = realloc(fnopt, mfnopt*sizeof fnopt[0]);
+		if(fnopt == nil)
+			fatal("out of memory");
+	}
+	f = &fnopt[nfnopt++];
+	f->fn = curfn;
+	f->pl = pl;
+	f->ptxt = ptxt;
+	f->opt = !debug['N'] || debug['R'] || debug['P'];
+	f->stksize = stksize;
+	f->maxarg = maxarg;
+
+	// naddr can lay out types, so find the results'
+	// addresses here rather than in regopt.
+	f->out = nil;
+	f->nout = 0;
+	if(f->opt && curfn->type->outtuple > 0) {
+		f->out = mal(curfn->type->outtuple*sizeof f->out[0]);
+		i = 0;
+		for(t = structfirst(&save, getoutarg(curfn->type)); t != T; t = structnext(&save)) {
+			n = nodarg(t, 1);
+			f->out[i] = zprog.from;
+			naddr(n, &f->out[i], 0);
+			i++;
+		}
+		f->nout = i;
 	}
 
-	oldstksize = stksize;
-	allocauto(ptxt);
-	if(0)
-		print("allocauto: %lld to %lld\n", oldstksize, (vlong)stksize);
+	// Finish the queued functions now and then, so that
+	// the backend can write them out and free their Progs
+	// instead of holding every function until dumpobj.
+	if(nfnopt >= NFNBATCH) {
+		finishfuncs();
+		if(nerrors == 0)
+			emitfuncs();
+	}
 
-	setlineno(curfn);
-	if((int64)stksize+maxarg > (1ULL<<31))
-		yyerror("stack frame too large (>2GB)");
+ret:
+	lineno = lno;
+}
 
-	defframe(ptxt);
+static void
+optfunc(void *arg, int i)
+{
+	Fnopt *f;
+	Arena *a;
+
+	USED(arg);
+	f = &fnopt[i];
+	if(f->opt) {
+		curfn = f->fn;
+		a = progarena;
+		progarena = &f->pl->arena;
+		regopt(f->ptxt, f->out, f->nout);
+		progarena = a;
+		curfn = nil;
+	}
+}
 
-	if(0)
-		frame(0);
+/*
+ * Finish the functions compile has queued: optimize them and
+ * lay out their frames.  regopt keeps its state in THREAD
+ * variables and changes only the Progs of its own function,
+ * so the functions are optimized concurrently.  The frames
+ * are then laid out one by one in source order, so the
+ * object file is the same however many threads ran.
+ */
+void
+finishfuncs(void)
+{
+	Fnopt *f;
+	int32 lno;
+	vlong oldstksize;
+	int i;
 
-ret:
+	if(nfnopt == 0)
+		return;
+	regoptinit();
+
+	// the debugging output would interleave
+	if(debug['R'] || debug['P'] || debug['K'] || debug['v'])
+		for(i=0; i<nfnopt; i++)
+			optfunc(nil, i);
+	else
+		parfor(nfnopt, optfunc, nil);
+
+	lno = lineno;
+	for(i=0; i<nfnopt; i++) {
+		f = &fnopt[i];
+		curfn = f->fn;
+		stksize = f->stksize;
+		maxarg = f->maxarg;
+
+		oldstksize = stksize;
+		allocauto(f->ptxt);
+		if(0)
+			print("allocauto: %lld to %lld\n", oldstksize, (vlong)stksize);
+
+		setlineno(curfn);
+		if((int64)stksize+maxarg > (1ULL<<31))
+			yyerror("stack frame too large (>2GB)");
+
+		defframe(f->ptxt);
+
+		if(0)
+			frame(0);
+	}
+	curfn = nil;
 	lineno = lno;
+	nfnopt = 0;
 }
 
 
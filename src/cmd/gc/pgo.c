@@ -0,0 +1,287 @@
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Profile feedback (-F).
+//
+// The feedback file is the text written by go tool prof -F from a
+// CPU profile of an earlier build of the same program.  Each line is
+// a key followed by a sample count:
+//
+//	total N
+//	func main.f N
+//	edge main.f strings.Index N
+//	line /home/gopher/f.go:12 N
+//
+// Functions are named as in the linker's symbol table, lines by
+// absolute file name.  Anything that accounts for at least 1/PgoHot
+// of the samples is hot.  The compiler uses the feedback in two ways:
+// inl.c gives hot callees a larger budget and expands the extra large
+// ones only at hot call sites, and pgolayout marks the executed if
+// statements one of whose branches was never seen in the profile, so
+// that bgen can tell the linker which way the branch goes and the
+// cold code is laid out after the hot path.
+
+#include <u.h>
+#include <libc.h>
+#include "go.h"
+
+enum
+{
+	PgoHot		= 100,
+	PgoHash		= 1024,
+};
+
+typedef	struct	Pgo	Pgo;
+struct	Pgo
+{
+	char*	key;
+	vlong	n;
+	Pgo*	link;
+};
+
+static	Pgo*	pgohash[PgoHash];
+static	vlong	pgototal;
+
+static Pgo*
+pgolook(char *key, int create)
+{
+	Pgo *p;
+	uint32 h;
+
+	h = stringhash(key) % PgoHash;
+	for(p=pgohash[h]; p; p=p->link)
+		if(strcmp(p->key, key) == 0)
+			return p;
+	if(!create)
+		return nil;
+	p = mal(sizeof(*p));
+	p->key = strdup(key);
+	p->link = pgohash[h];
+	pgohash[h] = p;
+	return p;
+}
+
+static vlong
+pgocount(char *key)
+{
+	Pgo *p;
+
+	p = pgolook(key, 0);
+	if(p == nil)
+		return 0;
+	return p->n;
+}
+
+static int
+pgohot(vlong n)
+{
+	return n > 0 && n*PgoHot >= pgototal;
+}
+
+void
+pgoload(char *file)
+{
+	Biobuf *b;
+	char *line, *p;
+	vlong n;
+
+	b = Bopen(file, OREAD);
+	if(b == nil) {
+		flusherrors();
+		print("can't open %s: %r\n", file);
+		errorexit();
+	}
+	while((line = Brdstr(b, '\n', 1)) != nil) {
+		p = strrchr(line, ' ');
+		if(p == nil || line[0] == '#') {
+			free(line);
+			continue;
+		}
+		*p++ = '\0';
+		n = atoll(p);
+		if(strcmp(line, "total") == 0)
+			pgototal = n;
+		else
+			pgolook(line, 1)->n += n;
+
+		// total the incoming edges of each callee.
+		if(strncmp(line, "edge ", 5) == 0) {
+			p = strrchr(line, ' ');
+			*p = '\0';
+			snprint(namebuf, sizeof(namebuf), "in %s", p+1);
+			pgolook(namebuf, 1)->n += n;
+		}
+		free(line);
+	}
+	Bterm(b);
+	pgoloaded = 1;
+}
+
+// Name fn as it appears in the symbol table of the profiled binary.
+static void
+pgoname(char *buf, int nbuf, Node *fn)
+{
+	Pkg *pkg;
+	char *path;
+
+	if(fn->op == ODCLFUNC)
+		fn = fn->nname;
+	pkg = fnpkg(fn);
+	if(pkg != localpkg && pkg != nil)
+		path = pkg->path->s;
+	else if(strcmp(localpkg->name, "main") == 0)
+		path = "main";
+	else if(myimportpath != nil)
+		path = myimportpath;
+	else
+		path = localpkg->name;
+	snprint(buf, nbuf, "%s.%s", path, fn->sym->name);
+}
+
+// Is fn, a function with an inlinable body, called from hot code?
+int
+pgohotfunc(Node *fn)
+{
+	char name[NSYMB];
+
+	if(!pgoloaded)
+		return 0;
+	pgoname(name, sizeof name, fn);
+	snprint(namebuf, sizeof(namebuf), "in %s", name);
+	return pgohot(pgocount(namebuf));
+}
+
+// Is the call from caller to callee hot?
+int
+pgohotcall(Node *caller, Node *callee)
+{
+	char a[NSYMB], b[NSYMB];
+
+	if(!pgoloaded || caller == N)
+		return 0;
+	pgoname(a, sizeof a, caller);
+	pgoname(b, sizeof b, callee);
+	snprint(namebuf, sizeof(namebuf), "edge %s %s", a, b);
+	return pgohot(pgocount(namebuf));
+}
+
+static vlong
+linecount(int32 lno)
+{
+	static int32 lastlno = -1;
+	static vlong lastn;
+	char buf[1024];
+
+	if(lno == lastlno)
+		return lastn;
+	snprint(buf, sizeof buf, "%L", lno);
+	if(buf[0] == '/' || (buf[0] != '\0' && buf[1] == ':'))
+		snprint(namebuf, sizeof(namebuf), "line %s", buf);
+	else
+		snprint(namebuf, sizeof(namebuf), "line %s/%s", pathname, buf);
+	lastlno = lno;
+	lastn = pgocount(namebuf);
+	return lastn;
+}
+
+static vlong maxcountlist(NodeList *l);
+
+// The largest sample count of any line in n.
+static vlong
+maxcount(Node *n)
+{
+	vlong m, c;
+
+	if(n == N)
+		return 0;
+	switch(n->op) {
+	case ONAME:
+	case ONONAME:
+	case OTYPE:
+	case OLITERAL:
+	case OPACK:
+		// shared, with the line of the declaration
+		return 0;
+	}
+	m = linecount(n->lineno);
+	if((c = maxcount(n->left)) > m)
+		m = c;
+	if((c = maxcount(n->right)) > m)
+		m = c;
+	if((c = maxcountlist(n->list)) > m)
+		m = c;
+	if((c = maxcountlist(n->rlist)) > m)
+		m = c;
+	if((c = maxcountlist(n->ninit)) > m)
+		m = c;
+	if((c = maxcount(n->ntest)) > m)
+		m = c;
+	if((c = maxcount(n->nincr)) > m)
+		m = c;
+	if((c = maxcountlist(n->nbody)) > m)
+		m = c;
+	if((c = maxcountlist(n->nelse)) > m)
+		m = c;
+	return m;
+}
+
+static vlong
+maxcountlist(NodeList *l)
+{
+	vlong m, c;
+
+	m = 0;
+	for(; l; l=l->next)
+		if((c = maxcount(l->n)) > m)
+			m = c;
+	return m;
+}
+
+static void layoutlist(NodeList *l);
+
+static void
+layout(Node *n)
+{
+	vlong then, els;
+
+	if(n == N)
+		return;
+	if(n->op == OIF && linecount(n->lineno) > 0) {
+		then = maxcountlist(n->nbody);
+		els = maxcountlist(n->nelse);
+		if(then == 0 && (n->nelse == nil || els > 0))
+			n->likely = -1;
+		else if(els == 0 && n->nelse != nil && then > 0)
+			n->likely = 1;
+		if(n->likely && debug['m'] > 1)
+			print("%L: if is %s\n", n->lineno, n->likely > 0 ? "likely" : "unlikely");
+	}
+	layout(n->left);
+	layout(n->right);
+	layoutlist(n->list);
+	layoutlist(n->rlist);
+	layoutlist(n->ninit);
+	layout(n->ntest);
+	layout(n->nincr);
+	layoutlist(n->nbody);
+	layoutlist(n->nelse);
+}
+
+static void
+layoutlist(NodeList *l)
+{
+	for(; l; l=l->next)
+		layout(l->n);
+}
+
+// Mark the if statements in fn whose condition appears in the
+// profile but one of whose branches does not.
+// Inlining copies the marks along with the bodies.
+void
+pgolayout(Node *fn)
+{
+	if(!pgoloaded)
+		return;
+	layoutlist(fn->nbody);
+}
@@ -18,6 +18,7 @@ func panicslice()
 func throwreturn()
 func throwinit()
 func panicwrap(string, string, string)
+func coverregister(counts []uint32, pos string)
 
 func panic(interface{})
 func recover(*int32) interface{}
@@ -247,7 +247,6 @@ fatal(char *fmt, ...)
 void
 linehist(char *file, int32 off, int relative)
 {
-	Hist *h;
 	char *cp;
 
 	if(debug['i']) {
@@ -270,9 +269,17 @@ linehist(char *file, int32 off, int relative)
 		file = cp;
 	}
 
+	addhist(file, lexlineno, off);
+}
+
+void
+addhist(char *file, int32 line, int32 off)
+{
+	Hist *h;
+
 	h = mal(sizeof(Hist));
 	h->name = file;
-	h->line = lexlineno;
+	h->line = line;
 	h->offset = off;
 	h->link = H;
 	if(ehist == H) {
@@ -308,10 +315,28 @@ setlineno(Node *n)
 	return lno;
 }
 
+/*
+ * a string hashes to the sum h = h*PRIME1 + c
+ * over its bytes, folded to be non-negative.
+ */
+static uint32
+hashfold(uint32 sum)
+{
+	int32 h;
+
+	h = sum;
+	if(h < 0) {
+		h = -h;
+		if(h < 0)
+			h = 0;
+	}
+	return h;
+}
+
 uint32
 stringhash(char *p)
 {
-	int32 h;
+	uint32 h;
 	int c;
 
 	h = 0;
@@ -321,29 +346,86 @@ stringhash(char *p)
 			break;
 		h = h*PRIME1 + c;
 	}
-
-	if(h < 0) {
-		h = -h;
-		if(h < 0)
-			h = 0;
-	}
-	return h;
+	return hashfold(h);
 }
 
+static Sym*	pkglookuph(char *name, uint32 h, Pkg *pkg);
+
 Sym*
 lookup(char *name)
 {
-	return pkglookup(name, localpkg);
+	return pkglookuph(name, stringhash(name), localpkg);
+}
+
+/*
+ * lookup for the lexer, which has summed
+ * the bytes of name while scanning it.
+ */
+Sym*
+lookuph(char *name, uint32 sum)
+{
+	return pkglookuph(name, hashfold(sum), localpkg);
+}
+
+static	uint32	nsym;	// symbols in hash
+
+/*
+ * double the size of the symbol table,
+ * or create it if there is none.
+ * each old chain is split in order between two
+ * new ones, so the symbols with a given name stay
+ * in the order they were made; init depends on that.
+ */
+static void
+growhash(void)
+{
+	Sym **h, ***tail, *s, *next;
+	uint32 i, j, n;
+
+	n = 2*nhash;
+	if(n == 0)
+		n = NHASH;
+	h = malloc(n*sizeof h[0]);
+	tail = malloc(n*sizeof tail[0]);
+	if(h == nil || tail == nil) {
+		flusherrors();
+		yyerror("out of memory");
+		errorexit();
+	}
+	for(i=0; i<n; i++) {
+		h[i] = S;
+		tail[i] = &h[i];
+	}
+	for(i=0; i<nhash; i++) {
+		for(s = hash[i]; s != S; s = next) {
+			next = s->link;
+			s->link = S;
+			j = stringhash(s->name) & (n-1);
+			*tail[j] = s;
+			tail[j] = &s->link;
+		}
+	}
+	free(tail);
+	free(hash);
+	hash = h;
+	nhash = n;
 }
 
 Sym*
 pkglookup(char *name, Pkg *pkg)
+{
+	return pkglookuph(name, stringhash(name), pkg);
+}
+
+static Sym*
+pkglookuph(char *name, uint32 h, Pkg *pkg)
 {
 	Sym *s;
-	uint32 h;
 	int c;
 
-	h = stringhash(name) % NHASH;
+	if(nsym >= nhash)
+		growhash();
+	h &= nhash-1;
 	c = name[0];
 	for(s = hash[h]; s != S; s = s->link) {
 		if(s->name[0] != c || s->pkg != pkg)
@@ -361,6 +443,7 @@ pkglookup(char *name, Pkg *pkg)
 	s->link = hash[h];
 	hash[h] = s;
 	s->lexical = LNAME;
+	nsym++;
 
 	return s;
 }
@@ -384,7 +467,7 @@ importdot(Pkg *opkg, Node *pack)
 	int n;
 
 	n = 0;
-	for(h=0; h<NHASH; h++) {
+	for(h=0; h<nhash; h++) {
 		for(s = hash[h]; s != S; s = s->link) {
 			if(s->pkg != opkg)
 				continue;
@@ -483,6 +566,61 @@ remal(void *p, int32 on, int32 n)
 	return p;
 }
 
+/*
+ * allocate n zeroed bytes from arena a.
+ * each block starts with a word linking it
+ * to the previous one, for afree.
+ */
+void*
+amal(Arena *a, int32 n)
+{
+	char *p;
+	int32 nb;
+
+	while((uintptr)a->hunk & MAXALIGN) {
+		a->hunk++;
+		a->nhunk--;
+	}
+	if(a->nhunk < n) {
+		nb = 8192;
+		if(nb < n)
+			nb = n;
+		p = malloc(MAXALIGN+1 + nb);
+		if(p == nil) {
+			flusherrors();
+			yyerror("out of memory");
+			errorexit();
+		}
+		*(char**)p = a->blk;
+		a->blk = p;
+		a->hunk = p + MAXALIGN+1;
+		a->nhunk = nb;
+	}
+
+	p = a->hunk;
+	a->nhunk -= n;
+	a->hunk += n;
+	memset(p, 0, n);
+	return p;
+}
+
+/*
+ * free everything allocated from arena a.
+ */
+void
+afree(Arena *a)
+{
+	char *p, *next;
+
+	for(p = a->blk; p != nil; p = next) {
+		next = *(char**)p;
+		free(p);
+	}
+	a->blk = nil;
+	a->hunk = nil;
+	a->nhunk = 0;
+}
+
 Node*
 nod(int op, Node *nleft, Node *nright)
 {
@@ -21,6 +21,9 @@ enum
 	Ttypevar,	// interface type
 
 	Ncase	= 4,	// count needed to split
+	Njmptab	= 8,	// count needed for a jump table
+	Dense	= 4,	// at least 1 in Dense table entries used
+	Nlenswt	= 8,	// count needed to switch on string length
 };
 
 typedef	struct	Case	Case;
@@ -428,6 +431,118 @@ mkcaselist(Node *sw, int arg)
 
 static	Node*	exprname;
 
+/*
+ * is the sorted run of ncase integer constants
+ * dense enough to jump through a table?
+ * only 6g has the indirect jump.
+ */
+static int
+jmptabok(Case *c0, int ncase, int arg)
+{
+	Case *c;
+	Mpint d, n;
+	int i;
+
+	if(thechar != '6' || arg != Snorm || ncase < Njmptab)
+		return 0;
+	if(!isint[exprname->type->etype])
+		return 0;
+	c = c0;
+	for(i=0; i<ncase; i++) {
+		if(c->node->right->op != OGOTO)
+			return 0;
+		if(i < ncase-1)
+			c = c->link;
+	}
+	mpmovefixfix(&d, c->node->left->val.u.xval);
+	mpsubfixfix(&d, c0->node->left->val.u.xval);
+	mpmovecfix(&n, (vlong)ncase*Dense);
+	return mpcmpfixfix(&d, &n) < 0;
+}
+
+/*
+ * the run of cases as
+ *	i := uint64(uintN(name - lo))
+ *	if i <= hi-lo {
+ *		goto table[i]
+ *	}
+ *	next:
+ * where the table entries with no case go to next.
+ */
+static Node*
+exprjmptab(Case *c0, int ncase)
+{
+	Node *lo, *idx, *a, *tab, *next, *gap;
+	NodeList *l;
+	Mpint v;
+	Type *ut;
+	Case *c;
+	int et;
+
+	lo = c0->node->left;
+	switch(exprname->type->width) {
+	case 1:
+		et = TUINT8;
+		break;
+	case 2:
+		et = TUINT16;
+		break;
+	case 4:
+		et = TUINT32;
+		break;
+	default:
+		et = TUINT64;
+		break;
+	}
+	ut = types[et];
+
+	idx = temp(types[TUINT64]);
+	a = exprname;
+	if(mpcmpfixc(lo->val.u.xval, 0) != 0) {
+		a = nod(OSUB, a, lo);
+		typecheck(&a, Erv);
+	}
+	a = nod(OAS, idx, conv(conv(a, ut), types[TUINT64]));
+	typecheck(&a, Etop);
+	l = list1(a);
+
+	tab = nod(OJMPTAB, idx, N);
+	next = N;
+	gap = N;
+	mpmovefixfix(&v, lo->val.u.xval);
+	for(c=c0; ncase>0; ) {
+		switch(mpcmpfixfix(&v, c->node->left->val.u.xval)) {
+		case 1:
+			// duplicate, already diagnosed
+			c = c->link;
+			ncase--;
+			continue;
+		case 0:
+			tab->list = list(tab->list, c->node->right);
+			c = c->link;
+			ncase--;
+			break;
+		default:
+			if(gap == N) {
+				next = newlabel();
+				gap = nod(OGOTO, next, N);
+			}
+			tab->list = list(tab->list, gap);
+			break;
+		}
+		mpaddcfix(&v, 1);
+	}
+
+	a = nod(OIF, N, N);
+	a->ntest = nod(OLE, idx, nodintconst(count(tab->list)-1));
+	typecheck(&a->ntest, Erv);
+	a->nbody = list1(tab);
+	l = list(l, a);
+	if(next != N)
+		l = list(l, nod(OLABEL, next, N));
+	return liststmt(l);
+}
+
 static Node*
 exprbsw(Case *c0, int ncase, int arg)
 {
@@ -436,6 +551,9 @@ exprbsw(Case *c0, int ncase, int arg)
 	Case *c;
 	int i, half, lno;
 
+	if(jmptabok(c0, ncase, arg))
+		return exprjmptab(c0, ncase);
+
 	cas = nil;
 	if(ncase < Ncase) {
 		for(i=0; i<ncase; i++) {
@@ -484,6 +602,64 @@ exprbsw(Case *c0, int ncase, int arg)
 	return a;
 }
 
+static int
+lencmp(Case *c1, Case *c2)
+{
+	int32 l1, l2;
+
+	l1 = c1->node->left->val.u.sval->len;
+	l2 = c2->node->left->val.u.sval->len;
+	if(l1 != l2)
+		return l1 < l2 ? -1 : +1;
+	return cmpslit(c1->node->left, c2->node->left);
+}
+
+/*
+ * a large run of string constants.
+ * the length is a cheap hash of the string:
+ * switch on it first and then compare the
+ * strings with that length.
+ */
+static Node*
+exprlenswt(Case *c0, int ncase, int arg)
+{
+	Node *sname, *lname, *a;
+	Case *c, *g, *g0, *gl;
+	int32 len;
+	int n, ng;
+
+	c0 = csort(c0, lencmp);
+	sname = exprname;
+	lname = temp(types[TINT]);
+	a = nod(OAS, lname, nod(OLEN, sname, N));
+	typecheck(&a, Etop);
+
+	g0 = C;
+	gl = C;
+	ng = 0;
+	while(c0 != C) {
+		len = c0->node->left->val.u.sval->len;
+		n = 1;
+		for(c=c0; c->link!=C && c->link->node->left->val.u.sval->len == len; c=c->link)
+			n++;
+		g = mal(sizeof(*g));
+		g->node = nod(OCASE, nodintconst(len), exprbsw(c0, n, arg));
+		g->node->lineno = c0->node->lineno;
+		if(gl == C)
+			g0 = g;
+		else
+			gl->link = g;
+		gl = g;
+		ng++;
+		c0 = c->link;
+	}
+
+	exprname = lname;
+	a = liststmt(list(list1(a), exprbsw(g0, ng, arg)));
+	exprname = sname;
+	return a;
+}
+
 /*
  * normal (expression) switch.
  * rebulid case statements into if .. goto
@@ -560,8 +736,12 @@ loop:
 	c->link = C;
 
 	// sort and compile constants
-	c0 = csort(c0, exprcmp);
-	a = exprbsw(c0, ncase, arg);
+	if(t->etype == TSTRING && ncase >= Nlenswt)
+		a = exprlenswt(c0, ncase, arg);
+	else {
+		c0 = csort(c0, exprcmp);
+		a = exprbsw(c0, ncase, arg);
+	}
 	cas = list(cas, a);
 
 	c0 = c1;
@@ -25,6 +25,7 @@ static	Node*	sliceany(Node*, NodeList**);
 static	void	walkcompare(Node**, NodeList**);
 static	void	walkrotate(Node**);
 static	int	bounded(Node*, int64);
+static	void	usemethod(Node*);
 static	Mpint	mpzero;
 
 // can this code branch reach the end
@@ -232,6 +233,10 @@ walkstmt(Node **np)
 		walkstmt(&n->right);
 		break;
 
+	case OJMPTAB:
+		walkexpr(&n->left, &n->ninit);
+		break;
+
 	case ODEFER:
 		hasdefer = 1;
 		switch(n->left->op) {
@@ -535,6 +540,7 @@ walkexpr(Node **np, NodeList **init)
 		goto ret;
 
 	case OCALLINTER:
+		usemethod(n);
 		t = n->left->type;
 		if(n->list && n->list->n->op == OAS)
 			goto ret;
@@ -545,6 +551,7 @@ walkexpr(Node **np, NodeList **init)
 		goto ret;
 
 	case OCALLFUNC:
+		usemethod(n);
 		t = n->left->type;
 		if(n->list && n->list->n->op == OAS)
 			goto ret;
@@ -562,6 +569,7 @@ walkexpr(Node **np, NodeList **init)
 		goto ret;
 
 	case OCALLMETH:
+		usemethod(n);
 		t = n->left->type;
 		if(n->list && n->list->n->op == OAS)
 			goto ret;
@@ -2832,3 +2840,52 @@ bounded(Node *n, int64 max)
 	
 	return 0;
 }
+
+/*
+ * A call of reflect's Type.Method or MethodByName, or of
+ * Value.Method or MethodByName, can reach any method of any
+ * type.  Mark the calling function so that the linker
+ * keeps every method of the reachable types; see deadcode in
+ * ../ld/go.c.  Going by name and result type also catches
+ * interfaces that embed reflect.Type.  A plain function call
+ * counts only if it calls a method expression such as
+ * reflect.Value.MethodByName on reflect's own Value or Type.
+ */
+static void
+usemethod(Node *n)
+{
+	Type *t;
+	char *name, *p;
+
+	if(n->op == OCALLFUNC) {
+		// ONAME for the method expression T.M, left is T.
+		if(n->left->op != ONAME || n->left->class != PFUNC)
+			return;
+		if(n->left->left == N || n->left->left->op != OTYPE)
+			return;
+		t = n->left->left->type;
+		if(t != T && t->sym == S && isptr[t->etype])
+			t = t->type;
+		if(t == T || t->sym == S || t->sym->pkg == nil || strcmp(t->sym->pkg->path->s, "reflect") != 0)
+			return;
+		if(strcmp(t->sym->name, "Value") != 0 && strcmp(t->sym->name, "Type") != 0)
+			return;
+	}
+	if(n->left->right == N || n->left->right->sym == S)
+		return;
+	// ODOTMETH and method expressions name the method T.M.
+	name = n->left->right->sym->name;
+	if((p = strrchr(name, '.')) != nil)
+		name = p+1;
+	if(strcmp(name, "Method") != 0 && strcmp(name, "MethodByName") != 0)
+		return;
+	t = getoutargx(n->left->type)->type;
+	if(t == T)
+		return;
+	t = t->type;
+	if(t->sym == S || t->sym->pkg == nil || strcmp(t->sym->pkg->path->s, "reflect") != 0)
+		return;
+	if(strcmp(t->sym->name, "Method") != 0 && strcmp(t->sym->name, "Value") != 0)
+		return;
+	curfn->reflectmethod = 1;
+}
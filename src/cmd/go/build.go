@@ -75,6 +75,12 @@ The build flags are shared by the build, install, run, and test commands:
 		See the documentation for the go/build package for
 		more information about build tags.
 
+If $GOCACHE names a directory, build keeps the compiled packages
+and linked commands there, keyed by a hash of their inputs, and
+reuses them when the same inputs come up again.  Dependents of a
+package are only recompiled when its export data changes.
+The -a flag ignores the saved results.
+
 For more about specifying packages, see 'go help packages'.
 For more about where packages and binaries are installed,
 see 'go help gopath'.
@@ -641,6 +647,15 @@ func (b *builder) build(a *action) (err error) {
 		return err
 	}
 
+	// Use the package archive from the build cache if possible.
+	key := b.compileKey(a)
+	if b.cacheGet(a, key, a.objpkg, 0666) {
+		if a.link {
+			return b.link(a, []string{a.objpkg})
+		}
+		return nil
+	}
+
 	var gofiles, cfiles, sfiles, objects, cgoObjects []string
 	gofiles = append(gofiles, a.p.GoFiles...)
 	cfiles = append(cfiles, a.p.CFiles...)
@@ -754,21 +769,34 @@ func (b *builder) build(a *action) (err error) {
 	if err := buildToolchain.pack(b, a.p, obj, a.objpkg, objects); err != nil {
 		return err
 	}
+	b.cachePut(key, a.objpkg)
 
 	// Link if needed.
 	if a.link {
-		// The compiler only cares about direct imports, but the
-		// linker needs the whole dependency tree.
-		all := actionList(a)
-		all = all[:len(all)-1] // drop a
-		if err := buildToolchain.ld(b, a.p, a.target, all, a.objpkg, objects); err != nil {
-			return err
-		}
+		return b.link(a, objects)
 	}
 
 	return nil
 }
 
+// link links the executable for a from its package archive and
+// those of its dependencies, or copies it from the build cache.
+func (b *builder) link(a *action, objects []string) error {
+	// The compiler only cares about direct imports, but the
+	// linker needs the whole dependency tree.
+	all := actionList(a)
+	all = all[:len(all)-1] // drop a
+	key := b.linkKey(a, all)
+	if b.cacheGet(a, key, a.target, 0777) {
+		return nil
+	}
+	if err := buildToolchain.ld(b, a.p, a.target, all, a.objpkg, objects); err != nil {
+		return err
+	}
+	b.cachePut(key, a.target)
+	return nil
+}
+
 // install is the action for installing a single package or executable.
 func (b *builder) install(a *action) (err error) {
 	defer func() {
@@ -1247,6 +1275,9 @@ func (gcToolchain) gc(b *builder, p *Package, obj string, importArgs []string, g
 		// additional reflect type data.
 		gcargs = append(gcargs, "-+")
 	}
+	if p.cover {
+		gcargs = append(gcargs, "-c")
+	}
 
 	args := stringList(tool(archChar+"g"), "-o", ofile, buildGcflags, gcargs, "-D", p.localPrefix, importArgs)
 	for _, f := range gofiles {
@@ -0,0 +1,271 @@
+// Copyright 2012 The Go Authors.  All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+package main
+
+import (
+	"bufio"
+	"crypto/sha1"
+	"fmt"
+	"hash"
+	"io"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"strconv"
+	"strings"
+	"sync"
+)
+
+// The build cache.
+//
+// If $GOCACHE names a directory, the results of compiling
+// a package and of linking a command are saved there, named
+// by a hash of everything that went into them, and a later
+// build with the same inputs copies the saved result instead
+// of running the tools.  The hash for compiling a package
+// covers its source files, the tools and flags, and only the
+// export data of the packages it imports, so a change to the
+// implementation of a package does not force its importers
+// to be recompiled; linking a command still sees the change.
+//
+// Packages using cgo are not cached: their results depend
+// on the host C toolchain too.
+
+var buildCache = os.Getenv("GOCACHE")
+
+// cacheable reports whether the results of a can be cached.
+func cacheable(a *action) bool {
+	if buildCache == "" || buildCache == "off" || buildN {
+		return false
+	}
+	if _, ok := buildToolchain.(gcToolchain); !ok {
+		return false
+	}
+	return len(a.p.CgoFiles) == 0
+}
+
+var toolHash struct {
+	sync.Mutex
+	m map[string]string
+}
+
+// hashTool returns the hash of the named tool binary.
+// The tools do not change during a build, so the hash
+// is computed only once.
+func hashTool(name string) string {
+	toolHash.Lock()
+	defer toolHash.Unlock()
+	if h, ok := toolHash.m[name]; ok {
+		return h
+	}
+	h, err := hashFile(name)
+	if err != nil {
+		h = "missing"
+	}
+	if toolHash.m == nil {
+		toolHash.m = make(map[string]string)
+	}
+	toolHash.m[name] = h
+	return h
+}
+
+// hashFile returns the hash of the contents of the named file.
+func hashFile(name string) (string, error) {
+	f, err := os.Open(name)
+	if err != nil {
+		return "", err
+	}
+	defer f.Close()
+	h := sha1.New()
+	if _, err := io.Copy(h, f); err != nil {
+		return "", err
+	}
+	return fmt.Sprintf("%x", h.Sum(nil)), nil
+}
+
+// hashExports returns the hash of the export data in the package
+// archive named by file: the __.PKGDEF member that the compiler
+// reads when importing the package.  If there is none, it hashes
+// the whole file.
+func hashExports(file string) (string, error) {
+	f, err := os.Open(file)
+	if err != nil {
+		return "", err
+	}
+	defer f.Close()
+	r := bufio.NewReader(f)
+	magic := make([]byte, 8)
+	if _, err := io.ReadFull(r, magic); err != nil || string(magic) != "!<arch>\n" {
+		return hashFile(file)
+	}
+	hdr := make([]byte, 60)
+	for {
+		if _, err := io.ReadFull(r, hdr); err != nil {
+			return hashFile(file)
+		}
+		name := strings.TrimSpace(string(hdr[0:16]))
+		size, err := strconv.ParseInt(strings.TrimSpace(string(hdr[48:58])), 10, 64)
+		if err != nil {
+			return hashFile(file)
+		}
+		if name == "__.PKGDEF" {
+			h := sha1.New()
+			if _, err := io.CopyN(h, r, size); err != nil {
+				return "", err
+			}
+			return fmt.Sprintf("%x", h.Sum(nil)), nil
+		}
+		if _, err := io.CopyN(ioutil.Discard, r, size+size&1); err != nil {
+			return hashFile(file)
+		}
+	}
+	panic("unreachable")
+}
+
+// newCacheHash starts a hash with the parameters common
+// to every cached result.
+func newCacheHash(kind string) hash.Hash {
+	h := sha1.New()
+	fmt.Fprintf(h, "go build cache 1 %s\n", kind)
+	fmt.Fprintf(h, "goos %s goarch %s goroot %s\n", goos, goarch, goroot)
+	return h
+}
+
+// compileKey returns the cache key for compiling and packing
+// the package for a, or "" if the result cannot be cached.
+func (b *builder) compileKey(a *action) string {
+	if !cacheable(a) {
+		return ""
+	}
+	p := a.p
+	h := newCacheHash("compile")
+	fmt.Fprintf(h, "package %s %s\n", p.ImportPath, p.Name)
+	fmt.Fprintf(h, "dir %s\n", p.Dir)
+	fmt.Fprintf(h, "prefix %s\n", p.localPrefix)
+	fmt.Fprintf(h, "standard %v\n", p.Standard)
+	fmt.Fprintf(h, "cover %v\n", p.cover)
+	fmt.Fprintf(h, "gcflags %q\n", buildGcflags)
+	fmt.Fprintf(h, "ccflags %q\n", buildCcflags)
+	for _, t := range []string{archChar + "g", archChar + "c", archChar + "a", "pack"} {
+		fmt.Fprintf(h, "tool %s %s\n", t, hashTool(tool(t)))
+	}
+
+	files := [][]string{p.GoFiles, p.CFiles, p.SFiles, p.HFiles, p.SysoFiles}
+	for _, list := range files {
+		for _, file := range list {
+			fh, err := hashFile(filepath.Join(p.Dir, file))
+			if err != nil {
+				return ""
+			}
+			fmt.Fprintf(h, "file %s %s\n", file, fh)
+		}
+	}
+
+	// The C compiler and assembler also read the
+	// headers installed for the runtime.
+	if len(p.CFiles) > 0 || len(p.SFiles) > 0 {
+		inc := filepath.Join(goroot, "pkg", goos+"_"+goarch)
+		hfiles, _ := filepath.Glob(filepath.Join(inc, "*.h"))
+		for _, file := range hfiles {
+			fh, err := hashFile(file)
+			if err != nil {
+				return ""
+			}
+			fmt.Fprintf(h, "include %s %s\n", filepath.Base(file), fh)
+		}
+	}
+
+	for _, a1 := range a.deps {
+		if a1 == a.cgo || a1.target == "" {
+			continue
+		}
+		eh, err := hashExports(a1.target)
+		if err != nil {
+			return ""
+		}
+		fmt.Fprintf(h, "import %s %s\n", a1.p.ImportPath, eh)
+	}
+	return fmt.Sprintf("%x", h.Sum(nil))
+}
+
+// linkKey returns the cache key for linking the command for a,
+// or "" if the result cannot be cached.  all lists the actions
+// for the packages being linked, as passed to ld.
+func (b *builder) linkKey(a *action, all []*action) string {
+	if !cacheable(a) {
+		return ""
+	}
+	h := newCacheHash("link")
+	fmt.Fprintf(h, "ldflags %q\n", buildLdflags)
+	fmt.Fprintf(h, "tool %s\n", hashTool(buildToolchain.linker()))
+	for _, a1 := range append(all, a) {
+		file := a1.target
+		if a1 == a {
+			file = a.objpkg
+		} else if a1.link || file == "" {
+			continue
+		}
+		fh, err := hashFile(file)
+		if err != nil {
+			return ""
+		}
+		fmt.Fprintf(h, "package %s %s\n", a1.p.ImportPath, fh)
+	}
+	return fmt.Sprintf("%x", h.Sum(nil))
+}
+
+// cacheFile returns the name of the cache entry for key.
+func cacheFile(key string) string {
+	return filepath.Join(buildCache, key[:2], key)
+}
+
+// cacheGet copies the cache entry for key, if there is one,
+// to dst and reports whether it did.
+func (b *builder) cacheGet(a *action, key, dst string, perm os.FileMode) bool {
+	if key == "" || buildA {
+		return false
+	}
+	src := cacheFile(key)
+	if _, err := os.Stat(src); err != nil {
+		return false
+	}
+	if err := b.copyFile(a, dst, src, perm); err != nil {
+		return false
+	}
+	return true
+}
+
+// cachePut saves file as the cache entry for key.
+// A failure only means the result is not cached.
+func (b *builder) cachePut(key, file string) {
+	if key == "" {
+		return
+	}
+	dst := cacheFile(key)
+	if err := os.MkdirAll(filepath.Dir(dst), 0777); err != nil {
+		return
+	}
+	sf, err := os.Open(file)
+	if err != nil {
+		return
+	}
+	defer sf.Close()
+
+	// Write to a temporary name and rename,
+	// so that a concurrent build never reads
+	// a partly written entry.
+	tmp := fmt.Sprintf("%s.%d.tmp", dst, os.Getpid())
+	df, err := os.Create(tmp)
+	if err != nil {
+		return
+	}
+	_, err = io.Copy(df, sf)
+	if err1 := df.Close(); err == nil {
+		err = err1
+	}
+	if err != nil || os.Rename(tmp, dst) != nil {
+		os.Remove(tmp)
+	}
+}
@@ -90,6 +90,12 @@ The build flags are shared by the build, install, run, and test commands:
 		See the documentation for the go/build package for
 		more information about build tags.
 
+If $GOCACHE names a directory, build keeps the compiled packages
+and linked commands there, keyed by a hash of their inputs, and
+reuses them when the same inputs come up again.  Dependents of a
+package are only recompiled when its export data changes.
+The -a flag ignores the saved results.
+
 For more about specifying packages, see 'go help packages'.
 For more about where packages and binaries are installed,
 see 'go help gopath'.
@@ -353,7 +359,7 @@ Test packages
 
 Usage:
 
-	go test [-c] [-i] [build flags] [packages] [flags for test binary]
+	go test [-c] [-i] [-cover] [build flags] [packages] [flags for test binary]
 
 'Go test' automates testing the packages named by the import paths.
 It prints a summary of the test results in the format:
@@ -383,6 +389,13 @@ In addition to the build flags, the flags handled by 'go test' itself are:
 	    Install packages that are dependencies of the test.
 	    Do not run the test.
 
+	-cover
+	    Compile the package under test with coverage counters,
+	    which record the basic blocks of its code, not including
+	    the test files, that run.  The test binary reports the
+	    fraction of blocks that ran.  See -test.coverprofile for
+	    the counters themselves.
+
 The test binary also accepts flags that control execution of the test; these
 flags are also accessible by 'go test'.  See 'go help testflag' for details.
 
@@ -677,6 +690,12 @@ directory containing the package sources, has its own flags:
 	    Run benchmarks matching the regular expression.
 	    By default, no benchmarks run.
 
+	-test.coverprofile cover.out
+	    Write the coverage counters to the specified file when all
+	    tests are complete.  Go test -coverprofile implies -cover.
+	    'Go tool cov -p' merges such files and shows the code
+	    that did not run.
+
 	-test.cpuprofile cpu.out
 	    Write a CPU profile to the specified file before exiting.
 
@@ -75,6 +75,7 @@ type Package struct {
 	forceLibrary bool     // this package is a library (even if named "main")
 	local        bool     // imported via local path (./ or ../)
 	localPrefix  string   // interpret ./ and ../ imports relative to this prefix
+	cover        bool     // compile with coverage counters (6g -c)
 }
 
 func (p *Package) copyBuild(pp *build.Package) {
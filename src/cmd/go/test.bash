@@ -119,6 +119,22 @@ elif ! test -x testdata/bin1/helloworld; then
 	ok=false
 fi
 
+# go test -cover runs the package under test with coverage counters.
+rm -f testdata/cover.out
+if ! GOPATH=$(pwd)/testdata ./testgo test -cover -coverprofile=$(pwd)/testdata/cover.out cover >testdata/cover.txt; then
+	echo "go test -cover cover failed"
+	ok=false
+elif ! grep -q 'coverage: 66.7% of blocks' testdata/cover.txt; then
+	echo "go test -cover cover did not report 66.7% coverage:"
+	cat testdata/cover.txt
+	ok=false
+elif ! grep -q 'cover/cover.go:7,7 0$' testdata/cover.out; then
+	echo "go test -coverprofile did not record the block that did not run:"
+	cat testdata/cover.out
+	ok=false
+fi
+rm -f testdata/cover.out testdata/cover.txt
+
 if $ok; then
 	echo PASS
 else
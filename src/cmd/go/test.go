@@ -32,7 +32,7 @@ func init() {
 
 var cmdTest = &Command{
 	CustomFlags: true,
-	UsageLine:   "test [-c] [-i] [build flags] [packages] [flags for test binary]",
+	UsageLine:   "test [-c] [-i] [-cover] [build flags] [packages] [flags for test binary]",
 	Short:       "test packages",
 	Long: `
 'Go test' automates testing the packages named by the import paths.
@@ -63,6 +63,13 @@ In addition to the build flags, the flags handled by 'go test' itself are:
 	    Install packages that are dependencies of the test.
 	    Do not run the test.
 
+	-cover
+	    Compile the package under test with coverage counters,
+	    which record the basic blocks of its code, not including
+	    the test files, that run.  The test binary reports the
+	    fraction of blocks that ran.  See -test.coverprofile for
+	    the counters themselves.
+
 The test binary also accepts flags that control execution of the test; these
 flags are also accessible by 'go test'.  See 'go help testflag' for details.
 
@@ -94,6 +101,12 @@ directory containing the package sources, has its own flags:
 	    Run benchmarks matching the regular expression.
 	    By default, no benchmarks run.
 
+	-test.coverprofile cover.out
+	    Write the coverage counters to the specified file when all
+	    tests are complete.  Go test -coverprofile implies -cover.
+	    'Go tool cov -p' merges such files and shows the code
+	    that did not run.
+
 	-test.cpuprofile cpu.out
 	    Write a CPU profile to the specified file before exiting.
 
@@ -191,6 +204,7 @@ See the documentation of the testing package for more information.
 
 var (
 	testC            bool     // -c flag
+	testCover        bool     // -cover flag
 	testI            bool     // -i flag
 	testV            bool     // -v flag
 	testFiles        []string // -file flag(s)  TODO: not respected
@@ -435,7 +449,8 @@ func (b *builder) test(p *Package) (buildAction, runAction, printAction *action,
 	}
 
 	// Test package.
-	if len(p.TestGoFiles) > 0 {
+	// With -cover it is always a copy of p, compiled with counters.
+	if len(p.TestGoFiles) > 0 || testCover {
 		ptest = new(Package)
 		*ptest = *p
 		ptest.GoFiles = nil
@@ -458,6 +473,7 @@ func (b *builder) test(p *Package) (buildAction, runAction, printAction *action,
 			m[k] = append(m[k], v...)
 		}
 		ptest.build.ImportPos = m
+		ptest.cover = testCover
 	} else {
 		ptest = p
 	}
@@ -624,7 +640,7 @@ func (b *builder) runTest(a *action) error {
 		if testShowPass {
 			a.testOutput.Write(out)
 		}
-		fmt.Fprintf(a.testOutput, "ok  \t%s\t%s\n", a.p.ImportPath, t)
+		fmt.Fprintf(a.testOutput, "ok  \t%s\t%s%s\n", a.p.ImportPath, t, coverageSummary(out))
 		return nil
 	}
 
@@ -640,6 +656,18 @@ func (b *builder) runTest(a *action) error {
 	return nil
 }
 
+// coverageSummary returns the "coverage:" line that a test binary
+// built with -cover prints after PASS, formatted to be appended to
+// the ok line, or "" if there is none.
+func coverageSummary(out []byte) string {
+	for _, line := range strings.Split(string(out), "\n") {
+		if strings.HasPrefix(line, "coverage: ") {
+			return "\t" + line
+		}
+	}
+	return ""
+}
+
 // cleanTest is the action for cleaning up after a test.
 func (b *builder) cleanTest(a *action) error {
 	if buildWork {
@@ -0,0 +1,9 @@
+package cover
+
+import "testing"
+
+func TestAbs(t *testing.T) {
+	if Abs(-1) != 1 {
+		t.Fatal("Abs(-1) != 1")
+	}
+}
@@ -18,6 +18,7 @@ import (
 
 var usageMessage = `Usage of go test:
   -c=false: compile but do not run the test binary
+  -cover=false: record which basic blocks of the package run
   -file=file_test.go: specify file to use for tests;
       use multiple times for multiple files
   -p=n: build and test up to n packages in parallel
@@ -27,6 +28,7 @@ var usageMessage = `Usage of go test:
   -bench="": passes -test.bench to test
   -benchtime=1: passes -test.benchtime to test
   -cpu="": passes -test.cpu to test
+  -coverprofile="": passes -test.coverprofile to test; implies -cover
   -cpuprofile="": passes -test.cpuprofile to test
   -memprofile="": passes -test.memprofile to test
   -memprofilerate=0: passes -test.memprofilerate to test
@@ -59,6 +61,7 @@ var testFlagDefn = []*testFlagSpec{
 	{name: "c", boolVar: &testC},
 	{name: "file", multiOK: true},
 	{name: "i", boolVar: &testI},
+	{name: "cover", boolVar: &testCover},
 
 	// build flags.
 	{name: "a", boolVar: &buildA},
@@ -75,6 +78,7 @@ var testFlagDefn = []*testFlagSpec{
 	// passed to 6.out, adding a "test." prefix to the name if necessary: -v becomes -test.v.
 	{name: "bench", passToTest: true},
 	{name: "benchtime", passToTest: true},
+	{name: "coverprofile", passToTest: true},
 	{name: "cpu", passToTest: true},
 	{name: "cpuprofile", passToTest: true},
 	{name: "memprofile", passToTest: true},
@@ -129,7 +133,7 @@ func testFlags(args []string) (packageNames, passToTest []string) {
 		}
 		switch f.name {
 		// bool flags.
-		case "a", "c", "i", "n", "x", "v", "work":
+		case "a", "c", "cover", "i", "n", "x", "v", "work":
 			setBoolFlag(f.boolVar, value)
 		case "p":
 			setIntFlag(&buildP, value)
@@ -150,6 +154,8 @@ func testFlags(args []string) (packageNames, passToTest []string) {
 			testBench = true
 		case "timeout":
 			testTimeout = value
+		case "coverprofile":
+			testCover = true
 		}
 		if extraWord {
 			i++
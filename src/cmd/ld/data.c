@@ -141,8 +141,15 @@ addrel(Sym *s)
 	return &s->r[s->nr++];
 }
 
-void
-relocsym(Sym *s)
+/*
+ * Apply the relocations of s.  When running on a worker thread
+ * (par set), relocsym1 does not report errors or call archreloc,
+ * which may look up symbols; it returns -1 instead and the symbol
+ * is redone serially.  Relocations only write s->p, and redoing
+ * them writes the same bytes.
+ */
+static int
+relocsym1(Sym *s, int par)
 {
 	Reloc *r;
 	Prog p;
@@ -150,22 +157,30 @@ relocsym(Sym *s)
 	vlong o;
 	uchar *cast;
 	
-	cursym = s;
+	if(!par)
+		cursym = s;
 	memset(&p, 0, sizeof p);
 	for(r=s->r; r<s->r+s->nr; r++) {
 		off = r->off;
 		siz = r->siz;
 		if(off < 0 || off+(siz&~Rbig) > s->np) {
+			if(par)
+				return -1;
 			diag("%s: invalid relocation %d+%d not in [%d,%d)", s->name, off, siz&~Rbig, 0, s->np);
 			continue;
 		}
 		if(r->sym != S && (r->sym->type & SMASK == 0 || r->sym->type & SMASK == SXREF)) {
+			if(par)
+				return -1;
 			diag("%s: not defined", r->sym->name);
 			continue;
 		}
 		if(r->type >= 256)
 			continue;
 
+		if(r->sym != S && (r->sym->type == SDYNIMPORT || !r->sym->reachable) && par)
+			return -1;
+
 		if(r->sym != S && r->sym->type == SDYNIMPORT)
 			diag("unhandled relocation for %s (type %d rtype %d)", r->sym->name, r->sym->type, r->type);
 
@@ -174,6 +189,8 @@ relocsym(Sym *s)
 
 		switch(r->type) {
 		default:
+			if(par)
+				return -1;
 			o = 0;
 			if(archreloc(r, s, &o) < 0)
 				diag("unknown reloc %d", r->type);
@@ -195,6 +212,8 @@ relocsym(Sym *s)
 //print("relocate %s %p %s => %p %p %p %p [%p]\n", s->name, s->value+off, r->sym ? r->sym->name : "<nil>", (void*)symaddr(r->sym), (void*)s->value, (void*)r->off, (void*)r->siz, (void*)o);
 		switch(siz) {
 		default:
+			if(par)
+				return -1;
 			cursym = s;
 			diag("bad reloc size %#ux for %s", siz, r->sym->name);
 		case 4 + Rbig:
@@ -224,21 +243,127 @@ relocsym(Sym *s)
 			break;
 		}		
 	}
+	return 0;
+}
+
+void
+relocsym(Sym *s)
+{
+	relocsym1(s, 0);
+}
+
+/*
+ * reloc splits textp and datap into runs of symbols holding
+ * about the same number of relocations and hands the runs to
+ * the lib9 worker pool.  Runs that hit anything relocsym1 will
+ * not do on a worker are redone in order afterward, so any
+ * diagnostics come out as they would from a serial loop.
+ */
+enum
+{
+	Relocrun = 4096,	// fewest relocations worth a thread
+};
+
+typedef struct Relrun Relrun;
+struct Relrun
+{
+	Sym*	s;	// run is s up to but not including e
+	Sym*	e;
+	int	redo;
+};
+
+static struct
+{
+	Relrun*	r;
+	int	n;
+	int	m;
+} relwork;
+
+static void
+addrelrun(Sym *s, Sym *e)
+{
+	Relrun *r;
+
+	if(s == e)
+		return;
+	if(relwork.n >= relwork.m) {
+		relwork.m = 2*relwork.m + 16;
+		relwork.r = realloc(relwork.r, relwork.m*sizeof relwork.r[0]);
+		if(relwork.r == nil) {
+			diag("out of memory");
+			errorexit();
+		}
+	}
+	r = &relwork.r[relwork.n++];
+	r->s = s;
+	r->e = e;
+	r->redo = 0;
+}
+
+static void
+relocrun(void *v, int i)
+{
+	Relrun *r;
+	Sym *s;
+
+	USED(v);
+	r = &relwork.r[i];
+	for(s=r->s; s!=r->e; s=s->next)
+		if(relocsym1(s, 1) < 0) {
+			r->redo = 1;
+			return;
+		}
+}
+
+static void
+splitrel(Sym *list, int32 chunk)
+{
+	Sym *s, *start;
+	int32 n;
+
+	start = list;
+	n = 0;
+	for(s=list; s!=S; s=s->next) {
+		if(n >= chunk) {
+			addrelrun(start, s);
+			start = s;
+			n = 0;
+		}
+		n += s->nr;
+	}
+	addrelrun(start, S);
 }
 
 void
 reloc(void)
 {
 	Sym *s;
+	Relrun *r;
+	vlong n;
+	int32 chunk;
 	
 	if(debug['v'])
 		Bprint(&bso, "%5.2f reloc\n", cputime());
 	Bflush(&bso);
 
+	n = 0;
 	for(s=textp; s!=S; s=s->next)
-		relocsym(s);
+		n += s->nr;
 	for(s=datap; s!=S; s=s->next)
-		relocsym(s);
+		n += s->nr;
+	chunk = n/(4*nworker());
+	if(chunk < Relocrun)
+		chunk = Relocrun;
+
+	relwork.n = 0;
+	splitrel(textp, chunk);
+	splitrel(datap, chunk);
+	parfor(relwork.n, relocrun, nil);
+
+	for(r=relwork.r; r<relwork.r+relwork.n; r++)
+		if(r->redo)
+			for(s=r->s; s!=r->e; s=s->next)
+				relocsym(s);
 }
 
 void
@@ -413,6 +538,129 @@ savedata(Sym *s, Prog *p, char *pn)
 	}
 }
 
+/*
+ * When the output can be mapped, blk cuts the block into chunks
+ * at symbol boundaries and fills them from several threads.
+ */
+enum
+{
+	Blkchunk = 64*1024,	// smallest chunk worth a thread
+};
+
+typedef struct Chunk Chunk;
+struct Chunk
+{
+	Sym*	sym;	// first symbol at or after addr
+	int32	addr;	// chunk covers [addr, eaddr)
+	int32	eaddr;
+};
+
+static struct
+{
+	Chunk*	c;
+	int	n;
+	int	m;
+	uchar*	out;	// mapped output for block
+	int32	addr;	// address of out[0]
+} blkwork;
+
+static void
+addchunk(Sym *sym, int32 addr, int32 eaddr)
+{
+	Chunk *c;
+
+	if(blkwork.n >= blkwork.m) {
+		blkwork.m = 2*blkwork.m + 16;
+		blkwork.c = realloc(blkwork.c, blkwork.m*sizeof blkwork.c[0]);
+		if(blkwork.c == nil) {
+			diag("out of memory");
+			errorexit();
+		}
+	}
+	c = &blkwork.c[blkwork.n++];
+	c->sym = sym;
+	c->addr = addr;
+	c->eaddr = eaddr;
+}
+
+static void
+fillchunk(void *v, int i)
+{
+	Chunk *c;
+	Sym *sym;
+	uchar *out;
+	int32 addr;
+
+	USED(v);
+	c = &blkwork.c[i];
+	out = blkwork.out;
+	addr = c->addr;
+	for(sym = c->sym; sym != nil && sym->value < c->eaddr; sym = sym->next) {
+		if(sym->type&SSUB)
+			continue;
+		memset(out + (addr - blkwork.addr), 0, sym->value - addr);
+		memmove(out + (sym->value - blkwork.addr), sym->p, sym->np);
+		addr = sym->value + sym->np;
+		memset(out + (addr - blkwork.addr), 0, sym->value + sym->size - addr);
+		addr = sym->value + sym->size;
+	}
+	memset(out + (addr - blkwork.addr), 0, c->eaddr - addr);
+}
+
+static int
+blkmap(Sym *start, int32 addr, int32 size)
+{
+	Sym *sym, *csym;
+	int32 eaddr, caddr, a, chunk;
+
+	if(size <= 0 || (blkwork.out = cmap(size)) == nil)
+		return 0;
+	blkwork.addr = addr;
+	blkwork.n = 0;
+	chunk = size/(4*nworker());
+	if(chunk < Blkchunk)
+		chunk = Blkchunk;
+
+	for(sym = start; sym != nil; sym = sym->next)
+		if(!(sym->type&SSUB) && sym->value >= addr)
+			break;
+
+	eaddr = addr+size;
+	a = addr;
+	caddr = addr;
+	csym = sym;
+	for(; sym != nil; sym = sym->next) {
+		if(sym->type&SSUB)
+			continue;
+		if(sym->value >= eaddr)
+			break;
+		cursym = sym;
+		if(sym->value < a) {
+			diag("phase error: addr=%#llx but sym=%#llx type=%d", (vlong)a, (vlong)sym->value, sym->type);
+			errorexit();
+		}
+		if(sym->np > sym->size) {
+			diag("phase error: addr=%#llx value+size=%#llx", (vlong)sym->value+sym->np, (vlong)sym->value+sym->size);
+			errorexit();
+		}
+		if(sym->value - caddr >= chunk) {
+			addchunk(csym, caddr, sym->value);
+			csym = sym;
+			caddr = sym->value;
+		}
+		a = sym->value + sym->size;
+	}
+	if(a > eaddr) {
+		diag("phase error: addr=%#llx past end of block %#llx", (vlong)a, (vlong)eaddr);
+		errorexit();
+	}
+	addchunk(csym, caddr, eaddr);
+
+	parfor(blkwork.n, fillchunk, nil);
+	cunmap(blkwork.out, size);
+	return 1;
+}
+
 static void
 blk(Sym *start, int32 addr, int32 size)
 {
@@ -420,6 +668,9 @@ blk(Sym *start, int32 addr, int32 size)
 	int32 eaddr;
 	uchar *p, *ep;
 
+	if(blkmap(start, addr, size))
+		return;
+
 	for(sym = start; sym != nil; sym = sym->next)
 		if(!(sym->type&SSUB) && sym->value >= addr)
 			break;
@@ -1001,6 +1252,9 @@ textaddress(void)
 
 	addsection(&segtext, ".text", 05);
 
+	if(pgofile != nil || symorder != nil)
+		ordertext();
+
 	// Assign PCs in text segment.
 	// Could parallelize, by assigning to text 
 	// and then letting threads copy down, but probably not worth it.
@@ -0,0 +1,534 @@
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Streaming zlib compressor (RFC 1950, 1951), used for the
+// compressed debug sections.  It does greedy LZ77 matching over
+// hash chains and writes each block with dynamic or fixed
+// Huffman codes, whichever is shorter.
+
+#include	"l.h"
+#include	"lib.h"
+
+enum
+{
+	WSIZE = 1<<15,		// window; also the longest distance
+	WMASK = WSIZE-1,
+	HSIZE = 1<<15,
+	HMASK = HSIZE-1,
+	MINMATCH = 3,
+	MAXMATCH = 258,
+	MAXCHAIN = 128,		// candidates tried per position
+	NBLOCKSYM = 1<<14,	// symbols per block
+	NLIT = 286,
+	NDIST = 30,
+	NCLEN = 19,
+	OBUFSIZE = 8192,
+};
+
+struct Deflate
+{
+	void	(*out)(void*, uchar*, int);
+	void*	arg;
+
+	uchar	win[2*WSIZE];
+	int	pos;		// next byte to compress
+	int	end;		// end of input in win
+	int	head[HSIZE];	// last position with each hash
+	int	prev[WSIZE];	// previous position with the same hash
+
+	ushort	sym[NBLOCKSYM];	// literal byte, or match length
+	ushort	dist[NBLOCKSYM];	// match distance, 0 for a literal
+	int	nsym;
+
+	uchar	lcode[MAXMATCH+1];	// match length -> length code
+	uchar	dcode[512];		// see distcode
+
+	uint32	adlera;
+	uint32	adlerb;
+
+	uint32	bits;
+	int	nbits;
+	uchar	obuf[OBUFSIZE];
+	int	nobuf;
+};
+
+static int lbase[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static int lext[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static int dbase[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577,
+};
+static int dext[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+static uchar clenorder[NCLEN] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+#define	HASH(p)	((((p)[0]<<10) ^ ((p)[1]<<5) ^ (p)[2]) & HMASK)
+
+/*
+ * Start a zlib stream.  Compressed bytes are passed to out(arg, p, n)
+ * as they are produced.  Deflate is safe to use from several threads
+ * at once as long as each has its own stream.
+ */
+Deflate*
+deflateinit(void (*out)(void*, uchar*, int), void *arg)
+{
+	Deflate *z;
+	int c, i, d;
+
+	z = malloc(sizeof *z);
+	if(z == nil) {
+		diag("out of memory");
+		errorexit();
+	}
+	memset(z, 0, sizeof *z);
+	z->out = out;
+	z->arg = arg;
+	for(i=0; i<HSIZE; i++)
+		z->head[i] = -1;
+	for(i=0; i<WSIZE; i++)
+		z->prev[i] = -1;
+	for(c=0; c<29; c++)
+		for(i=lbase[c]; i<lbase[c]+(1<<lext[c]) && i<=MAXMATCH; i++)
+			z->lcode[i] = c;
+	for(c=0; c<30; c++)
+		for(d=dbase[c]; d<dbase[c]+(1<<dext[c]); d++) {
+			if(d-1 < 256)
+				z->dcode[d-1] = c;
+			else
+				z->dcode[256+((d-1)>>7)] = c;
+		}
+	z->adlera = 1;
+
+	z->obuf[z->nobuf++] = 0x78;	// deflate, 32k window
+	z->obuf[z->nobuf++] = 0x9c;	// default level, check bits
+	return z;
+}
+
+static int
+distcode(Deflate *z, int d)
+{
+	if(d-1 < 256)
+		return z->dcode[d-1];
+	return z->dcode[256+((d-1)>>7)];
+}
+
+static void
+putbyte(Deflate *z, int c)
+{
+	z->obuf[z->nobuf++] = c;
+	if(z->nobuf == OBUFSIZE) {
+		z->out(z->arg, z->obuf, z->nobuf);
+		z->nobuf = 0;
+	}
+}
+
+static void
+putbits(Deflate *z, uint32 v, int n)
+{
+	z->bits |= v << z->nbits;
+	z->nbits += n;
+	while(z->nbits >= 8) {
+		putbyte(z, z->bits);
+		z->bits >>= 8;
+		z->nbits -= 8;
+	}
+}
+
+/*
+ * Set len[i] to the length of the Huffman code for symbol i,
+ * given the frequencies freq[0:n], with no code longer than maxlen.
+ * At least two symbols always get a code, so that the code is
+ * complete.  Too long codes are fixed by flattening the frequencies
+ * and trying again.
+ */
+static void
+mklens(uint32 *freq, int n, uchar *len, int maxlen)
+{
+	uint32 f[NLIT], w[2*NLIT];
+	int node[NLIT], parent[2*NLIT];
+	int i, j, k, a, nn, nleaf, next, depth, max;
+
+	nleaf = 0;
+	for(i=0; i<n; i++) {
+		f[i] = freq[i];
+		if(f[i])
+			nleaf++;
+	}
+	for(i=0; i<n && nleaf<2; i++)
+		if(f[i] == 0) {
+			f[i] = 1;
+			nleaf++;
+		}
+
+	for(;;) {
+		nn = 0;
+		for(i=0; i<n; i++) {
+			len[i] = 0;
+			parent[i] = -1;
+			if(f[i]) {
+				w[i] = f[i];
+				node[nn++] = i;
+			}
+		}
+		next = n;
+		while(nn > 1) {
+			// Replace the two lightest nodes by their sum.
+			for(k=0; k<2; k++) {
+				a = 0;
+				for(j=1; j<nn; j++)
+					if(w[node[j]] < w[node[a]])
+						a = j;
+				parent[node[a]] = next;
+				if(k == 0)
+					w[next] = w[node[a]];
+				else
+					w[next] += w[node[a]];
+				node[a] = node[--nn];
+			}
+			parent[next] = -1;
+			node[nn++] = next++;
+		}
+		max = 0;
+		for(i=0; i<n; i++) {
+			if(f[i] == 0)
+				continue;
+			depth = 0;
+			for(j=i; parent[j] >= 0; j=parent[j])
+				depth++;
+			len[i] = depth;
+			if(depth > max)
+				max = depth;
+		}
+		if(max <= maxlen)
+			return;
+		for(i=0; i<n; i++)
+			if(f[i])
+				f[i] = (f[i]>>1) | 1;
+	}
+}
+
+/*
+ * Assign the canonical codes for the lengths len[0:n],
+ * bit-reversed, since deflate sends codes high bit first.
+ */
+static void
+mkcodes(uchar *len, int n, ushort *code)
+{
+	int i, j, c, r, bits, count[16], next[16];
+
+	memset(count, 0, sizeof count);
+	for(i=0; i<n; i++)
+		count[len[i]]++;
+	count[0] = 0;
+	c = 0;
+	for(bits=1; bits<16; bits++) {
+		c = (c + count[bits-1]) << 1;
+		next[bits] = c;
+	}
+	for(i=0; i<n; i++) {
+		if(len[i] == 0)
+			continue;
+		c = next[len[i]]++;
+		r = 0;
+		for(j=0; j<len[i]; j++) {
+			r = (r<<1) | (c&1);
+			c >>= 1;
+		}
+		code[i] = r;
+	}
+}
+
+/*
+ * Write the buffered symbols as one block.
+ */
+static void
+putblock(Deflate *z, int final)
+{
+	uint32 lf[NLIT], df[NDIST], cf[NCLEN];
+	uchar ll[NLIT], dl[NDIST], cl[NCLEN], all[NLIT+NDIST];
+	ushort lc[NLIT], dc[NDIST], cc[NCLEN];
+	ushort rs[NLIT+NDIST];
+	uchar rx[NLIT+NDIST];
+	int i, c, d, k, m, r, v, n, nr, nlit, ndist, nclen;
+	vlong dyn, fixed;
+
+	memset(lf, 0, sizeof lf);
+	memset(df, 0, sizeof df);
+	memset(cf, 0, sizeof cf);
+	for(i=0; i<z->nsym; i++) {
+		if(z->dist[i] == 0) {
+			lf[z->sym[i]]++;
+			continue;
+		}
+		lf[257+z->lcode[z->sym[i]]]++;
+		df[distcode(z, z->dist[i])]++;
+	}
+	lf[256] = 1;
+
+	mklens(lf, NLIT, ll, 15);
+	mklens(df, NDIST, dl, 15);
+	for(nlit=NLIT; nlit>257 && ll[nlit-1]==0; nlit--)
+		;
+	for(ndist=NDIST; ndist>1 && dl[ndist-1]==0; ndist--)
+		;
+
+	// Run-length encode the code lengths.
+	memmove(all, ll, nlit);
+	memmove(all+nlit, dl, ndist);
+	n = nlit+ndist;
+	nr = 0;
+	for(i=0; i<n; i+=r) {
+		v = all[i];
+		for(r=1; i+r<n && all[i+r]==v; r++)
+			;
+		k = r;
+		if(v == 0) {
+			while(k >= 11) {
+				m = k < 138 ? k : 138;
+				rs[nr] = 18;
+				rx[nr++] = m-11;
+				k -= m;
+			}
+			if(k >= 3) {
+				rs[nr] = 17;
+				rx[nr++] = k-3;
+				k = 0;
+			}
+		} else {
+			rs[nr] = v;
+			rx[nr++] = 0;
+			k--;
+			while(k >= 3) {
+				m = k < 6 ? k : 6;
+				rs[nr] = 16;
+				rx[nr++] = m-3;
+				k -= m;
+			}
+		}
+		while(k-- > 0) {
+			rs[nr] = v;
+			rx[nr++] = 0;
+		}
+	}
+	for(i=0; i<nr; i++)
+		cf[rs[i]]++;
+	mklens(cf, NCLEN, cl, 7);
+	for(nclen=NCLEN; nclen>4 && cl[clenorder[nclen-1]]==0; nclen--)
+		;
+
+	// Compare the dynamic and fixed encodings.
+	// The extra bits are the same in both, so leave them out.
+	dyn = 5+5+4 + 3*nclen;
+	for(i=0; i<nr; i++)
+		dyn += cl[rs[i]] + (rs[i]==16 ? 2 : rs[i]==17 ? 3 : rs[i]==18 ? 7 : 0);
+	fixed = 0;
+	for(i=0; i<NLIT; i++) {
+		dyn += (vlong)lf[i] * ll[i];
+		fixed += (vlong)lf[i] * (i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8);
+	}
+	for(i=0; i<NDIST; i++) {
+		dyn += (vlong)df[i] * dl[i];
+		fixed += (vlong)df[i] * 5;
+	}
+
+	putbits(z, final, 1);
+	if(fixed <= dyn) {
+		putbits(z, 1, 2);
+		for(i=0; i<NLIT; i++)
+			ll[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+		for(i=0; i<NDIST; i++)
+			dl[i] = 5;
+	} else {
+		putbits(z, 2, 2);
+		putbits(z, nlit-257, 5);
+		putbits(z, ndist-1, 5);
+		putbits(z, nclen-4, 4);
+		for(i=0; i<nclen; i++)
+			putbits(z, cl[clenorder[i]], 3);
+		mkcodes(cl, NCLEN, cc);
+		for(i=0; i<nr; i++) {
+			putbits(z, cc[rs[i]], cl[rs[i]]);
+			switch(rs[i]) {
+			case 16:
+				putbits(z, rx[i], 2);
+				break;
+			case 17:
+				putbits(z, rx[i], 3);
+				break;
+			case 18:
+				putbits(z, rx[i], 7);
+				break;
+			}
+		}
+	}
+	mkcodes(ll, NLIT, lc);
+	mkcodes(dl, NDIST, dc);
+
+	for(i=0; i<z->nsym; i++) {
+		v = z->sym[i];
+		d = z->dist[i];
+		if(d == 0) {
+			putbits(z, lc[v], ll[v]);
+			continue;
+		}
+		c = z->lcode[v];
+		putbits(z, lc[257+c], ll[257+c]);
+		if(lext[c])
+			putbits(z, v - lbase[c], lext[c]);
+		c = distcode(z, d);
+		putbits(z, dc[c], dl[c]);
+		if(dext[c])
+			putbits(z, d - dbase[c], dext[c]);
+	}
+	putbits(z, lc[256], ll[256]);
+	z->nsym = 0;
+}
+
+static void
+insert(Deflate *z, int p)
+{
+	int h;
+
+	if(p+MINMATCH > z->end)
+		return;
+	h = HASH(z->win+p);
+	z->prev[p&WMASK] = z->head[h];
+	z->head[h] = p;
+}
+
+/*
+ * Turn input into symbols.  Unless flushing, keep enough
+ * lookahead for the longest match.
+ */
+static void
+compress(Deflate *z, int flush)
+{
+	uchar *w;
+	int p, n, l, max, best, bestpos, cand, chain;
+
+	w = z->win;
+	for(;;) {
+		p = z->pos;
+		n = z->end - p;
+		if(n <= 0 || (n < MAXMATCH+MINMATCH && !flush))
+			break;
+		best = 0;
+		bestpos = 0;
+		if(n >= MINMATCH) {
+			max = n < MAXMATCH ? n : MAXMATCH;
+			cand = z->head[HASH(w+p)];
+			for(chain=MAXCHAIN; chain>0 && cand>=0 && p-cand<WSIZE; chain--) {
+				if(w[cand+best] == w[p+best]) {
+					for(l=0; l<max && w[cand+l]==w[p+l]; l++)
+						;
+					if(l > best) {
+						best = l;
+						bestpos = cand;
+						if(l == max)
+							break;
+					}
+				}
+				cand = z->prev[cand&WMASK];
+			}
+		}
+		if(best >= MINMATCH) {
+			z->sym[z->nsym] = best;
+			z->dist[z->nsym++] = p - bestpos;
+			for(l=0; l<best; l++)
+				insert(z, p+l);
+			z->pos = p+best;
+		} else {
+			z->sym[z->nsym] = w[p];
+			z->dist[z->nsym++] = 0;
+			insert(z, p);
+			z->pos = p+1;
+		}
+		if(z->nsym == NBLOCKSYM)
+			putblock(z, 0);
+	}
+}
+
+/*
+ * Drop the older half of the window.
+ */
+static void
+slide(Deflate *z)
+{
+	int i;
+
+	memmove(z->win, z->win+WSIZE, WSIZE);
+	z->pos -= WSIZE;
+	z->end -= WSIZE;
+	for(i=0; i<HSIZE; i++)
+		z->head[i] = z->head[i] >= WSIZE ? z->head[i]-WSIZE : -1;
+	for(i=0; i<WSIZE; i++)
+		z->prev[i] = z->prev[i] >= WSIZE ? z->prev[i]-WSIZE : -1;
+}
+
+void
+deflatewrite(Deflate *z, uchar *p, int n)
+{
+	uint32 a, b;
+	int i, m;
+
+	a = z->adlera;
+	b = z->adlerb;
+	for(i=0; i<n; ) {
+		m = n-i < 5552 ? n-i : 5552;
+		while(m-- > 0) {
+			a += p[i++];
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	z->adlera = a;
+	z->adlerb = b;
+
+	while(n > 0) {
+		if(z->end == 2*WSIZE)
+			slide(z);
+		m = 2*WSIZE - z->end;
+		if(m > n)
+			m = n;
+		memmove(z->win+z->end, p, m);
+		z->end += m;
+		p += m;
+		n -= m;
+		compress(z, 0);
+	}
+}
+
+/*
+ * Finish the stream and free z.
+ */
+void
+deflateend(Deflate *z)
+{
+	uint32 sum;
+
+	compress(z, 1);
+	putblock(z, 1);
+	if(z->nbits > 0)
+		putbits(z, 0, 8 - z->nbits);
+	sum = z->adlerb<<16 | z->adlera;
+	putbyte(z, sum>>24);
+	putbyte(z, sum>>16);
+	putbyte(z, sum>>8);
+	putbyte(z, sum);
+	if(z->nobuf > 0)
+		z->out(z->arg, z->obuf, z->nobuf);
+	free(z);
+}
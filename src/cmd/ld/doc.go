@@ -29,6 +29,11 @@ Options new in this version:
 		is statically linked and does not refer to a dynamic linker.  Without this option
 		(the default), the binary's contents are identical but it is loaded with a dynamic
 		linker. This flag cannot be used when $GOOS is windows.
+	-F file      (only in 6l/8l)
+		Place the functions that the profile feedback in file,
+		written by go tool prof -F, reports as hot at the start
+		of the text segment, hottest first.  With -F or -k, package
+		initializers and the runtime's panic paths go at the end.
 	-Hdarwin     (only in 6l/8l)
 		Write Apple Mach-O binaries (default when $GOOS is darwin)
 	-Hlinux
@@ -45,6 +50,11 @@ Options new in this version:
 		Write Windows PE32+ GUI binaries
 	-I interpreter
 		Set the ELF dynamic linker to use.
+	-k file      (only in 6l/8l)
+		Place the functions named in file, one per line, at the
+		start of the text segment in the order given, ahead of
+		any placed by -F.  Blank lines, lines starting with #,
+		and names of functions not in the binary are ignored.
 	-L dir1 -L dir2
 		Search for libraries (package files) in dir1, dir2, etc.
 		The default is the single location $GOROOT/pkg/$GOOS_$GOARCH.
@@ -56,5 +66,8 @@ Options new in this version:
 		Set the value of an otherwise uninitialized string variable.
 		The symbol name should be of the form importpath.name,
 		as displayed in the symbol table printed by "go tool nm".
+	-Z           (only in 6l/8l)
+		Write the DWARF sections of ELF binaries uncompressed.
+		By default each is zlib-compressed into a .zdebug_ section.
 */
 package documentation
@@ -363,7 +363,7 @@ writeabbrev(void)
 
 enum
 {
-	HASHSIZE = 107
+	HASHMIN = 32	// initial buckets in an index; grows by doubling
 };
 
 static uint32
@@ -371,10 +371,11 @@ hashstr(char* s)
 {
 	uint32 h;
 
-	h = 0;
+	// FNV-1a
+	h = 2166136261U;
 	while (*s)
-		h = h+h+h + *s++;
-	return h % HASHSIZE;
+		h = (h ^ (uchar)*s++) * 16777619U;
+	return h;
 }
 
 // For DW_CLS_string and _block, value should contain the length, and
@@ -392,6 +393,7 @@ struct DWAttr {
 };
 
 typedef struct DWDie DWDie;
+typedef struct DWIndex DWIndex;
 struct DWDie {
 	int abbrev;
 	DWDie *link;
@@ -400,10 +402,19 @@ struct DWDie {
 	// offset into .debug_info section, i.e relative to
 	// infoo. only valid after call to putdie()
 	vlong offs;
-	DWDie **hash;  // optional index of children by name, enabled by mkindex()
+	DWIndex *hash;  // optional index of children by name, enabled by mkindex()
 	DWDie *hlink;  // bucket chain in parent's index
 };
 
+// An index of a DIE's children by name: a hash table whose
+// size is a power of 2, doubled when it gets as many entries
+// as buckets.
+struct DWIndex {
+	DWDie **bucket;
+	uint32 nbucket;
+	uint32 nelem;
+};
+
 /*
  * Root DIEs for compilation units, types and global variables.
  */
@@ -456,11 +467,37 @@ getattr(DWDie *die, uint8 attr)
 // Every DIE has at least a DW_AT_name attribute (but it will only be
 // written out if it is listed in the abbrev).	If its parent is
 // keeping an index, the new DIE will be inserted there.
+static void
+addindex(DWIndex *x, DWDie *die, char *name)
+{
+	DWDie **ob, *a, *next;
+	uint32 i, on, h;
+
+	if (x->nelem >= x->nbucket) {
+		// Old buckets are not freed: mal memory is never reclaimed.
+		ob = x->bucket;
+		on = x->nbucket;
+		x->nbucket *= 2;
+		x->bucket = mal(x->nbucket * sizeof(DWDie*));
+		for (i = 0; i < on; i++) {
+			for (a = ob[i]; a != nil; a = next) {
+				next = a->hlink;
+				h = hashstr(getattr(a, DW_AT_name)->data) & (x->nbucket-1);
+				a->hlink = x->bucket[h];
+				x->bucket[h] = a;
+			}
+		}
+	}
+	h = hashstr(name) & (x->nbucket-1);
+	die->hlink = x->bucket[h];
+	x->bucket[h] = die;
+	x->nelem++;
+}
+
 static DWDie*
 newdie(DWDie *parent, int abbrev, char *name)
 {
 	DWDie *die;
-	int h;
 
 	die = mal(sizeof *die);
 	die->abbrev = abbrev;
@@ -469,11 +506,8 @@ newdie(DWDie *parent, int abbrev, char *name)
 
 	newattr(die, DW_AT_name, DW_CLS_STRING, strlen(name), name);
 
-	if (parent->hash) {
-		h = hashstr(name);
-		die->hlink = parent->hash[h];
-		parent->hash[h] = die;
-	}
+	if (parent->hash)
+		addindex(parent->hash, die, name);
 
 	return die;
 }
@@ -481,7 +515,9 @@ newdie(DWDie *parent, int abbrev, char *name)
 static void
 mkindex(DWDie *die)
 {
-	die->hash = mal(HASHSIZE * sizeof(DWDie*));
+	die->hash = mal(sizeof *die->hash);
+	die->hash->nbucket = HASHMIN;
+	die->hash->bucket = mal(HASHMIN * sizeof(DWDie*));
 }
 
 // Find child by AT_name using hashtable if available or linear scan
@@ -489,8 +525,7 @@ mkindex(DWDie *die)
 static DWDie*
 find(DWDie *die, char* name)
 {
-	DWDie *a, *b;
-	int h;
+	DWDie *a;
 
 	if (die->hash == nil) {
 		for (a = die->child; a != nil; a = a->link)
@@ -499,28 +534,10 @@ find(DWDie *die, char* name)
 		return nil;
 	}
 
-	h = hashstr(name);
-	a = die->hash[h];
-
-	if (a == nil)
-		return nil;
-
-
-	if (strcmp(name, getattr(a, DW_AT_name)->data) == 0)
-		return a;
-
-	// Move found ones to head of the list.
-	b = a->hlink;
-	while (b != nil) {
-		if (strcmp(name, getattr(b, DW_AT_name)->data) == 0) {
-			a->hlink = b->hlink;
-			b->hlink = die->hash[h];
-			die->hash[h] = b;
-			return b;
-		}
-		a = b;
-		b = b->hlink;
-	}
+	a = die->hash->bucket[hashstr(name) & (die->hash->nbucket-1)];
+	for (; a != nil; a = a->hlink)
+		if (strcmp(name, getattr(a, DW_AT_name)->data) == 0)
+			return a;
 	return nil;
 }
 
@@ -740,242 +757,6 @@ newabslocexprattr(DWDie *die, vlong addr)
 	memmove(die->attr->data, block, i);
 }
 
-// Decoding the type.* symbols.	 This has to be in sync with
-// ../../pkg/runtime/type.go, or more specificaly, with what
-// ../gc/reflect.c stuffs in these.
-
-enum {
-	KindBool = 1,
-	KindInt,
-	KindInt8,
-	KindInt16,
-	KindInt32,
-	KindInt64,
-	KindUint,
-	KindUint8,
-	KindUint16,
-	KindUint32,
-	KindUint64,
-	KindUintptr,
-	KindFloat32,
-	KindFloat64,
-	KindComplex64,
-	KindComplex128,
-	KindArray,
-	KindChan,
-	KindFunc,
-	KindInterface,
-	KindMap,
-	KindPtr,
-	KindSlice,
-	KindString,
-	KindStruct,
-	KindUnsafePointer,
-
-	KindNoPointers = 1<<7,
-
-	// size of Type interface header + CommonType structure.
-	CommonSize = 2*PtrSize+ 6*PtrSize + 8,
-};
-
-static Reloc*
-decode_reloc(Sym *s, int32 off)
-{
-	int i;
-
-	for (i = 0; i < s->nr; i++)
-		if (s->r[i].off == off)
-			return s->r + i;
-	return nil;
-}
-
-static Sym*
-decode_reloc_sym(Sym *s, int32 off)
-{
-	Reloc *r;
-
-	r = decode_reloc(s,off);
-	if (r == nil)
-		return nil;
-	return r->sym;
-}
-
-static uvlong
-decode_inuxi(uchar* p, int sz)
-{
-	uint64 v;
-	uint32 l;
-	uchar *cast, *inuxi;
-	int i;
-
-	v = l = 0;
-	cast = nil;
-	inuxi = nil;
-	switch (sz) {
-	case 2:
-		cast = (uchar*)&l;
-		inuxi = inuxi2;
-		break;
-	case 4:
-		cast = (uchar*)&l;
-		inuxi = inuxi4;
-		break;
-	case 8:
-		cast = (uchar*)&v;
-		inuxi = inuxi8;
-		break;
-	default:
-		diag("dwarf: decode inuxi %d", sz);
-		errorexit();
-	}
-	for (i = 0; i < sz; i++)
-		cast[inuxi[i]] = p[i];
-	if (sz == 8)
-		return v;
-	return l;
-}
-
-// Type.commonType.kind
-static uint8
-decodetype_kind(Sym *s)
-{
-	return s->p[3*PtrSize + 7] & ~KindNoPointers;	//  0x13 / 0x1f
-}
-
-// Type.commonType.size
-static vlong
-decodetype_size(Sym *s)
-{
-	return decode_inuxi(s->p + 2*PtrSize, PtrSize);	 // 0x8 / 0x10
-}
-
-// Type.ArrayType.elem and Type.SliceType.Elem
-static Sym*
-decodetype_arrayelem(Sym *s)
-{
-	return decode_reloc_sym(s, CommonSize);	// 0x1c / 0x30
-}
-
-static vlong
-decodetype_arraylen(Sym *s)
-{
-	return decode_inuxi(s->p + CommonSize+PtrSize, PtrSize);
-}
-
-// Type.PtrType.elem
-static Sym*
-decodetype_ptrelem(Sym *s)
-{
-	return decode_reloc_sym(s, CommonSize);	// 0x1c / 0x30
-}
-
-// Type.MapType.key, elem
-static Sym*
-decodetype_mapkey(Sym *s)
-{
-	return decode_reloc_sym(s, CommonSize);	// 0x1c / 0x30
-}
-static Sym*
-decodetype_mapvalue(Sym *s)
-{
-	return decode_reloc_sym(s, CommonSize+PtrSize);	// 0x20 / 0x38
-}
-
-// Type.ChanType.elem
-static Sym*
-decodetype_chanelem(Sym *s)
-{
-	return decode_reloc_sym(s, CommonSize);	// 0x1c / 0x30
-}
-
-// Type.FuncType.dotdotdot
-static int
-decodetype_funcdotdotdot(Sym *s)
-{
-	return s->p[CommonSize];
-}
-
-// Type.FuncType.in.len
-static int
-decodetype_funcincount(Sym *s)
-{
-	return decode_inuxi(s->p + CommonSize+2*PtrSize, 4);
-}
-
-static int
-decodetype_funcoutcount(Sym *s)
-{
-	return decode_inuxi(s->p + CommonSize+3*PtrSize + 2*4, 4);
-}
-
-static Sym*
-decodetype_funcintype(Sym *s, int i)
-{
-	Reloc *r;
-
-	r = decode_reloc(s, CommonSize + PtrSize);
-	if (r == nil)
-		return nil;
-	return decode_reloc_sym(r->sym, r->add + i * PtrSize);
-}
-
-static Sym*
-decodetype_funcouttype(Sym *s, int i)
-{
-	Reloc *r;
-
-	r = decode_reloc(s, CommonSize + 2*PtrSize + 2*4);
-	if (r == nil)
-		return nil;
-	return decode_reloc_sym(r->sym, r->add + i * PtrSize);
-}
-
-// Type.StructType.fields.Slice::len
-static int
-decodetype_structfieldcount(Sym *s)
-{
-	return decode_inuxi(s->p + CommonSize + PtrSize, 4);
-}
-
-enum {
-	StructFieldSize = 5*PtrSize
-};
-// Type.StructType.fields[]-> name, typ and offset.
-static char*
-decodetype_structfieldname(Sym *s, int i)
-{
-	Reloc *r;
-
-	// go.string."foo"  0x28 / 0x40
-	s = decode_reloc_sym(s, CommonSize + PtrSize + 2*4 + i*StructFieldSize);
-	if (s == nil)			// embedded structs have a nil name.
-		return nil;
-	r = decode_reloc(s, 0);		// s has a pointer to the string data at offset 0
-	if (r == nil)			// shouldn't happen.
-		return nil;
-	return (char*) r->sym->p + r->add;	// the c-string
-}
-
-static Sym*
-decodetype_structfieldtype(Sym *s, int i)
-{
-	return decode_reloc_sym(s, CommonSize + PtrSize + 2*4 + i*StructFieldSize + 2*PtrSize);
-}
-
-static vlong
-decodetype_structfieldoffs(Sym *s, int i)
-{
-	return decode_inuxi(s->p + CommonSize + PtrSize + 2*4 + i*StructFieldSize + 4*PtrSize, 4);
-}
-
-// InterfaceTYpe.methods.len
-static vlong
-decodetype_ifacemethodcount(Sym *s)
-{
-	return decode_inuxi(s->p + CommonSize + PtrSize, 4);
-}
-
-
 // Fake attributes for slices, maps and channel
 enum {
 	DW_AT_internal_elem_type = 250,	 // channels and slices
@@ -1623,13 +1404,15 @@ static vlong absline;
 
 typedef struct Linehist Linehist;
 struct Linehist {
-	Linehist *link;
 	vlong absline;
 	vlong line;
 	int file;
 };
 
+// sorted by absline; inlined bodies can add many entries.
 static Linehist *linehist;
+static int nlinehist;
+static int mlinehist;
 
 static void
 checknesting(void)
@@ -1654,8 +1437,6 @@ checknesting(void)
 static int
 inithist(Auto *a)
 {
-	Linehist *lh;
-
 	for (; a; a = a->link)
 		if (a->type == D_FILE)
 			break;
@@ -1676,11 +1457,7 @@ inithist(Auto *a)
 	includestack[includetop].file = 0;
 	includestack[includetop].line = -1;
 	absline = 0;
-	while (linehist != nil) {
-		lh = linehist->link;
-		free(linehist);
-		linehist = lh;
-	}
+	nlinehist = 0;
 
 	// Construct the new one.
 	for (; a; a = a->link) {
@@ -1707,14 +1484,15 @@ inithist(Auto *a)
 			includestack[includetop].line =	 a->aoffset;
 		} else
 			continue;
-		if (linehist == 0 || linehist->absline != absline) {
-			Linehist* lh = malloc(sizeof *lh);
-			lh->link = linehist;
-			lh->absline = absline;
-			linehist = lh;
+		if (nlinehist == 0 || linehist[nlinehist-1].absline != absline) {
+			if (nlinehist == mlinehist) {
+				mlinehist = 2 * mlinehist + 16;
+				linehist = realloc(linehist, mlinehist * sizeof *linehist);
+			}
+			linehist[nlinehist++].absline = absline;
 		}
-		linehist->file = includestack[includetop].file;
-		linehist->line = includestack[includetop].line;
+		linehist[nlinehist-1].file = includestack[includetop].file;
+		linehist[nlinehist-1].line = includestack[includetop].line;
 	}
 	return 1;
 }
@@ -1722,12 +1500,20 @@ inithist(Auto *a)
 static Linehist *
 searchhist(vlong absline)
 {
-	Linehist *lh;
+	int i, j, k;
 
-	for (lh = linehist; lh; lh = lh->link)
-		if (lh->absline <= absline)
-			break;
-	return lh;
+	i = 0;
+	j = nlinehist;
+	while (i < j) {
+		k = (i + j) / 2;
+		if (linehist[k].absline <= absline)
+			i = k + 1;
+		else
+			j = k;
+	}
+	if (i == 0)
+		return nil;
+	return &linehist[i-1];
 }
 
 static int
@@ -1841,7 +1627,7 @@ writelines(void)
 	int i, lang, da, dt;
 	Linehist *lh;
 	DWDie *dwinfo, *dwfunc, *dwvar, **dws;
-	DWDie *varhash[HASHSIZE];
+	DWIndex varhash;
 	char *n, *nn;
 
 	unitstart = -1;
@@ -1853,6 +1639,7 @@ writelines(void)
 	currfile = -1;
 	lineo = cpos();
 	dwinfo = nil;
+	memset(&varhash, 0, sizeof varhash);
 
 	for(cursym = textp; cursym != nil; cursym = cursym->next) {
 		s = cursym;
@@ -1868,10 +1655,9 @@ writelines(void)
 
 			if(debug['v'] > 1) {
 				print("dwarf writelines found %s\n", histfile[1]);
-				Linehist* lh;
-				for (lh = linehist; lh; lh = lh->link)
+				for (i = nlinehist - 1; i >= 0; i--)
 					print("\t%8lld: [%4lld]%s\n",
-					      lh->absline, lh->line, histfile[lh->file]);
+					      linehist[i].absline, linehist[i].line, histfile[linehist[i].file]);
 			}
 
 			lang = guesslang(histfile[1]);
@@ -1966,8 +1752,13 @@ writelines(void)
 		}
 
 		da = 0;
-		dwfunc->hash = varhash;	 // enable indexing of children by name
-		memset(varhash, 0, sizeof varhash);
+		dwfunc->hash = &varhash;	 // enable indexing of children by name
+		if (varhash.bucket == nil) {
+			varhash.nbucket = HASHMIN;
+			varhash.bucket = mal(HASHMIN * sizeof(DWDie*));
+		} else
+			memset(varhash.bucket, 0, varhash.nbucket * sizeof(DWDie*));
+		varhash.nelem = 0;
 		for(a = s->autom; a; a = a->link) {
 			switch (a->type) {
 			case D_AUTO:
@@ -2281,6 +2072,8 @@ align(vlong size)
 		strnput("", rnd(size, PEFILEALIGN) - size);
 }
 
+static void compresssections(void);
+
 /*
  * This is the main entry point for generating dwarf.  After emitting
  * the mandatory debug_abbrev section, it calls writelines() to set up
@@ -2381,6 +2174,9 @@ dwarfemitdebugsections(void)
 	gdbscripto = writegdbscript();
 	gdbscriptsize = cpos() - gdbscripto;
 	align(gdbscriptsize);
+
+	if(iself && !debug['Z'])
+		compresssections();
 }
 
 /*
@@ -2405,9 +2201,140 @@ enum
 
 vlong elfstrdbg[NElfStrDbg];
 
+/*
+ * Compressed sections.  On ELF, each section that gets smaller is
+ * rewritten as .zdebug_*, in the GNU format: "ZLIB", the uncompressed
+ * size as 8 big-endian bytes, then a zlib stream.  The sections are
+ * read back once written, since .debug_info is patched in place, and
+ * compressed in parallel.  -Z leaves them uncompressed.
+ */
+typedef struct Zsect Zsect;
+struct Zsect
+{
+	int	elfstr;
+	char*	zname;
+	vlong*	off;
+	vlong*	size;
+	vlong	zstr;	// offset of zname in .shstrtab
+	int	zipped;
+	uchar*	data;
+	uchar*	z;
+	int	nz;
+	int	zcap;
+};
+
+static Zsect zsect[] = {
+	{ElfStrDebugAbbrev,	".zdebug_abbrev",	&abbrevo,	&abbrevsize},
+	{ElfStrDebugLine,	".zdebug_line",		&lineo,		&linesize},
+	{ElfStrDebugFrame,	".zdebug_frame",	&frameo,	&framesize},
+	{ElfStrDebugInfo,	".zdebug_info",		&infoo,		&infosize},
+	{ElfStrDebugPubNames,	".zdebug_pubnames",	&pubnameso,	&pubnamessize},
+	{ElfStrDebugPubTypes,	".zdebug_pubtypes",	&pubtypeso,	&pubtypessize},
+	{ElfStrDebugAranges,	".zdebug_aranges",	&arangeso,	&arangessize},
+	{ElfStrGDBScripts,	nil,			&gdbscripto,	&gdbscriptsize},	// gdb finds it by name
+};
+
+static void
+zout(void *v, uchar *p, int n)
+{
+	Zsect *z;
+
+	z = v;
+	if(z->nz + n > z->zcap) {
+		z->zcap = 2*z->zcap + n;
+		z->z = realloc(z->z, z->zcap);
+		if(z->z == nil) {
+			diag("out of memory");
+			errorexit();
+		}
+	}
+	memmove(z->z + z->nz, p, n);
+	z->nz += n;
+}
+
+static void
+zsect1(void *v, int i)
+{
+	Zsect *z;
+	Deflate *d;
+	vlong n;
+	int j;
+
+	USED(v);
+	z = &zsect[i];
+	n = *z->size;
+	if(z->zname == nil || n == 0)
+		return;
+	z->zcap = n/4 + 12;
+	z->z = malloc(z->zcap);
+	if(z->z == nil) {
+		diag("out of memory");
+		errorexit();
+	}
+	memmove(z->z, "ZLIB", 4);
+	for(j=0; j<8; j++)
+		z->z[4+j] = n >> (56 - 8*j);
+	z->nz = 12;
+	d = deflateinit(zout, z);
+	deflatewrite(d, z->data, n);
+	deflateend(d);
+}
+
+static void
+compresssections(void)
+{
+	Zsect *z;
+	vlong n;
+
+	for(z=zsect; z<zsect+nelem(zsect); z++) {
+		if(*z->size == 0)
+			continue;
+		z->data = malloc(*z->size);
+		if(z->data == nil) {
+			diag("out of memory");
+			errorexit();
+		}
+		cread(*z->off, z->data, *z->size);
+	}
+	parfor(nelem(zsect), zsect1, nil);
+
+	cseek(abbrevo);
+	for(z=zsect; z<zsect+nelem(zsect); z++) {
+		n = *z->size;
+		if(n == 0)
+			continue;
+		*z->off = cpos();
+		if(z->z != nil && z->nz < n) {
+			cwrite(z->z, z->nz);
+			*z->size = z->nz;
+			z->zipped = 1;
+		} else
+			cwrite(z->data, n);
+		free(z->data);
+		free(z->z);
+		z->data = nil;
+		z->z = nil;
+	}
+	ctruncate();
+}
+
+// The name of the section with the given ElfStrDebug index.
+static vlong
+dbgname(int elfstr)
+{
+	Zsect *z;
+
+	for(z=zsect; z<zsect+nelem(zsect); z++)
+		if(z->elfstr == elfstr && z->zipped)
+			return z->zstr;
+	return elfstrdbg[elfstr];
+}
+
 void
 dwarfaddshstrings(Sym *shstrtab)
 {
+	Zsect *z;
+
 	if(debug['w'])  // disable dwarf
 		return;
 
@@ -2423,6 +2350,11 @@ dwarfaddshstrings(Sym *shstrtab)
 	elfstrdbg[ElfStrDebugRanges]   = addstring(shstrtab, ".debug_ranges");
 	elfstrdbg[ElfStrDebugStr]      = addstring(shstrtab, ".debug_str");
 	elfstrdbg[ElfStrGDBScripts]    = addstring(shstrtab, ".debug_gdb_scripts");
+
+	if(!debug['Z'])
+		for(z=zsect; z<zsect+nelem(zsect); z++)
+			if(z->zname != nil)
+				z->zstr = addstring(shstrtab, z->zname);
 }
 
 void
@@ -2433,32 +2365,32 @@ dwarfaddelfheaders(void)
 	if(debug['w'])  // disable dwarf
 		return;
 
-	sh = newElfShdr(elfstrdbg[ElfStrDebugAbbrev]);
+	sh = newElfShdr(dbgname(ElfStrDebugAbbrev));
 	sh->type = SHT_PROGBITS;
 	sh->off = abbrevo;
 	sh->size = abbrevsize;
 	sh->addralign = 1;
 
-	sh = newElfShdr(elfstrdbg[ElfStrDebugLine]);
+	sh = newElfShdr(dbgname(ElfStrDebugLine));
 	sh->type = SHT_PROGBITS;
 	sh->off = lineo;
 	sh->size = linesize;
 	sh->addralign = 1;
 
-	sh = newElfShdr(elfstrdbg[ElfStrDebugFrame]);
+	sh = newElfShdr(dbgname(ElfStrDebugFrame));
 	sh->type = SHT_PROGBITS;
 	sh->off = frameo;
 	sh->size = framesize;
 	sh->addralign = 1;
 
-	sh = newElfShdr(elfstrdbg[ElfStrDebugInfo]);
+	sh = newElfShdr(dbgname(ElfStrDebugInfo));
 	sh->type = SHT_PROGBITS;
 	sh->off = infoo;
 	sh->size = infosize;
 	sh->addralign = 1;
 
 	if (pubnamessize > 0) {
-		sh = newElfShdr(elfstrdbg[ElfStrDebugPubNames]);
+		sh = newElfShdr(dbgname(ElfStrDebugPubNames));
 		sh->type = SHT_PROGBITS;
 		sh->off = pubnameso;
 		sh->size = pubnamessize;
@@ -2466,7 +2398,7 @@ dwarfaddelfheaders(void)
 	}
 
 	if (pubtypessize > 0) {
-		sh = newElfShdr(elfstrdbg[ElfStrDebugPubTypes]);
+		sh = newElfShdr(dbgname(ElfStrDebugPubTypes));
 		sh->type = SHT_PROGBITS;
 		sh->off = pubtypeso;
 		sh->size = pubtypessize;
@@ -2474,7 +2406,7 @@ dwarfaddelfheaders(void)
 	}
 
 	if (arangessize) {
-		sh = newElfShdr(elfstrdbg[ElfStrDebugAranges]);
+		sh = newElfShdr(dbgname(ElfStrDebugAranges));
 		sh->type = SHT_PROGBITS;
 		sh->off = arangeso;
 		sh->size = arangessize;
@@ -2482,7 +2414,7 @@ dwarfaddelfheaders(void)
 	}
 
 	if (gdbscriptsize) {
-		sh = newElfShdr(elfstrdbg[ElfStrGDBScripts]);
+		sh = newElfShdr(dbgname(ElfStrGDBScripts));
 		sh->type = SHT_PROGBITS;
 		sh->off = gdbscripto;
 		sh->size = gdbscriptsize;
@@ -0,0 +1,646 @@
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Runtime function table.
+//
+// The Plan 9 symbol table and pc/line table are written for
+// debuggers and need to be decoded before use.  The runtime
+// instead uses a table written here in the form it wants, in
+// read-only data:
+//
+//	functab		header: pointers to the arrays below and
+//			the number of functions and files
+//	functab.func	Func[nfunc+1], sorted by entry; the last
+//			one has only its entry set, to etext
+//	functab.data	names, file names, String[nfile], the
+//			per-function pc and inline tables and the find
+//			buckets
+//
+// Each function has four pc-value tables: the source line,
+// the source file (an index into the file array), the stack
+// pointer adjustment made by the function so far and the
+// inlined call the pc is in.
+// A table is a sequence of (pc delta, value delta) pairs:
+// the value starts at 0 at the function entry and holds
+// until pc delta more instructions (of size MINLC) have
+// passed, at which point value delta is added.  The pc delta
+// is an unsigned varint, the value delta a zig-zag encoded
+// signed varint.  A lookup reads only the table of the
+// function containing the pc.
+//
+// The compiler gives the body of each inlined call a block of
+// absolute lines of its own, which the history maps to the
+// callee's source, so the line and file tables already show
+// the callee's lines there.  It lists the blocks of a function
+// f in the data symbol f·inl (see ../gc/obj.c:/^dumpinlcalls),
+// from which the inline table gives, for each pc, 1 + the index
+// in f's Inl array of the innermost call it is in, or 0.  An
+// Inl has the callee's name and the file, line and Inl index
+// (or -1) of the call.
+//
+// To find that function, the text is cut into buckets of
+// Bucketsize bytes, each split into Subbuckets pieces.  A bucket
+// records the index of the function containing its first byte
+// and, for each piece, the number of functions to skip from
+// there (saturating at 255); the runtime steps forward from
+// that function, which is usually the right one already.
+//
+// Keep in sync with ../../pkg/runtime/runtime.h:/^struct.Func
+// and ../../pkg/runtime/symtab.c.
+
+#include	"l.h"
+#include	"../ld/lib.h"
+
+enum
+{
+	Bucketsize = 4096,
+	Subbuckets = 16,
+};
+
+typedef struct Pctab Pctab;
+struct Pctab
+{
+	uchar*	p;
+	int32	n;
+	int32	m;
+	vlong	pc;
+	int32	val;
+};
+
+typedef struct Hist Hist;
+struct Hist
+{
+	vlong	absline;
+	vlong	line;
+	int	file;
+};
+
+typedef struct Inl Inl;
+struct Inl
+{
+	int32	lo;	// block of absolute lines of the body
+	int32	hi;
+	int32	line;	// absolute line of the call
+	char*	name;
+};
+
+static	Sym*	fdata;
+
+static	char**	frag;
+static	int	nfrag;
+
+static	char**	file;
+static	int	nfile;
+static	int	mfile;
+static	int*	filehash;
+static	int	nfilehash;
+
+static	Hist*	hist;
+static	int	nhist;
+static	int	mhist;
+static	Hist*	stk;
+static	int	mstk;
+
+static	Inl*	inl;
+static	int	ninl;
+static	int	minl;
+
+static void
+adduintptr(Sym *s, uvlong v)
+{
+	if(PtrSize == 8)
+		adduint64(s, v);
+	else
+		adduint32(s, v);
+}
+
+static void
+alignptr(Sym *s)
+{
+	while(s->size % PtrSize)
+		adduint8(s, 0);
+}
+
+// add a String pointing at a copy of str in functab.data.
+static void
+addgostring(Sym *s, char *str)
+{
+	vlong off;
+
+	off = addstring(fdata, str);
+	addaddrplus(s, fdata, off);
+	adduint32(s, strlen(str));
+	if(PtrSize == 8)
+		adduint32(s, 0);
+}
+
+// add a Slice pointing at the bytes of t, copied into functab.data.
+static void
+addpctab(Sym *s, Pctab *t)
+{
+	vlong off;
+
+	if(t->n == 0) {
+		adduintptr(s, 0);
+		adduint32(s, 0);
+		adduint32(s, 0);
+		return;
+	}
+	off = fdata->size;
+	symgrow(fdata, off+t->n);
+	memmove(fdata->p+off, t->p, t->n);
+	fdata->size += t->n;
+	addaddrplus(s, fdata, off);
+	adduint32(s, t->n);
+	adduint32(s, t->n);
+}
+
+static void
+pcbyte(Pctab *t, int c)
+{
+	if(t->n >= t->m) {
+		t->m = 2*t->m + 64;
+		t->p = realloc(t->p, t->m);
+		if(t->p == nil) {
+			diag("out of memory");
+			errorexit();
+		}
+	}
+	t->p[t->n++] = c;
+}
+
+static void
+pcuvarint(Pctab *t, uvlong v)
+{
+	for(; v >= 0x80; v >>= 7)
+		pcbyte(t, v|0x80);
+	pcbyte(t, v);
+}
+
+static void
+pcreset(Pctab *t, vlong entry)
+{
+	t->n = 0;
+	t->pc = entry;
+	t->val = 0;
+}
+
+// record that the value in t is val from pc on.
+static void
+pcset(Pctab *t, vlong pc, int32 val)
+{
+	int32 d;
+
+	if(val == t->val)
+		return;
+	if(pc < t->pc) {
+		diag("functab: pc went backward %llux < %llux", pc, t->pc);
+		return;
+	}
+	pcuvarint(t, (pc - t->pc) / MINLC);
+	d = val - t->val;
+	pcuvarint(t, ((uint32)d<<1) ^ (uint32)(d>>31));
+	t->pc = pc;
+	t->val = val;
+}
+
+// collect the file name fragments named by z entries.
+static void
+fragtab(void)
+{
+	Sym *s;
+	int n;
+
+	for(s=allsym; s!=S; s=s->allsym) {
+		if(s->type != SFILE || s->value < 0)
+			continue;
+		if(s->value >= nfrag) {
+			n = nfrag;
+			nfrag = s->value + 1 + nfrag/2;
+			frag = realloc(frag, nfrag*sizeof frag[0]);
+			if(frag == nil) {
+				diag("out of memory");
+				errorexit();
+			}
+			memset(frag+n, 0, (nfrag-n)*sizeof frag[0]);
+		}
+		frag[s->value] = s->name;
+		if(*frag[s->value] == '<')
+			frag[s->value]++;
+	}
+}
+
+static uint32
+filehashstr(char *s)
+{
+	uint32 h;
+
+	h = 0;
+	for(; *s; s++)
+		h = h*31 + (uchar)*s;
+	return h;
+}
+
+// index of the file named by the z entry path,
+// or -1 if the entry pops the include stack.
+static int
+zfile(char *path)
+{
+	char buf[1024], *p, *e, *f;
+	int i, o, n;
+	uint32 h;
+
+	p = buf;
+	e = buf + sizeof buf;
+	*p = '\0';
+	for(path++; (o = ((uchar)path[0]<<8) | (uchar)path[1]) != 0; path += 2) {
+		if(o >= nfrag || (f = frag[o]) == nil) {
+			diag("functab: corrupt z entry");
+			return -1;
+		}
+		if(p == buf || p[-1] == '/')
+			p = seprint(p, e, "%s", f);
+		else
+			p = seprint(p, e, "/%s", f);
+	}
+	if(p == buf)
+		return -1;
+
+	if(2*nfile >= nfilehash) {
+		free(filehash);
+		nfilehash = 2*nfilehash + 256;
+		filehash = malloc(nfilehash*sizeof filehash[0]);
+		if(filehash == nil) {
+			diag("out of memory");
+			errorexit();
+		}
+		for(i=0; i<nfilehash; i++)
+			filehash[i] = -1;
+		for(i=0; i<nfile; i++) {
+			for(h=filehashstr(file[i])%nfilehash; filehash[h]>=0; h=(h+1)%nfilehash)
+				;
+			filehash[h] = i;
+		}
+	}
+	for(h=filehashstr(buf)%nfilehash; (n = filehash[h]) >= 0; h=(h+1)%nfilehash)
+		if(strcmp(file[n], buf) == 0)
+			return n;
+	if(nfile >= mfile) {
+		mfile = 2*mfile + 64;
+		file = realloc(file, mfile*sizeof file[0]);
+		if(file == nil) {
+			diag("out of memory");
+			errorexit();
+		}
+	}
+	file[nfile] = strdup(buf);
+	filehash[h] = nfile;
+	return nfile++;
+}
+
+// rebuild the line history from the z entries that
+// start a new object file, as ../ld/dwarf.c:/^inithist does.
+static void
+inithist(Auto *a)
+{
+	int top, f;
+	vlong absline;
+
+	for(; a; a=a->link)
+		if(a->type == D_FILE)
+			break;
+	if(a == nil)
+		return;
+	if(a->aoffset != 1) {
+		diag("functab: stray 'z' with offset %d", a->aoffset);
+		return;
+	}
+
+	nhist = 0;
+	top = 0;
+	absline = 0;
+	if(mstk == 0) {
+		mstk = 16;
+		stk = malloc(mstk*sizeof stk[0]);
+	}
+	stk[0].file = -1;
+	stk[0].line = -1;
+	for(; a; a=a->link) {
+		if(a->type == D_FILE) {
+			f = zfile(a->asym->name);
+			if(f < 0) {
+				if(--top < 0) {
+					diag("functab: corrupt z stack");
+					errorexit();
+				}
+			} else {
+				stk[top].line += a->aoffset - absline;
+				if(++top >= mstk) {
+					mstk *= 2;
+					stk = realloc(stk, mstk*sizeof stk[0]);
+				}
+				stk[top].file = f;
+				stk[top].line = 1;
+			}
+			absline = a->aoffset;
+		} else if(a->type == D_FILE1)
+			stk[top].line = a->aoffset;
+		else
+			continue;
+		if(nhist == 0 || hist[nhist-1].absline != absline) {
+			if(nhist >= mhist) {
+				mhist = 2*mhist + 16;
+				hist = realloc(hist, mhist*sizeof hist[0]);
+			}
+			hist[nhist++].absline = absline;
+		}
+		hist[nhist-1].file = stk[top].file;
+		hist[nhist-1].line = stk[top].line;
+	}
+}
+
+// the history entry covering absolute line n.
+static Hist*
+searchhist(vlong n)
+{
+	int i, j, k;
+
+	i = 0;
+	j = nhist;
+	while(i < j) {
+		k = (i+j)/2;
+		if(hist[k].absline <= n)
+			i = k+1;
+		else
+			j = k;
+	}
+	if(i == 0)
+		return nil;
+	return &hist[i-1];
+}
+
+static int
+inlcmp(const void *a, const void *b)
+{
+	return ((Inl*)a)->lo - ((Inl*)b)->lo;
+}
+
+// load the calls inlined into s from s·inl, sorted by block.
+static void
+loadinl(Sym *s)
+{
+	Sym *t;
+	Reloc *r;
+	uchar *p;
+	char *name;
+	int i, n, siz;
+
+	ninl = 0;
+	name = smprint("%s·inl", s->name);
+	t = rlookup(name, 0);
+	free(name);
+	if(t == nil || t->np == 0)
+		return;
+	siz = 16 + PtrSize;
+	n = t->np / siz;
+	if(n > minl) {
+		minl = n + minl/2;
+		inl = realloc(inl, minl*sizeof inl[0]);
+		if(inl == nil) {
+			diag("out of memory");
+			errorexit();
+		}
+	}
+	for(i=0; i<n; i++) {
+		p = t->p + i*siz;
+		inl[i].lo = p[0] | p[1]<<8 | p[2]<<16 | p[3]<<24;
+		inl[i].hi = p[4] | p[5]<<8 | p[6]<<16 | p[7]<<24;
+		inl[i].line = p[8] | p[9]<<8 | p[10]<<16 | p[11]<<24;
+		inl[i].name = "?";
+	}
+	for(r=t->r; r<t->r+t->nr; r++)
+		if(r->sym != S && r->off/siz < n)
+			inl[r->off/siz].name = r->sym->name;
+	ninl = n;
+	qsort(inl, ninl, sizeof inl[0], inlcmp);
+}
+
+// the index of the inlined call whose body has absolute line n, or -1.
+static int
+searchinl(vlong n)
+{
+	int i, j, k;
+
+	i = 0;
+	j = ninl;
+	while(i < j) {
+		k = (i+j)/2;
+		if(inl[k].lo <= n)
+			i = k+1;
+		else
+			j = k;
+	}
+	if(i == 0 || n > inl[i-1].hi)
+		return -1;
+	return i-1;
+}
+
+// add the Inl array for the calls loaded by loadinl to functab.data
+// and a pointer to it to s.
+static void
+addinl(Sym *s)
+{
+	Hist *h;
+	vlong *name;
+	int i, j, file;
+	int32 line;
+
+	if(ninl == 0) {
+		adduintptr(s, 0);
+		return;
+	}
+	name = malloc(ninl*sizeof name[0]);
+	if(name == nil) {
+		diag("out of memory");
+		errorexit();
+	}
+	for(i=0; i<ninl; i++)
+		name[i] = addstring(fdata, inl[i].name);
+	alignptr(fdata);
+	addaddrplus(s, fdata, fdata->size);
+	for(i=0; i<ninl; i++) {
+		addaddrplus(fdata, fdata, name[i]);
+		adduint32(fdata, strlen(inl[i].name));
+		if(PtrSize == 8)
+			adduint32(fdata, 0);
+		file = -1;
+		line = 0;
+		if((h = searchhist(inl[i].line)) != nil && h->file >= 0) {
+			file = h->file;
+			line = h->line + inl[i].line - h->absline;
+		}
+		// the blocks are sorted and an inlined body is
+		// expanded before the calls in it.
+		j = searchinl(inl[i].line);
+		if(j >= i)
+			j = -1;
+		adduint32(fdata, j);	// parent
+		adduint32(fdata, file);
+		adduint32(fdata, line);
+		alignptr(fdata);
+	}
+	free(name);
+}
+
+void
+functab(void)
+{
+	Sym *ftab, *funcs, *s, **fn;
+	Prog *p;
+	Auto *a;
+	Hist *h;
+	Pctab pcln, pcfile, pcsp, pcinl;
+	int32 args, sp;
+	int i, j, k, n, nfunc;
+	vlong minpc, maxpc, pc, filetab, buckets, *off;
+
+	if(debug['v'])
+		Bprint(&bso, "%5.2f functab\n", cputime());
+	Bflush(&bso);
+
+	ftab = lookup("functab", 0);
+	ftab->type = SRODATA;
+	ftab->reachable = 1;
+	funcs = lookup("functab.func", 0);
+	funcs->type = SRODATA;
+	funcs->reachable = 1;
+	fdata = lookup("functab.data", 0);
+	fdata->type = SRODATA;
+	fdata->reachable = 1;
+
+	nfunc = 0;
+	for(s = textp; s != nil; s = s->next)
+		if(s->text != P)
+			nfunc++;
+	fn = malloc((nfunc+1)*sizeof fn[0]);
+	if(fn == nil) {
+		diag("out of memory");
+		errorexit();
+	}
+	n = 0;
+	for(s = textp; s != nil; s = s->next)
+		if(s->text != P)
+			fn[n++] = s;
+	minpc = 0;
+	maxpc = 0;
+	if(nfunc > 0) {
+		minpc = fn[0]->value;
+		maxpc = fn[nfunc-1]->value + fn[nfunc-1]->size;
+	}
+
+	fragtab();
+	memset(&pcln, 0, sizeof pcln);
+	memset(&pcfile, 0, sizeof pcfile);
+	memset(&pcsp, 0, sizeof pcsp);
+	memset(&pcinl, 0, sizeof pcinl);
+	nhist = 0;
+	nfile = 0;
+	for(i=0; i<nfunc; i++) {
+		s = fn[i];
+		inithist(s->autom);
+		loadinl(s);
+
+		pcreset(&pcln, s->value);
+		pcreset(&pcfile, s->value);
+		pcreset(&pcsp, s->value);
+		pcreset(&pcinl, s->value);
+		sp = 0;
+		for(p = s->text; p != P; p = p->link) {
+			if(p->as != ATEXT && p->as != ANOP && (h = searchhist(p->line)) != nil && h->file >= 0) {
+				pcset(&pcfile, p->pc, h->file);
+				pcset(&pcln, p->pc, h->line + p->line - h->absline);
+				if(ninl > 0)
+					pcset(&pcinl, p->pc, searchinl(p->line) + 1);
+			}
+			if(p->spadj != 0 && p->link != P) {
+				sp += p->spadj;
+				pcset(&pcsp, p->link->pc, sp);
+			}
+		}
+
+		args = 0;
+		for(a = s->autom; a; a = a->link)
+			if(a->type == D_PARAM && args < a->aoffset/4 + 2)
+				args = a->aoffset/4 + 2;
+
+		addgostring(funcs, s->name);
+		addaddr(funcs, s);
+		addpctab(funcs, &pcln);
+		addpctab(funcs, &pcfile);
+		addpctab(funcs, &pcsp);
+		addpctab(funcs, &pcinl);
+		addinl(funcs);
+		adduint32(funcs, s->text->to.offset + PtrSize);	// frame
+		adduint32(funcs, args);
+		adduint32(funcs, 0);	// locals
+		alignptr(funcs);
+	}
+	free(pcln.p);
+	free(pcfile.p);
+	free(pcsp.p);
+	free(pcinl.p);
+
+	// the last Func has only its entry, etext.
+	n = funcs->size;
+	adduintptr(funcs, 0);
+	adduintptr(funcs, 0);
+	adduintptr(funcs, maxpc);
+	while(funcs->size < n + (nfunc > 0 ? n/nfunc : 0))
+		adduint8(funcs, 0);
+
+	// the names first: addgostring would put each
+	// one in the middle of the String array.
+	off = malloc((nfile+1)*sizeof off[0]);
+	if(off == nil) {
+		diag("out of memory");
+		errorexit();
+	}
+	for(i=0; i<nfile; i++)
+		off[i] = addstring(fdata, file[i]);
+	alignptr(fdata);
+	filetab = fdata->size;
+	for(i=0; i<nfile; i++) {
+		addaddrplus(fdata, fdata, off[i]);
+		adduint32(fdata, strlen(file[i]));
+		if(PtrSize == 8)
+			adduint32(fdata, 0);
+	}
+	free(off);
+
+	buckets = fdata->size;
+	k = 0;
+	for(pc = minpc; pc < maxpc; pc += Bucketsize) {
+		while(k+1 < nfunc && fn[k+1]->value <= pc)
+			k++;
+		adduint32(fdata, k);
+		j = k;
+		for(i=0; i<Subbuckets; i++) {
+			while(j+1 < nfunc && fn[j+1]->value <= pc + i*(Bucketsize/Subbuckets))
+				j++;
+			adduint8(fdata, j-k < 255 ? j-k : 255);
+		}
+	}
+	free(fn);
+
+	addaddr(ftab, funcs);
+	addaddrplus(ftab, fdata, filetab);
+	addaddrplus(ftab, fdata, buckets);
+	adduint32(ftab, nfunc);
+	adduint32(ftab, nfile);
+
+	if(debug['v'])
+		Bprint(&bso, "functab: %d funcs %d files %lld+%lld bytes\n",
+			nfunc, nfile, funcs->size, fdata->size);
+	Bflush(&bso);
+}
@@ -26,6 +26,8 @@ struct Import
 	char *name;
 	char *def;
 	char *file;
+	uint32 defhash;	// hash of def, from the export index
+	int hashed;
 };
 enum {
 	NIHASH = 1024
@@ -67,16 +69,19 @@ ilookup(char *name)
 }
 
 static void loadpkgdata(char*, char*, char*, int);
+static void loadindex(char*, char*, char*, int);
 static void loaddynimport(char*, char*, char*, int);
 static void loaddynexport(char*, char*, char*, int);
 static void loaddynlinker(char*, char*, char*, int);
 static int parsemethod(char**, char*, char**);
+static char* enddef(char*, char*);
+static char* joinlines(char*);
 static int parsepkgdata(char*, char*, char**, char*, char**, char**, char**);
 
 static Sym **dynexp;
 
 void
-ldpkg(Biobuf *f, char *pkg, int64 len, char *filename, int whence)
+ldpkg(char *buf, char *pkg, int64 len, char *filename, int whence)
 {
 	char *data, *p0, *p1, *name;
 
@@ -89,13 +94,9 @@ ldpkg(Biobuf *f, char *pkg, int64 len, char *filename, int whence)
 			errorexit();
 		return;
 	}
+	// the imports refer into data, so keep a copy.
 	data = mal(len+1);
-	if(Bread(f, data, len) != len) {
-		fprint(2, "%s: short pkg read %s\n", argv0, filename);
-		if(debug['u'])
-			errorexit();
-		return;
-	}
+	memmove(data, buf, len);
 	data[len] = '\0';
 
 	// first \n$$ marks beginning of exports - skip rest of line
@@ -154,7 +155,20 @@ ldpkg(Biobuf *f, char *pkg, int64 len, char *filename, int whence)
 			nerrors++;
 			errorexit();
 		}
-		loadpkgdata(filename, pkg, p0, p1 - p0);
+		// the index, if any, describes the exports
+		// well enough that there is no need to parse them.
+		if(strncmp(p1, "\n$$  // index\n", 14) == 0) {
+			p0 = p1 + 14;
+			p1 = strchr(p0, '\n');
+			if(p1 == nil) {
+				fprint(2, "%s: cannot find end of export index in %s\n", argv0, filename);
+				if(debug['u'])
+					errorexit();
+				return;
+			}
+			loadindex(filename, pkg, p0, p1 - p0);
+		} else
+			loadpkgdata(filename, pkg, p0, p1 - p0);
 	}
 
 	// The __.PKGDEF archive summary has no local types.
@@ -264,7 +278,7 @@ loadpkgdata(char *file, char *pkg, char *data, int len)
 			fprint(2, "%s:\t%s %s ...\n", x->file, x->prefix, name);
 			fprint(2, "%s:\t%s %s ...\n", file, prefix, name);
 			nerrors++;
-		} else if(strcmp(x->def, def) != 0) {
+		} else if(x->def != nil && strcmp(x->def, def) != 0) {
 			fprint(2, "%s: conflicting definitions for %s\n", argv0, name);
 			fprint(2, "%s:\t%s %s %s\n", x->file, x->prefix, name, x->def);
 			fprint(2, "%s:\t%s %s %s\n", file, prefix, name, def);
@@ -276,6 +290,133 @@ loadpkgdata(char *file, char *pkg, char *data, int len)
 	free(file);
 }
 
+/*
+ * the export index written by the compiler after the exports
+ * (see export.c in gc): a version and a count of entries, each
+ * a kind, a name, the place of the declaration in the exports,
+ * a 32-bit hash of it, and the entries it uses.
+ * numbers are varints and the bytes 0, 1 and \n are escaped
+ * as 1 followed by the byte plus '@'.
+ */
+static uvlong
+ixgetv(uchar **pp, uchar *ep, int *err)
+{
+	uvlong v;
+	int c, s;
+	uchar *p;
+
+	p = *pp;
+	v = 0;
+	for(s=0; s<64; s+=7) {
+		if(p >= ep)
+			break;
+		c = *p++;
+		v |= (uvlong)(c&0x7f) << s;
+		if(!(c&0x80)) {
+			*pp = p;
+			return v;
+		}
+	}
+	*err = 1;
+	return 0;
+}
+
+static void
+loadindex(char *file, char *pkg, char *data, int len)
+{
+	uchar *buf, *p, *ep;
+	char *prefix, *name;
+	int i, j, n, err, kind, nname;
+	uint32 hash;
+	Import *x;
+
+	buf = mal(len);
+	n = 0;
+	for(i=0; i<len; i++) {
+		if(data[i] == 1 && i+1 < len)
+			buf[n++] = data[++i] - '@';
+		else
+			buf[n++] = data[i];
+	}
+	p = buf;
+	ep = buf + n;
+	err = 0;
+
+	file = strdup(file);
+	if(ixgetv(&p, ep, &err) != 1 || err) {
+		fprint(2, "%s: %s: unknown export index version\n", argv0, file);
+		nerrors++;
+		return;
+	}
+	n = ixgetv(&p, ep, &err);
+	for(i=0; i<n && !err; i++) {
+		if(p >= ep)
+			break;
+		kind = *p++;
+		nname = ixgetv(&p, ep, &err);
+		if(err || nname > ep - p)
+			break;
+		name = mal(nname+1);
+		memmove(name, p, nname);
+		p += nname;
+		ixgetv(&p, ep, &err);	// offset
+		ixgetv(&p, ep, &err);	// length
+		if(p+4 > ep)
+			break;
+		hash = p[0] | p[1]<<8 | p[2]<<16 | (uint32)p[3]<<24;
+		p += 4;
+		j = ixgetv(&p, ep, &err);
+		while(j-- > 0 && !err)
+			ixgetv(&p, ep, &err);
+
+		switch(kind) {
+		case 'i':
+			imported(pkg, name);
+			continue;
+		case 'c':
+			prefix = "const";
+			break;
+		case 'v':
+			prefix = "var";
+			break;
+		case 'f':
+			prefix = "func";
+			break;
+		case 't':
+			prefix = "type";
+			break;
+		default:
+			fprint(2, "%s: %s: confused in export index\n", argv0, file);
+			nerrors++;
+			return;
+		}
+
+		name = expandpkg(name, pkg);
+		x = ilookup(name);
+		if(x->prefix == nil) {
+			x->prefix = prefix;
+			x->defhash = hash;
+			x->hashed = 1;
+			x->file = file;
+		} else if(strcmp(x->prefix, prefix) != 0) {
+			fprint(2, "%s: conflicting definitions for %s\n", argv0, name);
+			fprint(2, "%s:\t%s %s ...\n", x->file, x->prefix, name);
+			fprint(2, "%s:\t%s %s ...\n", file, prefix, name);
+			nerrors++;
+		} else if(x->hashed && x->defhash != hash) {
+			fprint(2, "%s: conflicting definitions for %s\n", argv0, name);
+			fprint(2, "%s:\t%s %s\n", x->file, x->prefix, name);
+			fprint(2, "%s:\t%s %s\n", file, prefix, name);
+			nerrors++;
+		}
+		free(name);
+	}
+	if(i < n || err) {
+		fprint(2, "%s: %s: short export index\n", argv0, file);
+		nerrors++;
+	}
+}
+
 // replace all "". with pkg.
 char*
 expandpkg(char *t0, char *pkg)
@@ -315,13 +456,18 @@ parsepkgdata(char *file, char *pkg, char **pp, char *ep, char **prefixp, char **
 	char *p, *prefix, *name, *def, *edef, *meth;
 	int n, inquote;
 
-	// skip white space
+	// skip white space and comments
 	p = *pp;
 loop:
 	while(p < ep && (*p == ' ' || *p == '\t' || *p == '\n'))
 		p++;
 	if(p == ep || strncmp(p, "$$\n", 3) == 0)
 		return 0;
+	if(p + 2 <= ep && strncmp(p, "//", 2) == 0) {
+		while(p < ep && *p != '\n')
+			p++;
+		goto loop;
+	}
 
 	// prefix: (var|type|func|const)
 	prefix = p;
@@ -378,14 +524,18 @@ loop:
 		return -1;
 	*p++ = '\0';
 
-	// def: free form to new line
+	// def: free form to new line, or for a func
+	// to the end of its body
 	def = p;
-	while(p < ep && *p != '\n')
-		p++;
+	if(strcmp(prefix, "func") == 0)
+		p = enddef(p, ep);
+	else
+		while(p < ep && *p != '\n')
+			p++;
 	if(p >= ep)
 		return -1;
-	edef = p;
 	*p++ = '\0';
+	edef = joinlines(def);
 
 	// include methods on successive lines in def of named type
 	while(parsemethod(&p, ep, &meth) > 0) {
@@ -424,31 +574,92 @@ parsemethod(char **pp, char *ep, char **methp)
 {
 	char *p;
 
-	// skip white space
+	// skip white space and comments
 	p = *pp;
+loop:
 	while(p < ep && (*p == ' ' || *p == '\t'))
 		p++;
 	if(p == ep)
 		return 0;
+	if(p + 2 <= ep && strncmp(p, "//", 2) == 0) {
+		while(p < ep && *p != '\n')
+			p++;
+		if(p < ep)
+			p++;
+		goto loop;
+	}
 
 	// if it says "func (", it's a method
 	if(p + 6 >= ep || strncmp(p, "func (", 6) != 0)
 		return 0;
 
-	// definition to end of line
+	// definition to end of line, or of its body
 	*methp = p;
-	while(p < ep && *p != '\n')
-		p++;
+	p = enddef(p, ep);
 	if(p >= ep) {
 		fprint(2, "%s: lost end of line in method definition\n", argv0);
 		*pp = ep;
 		return -1;
 	}
 	*p++ = '\0';
+	joinlines(*methp);
 	*pp = p;
 	return 1;
 }
 
+// the newline that ends the func declaration at p.  an inlinable
+// body is spread over the lines of its source (see gc/export.c),
+// so look for the first newline outside all braces and literals.
+static char*
+enddef(char *p, char *ep)
+{
+	int depth, quote;
+
+	depth = 0;
+	quote = 0;
+	for(; p < ep; p++) {
+		if(quote) {
+			if(*p == '\\' && quote != '`')
+				p++;
+			else if(*p == quote)
+				quote = 0;
+			continue;
+		}
+		switch(*p) {
+		case '"':
+		case '\'':
+		case '`':
+			quote = *p;
+			break;
+		case '{':
+			depth++;
+			break;
+		case '}':
+			depth--;
+			break;
+		case '\n':
+			if(depth <= 0)
+				return p;
+			break;
+		}
+	}
+	return p;
+}
+
+// remove the newlines from the declaration s, which make no
+// difference to it, and return its new end.
+static char*
+joinlines(char *s)
+{
+	char *t;
+
+	for(t=s; *s; s++)
+		if(*s != '\n')
+			*t++ = *s;
+	*t = '\0';
+	return t;
+}
+
 static void
 loaddynimport(char *file, char *pkg, char *p, int n)
 {
@@ -613,6 +824,146 @@ err:
 
 static int markdepth;
 
+/*
+ * Method tables.  The type.T symbol for a type with methods points
+ * at the code for each of them (ifn and tfn in ../../pkg/runtime/type.go),
+ * but a method needs to be in the binary only if something can call it:
+ * directly, which marks it as usual; through an interface, which needs
+ * an interface type with a method of the same name and type to be
+ * reachable; or through reflect's Method and MethodByName, which the
+ * compiler flags on the functions calling them (REFLECTMETHOD).
+ * mark leaves ifn and tfn alone and notes each method here, and
+ * deadcode keeps the ones that turn out to be needed.
+ */
+typedef struct Meth Meth;
+struct Meth
+{
+	Sym*	type;	// type.T holding the method table
+	int32	off;	// offset of the entry in type
+	Sym*	name;
+	Sym*	mtyp;	// method type, without receiver
+	uchar	kept;
+};
+
+typedef struct IMeth IMeth;
+struct IMeth
+{
+	Sym*	name;
+	Sym*	type;
+	IMeth*	link;
+};
+
+enum {
+	NIMHASH = 4093,
+};
+
+static Meth*	meth;
+static int	nmeth;
+static int	mmeth;
+static IMeth*	imhash[NIMHASH];
+static int	reflectmethod;	// a function calling reflect Method is reachable
+
+static uint32
+imhashval(Sym *name, Sym *type)
+{
+	return ((uintptr)name/8*31 + (uintptr)type/8) % NIMHASH;
+}
+
+static void
+addimeth(Sym *name, Sym *type)
+{
+	IMeth *m;
+	uint32 h;
+
+	h = imhashval(name, type);
+	for(m=imhash[h]; m; m=m->link)
+		if(m->name == name && m->type == type)
+			return;
+	m = mal(sizeof *m);
+	m->name = name;
+	m->type = type;
+	m->link = imhash[h];
+	imhash[h] = m;
+}
+
+static int
+hasimeth(Sym *name, Sym *type)
+{
+	IMeth *m;
+
+	for(m=imhash[imhashval(name, type)]; m; m=m->link)
+		if(m->name == name && m->type == type)
+			return 1;
+	return 0;
+}
+
+// Mark what the type symbol s refers to, except the code in its
+// method table, and note its methods.  Interface types record the
+// methods they ask for.
+static void
+marktype(Sym *s)
+{
+	int i, n;
+	int32 off, end, slot;
+	Reloc *r;
+	Meth *m;
+
+	n = decodetype_methodcount(s);
+	off = 0;
+	end = 0;
+	if(n > 0) {
+		off = decodetype_methodoff(s);
+		end = off + n*MethodSize;
+		if(nmeth+n > mmeth) {
+			mmeth = 2*mmeth + n + 64;
+			meth = realloc(meth, mmeth*sizeof meth[0]);
+			if(meth == nil) {
+				diag("out of memory");
+				errorexit();
+			}
+		}
+		m = &meth[nmeth];
+		for(i=0; i<n; i++) {
+			m[i].type = s;
+			m[i].off = off + i*MethodSize;
+			m[i].name = S;
+			m[i].mtyp = S;
+			m[i].kept = 0;
+		}
+		for(r=s->r; r<s->r+s->nr; r++) {
+			if(r->off < off || r->off >= end)
+				continue;
+			i = (r->off - off) / MethodSize;
+			slot = (r->off - off) % MethodSize;
+			if(slot == 0)
+				m[i].name = r->sym;
+			else if(slot == 2*PtrSize)
+				m[i].mtyp = r->sym;
+		}
+		nmeth += n;
+	}
+	if(decodetype_kind(s) == KindInterface) {
+		n = decodetype_ifacemethodcount(s);
+		for(i=0; i<n; i++)
+			addimeth(decodetype_ifacemethodname(s, i), decodetype_ifacemethodtype(s, i));
+	}
+
+	for(r=s->r; r<s->r+s->nr; r++) {
+		if(r->off >= off && r->off < end) {
+			slot = (r->off - off) % MethodSize;
+			if(slot == 4*PtrSize || slot == 5*PtrSize)
+				continue;
+		}
+		mark(r->sym);
+	}
+}
+
+static int
+istype(Sym *s)
+{
+	return strncmp(s->name, "type.", 5) == 0 && s->text == P && s->np >= CommonSize;
+}
+
 static void
 marktext(Sym *s)
 {
@@ -645,10 +996,15 @@ mark(Sym *s)
 	if(strncmp(s->name, "weak.", 5) == 0)
 		return;
 	s->reachable = 1;
+	if(s->reflectmethod)
+		reflectmethod = 1;
 	if(s->text)
 		marktext(s);
-	for(i=0; i<s->nr; i++)
-		mark(s->r[i].sym);
+	if(istype(s))
+		marktype(s);
+	else
+		for(i=0; i<s->nr; i++)
+			mark(s->r[i].sym);
 	if(s->gotype)
 		mark(s->gotype);
 	if(s->sub)
@@ -707,6 +1063,63 @@ addz(Sym *s, Auto *z)
 	}
 }
 
+// Mark the methods that can be called, until no more turn up,
+// and take the rest out of the method tables.
+static void
+markmethods(void)
+{
+	int i, j, n, kept, changed;
+	int32 off, end, slot;
+	Sym *s;
+	Reloc *r, *w;
+	Meth *m;
+
+	do {
+		changed = 0;
+		for(i=0; i<nmeth; i++) {
+			m = &meth[i];
+			if(m->kept)
+				continue;
+			if(!reflectmethod && !hasimeth(m->name, m->mtyp))
+				continue;
+			m->kept = 1;
+			changed = 1;
+			s = m->type;
+			off = m->off;
+			// mark can grow meth; do not use m after this.
+			mark(decode_reloc_sym(s, off + 4*PtrSize));
+			mark(decode_reloc_sym(s, off + 5*PtrSize));
+		}
+	} while(changed);
+
+	kept = 0;
+	for(i=0; i<nmeth; i=j) {
+		s = meth[i].type;
+		for(j=i; j<nmeth && meth[j].type == s; j++)
+			kept += meth[j].kept;
+		n = j - i;
+		off = meth[i].off;
+		end = off + n*MethodSize;
+		w = s->r;
+		for(r=s->r; r<s->r+s->nr; r++) {
+			if(r->off >= off && r->off < end && !meth[i + (r->off - off)/MethodSize].kept) {
+				slot = (r->off - off) % MethodSize;
+				if(slot == 4*PtrSize || slot == 5*PtrSize)
+					continue;
+			}
+			*w++ = *r;
+		}
+		s->nr = w - s->r;
+	}
+	if(debug['v'])
+		Bprint(&bso, "%5.2f deadcode: kept %d of %d methods%s\n", cputime(), kept, nmeth,
+			reflectmethod ? " (reflect Method used)" : "");
+	free(meth);
+	meth = nil;
+	nmeth = 0;
+	mmeth = 0;
+}
+
 void
 deadcode(void)
 {
@@ -723,6 +1136,8 @@ deadcode(void)
 
 	for(i=0; i<ndynexp; i++)
 		mark(dynexp[i]);
+
+	markmethods();
 	
 	// remove dead text but keep file information (z symbols).
 	last = nil;
@@ -757,6 +1172,293 @@ deadcode(void)
 		}
 }
 
+// Copy the z symbols of z onto the front of s->autom,
+// leaving z alone, since its function stays in the image.
+static void
+copyz(Sym *s, Auto *z)
+{
+	Auto *a, *b, *first, *last;
+
+	first = nil;
+	last = nil;
+	for(a = z; a != nil; a = a->link) {
+		if(a->type != D_FILE && a->type != D_FILE1)
+			continue;
+		b = mal(sizeof *b);
+		*b = *a;
+		b->link = nil;
+		if(last == nil)
+			first = b;
+		else
+			last->link = b;
+		last = b;
+	}
+	if(last) {
+		last->link = s->autom;
+		s->autom = first;
+	}
+}
+
+enum {
+	PgoHot = 100,	// hot functions have 1/PgoHot of the samples
+};
+
+enum {
+	OrdFirst,	// named in the -k file
+	OrdHot,		// hot in the -F profile
+	OrdWarm,
+	OrdCold,	// package init and panic paths
+};
+
+typedef struct Ord Ord;
+struct Ord
+{
+	Sym*	s;
+	Sym*	z;	// function carrying s's file information
+	int	class;
+	vlong	rank;	// within class
+	int	idx;	// in textp
+	vlong	n;	// profile samples
+};
+
+static int
+ordcmp(const void *va, const void *vb)
+{
+	Ord *a, *b;
+
+	a = (Ord*)va;
+	b = (Ord*)vb;
+	if(a->class != b->class)
+		return a->class - b->class;
+	if(a->rank != b->rank)
+		return a->rank < b->rank ? -1 : 1;
+	return a->idx - b->idx;
+}
+
+static int
+ordsymcmp(const void *va, const void *vb)
+{
+	Ord *a, *b;
+
+	a = *(Ord**)va;
+	b = *(Ord**)vb;
+	if(a->s != b->s)
+		return (uintptr)a->s < (uintptr)b->s ? -1 : 1;
+	return 0;
+}
+
+static Ord**
+ordbysym;
+
+static Ord*
+findord(Sym *s, int n)
+{
+	int lo, hi, m;
+
+	lo = 0;
+	hi = n;
+	while(lo < hi) {
+		m = (lo+hi)/2;
+		if(ordbysym[m]->s == s)
+			return ordbysym[m];
+		if((uintptr)ordbysym[m]->s < (uintptr)s)
+			lo = m+1;
+		else
+			hi = m;
+	}
+	return nil;
+}
+
+// Functions that run at most once, or only on the way to a crash.
+static int
+iscold(Sym *s)
+{
+	static char *cold[] = {
+		"runtime.panic",
+		"runtime.throw",
+		"runtime.startpanic",
+		"runtime.dopanic",
+		"runtime.sigpanic",
+		"runtime.printpanics",
+		"runtime.newTypeAssertionError",
+		"runtime.newErrorString",
+	};
+	char *p;
+	int i;
+
+	for(i=0; i<nelem(cold); i++)
+		if(strncmp(s->name, cold[i], strlen(cold[i])) == 0)
+			return 1;
+	// pkg.init and pkg.init·N, but not methods named init.
+	p = strrchr(s->name, '.');
+	if(p == nil || p == s->name || p[-1] == ')')
+		return 0;
+	return strcmp(p+1, "init") == 0 || strncmp(p+1, "init\xc2\xb7", 6) == 0;
+}
+
+static Sym*
+ordlookup(char *name)
+{
+	Sym *s;
+
+	s = rlookup(name, 0);
+	if(s == S || s->text == P || !s->reachable || (s->type & SSUB) || s->sub != S)
+		return S;
+	return s;
+}
+
+// Read profile feedback written by go tool prof -F:
+// lines "total N" and "func F N".  Functions with at least
+// 1/PgoHot of the samples are hot.
+static void
+readpgo(Ord *ord, int nord)
+{
+	Biobuf *b;
+	char *line, *p;
+	vlong n, total;
+	int i, nhot;
+	Ord *o;
+
+	b = Bopen(pgofile, OREAD);
+	if(b == nil) {
+		diag("cannot open %s: %r", pgofile);
+		errorexit();
+	}
+	total = 0;
+	while((line = Brdstr(b, '\n', 1)) != nil) {
+		p = strrchr(line, ' ');
+		if(p == nil) {
+			free(line);
+			continue;
+		}
+		*p++ = '\0';
+		n = atoll(p);
+		if(strcmp(line, "total") == 0)
+			total = n;
+		else if(strncmp(line, "func ", 5) == 0 && (o = findord(ordlookup(line+5), nord)) != nil)
+			o->n += n;
+		free(line);
+	}
+	Bterm(b);
+
+	nhot = 0;
+	for(i=0; i<nord; i++) {
+		o = &ord[i];
+		if(o->n == 0 || o->n*PgoHot < total)
+			continue;
+		o->class = OrdHot;
+		o->rank = -o->n;
+		nhot++;
+	}
+	if(debug['v'])
+		Bprint(&bso, "%5.2f ordertext: %d hot functions\n", cputime(), nhot);
+}
+
+// Read the -k file: one function name per line, blank lines
+// and lines starting with # ignored.  The functions go first,
+// in the order given.
+static void
+readsymorder(Ord *ord, int nord)
+{
+	Biobuf *b;
+	char *line, *p, *e;
+	int lineno, nfound;
+	Ord *o;
+
+	b = Bopen(symorder, OREAD);
+	if(b == nil) {
+		diag("cannot open %s: %r", symorder);
+		errorexit();
+	}
+	lineno = 0;
+	nfound = 0;
+	while((line = Brdstr(b, '\n', 1)) != nil) {
+		lineno++;
+		for(p = line; *p == ' ' || *p == '\t'; p++)
+			;
+		for(e = p+strlen(p); e > p && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r'); e--)
+			;
+		*e = '\0';
+		if(*p != '\0' && *p != '#' && (o = findord(ordlookup(p), nord)) != nil && o->class != OrdFirst) {
+			o->class = OrdFirst;
+			o->rank = lineno;
+			nfound++;
+		}
+		free(line);
+	}
+	Bterm(b);
+	if(debug['v'])
+		Bprint(&bso, "%5.2f ordertext: %d of %d lines in %s found\n", cputime(), nfound, lineno, symorder);
+}
+
+// Lay out textp for locality: the functions named by -k first,
+// then the ones the profile feedback (-F) reports as hot, hottest
+// first, then the rest, with package initializers and panic paths
+// moved to the end so that the code that runs most shares as few
+// pages and cache lines as possible.  Otherwise the order is kept.
+// Each function's source file comes from the z symbols before it
+// in textp, so every function that ends up after a different set
+// than before gets a copy of its own.
+void
+ordertext(void)
+{
+	int i, n;
+	Ord *ord, *o;
+	Sym *s, *z, *cur, *last;
+
+	if(debug['v'])
+		Bprint(&bso, "%5.2f ordertext\n", cputime());
+
+	// note which z symbols apply to each function.
+	n = 0;
+	for(s = textp; s != nil; s = s->next)
+		n++;
+	if(n == 0)
+		return;
+	ord = mal(n*sizeof ord[0]);
+	ordbysym = mal(n*sizeof ordbysym[0]);
+	z = S;
+	i = 0;
+	for(s = textp; s != nil; s = s->next) {
+		if(isz(s->autom))
+			z = s;
+		o = &ord[i];
+		o->s = s;
+		o->z = z;
+		o->class = OrdWarm;
+		o->idx = i;
+		if(iscold(s) && ordlookup(s->name) == s)
+			o->class = OrdCold;
+		ordbysym[i++] = o;
+	}
+	qsort(ordbysym, n, sizeof ordbysym[0], ordsymcmp);
+
+	if(pgofile != nil)
+		readpgo(ord, n);
+	if(symorder != nil)
+		readsymorder(ord, n);
+	qsort(ord, n, sizeof ord[0], ordcmp);
+
+	// relink in the new order.
+	cur = S;
+	last = S;
+	textp = nil;
+	for(i=0; i<n; i++) {
+		s = ord[i].s;
+		z = ord[i].z;
+		if(z != cur && z != S && z != s)
+			copyz(s, z->autom);
+		cur = z;
+		if(last == S)
+			textp = s;
+		else
+			last->next = s;
+		last = s;
+	}
+	last->next = nil;
+	ordbysym = nil;
+}
+
 void
 doweak(void)
 {
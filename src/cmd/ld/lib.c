@@ -43,6 +43,40 @@ char**	libdir;
 int	nlibdir = 0;
 static int	maxlibdir = 0;
 static int	cout = -1;
+static vlong	phasestart;
+static Objbuf	obj;	// reused by each ldobj
+
+static int	objread(Objbuf*, Biobuf*, vlong);
+
+/*
+ * The index of an archive, from its __.SYMDEF member (see <ar.h>),
+ * kept by objfile when it leaves members that nothing needs yet,
+ * so that loadlib can load them once something does.
+ */
+typedef struct Arindex Arindex;
+struct Arindex
+{
+	char*	file;
+	char*	pkg;
+	uchar*	p;
+	int32	nmember;
+	int32	nsym;
+	int32	nhash;
+	uchar*	member;
+	uchar*	hash;
+	uchar*	sym;
+	char*	str;
+	int32	nstr;
+	uchar*	loaded;	/* loaded[i] once member i is loaded */
+	Arindex*	next;
+};
+static Arindex*	pending;
+
+static Arindex*	readarindex(Biobuf*, vlong, char*, char*);
+static int	arneeded(Arindex*, int);
+static int	arfind(Arindex*, char*);
+static void	arload(Arindex*, int);
+static int	loadneeded(void);
 
 char*	goroot;
 char*	goarch;
@@ -88,7 +122,7 @@ libinit(void)
 #ifndef _WIN32
 	remove(outfile);
 #endif
-	cout = create(outfile, 1, 0775);
+	cout = create(outfile, ORDWR, 0775);
 	if(cout < 0) {
 		diag("cannot create %s", outfile);
 		errorexit();
@@ -99,6 +133,54 @@ libinit(void)
 		sprint(INITENTRY, "_rt0_%s_%s", goarch, goos);
 	}
 	lookup(INITENTRY, 0)->type = SXREF;
+	phasestart = nsec();
+}
+
+/*
+ * Wall-clock time taken by each phase of the link, printed by -v.
+ * endphase charges the time since the previous call (or since
+ * libinit) to the named phase.
+ */
+enum
+{
+	Maxphase = 40,
+};
+
+static struct
+{
+	char*	name;
+	vlong	ns;
+} phases[Maxphase];
+static int nphase;
+
+void
+endphase(char *name)
+{
+	vlong t;
+
+	t = nsec();
+	if(nphase < Maxphase) {
+		phases[nphase].name = name;
+		phases[nphase].ns = t - phasestart;
+		nphase++;
+	}
+	phasestart = t;
+}
+
+void
+phasestats(void)
+{
+	int i;
+	vlong tot;
+
+	tot = 0;
+	for(i=0; i<nphase; i++)
+		tot += phases[i].ns;
+	if(tot <= 0)
+		tot = 1;
+	for(i=0; i<nphase; i++)
+		Bprint(&bso, "%8.3fs %5.1f%% %s\n", phases[i].ns/1e9, 100.0*phases[i].ns/tot, phases[i].name);
+	Bprint(&bso, "%8.3fs total (%d threads)\n", tot/1e9, nworker());
 }
 
 void
@@ -282,12 +364,18 @@ loadlib(void)
 	if(thechar == '5')
 		loadinternal("math");
 
-	for(i=0; i<libraryp; i++) {
-		if(debug['v'])
-			Bprint(&bso, "%5.2f autolib: %s (from %s)\n", cputime(), library[i].file, library[i].objref);
-		iscgo |= strcmp(library[i].pkg, "runtime/cgo") == 0;
-		objfile(library[i].file, library[i].pkg);
-	}
+	// load the libraries, then the archive members left by
+	// objfile that they turn out to need, which may import
+	// more libraries in turn.
+	i = 0;
+	do {
+		for(; i<libraryp; i++) {
+			if(debug['v'])
+				Bprint(&bso, "%5.2f autolib: %s (from %s)\n", cputime(), library[i].file, library[i].objref);
+			iscgo |= strcmp(library[i].pkg, "runtime/cgo") == 0;
+			objfile(library[i].file, library[i].pkg);
+		}
+	} while(loadneeded());
 	
 	// We've loaded all the code now.
 	// If there are no dynamic libraries needed, gcc disables dynamic linking.
@@ -340,17 +428,20 @@ void
 objfile(char *file, char *pkg)
 {
 	int32 off, l;
+	int m, nskip;
+	Arindex *ix;
 	Biobuf *f;
 	char magbuf[SARMAG];
 	char pname[150];
 	struct ar_hdr arhdr;
 
 	pkg = smprint("%i", pkg);
+	ix = nil;
 
 	if(debug['v'])
 		Bprint(&bso, "%5.2f ldobj: %s (%s)\n", cputime(), file, pkg);
 	Bflush(&bso);
-	f = Bopen(file, 0);
+	f = Bopenmap(file, 0);
 	if(f == nil) {
 		diag("cannot open file: %s", file);
 		errorexit();
@@ -366,7 +457,7 @@ objfile(char *file, char *pkg)
 		return;
 	}
 	
-	/* skip over __.SYMDEF */
+	/* read __.SYMDEF */
 	off = Boffset(f);
 	if((l = nextar(f, off, &arhdr)) <= 0) {
 		diag("%s: short read on archive file symbol header", file);
@@ -376,6 +467,8 @@ objfile(char *file, char *pkg)
 		diag("%s: first entry not symbol header", file);
 		goto out;
 	}
+	if(strcmp(pkg, "runtime") != 0 && strcmp(pkg, "runtime/cgo") != 0)
+		ix = readarindex(f, atolwhex(arhdr.size), file, pkg);
 	off += l;
 	
 	/* skip over (or process) __.PKGDEF */
@@ -389,21 +482,31 @@ objfile(char *file, char *pkg)
 	}
 	off += l;
 
-	if(debug['u'])
-		ldpkg(f, pkg, atolwhex(arhdr.size), file, Pkgdef);
+	if(debug['u']) {
+		if(objread(&obj, f, atolwhex(arhdr.size)) < 0) {
+			diag("%s: short read on package header", file);
+			goto out;
+		}
+		ldpkg((char*)obj.p, pkg, obj.ep - obj.p, file, Pkgdef);
+	}
 
 	/*
-	 * load all the object files from the archive now.
-	 * this gives us sequential file access and keeps us
-	 * from needing to come back later to pick up more
-	 * objects.  it breaks the usual C archive model, but
-	 * this is Go, not C.  the common case in Go is that
-	 * we need to load all the objects, and then we throw away
-	 * the individual symbols that are unused.
+	 * load the object files from the archive now.
+	 * this gives us sequential file access and, in the
+	 * common case in Go, where we need to load all the
+	 * objects and then throw away the individual symbols
+	 * that are unused, keeps us from needing to come back
+	 * later to pick up more objects.
 	 *
-	 * loading every object will also make it possible to
-	 * load foreign objects not referenced by __.SYMDEF.
+	 * if the archive has an index, though, leave the
+	 * members defining only symbols that nothing refers to
+	 * yet: loadlib comes back for them if something does.
+	 * the runtime is always loaded whole, since the linker
+	 * itself refers to its symbols.  members that define
+	 * no symbols, like foreign objects, are always loaded.
 	 */
+	m = 0;
+	nskip = 0;
 	for(;;) {
 		l = nextar(f, off, &arhdr);
 		if(l == 0)
@@ -412,6 +515,19 @@ objfile(char *file, char *pkg)
 			diag("%s: malformed archive", file);
 			goto out;
 		}
+		if(ix != nil) {
+			if(m >= ix->nmember || le32(ix->member + m*SAIMEMBER) != off) {
+				diag("%s: archive index does not match members", file);
+				goto out;
+			}
+			if(!arneeded(ix, m)) {
+				m++;
+				nskip++;
+				off += l;
+				continue;
+			}
+			ix->loaded[m++] = 1;
+		}
 		off += l;
 
 		l = SARNAME;
@@ -421,19 +537,261 @@ objfile(char *file, char *pkg)
 		l = atolwhex(arhdr.size);
 		ldobj(f, pkg, l, pname, ArchiveObj);
 	}
+	if(ix != nil && nskip > 0) {
+		if(debug['v'])
+			Bprint(&bso, "%5.2f ldobj: %s: left %d of %d members\n", cputime(), file, nskip, m);
+		ix->next = pending;
+		pending = ix;
+		ix = nil;
+	}
 
 out:
+	if(ix != nil) {
+		free(ix->p);
+		free(ix->loaded);
+		free(ix->pkg);
+		free(ix);
+	}
 	Bterm(f);
 	free(pkg);
 }
 
+/*
+ * Read the archive index of size bytes at the current offset of f,
+ * the archive file, if there is one and it is up to date.
+ */
+static Arindex*
+readarindex(Biobuf *f, vlong size, char *file, char *pkg)
+{
+	Arindex *ix;
+	uchar *p;
+	vlong off, arsize;
+	int32 used;
+
+	if(size < SAIHDR)
+		return nil;
+	off = Boffset(f);
+	arsize = Bseek(f, 0, 2);
+	Bseek(f, off, 0);
+	if(objread(&obj, f, size) < 0)
+		return nil;
+	p = obj.p;
+	if(memcmp(p, ARINDEX, SARINDEX) != 0 || le32(p+AIarsize) != arsize)
+		return nil;
+	used = le32(p+AIused);
+	if(used < SAIHDR || used > size)
+		return nil;
+
+	ix = malloc(sizeof *ix);
+	if(ix != nil) {
+		memset(ix, 0, sizeof *ix);
+		ix->p = malloc(used);
+	}
+	if(ix == nil || ix->p == nil) {
+		diag("out of memory");
+		errorexit();
+	}
+	memmove(ix->p, p, used);
+	p = ix->p;
+	ix->file = file;
+	ix->nmember = le32(p+AInmember);
+	ix->nsym = le32(p+AInsym);
+	ix->nhash = le32(p+AInhash);
+	if(ix->nmember < 0 || ix->nmember > used/SAIMEMBER
+	|| ix->nsym < 0 || ix->nsym > used/SAISYM
+	|| ix->nhash <= 0 || ix->nhash > used/4 || (ix->nhash & (ix->nhash-1)) != 0)
+		goto bad;
+	ix->member = p + SAIHDR;
+	ix->hash = ix->member + ix->nmember*SAIMEMBER;
+	ix->sym = ix->hash + ix->nhash*4;
+	ix->str = (char*)ix->sym + ix->nsym*SAISYM;
+	ix->nstr = (char*)p+used - ix->str;
+	if(ix->nstr < 0 || (ix->nstr > 0 && ix->str[ix->nstr-1] != '\0'))
+		goto bad;
+	ix->loaded = malloc(ix->nmember+1);
+	if(ix->loaded == nil) {
+		diag("out of memory");
+		errorexit();
+	}
+	memset(ix->loaded, 0, ix->nmember+1);
+	ix->pkg = strdup(pkg);
+	return ix;
+
+bad:
+	if(debug['v'])
+		Bprint(&bso, "%5.2f ldobj: %s: ignoring bad archive index\n", cputime(), file);
+	free(ix->p);
+	free(ix);
+	return nil;
+}
+
+/*
+ * Name and member of symbol i of the index,
+ * or nil if the entry is malformed.
+ */
+static char*
+arsym(Arindex *ix, int i, int *mp)
+{
+	uchar *s;
+	uint32 off, m;
+
+	s = ix->sym + i*SAISYM;
+	off = le32(s);
+	m = le32(s+4);
+	if(off >= ix->nstr || m >= ix->nmember)
+		return nil;
+	*mp = m;
+	return ix->str + off;
+}
+
+/*
+ * Does anything loaded so far refer to a symbol
+ * defined by member m of the archive and not yet defined?
+ */
+static int
+arneeded(Arindex *ix, int m)
+{
+	int i, first, last, m1;
+	char *name, *x;
+	Sym *s;
+
+	first = le32(ix->member + m*SAIMEMBER + 4);
+	last = ix->nsym;
+	if(m+1 < ix->nmember)
+		last = le32(ix->member + (m+1)*SAIMEMBER + 4);
+	if(first < 0 || last > ix->nsym || first >= last)
+		return 1;
+	for(i=first; i<last; i++) {
+		if((name = arsym(ix, i, &m1)) == nil)
+			return 1;
+		x = expandpkg(name, ix->pkg);
+		s = rlookup(x, 0);
+		free(x);
+		if(s != S && (s->type == 0 || s->type == SXREF))
+			return 1;
+	}
+	return 0;
+}
+
+static uint32
+arhash(char *name)
+{
+	uint32 h;
+	uchar *cp;
+
+	// as in pack.
+	h = 0;
+	for(cp = (uchar*)name; *cp; cp++)
+		h = h*1119 + *cp;
+	return h;
+}
+
+static int
+arlookup(Arindex *ix, char *name)
+{
+	uint32 i;
+	int m;
+	char *x;
+
+	i = le32(ix->hash + (arhash(name) & (ix->nhash-1))*4);
+	while(i != 0 && i <= ix->nsym) {
+		x = arsym(ix, i-1, &m);
+		if(x != nil && strcmp(x, name) == 0 && !ix->loaded[m])
+			return m;
+		i = le32(ix->sym + (i-1)*SAISYM + 8);
+	}
+	return -1;
+}
+
+/*
+ * Find a member of the archive not yet loaded that
+ * defines the symbol name, or return -1.
+ * Symbols of the archive's own package are written
+ * "". in the index, as in the objects themselves.
+ */
+static int
+arfind(Arindex *ix, char *name)
+{
+	int m, n;
+	char *x;
+
+	if((m = arlookup(ix, name)) >= 0)
+		return m;
+	n = strlen(ix->pkg);
+	if(strncmp(name, ix->pkg, n) != 0 || name[n] != '.')
+		return -1;
+	x = smprint("\"\"%s", name+n);
+	m = arlookup(ix, x);
+	free(x);
+	return m;
+}
+
+static void
+arload(Arindex *ix, int m)
+{
+	Biobuf *f;
+	struct ar_hdr arhdr;
+	char pname[150];
+	int32 l;
+
+	if(debug['v'])
+		Bprint(&bso, "%5.2f ldobj: %s: loading member %d\n", cputime(), ix->file, m);
+	ix->loaded[m] = 1;
+	f = Bopenmap(ix->file, 0);
+	if(f == nil) {
+		diag("cannot open file: %s", ix->file);
+		errorexit();
+	}
+	l = nextar(f, le32(ix->member + m*SAIMEMBER), &arhdr);
+	if(l <= 0) {
+		diag("%s: malformed archive", ix->file);
+		Bterm(f);
+		return;
+	}
+	l = SARNAME;
+	while(l > 0 && arhdr.name[l-1] == ' ')
+		l--;
+	snprint(pname, sizeof pname, "%s(%.*s)", ix->file, utfnlen(arhdr.name, l), arhdr.name);
+	ldobj(f, ix->pkg, atolwhex(arhdr.size), pname, ArchiveObj);
+	Bterm(f);
+}
+
+/*
+ * Load the members left by objfile that define symbols
+ * referred to but not defined.  Returns the number loaded;
+ * those may refer to more symbols, so loadlib calls again
+ * until there are none.
+ */
+static int
+loadneeded(void)
+{
+	Arindex *ix;
+	Sym *s;
+	int m, n;
+
+	n = 0;
+	for(s = allsym; s != S; s = s->allsym) {
+		if(s->version != 0 || (s->type != 0 && s->type != SXREF))
+			continue;
+		for(ix = pending; ix != nil; ix = ix->next) {
+			if((m = arfind(ix, s->name)) >= 0) {
+				arload(ix, m);
+				n++;
+				break;
+			}
+		}
+	}
+	return n;
+}
+
 void
 ldobj(Biobuf *f, char *pkg, int64 len, char *pn, int whence)
 {
 	char *line;
 	int n, c1, c2, c3, c4;
 	uint32 magic;
-	vlong import0, import1, eof;
+	vlong eof;
+	uchar *p;
 	char *t;
 
 	eof = Boffset(f) + len;
@@ -521,25 +879,23 @@ ldobj(Biobuf *f, char *pkg, int64 len, char *pn, int whence)
 	free(t);
 	line[n] = '\n';
 
-	/* skip over exports and other info -- ends with \n!\n */
-	import0 = Boffset(f);
-	c1 = '\n';	// the last line ended in \n
-	c2 = Bgetc(f);
-	c3 = Bgetc(f);
-	while(c1 != '\n' || c2 != '!' || c3 != '\n') {
-		c1 = c2;
-		c2 = c3;
-		c3 = Bgetc(f);
-		if(c3 == Beof)
+	/* read the rest in one piece */
+	if(objread(&obj, f, eof - Boffset(f)) < 0)
+		goto eof;
+
+	/* exports and other info end with \n!\n */
+	for(p=obj.p;; p++) {
+		p = memchr(p, '!', obj.ep - p);
+		if(p == nil || p+1 >= obj.ep)
 			goto eof;
+		// the last line ended in \n
+		if(p[1] == '\n' && (p == obj.p || p[-1] == '\n'))
+			break;
 	}
-	import1 = Boffset(f);
-
-	Bseek(f, import0, 0);
-	ldpkg(f, pkg, import1 - import0 - 2, pn, whence);	// -2 for !\n
-	Bseek(f, import1, 0);
+	ldpkg((char*)obj.p, pkg, p - obj.p, pn, whence);
+	obj.p = p+2;
 
-	ldobj1(f, pkg, eof - Boffset(f), pn);
+	ldobj1(&obj, pkg, pn);
 	free(pn);
 	return;
 
@@ -548,6 +904,59 @@ eof:
 	free(pn);
 }
 
+/*
+ * Read the next len bytes of f into o in one read, leaving f
+ * positioned after them.  o's buffer is reused by the next call.
+ * If f is mapped, o points straight into the mapping instead.
+ */
+static int
+objread(Objbuf *o, Biobuf *f, vlong len)
+{
+	vlong off;
+	long n;
+	uchar *p;
+
+	if(len < 0 || (int32)len != len)
+		return -1;
+	if(BMAPPED(f)) {
+		off = Boffset(f);
+		if((p = Bgetspan(f, len)) == nil)
+			return -1;
+		o->off = off;
+		o->p = p;
+		o->ep = p + len;
+		return 0;
+	}
+	if(len > o->nbuf) {
+		free(o->buf);
+		o->nbuf = len + len/4;
+		if(o->nbuf < len)
+			o->nbuf = len;
+		o->buf = malloc(o->nbuf);
+		if(o->buf == nil) {
+			diag("out of memory");
+			errorexit();
+		}
+	}
+	off = Boffset(f);
+
+	// take what f has buffered, then read the rest directly.
+	n = -f->icount;
+	if(n > len)
+		n = len;
+	if(Bread(f, o->buf, n) != n)
+		return -1;
+	if(n < len) {
+		if(seek(Bfildes(f), off+n, 0) != off+n || readn(Bfildes(f), o->buf+n, len-n) != len-n)
+			return -1;
+		Bseek(f, off+len, 0);
+	}
+	o->off = off;
+	o->p = o->buf;
+	o->ep = o->buf + len;
+	return 0;
+}
+
 Sym*
 newsym(char *symb, int v)
 {
@@ -578,30 +987,86 @@ newsym(char *symb, int v)
 	return s;
 }
 
+/*
+ * The symbol table is open-addressed, indexed by 32-bit FNV-1a
+ * of the name and version.  Each slot keeps the full hash, so a
+ * probe only touches the Sym when the hashes match.  The table
+ * doubles whenever it becomes half full.
+ */
+enum
+{
+	NHASHMIN = 1<<15,
+};
+
+typedef struct Symslot Symslot;
+struct Symslot
+{
+	uint32	h;
+	Sym*	s;
+};
+
+static Symslot*	hash;
+static uint32	nhash;
+static uint32	nhashsym;
+
+static void
+growhash(void)
+{
+	Symslot *old, *e;
+	uint32 i, n, j;
+
+	old = hash;
+	n = nhash;
+	nhash = n == 0 ? NHASHMIN : 2*n;
+	hash = malloc(nhash * sizeof hash[0]);
+	if(hash == nil) {
+		diag("out of memory");
+		errorexit();
+	}
+	memset(hash, 0, nhash * sizeof hash[0]);
+	for(i=0; i<n; i++) {
+		e = &old[i];
+		if(e->s == S)
+			continue;
+		for(j=e->h&(nhash-1); hash[j].s != S; j=(j+1)&(nhash-1))
+			;
+		hash[j] = *e;
+	}
+	free(old);
+}
+
 static Sym*
 _lookup(char *symb, int v, int creat)
 {
+	Symslot *e;
 	Sym *s;
-	char *p;
-	int32 h;
-	int l, c;
-
-	h = v;
-	for(p=symb; c = *p; p++)
-		h = h+h+h + c;
-	l = (p - symb) + 1;
-	// not if(h < 0) h = ~h, because gcc 4.3 -O2 miscompiles it.
-	h &= 0xffffff;
-	h %= NHASH;
-	for(s = hash[h]; s != S; s = s->hash)
-		if(memcmp(s->name, symb, l) == 0)
-			return s;
+	uchar *p;
+	uint32 h, j;
+	int l;
+
+	h = 2166136261U;
+	for(p=(uchar*)symb; *p; p++)
+		h = (h ^ *p) * 16777619;
+	h = (h ^ (uint32)v) * 16777619;
+	l = (p - (uchar*)symb) + 1;
+
+	if(hash == nil)
+		growhash();
+	for(j=h&(nhash-1);; j=(j+1)&(nhash-1)) {
+		e = &hash[j];
+		if(e->s == S)
+			break;
+		if(e->h == h && e->s->version == v && memcmp(e->s->name, symb, l) == 0)
+			return e->s;
+	}
 	if(!creat)
 		return nil;
 
 	s = newsym(symb, v);
-	s->hash = hash[h];
-	hash[h] = s;
+	e->h = h;
+	e->s = s;
+	if(++nhashsym >= nhash/2)
+		growhash();
 
 	return s;
 }
@@ -873,6 +1338,47 @@ Bget4(Biobuf *f)
 	return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
 }
 
+int32
+Oget4(Objbuf *o)
+{
+	uchar *p;
+
+	if(o->ep - o->p < 4) {
+		o->p = o->ep;
+		return 0;
+	}
+	p = o->p;
+	o->p += 4;
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+}
+
+/*
+ * Return the NUL-terminated string at o->p and move past it,
+ * or nil if the data ends first.
+ */
+char*
+Ordstr(Objbuf *o)
+{
+	uchar *p, *e;
+
+	p = o->p;
+	e = memchr(p, '\0', o->ep - p);
+	if(e == nil)
+		return nil;
+	o->p = e+1;
+	return (char*)p;
+}
+
+int
+Oread(Objbuf *o, void *v, int n)
+{
+	if(o->ep - o->p < n)
+		n = o->ep - o->p;
+	memmove(v, o->p, n);
+	o->p += n;
+	return n;
+}
+
 void
 mywhatsys(void)
 {
@@ -1491,3 +1997,52 @@ cwrite(void *buf, int n)
 	}
 	coutpos += n;
 }
+
+/*
+ * Map the next n bytes of output for writing, after anything
+ * buffered.  Returns nil if the output cannot be mapped, in
+ * which case write it with cput and cwrite instead.
+ */
+uchar*
+cmap(vlong n)
+{
+	cflush();
+	return mapwrite(cout, coutpos, n);
+}
+
+/*
+ * Release the map made by cmap(n) and move past it.
+ */
+void
+cunmap(uchar *p, vlong n)
+{
+	unmapwrite(p, coutpos, n);
+	cseek(coutpos + n);
+}
+
+/*
+ * Read back n bytes of output from offset off.
+ */
+void
+cread(vlong off, void *p, int n)
+{
+	cflush();
+	if(seek(cout, off, 0) < 0 || readn(cout, p, n) != n) {
+		diag("read error: %r");
+		errorexit();
+	}
+	seek(cout, coutpos, 0);
+}
+
+/*
+ * Cut the output off at the current position.
+ */
+void
+ctruncate(void)
+{
+	cflush();
+	if(ftruncate(cout, coutpos) < 0) {
+		diag("truncate error: %r");
+		errorexit();
+	}
+}
@@ -63,8 +63,6 @@ enum
 	SSUB = 1<<8,	/* sub-symbol, linked from parent via ->sub list */
 	SMASK = SSUB - 1,
 	SHIDDEN = 1<<9, // hidden or local symbol
-
-	NHASH = 100003,
 };
 
 typedef struct Library Library;
@@ -76,6 +74,21 @@ struct Library
 	char *pkg;	// import path
 };
 
+// The body of a Go object file, read in one piece
+// and parsed from memory by ldobj1.
+typedef struct Objbuf Objbuf;
+struct Objbuf
+{
+	uchar*	buf;
+	int32	nbuf;	// allocated size of buf
+	uchar*	p;	// next byte to parse
+	uchar*	ep;	// end of data
+	vlong	off;	// file offset of buf[0]
+};
+
+#define	OGETC(o)	((o)->p < (o)->ep ? *(o)->p++ : Beof)
+#define	Ooffset(o)	((o)->off + ((o)->p - (o)->buf))
+
 // Terrible but standard terminology.
 // A segment describes a block of file to load into memory.
 // A section further describes the pieces of that block for
@@ -113,7 +126,6 @@ EXTERN	char*	thestring;
 EXTERN	Library*	library;
 EXTERN	int	libraryp;
 EXTERN	int	nlibrary;
-EXTERN	Sym*	hash[NHASH];
 EXTERN	Sym*	allsym;
 EXTERN	Sym*	histfrog[MAXHIST];
 EXTERN	uchar	fnuxi8[8];
@@ -125,6 +137,8 @@ EXTERN	uchar	inuxi2[2];
 EXTERN	uchar	inuxi4[4];
 EXTERN	uchar	inuxi8[8];
 EXTERN	char*	outfile;
+EXTERN	char*	pgofile;
+EXTERN	char*	symorder;
 EXTERN	int32	nsymbol;
 EXTERN	char*	thestring;
 EXTERN	int	ndynexp;
@@ -156,26 +170,33 @@ void	undefsym(Sym *s);
 void	zerosig(char *sp);
 void	readundefs(char *f, int t);
 int32	Bget4(Biobuf *f);
+int32	Oget4(Objbuf *o);
+char*	Ordstr(Objbuf *o);
+int	Oread(Objbuf *o, void *v, int n);
 void	loadlib(void);
 void	errorexit(void);
+void	endphase(char*);
+void	phasestats(void);
 void	mangle(char*);
 void	objfile(char *file, char *pkg);
 void	libinit(void);
 void	pclntab(void);
+void	functab(void);
 void	symtab(void);
 void	Lflag(char *arg);
 void	usage(void);
 void	adddynrel(Sym*, Reloc*);
-void	ldobj1(Biobuf *f, char*, int64 len, char *pn);
+void	ldobj1(Objbuf *o, char *pkg, char *pn);
 void	ldobj(Biobuf*, char*, int64, char*, int);
 void	ldelf(Biobuf*, char*, int64, char*);
 void	ldmacho(Biobuf*, char*, int64, char*);
 void	ldpe(Biobuf*, char*, int64, char*);
-void	ldpkg(Biobuf*, char*, int64, char*, int);
+void	ldpkg(char*, char*, int64, char*, int);
 void	mark(Sym *s);
 void	mkfwd(void);
 char*	expandpkg(char*, char*);
 void	deadcode(void);
+void	ordertext(void);
 Reloc*	addrel(Sym*);
 void	codeblk(int32, int32);
 void	datblk(int32, int32);
@@ -313,5 +334,89 @@ void	cflush(void);
 vlong	cpos(void);
 void	cseek(vlong);
 void	cwrite(void*, int);
+uchar*	cmap(vlong);
+void	cunmap(uchar*, vlong);
+void	cread(vlong, void*, int);
+void	ctruncate(void);
 void	importcycles(void);
 int	Zconv(Fmt*);
+
+// decoding the type.* symbols
+
+// Type.commonType.kind, from ../../pkg/runtime/type.go
+enum
+{
+	KindBool = 1,
+	KindInt,
+	KindInt8,
+	KindInt16,
+	KindInt32,
+	KindInt64,
+	KindUint,
+	KindUint8,
+	KindUint16,
+	KindUint32,
+	KindUint64,
+	KindUintptr,
+	KindFloat32,
+	KindFloat64,
+	KindComplex64,
+	KindComplex128,
+	KindArray,
+	KindChan,
+	KindFunc,
+	KindInterface,
+	KindMap,
+	KindPtr,
+	KindSlice,
+	KindString,
+	KindStruct,
+	KindUnsafePointer,
+
+	KindNoPointers = 1<<7,
+};
+
+enum
+{
+	// size of Type interface header + CommonType structure.
+	CommonSize = 2*PtrSize+ 6*PtrSize + 8,
+
+	// runtime.method and runtime.imethod
+	MethodSize = 6*PtrSize,
+	IMethodSize = 3*PtrSize,
+};
+
+Reloc*	decode_reloc(Sym*, int32);
+Sym*	decode_reloc_sym(Sym*, int32);
+uvlong	decode_inuxi(uchar*, int);
+uint8	decodetype_kind(Sym*);
+vlong	decodetype_size(Sym*);
+Sym*	decodetype_arrayelem(Sym*);
+vlong	decodetype_arraylen(Sym*);
+Sym*	decodetype_ptrelem(Sym*);
+Sym*	decodetype_mapkey(Sym*);
+Sym*	decodetype_mapvalue(Sym*);
+Sym*	decodetype_chanelem(Sym*);
+int	decodetype_funcdotdotdot(Sym*);
+int	decodetype_funcincount(Sym*);
+int	decodetype_funcoutcount(Sym*);
+Sym*	decodetype_funcintype(Sym*, int);
+Sym*	decodetype_funcouttype(Sym*, int);
+int	decodetype_structfieldcount(Sym*);
+char*	decodetype_structfieldname(Sym*, int);
+Sym*	decodetype_structfieldtype(Sym*, int);
+vlong	decodetype_structfieldoffs(Sym*, int);
+vlong	decodetype_ifacemethodcount(Sym*);
+Sym*	decodetype_ifacemethodname(Sym*, int);
+Sym*	decodetype_ifacemethodtype(Sym*, int);
+int32	decodetype_uncommon(Sym*);
+int	decodetype_methodcount(Sym*);
+int32	decodetype_methodoff(Sym*);
+
+// zlib compression, in deflate.c
+
+typedef struct Deflate Deflate;
+
+Deflate*	deflateinit(void (*)(void*, uchar*, int), void*);
+void	deflatewrite(Deflate*, uchar*, int);
+void	deflateend(Deflate*);
@@ -130,11 +130,14 @@ int	errors;
 
 Arfile *astart, *amiddle, *aend;	/* Temp file control block pointers */
 int	allobj = 1;			/* set when all members are object files of the same type */
-int	symdefsize;			/* size of symdef file */
 char	*pkgstmt;		/* string "package foo" */
 char	*objhdr;		/* string "go object darwin 386 release.2010-01-01 2345+" */
 int	dupfound;			/* flag for duplicate symbol */
 Hashchain	*hash[NHASH];		/* hash table of text symbols */
+vlong	*imember;		/* index: archive offsets of member headers */
+int	nimember;
+Arsymref **isym;		/* index: defined symbols */
+int	nisym;
 
 #define	ARNAMESIZE	sizeof(astart->tail->hdr.name)
 
@@ -145,6 +148,7 @@ Biobuf bar;
 char	*prefix;
 int	pkgdefsafe;		/* was __.PKGDEF marked safe? */
 
+int	arappend(char*, int, int, char**);
 void	arcopy(Biobuf*, Arfile*, Armember*);
 int	arcreate(char*);
 void	arfree(Arfile*);
@@ -159,6 +163,12 @@ int	bamatch(char*, char*);
 int	duplicate(char*, char**);
 Armember *getdir(Biobuf*);
 void	getpkgdef(char**, int*);
+int	goobj(Biobuf*);
+char	*mkindex(vlong, vlong, long);
+void	indexmembers(Arfile*, vlong);
+void	indexsyms(Arfile*, vlong);
+long	indexsize(void);
+long	indexroom(long);
 int	getspace(void);
 void	install(char*, Arfile*, Arfile*, Arfile*, int);
 void	loadpkgdata(char*, int);
@@ -171,18 +181,22 @@ void	objsym(Sym*, void*);
 int	openar(char*, int, int);
 int	page(Arfile*);
 void	pmode(long);
+char	*readindex(int, long*, char***);
 void	rl(int);
 void	scanobj(Biobuf*, Arfile*, long);
 void	scanpkg(Biobuf*, long);
+void	seedsyms(void);
 void	select(int*, long);
 void	setcom(void(*)(char*, int, char**));
 void	skip(Biobuf*, vlong);
+void	staleindex(int);
 void	checksafe(Biobuf*, vlong);
-int	symcomp(void*, void*);
+int	symcomp(const void*, const void*);
+uint32	symhash(char*);
 void	trim(char*, char*, int);
 void	usage(void);
 void	wrerr(void);
-void	wrsym(Biobuf*, long, Arsymref*);
+void	wrindex(int, char*, long);
 int	arread_cutprefix(Biobuf*, Armember*);
 
 void	rcmd(char*, int, char**);		/* command processing */
@@ -303,10 +317,10 @@ rcmd(char *arname, int count, char **files)
 	Biobuf *bfile;
 
 	fd = openar(arname, ORDWR, 1);
-	if (fd >= 0) {
-		Binit(&bar, fd, OREAD);
-		Bseek(&bar,seek(fd,0,1), 1);
-	}
+	if (fd >= 0 && !aflag && !bflag && count > 0 && arappend(arname, fd, count, files))
+		return;
+	if (fd >= 0)
+		Binitmap(&bar, fd, OREAD);
 	astart = newtempfile(artemp);
 	ap = astart;
 	aend = 0;
@@ -369,8 +383,10 @@ rcmd(char *arname, int count, char **files)
 		armove(bfile, ap, bp);
 		Bterm(bfile);
 	}
-	if(fd >= 0)
+	if(fd >= 0) {
+		Bterm(&bar);
 		close(fd);
+	}
 		/* copy in remaining files named on command line */
 	for (i = 0; i < count; i++) {
 		file = files[i];
@@ -400,6 +416,114 @@ rcmd(char *arname, int count, char **files)
 		install(arname, astart, 0, aend, 0);
 }
 
+/*
+ *	add the files named on the command line to the end of the archive
+ *	open on fd and update its index in place, instead of copying the
+ *	whole archive.  this works when the archive has an index, none of
+ *	the files replaces a member and, with the g flag, none brings Go
+ *	package data to be merged into __.PKGDEF.  returns 0, having
+ *	done nothing, if the archive must be rewritten instead.
+ */
+int
+arappend(char *arname, int fd, int count, char **files)
+{
+	char *index, **names, name[ARNAMESIZE+1];
+	long room;
+	vlong arsize;
+	int i, j;
+	Arfile *ap;
+	Biobuf *bfile;
+	Dir *d;
+
+	index = readindex(fd, &room, &names);
+	if(index == nil)
+		goto no;
+	for(i = 0; i < count; i++) {
+		if(files[i] == 0)
+			continue;
+		trim(files[i], name, ARNAMESIZE);
+		for(j = 0; j < nimember; j++)
+			if(strncmp(name, names[j], ARNAMESIZE) == 0)
+				goto no;
+		if(gflag) {
+			bfile = Bopen(files[i], OREAD);
+			if(bfile == nil)
+				goto no;
+			j = goobj(bfile);
+			Bterm(bfile);
+			if(j)
+				goto no;
+		}
+	}
+	free(index);
+
+	seedsyms();
+	arsize = seek(fd, 0, 2);
+	ap = newtempfile(artemp);
+	for(i = 0; i < count; i++) {
+		file = files[i];
+		if(file == 0)
+			continue;
+		files[i] = 0;
+		bfile = Bopen(file, OREAD);
+		if (!bfile) {
+			fprint(2, "pack: cannot open %s\n", file);
+			errors++;
+		} else {
+			mesg('a', file);
+			d = dirfstat(Bfildes(bfile));
+			if (d == nil)
+				fprint(2, "can't stat %s\n", file);
+			else {
+				scanobj(bfile, ap, d->length);
+				armove(bfile, ap, newmember());
+				free(d);
+			}
+			Bterm(bfile);
+		}
+	}
+	if(allobj && dupfound) {
+		fprint(2, "%s not changed\n", arname);
+		arfree(ap);
+		close(fd);
+		return 1;
+	}
+	/* leave note group behind when writing archive; i.e. sidestep interrupts */
+	rfork(RFNOTEG);
+	indexmembers(ap, arsize);
+	indexsyms(ap, arsize);
+	arsize += ap->size;
+	arstream(fd, ap);
+	arfree(ap);
+	if(allobj && indexsize() <= room) {
+		wrindex(fd, mkindex(0, arsize, room), room);
+		close(fd);
+		return 1;
+	}
+	close(fd);
+
+	/*
+	 * the index has outgrown its room, or a member is not an
+	 * object file and the archive can have no index at all.
+	 * rewrite the archive as r would have done in the first place.
+	 */
+	memset(hash, 0, sizeof hash);
+	dupfound = 0;
+	free(objhdr);
+	objhdr = nil;
+	rcmd(arname, 0, nil);
+	return 1;
+
+no:
+	free(index);
+	free(objhdr);
+	objhdr = nil;
+	nimember = 0;
+	nisym = 0;
+	seek(fd, SARMAG, 0);
+	return 0;
+}
+
 void
 dcmd(char *arname, int count, char **files)
 {
@@ -409,8 +533,7 @@ dcmd(char *arname, int count, char **files)
 	if (!count)
 		return;
 	fd = openar(arname, ORDWR, 0);
-	Binit(&bar, fd, OREAD);
-	Bseek(&bar,seek(fd,0,1), 1);
+	Binitmap(&bar, fd, OREAD);
 	astart = newtempfile(artemp);
 	for (i = 0; bp = getdir(&bar); i++) {
 		if(match(count, files)) {
@@ -427,6 +550,7 @@ dcmd(char *arname, int count, char **files)
 			arcopy(&bar, astart, bp);
 		}
 	}
+	Bterm(&bar);
 	close(fd);
 	install(arname, astart, 0, 0, 0);
 }
@@ -439,8 +563,7 @@ xcmd(char *arname, int count, char **files)
 	Dir dx;
 
 	fd = openar(arname, OREAD, 0);
-	Binit(&bar, fd, OREAD);
-	Bseek(&bar,seek(fd,0,1), 1);
+	Binitmap(&bar, fd, OREAD);
 	i = 0;
 	while (bp = getdir(&bar)) {
 		if(count == 0 || match(count, files)) {
@@ -472,6 +595,7 @@ xcmd(char *arname, int count, char **files)
 			free(bp);
 		}
 	}
+	Bterm(&bar);
 	close(fd);
 }
 void
@@ -481,8 +605,7 @@ pcmd(char *arname, int count, char **files)
 	Armember *bp;
 
 	fd = openar(arname, OREAD, 0);
-	Binit(&bar, fd, OREAD);
-	Bseek(&bar,seek(fd,0,1), 1);
+	Binitmap(&bar, fd, OREAD);
 	while(bp = getdir(&bar)) {
 		if(count == 0 || match(count, files)) {
 			if(vflag)
@@ -494,6 +617,7 @@ pcmd(char *arname, int count, char **files)
 			skip(&bar, bp->size);
 		free(bp);
 	}
+	Bterm(&bar);
 	close(fd);
 }
 void
@@ -506,8 +630,7 @@ mcmd(char *arname, int count, char **files)
 	if (count == 0)
 		return;
 	fd = openar(arname, ORDWR, 0);
-	Binit(&bar, fd, OREAD);
-	Bseek(&bar,seek(fd,0,1), 1);
+	Binitmap(&bar, fd, OREAD);
 	astart = newtempfile(artemp);
 	amiddle = newtempfile(movtemp);
 	aend = 0;
@@ -539,6 +662,7 @@ mcmd(char *arname, int count, char **files)
 			arcopy(&bar, ap, bp);
 		}
 	}
+	Bterm(&bar);
 	close(fd);
 	if (poname[0] && aend == 0)
 		fprint(2, "pack: %s not found - files moved to end.\n", poname);
@@ -552,8 +676,7 @@ tcmd(char *arname, int count, char **files)
 	char name[ARNAMESIZE+1];
 
 	fd = openar(arname, OREAD, 0);
-	Binit(&bar, fd, OREAD);
-	Bseek(&bar,seek(fd,0,1), 1);
+	Binitmap(&bar, fd, OREAD);
 	while(bp = getdir(&bar)) {
 		if(count == 0 || match(count, files)) {
 			if(vflag)
@@ -564,31 +687,48 @@ tcmd(char *arname, int count, char **files)
 		skip(&bar, bp->size);
 		free(bp);
 	}
+	Bterm(&bar);
 	close(fd);
 }
 void
 qcmd(char *arname, int count, char **files)
 {
 	int fd, i;
+	long room;
+	vlong arsize;
+	char *index, **names;
 	Armember *bp;
+	Arfile *ap;
 	Biobuf *bfile;
+	Dir *d;
 
 	if(aflag || bflag) {
 		fprint(2, "pack: abi not allowed with q\n");
 		exits("error");
 	}
+	index = nil;
 	fd = openar(arname, ORDWR, 1);
 	if (fd < 0) {
 		if(!cflag)
 			fprint(2, "pack: creating %s\n", arname);
 		fd = arcreate(arname);
-	}
+	} else
+		index = readindex(fd, &room, &names);
 	Binit(&bar, fd, OREAD);
 	Bseek(&bar,seek(fd,0,1), 1);
 	/* leave note group behind when writing archive; i.e. sidestep interrupts */
 	rfork(RFNOTEG);
-	Bseek(&bar, 0, 2);
-	bp = newmember();
+	arsize = Bseek(&bar, 0, 2);
+
+	/*
+	 * if the archive has an index, keep it up to date
+	 * by scanning the new members as they go by.
+	 */
+	ap = nil;
+	if(index != nil) {
+		seedsyms();
+		ap = newtempfile(artemp);
+	}
 	for(i=0; i<count && files[i]; i++) {
 		file = files[i];
 		files[i] = 0;
@@ -598,15 +738,30 @@ qcmd(char *arname, int count, char **files)
 			errors++;
 		} else {
 			mesg('q', file);
-			armove(bfile, 0, bp);
+			if(ap != nil && (d = dirfstat(Bfildes(bfile))) != nil) {
+				scanobj(bfile, ap, d->length);
+				free(d);
+			}
+			bp = newmember();
+			armove(bfile, ap, bp);
 			if (!arwrite(fd, bp))
 				wrerr();
 			free(bp->member);
 			bp->member = 0;
+			if(ap == nil)
+				free(bp);
 			Bterm(bfile);
 		}
 	}
-	free(bp);
+	if(ap != nil) {
+		indexmembers(ap, arsize);
+		indexsyms(ap, arsize);
+		if(allobj && indexsize() <= room)
+			wrindex(fd, mkindex(0, arsize+ap->size, room), room);
+		else
+			staleindex(fd);
+		arfree(ap);
+	}
 	close(fd);
 }
 
@@ -749,6 +904,29 @@ scanobj(Biobuf *b, Arfile *ap, long size)
 	}
 }
 
+/*
+ *	is b, at the start of a file, an object file carrying Go package
+ *	data?  as in scanobj, a ! right after the header line means not.
+ */
+int
+goobj(Biobuf *b)
+{
+	vlong offset;
+	char *p;
+	int r;
+
+	offset = Boffset(b);
+	r = 0;
+	if(objtype(b, 0) >= 0) {
+		Bseek(b, offset, 0);
+		p = Brdline(b, '\n');
+		if(p != nil && strncmp(p, "go object ", 10) == 0)
+			r = Bgetc(b) != '!';
+	}
+	Bseek(b, offset, 0);
+	return r;
+}
+
 /*
  *	does line contain substring (length-limited)
  */
@@ -771,11 +949,13 @@ strstrn(char *line, int len, char *sub)
 int	safe = 1;
 char*	pkgname;
 char*	importblock;
+char*	importindex;
 
 void
 getpkgdef(char **datap, int *lenp)
 {
-	char *tag, *hdr;
+	char *tag, *hdr, *p;
+	int n, m;
 
 	if(pkgname == nil) {
 		pkgname = "__emptyarchive__";
@@ -790,8 +970,22 @@ getpkgdef(char **datap, int *lenp)
 	if(objhdr != nil)
 		hdr = objhdr;
 
-	*datap = smprint("%s\nimport\n$$\npackage %s %s\n%s\n$$\n", hdr, pkgname, tag, importblock);
-	*lenp = strlen(*datap);
+	if(importindex == nil) {
+		*datap = smprint("%s\nimport\n$$\npackage %s %s\n%s\n$$\n", hdr, pkgname, tag, importblock);
+		*lenp = strlen(*datap);
+		return;
+	}
+
+	// the index is not text: copy it, don't format it.
+	p = smprint("%s\nimport\n$$\npackage %s %s\n%s\n$$  // index\n", hdr, pkgname, tag, importblock);
+	n = strlen(p);
+	m = strlen(importindex);
+	*datap = armalloc(n+m+5);
+	memmove(*datap, p, n);
+	memmove(*datap+n, importindex, m);
+	strcpy(*datap+n+m, "\n$$\n");
+	*lenp = n+m+4;
+	free(p);
 }
 
 /*
@@ -804,7 +998,7 @@ scanpkg(Biobuf *b, long size)
 	long n;
 	int c;
 	long start, end, pkgsize;
-	char *data, *line, pkgbuf[1024], *pkg;
+	char *data, *line, pkgbuf[1024], *pkg, *index;
 	int first;
 
 	/*
@@ -839,6 +1033,7 @@ foundstart:
 	/* how big is it? */
 	first = 1;
 	start = end = 0;
+	index = nil;
 	for (n=0; n<size; n+=Blinelen(b)) {
 		line = Brdstr(b, '\n', 0);
 		if (line == nil)
@@ -868,6 +1063,9 @@ foundstart:
 			continue;
 		}
 		if(line[0] == '$' && line[1] == '$') {
+			// the exports may be followed by their index.
+			if(strncmp(line, "$$  // index\n", 13) == 0)
+				index = Brdstr(b, '\n', 1);
 			free(line);
 			goto foundend;
 		}
@@ -899,6 +1097,7 @@ foundend:
 	}
 	data[end-start] = '\0';
 	importblock = data;
+	importindex = index;
 }
 
 /*
@@ -929,7 +1128,6 @@ objsym(Sym *s, void *p)
 	}
 	as->type = s->type;
 	n = strlen(s->name);
-	symdefsize += 4+(n+1)+1;
 	as->len = n;
 	as->next = ap->sym;
 	ap->sym = as;
@@ -1218,9 +1416,10 @@ void
 rl(int fd)
 {
 	Biobuf b;
-	char *cp;
+	char *cp, *index;
 	struct ar_hdr a;
-	long len;
+	long room;
+	vlong len, base;
 	int headlen;
 	char *pkgdefdata;
 	int pkgdefsize;
@@ -1231,14 +1430,32 @@ rl(int fd)
 	Binit(&b, fd, OWRITE);
 	Bseek(&b,seek(fd,0,1), 0);
 
-	len = symdefsize;
-	if(len&01)
-		len++;
+	/* collect the index, with offsets relative to the first member */
+	nimember = 0;
+	nisym = 0;
+	len = 0;
+	if (astart) {
+		indexmembers(astart, len);
+		indexsyms(astart, len);
+		len += astart->size;
+	}
+	if(amiddle) {
+		indexmembers(amiddle, len);
+		indexsyms(amiddle, len);
+		len += amiddle->size;
+	}
+	if(aend) {
+		indexmembers(aend, len);
+		indexsyms(aend, len);
+		len += aend->size;
+	}
+	room = indexroom(indexsize());
+
 	sprint(a.date, "%-12ld", 0L);  // time(0)
 	sprint(a.uid, "%-6d", 0);
 	sprint(a.gid, "%-6d", 0);
 	sprint(a.mode, "%-8lo", 0644L);
-	sprint(a.size, "%-10ld", len);
+	sprint(a.size, "%-10ld", room);
 	strncpy(a.fmag, ARFMAG, 2);
 	strcpy(a.name, symdef);
 	for (cp = strchr(a.name, 0);		/* blank pad on right */
@@ -1248,26 +1465,17 @@ rl(int fd)
 			wrerr();
 
 	headlen = Boffset(&b);
-	len += headlen;
+	base = headlen + room;
 	if (gflag) {
 		getpkgdef(&pkgdefdata, &pkgdefsize);
-		len += SAR_HDR + pkgdefsize;
-		if (len & 1)
-			len++;
-	}
-	if (astart) {
-		wrsym(&b, len, astart->sym);
-		len += astart->size;
-	}
-	if(amiddle) {
-		wrsym(&b, len, amiddle->sym);
-		len += amiddle->size;
+		base += SAR_HDR + pkgdefsize;
+		if (base & 1)
+			base++;
 	}
-	if(aend)
-		wrsym(&b, len, aend->sym);
-
-	if(symdefsize&0x01)
-		Bputc(&b, 0);
+	index = mkindex(base, base+len, room);
+	if(Bwrite(&b, index, room) != room)
+		wrerr();
+	free(index);
 
 	if (gflag) {
 		len = pkgdefsize;
@@ -1275,7 +1483,7 @@ rl(int fd)
 		sprint(a.uid, "%-6d", 0);
 		sprint(a.gid, "%-6d", 0);
 		sprint(a.mode, "%-8lo", 0644L);
-		sprint(a.size, "%-10ld", (len + 1) & ~1);
+		sprint(a.size, "%-10ld", (long)((len + 1) & ~1));
 		strncpy(a.fmag, ARFMAG, 2);
 		strcpy(a.name, pkgdef);
 		for (cp = strchr(a.name, 0);		/* blank pad on right */
@@ -1293,26 +1501,332 @@ rl(int fd)
 }
 
 /*
- *	Write the defined symbols to the symdef file
+ *	The archive index (see <ar.h>).  imember and isym
+ *	collect the members and symbols; mkindex lays them out.
+ */
+static void
+putle4(uchar *p, uint32 v)
+{
+	p[0] = v;
+	p[1] = v>>8;
+	p[2] = v>>16;
+	p[3] = v>>24;
+}
+
+static uint32
+getle4(uchar *p)
+{
+	return p[0] | p[1]<<8 | p[2]<<16 | (uint32)p[3]<<24;
+}
+
+uint32
+symhash(char *name)
+{
+	uint32 h;
+	uchar *cp;
+
+	h = 0;
+	for(cp = (uchar*)name; *cp; cp++)
+		h = h*1119 + *cp;
+	return h;
+}
+
+int
+symcomp(const void *a, const void *b)
+{
+	Arsymref *x, *y;
+
+	x = *(Arsymref**)a;
+	y = *(Arsymref**)b;
+	if(x->offset != y->offset)
+		return x->offset < y->offset ? -1 : 1;
+	return strcmp(x->name, y->name);
+}
+
+/*
+ *	add the members of the temp file, which will start
+ *	at offset off, to the index.
  */
 void
-wrsym(Biobuf *bp, long offset, Arsymref *as)
-{
-	int off;
-
-	while(as) {
-		Bputc(bp, as->type);
-		off = as->offset+offset;
-		Bputc(bp, off);
-		Bputc(bp, off>>8);
-		Bputc(bp, off>>16);
-		Bputc(bp, off>>24);
-		if (Bwrite(bp, as->name, as->len+1) != as->len+1)
-			wrerr();
-		as = as->next;
+indexmembers(Arfile *ap, vlong off)
+{
+	Armember *bp;
+	int n;
+
+	n = 0;
+	for(bp = ap->head; bp; bp = bp->next)
+		n++;
+	imember = realloc(imember, (nimember+n+1)*sizeof imember[0]);
+	if(imember == nil) {
+		fprint(2, "pack: out of memory\n");
+		exits("malloc");
+	}
+	for(bp = ap->head; bp; bp = bp->next) {
+		imember[nimember++] = off;
+		off += SAR_HDR + ((bp->size+1) & ~1);
+	}
+}
+
+/*
+ *	add the symbols defined by the temp file, which will
+ *	start at offset off, to the index.
+ */
+void
+indexsyms(Arfile *ap, vlong off)
+{
+	Arsymref *as;
+	int n;
+
+	n = 0;
+	for(as = ap->sym; as; as = as->next)
+		n++;
+	isym = realloc(isym, (nisym+n+1)*sizeof isym[0]);
+	if(isym == nil) {
+		fprint(2, "pack: out of memory\n");
+		exits("malloc");
+	}
+	for(as = ap->sym; as; as = as->next) {
+		as->offset += off;
+		isym[nisym++] = as;
+	}
+}
+
+static int
+nbucket(void)
+{
+	int n;
+
+	for(n = 1; n < nisym; n <<= 1)
+		;
+	return n;
+}
+
+/*
+ *	the size of the index, without room to grow
+ */
+long
+indexsize(void)
+{
+	long n;
+	int i;
+
+	n = SAIHDR + nimember*SAIMEMBER + nbucket()*4 + nisym*SAISYM;
+	for(i = 0; i < nisym; i++)
+		n += isym[i]->len+1;
+	if(objhdr != nil)
+		n += strlen(objhdr)+1;
+	return n;
+}
+
+/*
+ *	the size of the __.SYMDEF member for an index of
+ *	used bytes, leaving room to add to it in place.
+ */
+long
+indexroom(long used)
+{
+	return (used + used/4 + 256 + 7) & ~7;
+}
+
+/*
+ *	lay out the index for an archive of arsize bytes in room
+ *	bytes.  member offsets are relative to base.
+ */
+char*
+mkindex(vlong base, vlong arsize, long room)
+{
+	uchar *p, *mem, *bucket, *sym, *str, *s;
+	long nstr;
+	int i, m, nhash;
+	uint32 h;
+	Arsymref *as;
+
+	qsort(isym, nisym, sizeof isym[0], symcomp);
+	nhash = nbucket();
+	p = armalloc(room);
+	memmove(p, ARINDEX, SARINDEX);
+	putle4(p+AIused, indexsize());
+	putle4(p+AIarsize, arsize);
+	putle4(p+AInmember, nimember);
+	putle4(p+AInsym, nisym);
+	putle4(p+AInhash, nhash);
+	mem = p + SAIHDR;
+	bucket = mem + nimember*SAIMEMBER;
+	sym = bucket + nhash*4;
+	str = sym + nisym*SAISYM;
+	nstr = 0;
+	putle4(p+AIhdr, ~0);
+	if(objhdr != nil) {
+		putle4(p+AIhdr, nstr);
+		strcpy((char*)str, objhdr);
+		nstr += strlen(objhdr)+1;
+	}
+
+	/* symbols are sorted by member, so each member's are a run */
+	m = 0;
+	for(i = 0; i < nimember; i++) {
+		while(m < nisym && isym[m]->offset < imember[i])
+			m++;
+		putle4(mem + i*SAIMEMBER, base+imember[i]);
+		putle4(mem + i*SAIMEMBER + 4, m);
+	}
+	i = 0;
+	for(m = 0; m < nisym; m++) {
+		as = isym[m];
+		while(i+1 < nimember && imember[i+1] <= as->offset)
+			i++;
+		s = sym + m*SAISYM;
+		putle4(s, nstr);
+		putle4(s+4, i);
+		putle4(s+12, as->type);
+		memmove(str+nstr, as->name, as->len+1);
+		nstr += as->len+1;
+	}
+
+	/* chain in reverse, so that each chain is in archive order */
+	for(m = nisym-1; m >= 0; m--) {
+		h = symhash(isym[m]->name) & (nhash-1);
+		putle4(sym + m*SAISYM + 8, getle4(bucket + h*4));
+		putle4(bucket + h*4, m+1);
+	}
+	return (char*)p;
+}
+
+/*
+ *	read the index at the start of the archive open on fd
+ *	into imember, isym and objhdr, with the names of the
+ *	members in *namesp and the size of the __.SYMDEF member
+ *	in *roomp.  returns nil if there is no up-to-date index.
+ */
+char*
+readindex(int fd, long *roomp, char ***namesp)
+{
+	struct ar_hdr h;
+	Dir *d;
+	uchar *p, *s, *str;
+	char **names, *cp, name[ARNAMESIZE+1];
+	long room, used, nstr;
+	int i, m, nhash;
+	uint32 off;
+	vlong arsize;
+	Arsymref *as;
+
+	d = dirfstat(fd);
+	if(d == nil)
+		return nil;
+	arsize = d->length;
+	free(d);
+	if(seek(fd, SARMAG, 0) != SARMAG || HEADER_IO(read, fd, h))
+		return nil;
+	if(strncmp(h.name, symdef, strlen(symdef)) != 0 || strncmp(h.fmag, ARFMAG, 2) != 0)
+		return nil;
+	room = strtol(h.size, 0, 0);
+	if(room < SAIHDR || room > arsize)
+		return nil;
+	p = armalloc(room);
+	if(readn(fd, p, room) != room || memcmp(p, ARINDEX, SARINDEX) != 0)
+		goto bad;
+	used = getle4(p+AIused);
+	nimember = getle4(p+AInmember);
+	nisym = getle4(p+AInsym);
+	nhash = getle4(p+AInhash);
+	if(getle4(p+AIarsize) != arsize || used > room)
+		goto bad;
+	if(nimember > room/SAIMEMBER || nisym > room/SAISYM || nhash > room/4)
+		goto bad;
+	str = p + SAIHDR + nimember*SAIMEMBER + nhash*4 + nisym*SAISYM;
+	nstr = p+used - str;
+	if(nstr < 0 || (nstr > 0 && str[nstr-1] != 0))
+		goto bad;
+
+	imember = armalloc((nimember+1)*sizeof imember[0]);
+	names = armalloc((nimember+1)*sizeof names[0]);
+	for(i = 0; i < nimember; i++) {
+		imember[i] = getle4(p + SAIHDR + i*SAIMEMBER);
+		if(seek(fd, imember[i], 0) != imember[i] || HEADER_IO(read, fd, h))
+			goto bad;
+		memmove(name, h.name, sizeof(h.name));
+		name[ARNAMESIZE] = '\0';
+		for(cp = name+ARNAMESIZE; cp > name && cp[-1] == ' '; cp--)
+			;
+		*cp = '\0';
+		names[i] = arstrdup(name);
+	}
+	isym = armalloc((nisym+1)*sizeof isym[0]);
+	s = str - nisym*SAISYM;
+	for(i = 0; i < nisym; i++, s += SAISYM) {
+		off = getle4(s);
+		m = getle4(s+4);
+		if(off >= nstr || m < 0 || m >= nimember)
+			goto bad;
+		as = armalloc(sizeof(Arsymref));
+		as->name = arstrdup((char*)str+off);
+		as->len = strlen(as->name);
+		as->file = names[m];
+		as->type = getle4(s+12);
+		as->offset = imember[m];
+		isym[i] = as;
+	}
+	off = getle4(p+AIhdr);
+	if(off != ~0) {
+		if(off >= nstr)
+			goto bad;
+		objhdr = arstrdup((char*)str+off);
+	}
+	*roomp = room;
+	*namesp = names;
+	return (char*)p;
+
+bad:
+	free(p);
+	nimember = 0;
+	nisym = 0;
+	return nil;
+}
+
+/*
+ *	enter the text symbols already in the index
+ *	in the table used to find duplicates.
+ */
+void
+seedsyms(void)
+{
+	int i;
+	char *ofile;
+
+	for(i = 0; i < nisym; i++) {
+		if(isym[i]->type != 'T')
+			continue;
+		file = isym[i]->file;
+		duplicate(isym[i]->name, &ofile);
 	}
 }
 
+/*
+ *	write the index into the __.SYMDEF member of the archive on fd.
+ */
+void
+wrindex(int fd, char *index, long room)
+{
+	if(seek(fd, SARMAG+SAR_HDR, 0) != SARMAG+SAR_HDR || write(fd, index, room) != room)
+		wrerr();
+	free(index);
+}
+
+/*
+ *	mark the index of the archive on fd out of date,
+ *	so that it is not used.  pack r rebuilds it.
+ */
+void
+staleindex(int fd)
+{
+	uchar buf[4];
+
+	putle4(buf, 0);
+	if(seek(fd, SARMAG+SAR_HDR+AIarsize, 0) < 0 || write(fd, buf, 4) != 4)
+		wrerr();
+}
+
 /*
  *	Check if the archive member matches an entry on the command line.
  */
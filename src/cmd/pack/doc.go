@@ -23,5 +23,14 @@ The new option 'S' forces pack to mark the archive as safe.
 The new option 'P' causes pack to remove the given prefix
 from file names in the line number information in object files
 that are already stored in or added to the archive.
+
+The __.SYMDEF section holds an index of the archive: the offsets of
+its members and a hash table of the symbols they define.  The linker
+uses it to load only the members a program needs.  When 'r' adds
+files that are not already in the archive, and with 'g' none of them
+brings Go type information, pack appends them and updates the index in
+place rather than rewriting the whole archive.  'q' keeps an existing
+index up to date the same way, or marks it out of date if it has
+run out of room; a later 'r' rebuilds it.
 */
 package documentation
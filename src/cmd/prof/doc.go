@@ -17,7 +17,8 @@ asleep or waiting for I/O.  Each thread contributes equally to the
 statistics.
 
 Usage:
-	go tool prof -p pid [-t total_secs] [-d delta_msec] [6.out args ...]
+	go tool prof -p pid [-e] [-t total_secs] [-d delta_msec] [6.out args ...]
+	go tool prof -F file.prof 6.out
 
 The output modes (default -h) are:
 
@@ -37,9 +38,33 @@ The output modes (default -h) are:
 	-s: dynamic function stack traces
 		At each sample period, print the symbolic stack trace.
 
+Flag -F converts a CPU profile of 6.out, such as one written by
+runtime/pprof or go test -cpuprofile, into the text feedback read by
+the compiler and linker -F flags, and prints it on standard output.
+Each line is a key followed by a sample count: "total N" for the whole
+profile, "func F N" for samples executing in function F, "edge F G N"
+for samples in which F was calling G, and "line file:line N" for samples
+executing or calling from that line.  For example:
+
+	go test -c
+	./pkg.test -test.cpuprofile=cpu.prof
+	go tool prof -F cpu.prof pkg.test > pkg.fdo
+	go build -gcflags "-F $PWD/pkg.fdo" -ldflags "-F $PWD/pkg.fdo"
+
 Flag -t sets the maximum real time to sample, in seconds, and -d
-sets the sampling interval in milliseconds.  The default is to sample
-every 100ms until the program completes.
+sets the sampling interval in milliseconds, which may be fractional.
+The default is to sample every 100ms until the program completes.
+
+Flag -e, on Linux, samples with the kernel's perf events instead of
+stopping the program with ptrace.  The kernel records the registers
+and the top of the stack of whichever thread is running, every 1ms of
+CPU time by default, and prof unwinds the stacks afterward using the
+symbol table of the binary.  Unlike the default mode, only threads
+that are running are sampled, and the program is not slowed by the
+sampling.  Flag -e needs no privileges as long as the sysctl
+kernel.perf_event_paranoid is 2 or less.  For example:
+
+	go tool prof -e -P cpu.prof ./6.out
 
 It is installed as go tool prof and is architecture-independent.
 
@@ -19,13 +19,13 @@
 #include <mach.h>
 
 char* file = "6.out";
-static Fhdr fhdr;
+Fhdr fhdr;
 int have_syms;
 int fd;
 struct Ureg_amd64 ureg_amd64;
 struct Ureg_x86 ureg_x86;
 int total_sec = 0;
-int delta_msec = 100;
+int delta_usec;	// sampling period
 int nsample;
 int nsamplethread;
 
@@ -45,6 +45,7 @@ int histograms;	// print histograms
 int linenums;	// print file and line numbers rather than function names
 int registers;	// print registers
 int stacks;		// print stack traces
+int perf;		// sample with the kernel's perf events
 
 int pid;		// main process pid
 
@@ -52,13 +53,19 @@ int nthread;	// number of threads
 int thread[32];	// thread pids
 Map *map[32];	// thread maps
 
+int	perfsamples(char**);
+
 void
 Usage(void)
 {
-	fprint(2, "Usage: prof -p pid [-t total_secs] [-d delta_msec]\n");
-	fprint(2, "       prof [-t total_secs] [-d delta_msec] 6.out args ...\n");
+	fprint(2, "Usage: prof -p pid [-e] [-t total_secs] [-d delta_msec]\n");
+	fprint(2, "       prof [-e] [-t total_secs] [-d delta_msec] 6.out args ...\n");
+	fprint(2, "       prof -F file.prof 6.out\n");
+	fprint(2, "\t-e: sample with perf events (Linux only)\n");
 	fprint(2, "\tformats (default -h):\n");
 	fprint(2, "\t\t-P file.prof: write [c]pprof output to file.prof\n");
+	fprint(2, "\t\t-F file.prof: convert [c]pprof CPU profile file.prof into\n");
+	fprint(2, "\t\t\tcompiler and linker feedback on standard output\n");
 	fprint(2, "\t\t-h: histograms\n");
 	fprint(2, "\t\t-f: dynamic functions\n");
 	fprint(2, "\t\t-l: dynamic file and line numbers\n");
@@ -552,16 +559,17 @@ ppmaps(void)
 void
 samples(void)
 {
-	int i, pid, msec;
+	int i, pid;
+	vlong usec;
 	struct timespec req;
 	int getmaps;
 
-	req.tv_sec = delta_msec/1000;
-	req.tv_nsec = 1000000*(delta_msec % 1000);
+	req.tv_sec = delta_usec/1000000;
+	req.tv_nsec = 1000*(delta_usec % 1000000);
 	getmaps = 0;
 	if(pprof)
 		getmaps= 1;
-	for(msec = 0; total_sec <= 0 || msec < 1000*total_sec; msec += delta_msec) {
+	for(usec = 0; total_sec <= 0 || usec < 1000000LL*total_sec; usec += delta_usec) {
 		nsample++;
 		nsamplethread += nthread;
 		for(i = 0; i < nthread; i++) {
@@ -747,7 +755,7 @@ dumppprof()
 	arch->ppword(0);	// must be zero
 	arch->ppword(3);	// 3 words follow in header
 	arch->ppword(0);	// must be zero
-	arch->ppword(delta_msec * 1000);	// sampling period in microseconds
+	arch->ppword(delta_usec);	// sampling period in microseconds
 	arch->ppword(0);	// must be zero (padding)
 	// 2) One record for each trace.
 	for(tp = trace; tp != nil; tp = tp->next) {
@@ -767,6 +775,151 @@ dumppprof()
 	Bterm(pproffd);
 }
 
+// Profile feedback for 6g -F and 6l -F.
+// Each output line is a key followed by a sample count:
+//
+//	total N		samples in the profile
+//	func F N	samples executing in function F
+//	edge F G N	samples in which F called G
+//	line P:L N	samples executing, or calling from, line L of file P
+//
+// Counts are accumulated in a hash table keyed by the text
+// of the line so that printing them is trivial.
+typedef struct Count Count;
+struct Count {
+	char	*key;
+	uvlong	n;
+	Count	*next;
+};
+
+Count	*fbcount[1021];
+int	nfbcount;
+
+void
+addcount(char *key, uvlong n)
+{
+	uint h;
+	char *p;
+	Count *c;
+
+	h = 0;
+	for(p = key; *p; p++)
+		h = h*31 + *p;
+	h %= nelem(fbcount);
+	for(c = fbcount[h]; c != nil; c = c->next) {
+		if(strcmp(c->key, key) == 0) {
+			c->n += n;
+			return;
+		}
+	}
+	c = malloc(sizeof *c);
+	c->key = strdup(key);
+	c->n = n;
+	c->next = fbcount[h];
+	fbcount[h] = c;
+	nfbcount++;
+}
+
+int
+comparecount(const void *va, const void *vb)
+{
+	return strcmp((*(Count**)va)->key, (*(Count**)vb)->key);
+}
+
+// getppword reads one little-endian pprof word, which is
+// the size of an address on the profiled machine.
+int
+getppword(Biobuf *b, uvlong *w)
+{
+	uchar buf[8];
+	int i, n;
+
+	n = mach->szaddr;
+	if(Bread(b, buf, n) != n)
+		return -1;
+	*w = 0;
+	for(i = n-1; i >= 0; i--)
+		*w = *w<<8 | buf[i];
+	return 0;
+}
+
+void
+feedback(char *ppfile)
+{
+	Biobuf *b;
+	uvlong w, count, n, i, pc, total, pcs[100];
+	char key[2048], line[1024];
+	Symbol s, caller;
+	Count *c, **cc;
+	int h;
+
+	b = Bopen(ppfile, OREAD);
+	if(b == nil) {
+		fprint(2, "prof: cannot open %s: %r\n", ppfile);
+		exit(2);
+	}
+	// Skip the header: 0, count of header words, words.
+	if(getppword(b, &w) < 0 || w != 0 || getppword(b, &n) < 0)
+		goto bad;
+	for(i = 0; i < n; i++)
+		if(getppword(b, &w) < 0)
+			goto bad;
+
+	total = 0;
+	for(;;) {
+		// The trailer is optional.
+		if(getppword(b, &count) < 0)
+			break;
+		if(getppword(b, &n) < 0)
+			goto bad;
+		if(n > nelem(pcs))
+			goto bad;
+		for(i = 0; i < n; i++)
+			if(getppword(b, &pcs[i]) < 0)
+				goto bad;
+		if(count == 0)
+			break;	// trailer
+		total += count;
+		for(i = 0; i < n; i++) {
+			// Every pc but the first is a return address;
+			// back up into the call instruction.
+			pc = pcs[i];
+			if(i > 0)
+				pc--;
+			if(!findsym(pc, CTEXT, &s))
+				break;
+			if(i == 0) {
+				snprint(key, sizeof key, "func %s", s.name);
+				addcount(key, count);
+			}
+			if(fileline(line, sizeof line, pc)) {
+				snprint(key, sizeof key, "line %s", line);
+				addcount(key, count);
+			}
+			if(i+1 < n && findsym(pcs[i+1]-1, CTEXT, &caller)) {
+				snprint(key, sizeof key, "edge %s %s", caller.name, s.name);
+				addcount(key, count);
+			}
+		}
+	}
+	Bterm(b);
+
+	cc = malloc(nfbcount*sizeof cc[0]);
+	n = 0;
+	for(h = 0; h < nelem(fbcount); h++)
+		for(c = fbcount[h]; c != nil; c = c->next)
+			cc[n++] = c;
+	qsort(cc, nfbcount, sizeof cc[0], comparecount);
+	print("total %llud\n", total);
+	for(i = 0; i < nfbcount; i++)
+		print("%s %llud\n", cc[i]->key, cc[i]->n);
+	return;
+
+bad:
+	fprint(2, "prof: %s: malformed profile\n", ppfile);
+	exit(2);
+}
+
 int
 startprocess(char **argv)
 {
@@ -807,9 +960,13 @@ int
 main(int argc, char *argv[])
 {
 	int i;
-	char *ppfile;
+	char *ppfile, *fbfile;
 
+	fbfile = nil;
 	ARGBEGIN{
+	case 'F':
+		fbfile = EARGF(Usage());
+		break;
 	case 'P':
 		pprof =1;
 		ppfile = EARGF(Usage());
@@ -820,7 +977,10 @@ main(int argc, char *argv[])
 		}
 		break;
 	case 'd':
-		delta_msec = atoi(EARGF(Usage()));
+		delta_usec = atof(EARGF(Usage()))*1000;
+		break;
+	case 'e':
+		perf = 1;
 		break;
 	case 't':
 		total_sec = atoi(EARGF(Usage()));
@@ -848,8 +1008,12 @@ main(int argc, char *argv[])
 	}ARGEND
 	if(pid <= 0 && argc == 0)
 		Usage();
+	if(fbfile != nil && (pid > 0 || argc != 1))
+		Usage();
 	if(functions+linenums+registers+stacks+pprof == 0)
 		histograms = 1;
+	if(delta_usec <= 0)
+		delta_usec = perf ? 1000 : 100000;
 	if(!machbyname("amd64")) {
 		fprint(2, "prof: no amd64 support\n", pid);
 		exit(1);
@@ -878,6 +1042,25 @@ main(int argc, char *argv[])
 		fprint(2, "prof: crack header for %s: %r\n", file);
 		exit(1);
 	}
+	if(fbfile != nil) {
+		if(!have_syms)
+			exit(1);
+		feedback(fbfile);
+		exit(0);
+	}
+	if(perf) {
+		if(setarch() < 0) {
+			fprint(2, "prof: can't identify binary architecture for %s\n", file);
+			exit(1);
+		}
+		if(perfsamples(argv) < 0) {
+			fprint(2, "prof: can't sample %s: %r\n", file);
+			exit(1);
+		}
+		dumphistogram();
+		dumppprof();
+		exit(0);
+	}
 	if(pid <= 0)
 		pid = startprocess(argv);
 	attachproc(pid, &fhdr);	// initializes thread list
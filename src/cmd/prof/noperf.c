@@ -0,0 +1,17 @@
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// +build !linux
+// +build !plan9
+
+#include <u.h>
+#include <libc.h>
+
+int
+perfsamples(char **argv)
+{
+	USED(argv);
+	werrstr("perf events not supported on this system");
+	return -1;
+}
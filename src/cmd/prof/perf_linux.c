@@ -0,0 +1,477 @@
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Sampling with the Linux perf events interface.
+//
+// Rather than stopping each thread with ptrace to read its
+// registers, prof -e asks the kernel for a cpu-clock sampling
+// event on every thread of the process.  Each sample carries
+// the user registers and a copy of the top of the user stack
+// and is delivered through a ring buffer shared with the kernel,
+// one for each CPU, so the program runs undisturbed.  The samples are unwound
+// afterward with the symbol table of the binary, by running
+// the usual traceback over a Map made from the copied stack.
+//
+// Only user mode is sampled, which is what an unprivileged
+// user may do with kernel.perf_event_paranoid at 2 or below.
+
+#include <u.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <libc.h>
+#include <bio.h>
+#define Ureg Ureg_amd64
+	#include <ureg_amd64.h>
+#undef Ureg
+#define Ureg Ureg_x86
+	#include <ureg_x86.h>
+#undef Ureg
+#include <mach.h>
+
+#undef waitpid
+
+// From main.c.
+extern	Fhdr	fhdr;
+extern	int	fd;
+extern	int	total_sec;
+extern	int	delta_usec;
+extern	int	nsample;
+extern	int	nsamplethread;
+extern	int	pprof;
+extern	int	pid;
+extern	struct Ureg_amd64 ureg_amd64;
+extern	struct Ureg_x86 ureg_x86;
+void	printpc(Map*, uvlong, uvlong);
+void	ppmaps(void);
+
+// The kernel interface, from <linux/perf_event.h>.
+// It is spelled out here because the sampling of
+// user registers and stacks is newer than most headers.
+#ifndef SYS_perf_event_open
+#define SYS_perf_event_open 298
+#endif
+
+typedef struct Perfattr Perfattr;
+struct Perfattr
+{
+	uint32	type;
+	uint32	size;
+	uvlong	config;
+	uvlong	sample_period;
+	uvlong	sample_type;
+	uvlong	read_format;
+	uvlong	flags;
+	uint32	wakeup_events;
+	uint32	bp_type;
+	uvlong	config1;
+	uvlong	config2;
+	uvlong	branch_sample_type;
+	uvlong	sample_regs_user;
+	uint32	sample_stack_user;
+	uint32	reserved;
+};
+
+enum
+{
+	PerfTypeSoftware = 1,
+	PerfCpuClock = 0,
+
+	PerfSampleIP = 1<<0,
+	PerfSampleTID = 1<<1,
+	PerfSampleRegsUser = 1<<12,
+	PerfSampleStackUser = 1<<13,
+
+	PerfDisabled = 1<<0,
+	PerfInherit = 1<<1,
+	PerfExcludeKernel = 1<<5,
+	PerfExcludeHV = 1<<6,
+
+	PerfRecordLost = 2,
+	PerfRecordSample = 9,
+
+	PerfIocEnable = 0x2400,
+	PerfIocSetOutput = 0x2405,
+
+	// x86 register numbers for sample_regs_user.
+	PerfRegBP = 6,
+	PerfRegSP = 7,
+	PerfRegIP = 8,
+
+	// Offsets in the first page of the ring buffer.
+	PerfDataHead = 1024,
+	PerfDataTail = 1032,
+
+	Stackcopy = 8192,	// bytes of user stack per sample
+	Ringpages = 128,	// data pages in each ring buffer
+	Maxcpu = 256,
+	Maxevent = 4096,
+};
+
+// The kernel does not map the buffer of an event that
+// follows new threads unless the event is bound to a CPU,
+// so there is an event for each thread on each CPU, and
+// the events on a CPU share the buffer of the first one.
+typedef struct Ring Ring;
+struct Ring
+{
+	int	fd;
+	uchar*	base;
+	uvlong	size;	// data bytes, a power of two
+};
+
+static	Ring	ring[Maxcpu];
+static	int	nring;
+static	int	evfd[Maxevent];
+static	int	nevfd;
+static	long	pagesize;
+static	uvlong	nlost;
+
+// The Map that the traceback reads: the registers of the
+// sample at address 0, the copied stack at its address,
+// and the text of the binary.
+static	Map*	pmap;
+static	uchar*	sregs;
+static	int	nsregs;
+static	uchar*	sstack;
+
+static int
+memrw(uchar *p, uvlong size, uvlong addr, void *v, uint n, int isread)
+{
+	if(!isread) {
+		werrstr("sample is read-only");
+		return -1;
+	}
+	if(addr > size || n > size-addr) {
+		werrstr("address %#llux not in sample", addr);
+		return -1;
+	}
+	memmove(v, p+addr, n);
+	return 0;
+}
+
+static int
+regrw(Map *map, Seg *s, uvlong addr, void *v, uint n, int isread)
+{
+	USED(map);
+	USED(s);
+	return memrw(sregs, nsregs, addr, v, n, isread);
+}
+
+static int
+stackrw(Map *map, Seg *s, uvlong addr, void *v, uint n, int isread)
+{
+	USED(map);
+	return memrw(sstack, s->e - s->b, addr, v, n, isread);
+}
+
+static int
+perfopen(int tid, int cpu, int group)
+{
+	Perfattr a;
+	int efd;
+
+	memset(&a, 0, sizeof a);
+	a.type = PerfTypeSoftware;
+	a.size = sizeof a;
+	a.config = PerfCpuClock;
+	a.sample_period = (uvlong)delta_usec*1000;	// nanoseconds
+	a.sample_type = PerfSampleIP|PerfSampleTID|PerfSampleRegsUser|PerfSampleStackUser;
+	a.flags = PerfDisabled|PerfInherit|PerfExcludeKernel|PerfExcludeHV;
+	a.sample_regs_user = (1<<PerfRegBP)|(1<<PerfRegSP)|(1<<PerfRegIP);
+	a.sample_stack_user = Stackcopy;
+	efd = syscall(SYS_perf_event_open, &a, tid, cpu, -1, 0);
+	if(efd < 0)
+		return -1;
+	if(group >= 0 && ioctl(efd, PerfIocSetOutput, group) < 0) {
+		close(efd);
+		return -1;
+	}
+	return efd;
+}
+
+// Map the buffer for the first event on a CPU.  The buffer
+// may be bigger than the locked memory an unprivileged user
+// is allowed, so try smaller ones before giving up.
+static int
+ringmap(Ring *r, int efd)
+{
+	int n;
+
+	for(n = Ringpages; n >= 8; n /= 2) {
+		r->base = mmap(nil, (n+1)*pagesize, PROT_READ|PROT_WRITE, MAP_SHARED, efd, 0);
+		if(r->base != MAP_FAILED) {
+			r->fd = efd;
+			r->size = (uvlong)n*pagesize;
+			return 0;
+		}
+	}
+	werrstr("mmap perf buffer: %r");
+	return -1;
+}
+
+// Open the events for the threads of pid.
+static int
+perfopenall(int pid)
+{
+	char buf[64];
+	DIR *d;
+	struct dirent *de;
+	int tid, efd, cpu, ncpu;
+	Ring *r;
+
+	ncpu = sysconf(_SC_NPROCESSORS_CONF);
+	if(ncpu > Maxcpu)
+		ncpu = Maxcpu;
+	snprint(buf, sizeof buf, "/proc/%d/task", pid);
+	d = opendir(buf);
+	if(d == nil)
+		return -1;
+	for(cpu = 0; cpu < ncpu; cpu++) {
+		r = &ring[nring];
+		r->fd = -1;
+		rewinddir(d);
+		while((de = readdir(d)) != nil) {
+			tid = atoi(de->d_name);
+			if(tid <= 0)
+				continue;
+			if(nevfd == Maxevent) {
+				werrstr("too many threads");
+				goto err;
+			}
+			efd = perfopen(tid, cpu, r->fd);
+			if(efd < 0) {
+				if(errno == ESRCH)
+					continue;	// exited
+				if(errno == ENODEV)
+					break;	// CPU is offline
+				if(errno == EACCES || errno == EPERM)
+					werrstr("perf_event_open: %r; kernel.perf_event_paranoid must be 2 or less");
+				else
+					werrstr("perf_event_open: %r");
+				goto err;
+			}
+			evfd[nevfd++] = efd;
+			if(r->fd < 0 && ringmap(r, efd) < 0)
+				goto err;
+		}
+		if(r->fd >= 0)
+			nring++;
+	}
+	closedir(d);
+	if(nring == 0) {
+		werrstr("no threads");
+		return -1;
+	}
+	return 0;
+
+err:
+	closedir(d);
+	return -1;
+}
+
+static void
+perfsample(uchar *p, uchar *ep)
+{
+	uvlong abi, ip, bp, sp, size, dynsize;
+
+	// PerfSampleIP, then PerfSampleTID.
+	p += 8+8;
+	// PerfSampleRegsUser: the ABI, then the registers in bit order.
+	if(p+8 > ep)
+		return;
+	abi = *(uvlong*)p;
+	p += 8;
+	if(abi == 0)
+		return;	// kernel thread
+	bp = ((uvlong*)p)[0];
+	sp = ((uvlong*)p)[1];
+	ip = ((uvlong*)p)[2];
+	p += 3*8;
+	// PerfSampleStackUser: the size, the copy, the size that was valid.
+	if(p+8 > ep)
+		return;
+	size = *(uvlong*)p;
+	p += 8;
+	dynsize = 0;
+	if(size > 0 && p+size+8 <= ep)
+		dynsize = *(uvlong*)(p+size);
+	if(dynsize > size)
+		dynsize = size;
+
+	if(mach->szaddr == 8) {
+		memset(&ureg_amd64, 0, sizeof ureg_amd64);
+		ureg_amd64.ip = ip;
+		ureg_amd64.sp = sp;
+		ureg_amd64.bp = bp;
+		sregs = (uchar*)&ureg_amd64;
+		nsregs = sizeof ureg_amd64;
+	} else {
+		memset(&ureg_x86, 0, sizeof ureg_x86);
+		ureg_x86.pc = ip;
+		ureg_x86.sp = sp;
+		ureg_x86.bp = bp;
+		sregs = (uchar*)&ureg_x86;
+		nsregs = sizeof ureg_x86;
+	}
+	sstack = p;
+	pmap->seg[1].b = sp;
+	pmap->seg[1].e = sp+dynsize;
+
+	nsample++;
+	nsamplethread++;
+	printpc(pmap, ip, sp);
+}
+
+// Process the records in a ring buffer.
+static void
+perfdrain(Ring *rp)
+{
+	static uchar *buf;
+	static uvlong nbuf;
+	uchar *data, *r;
+	uvlong head, tail, off, n;
+	uint32 type, size;
+
+	data = rp->base + pagesize;
+	head = *(volatile uvlong*)(rp->base+PerfDataHead);
+	__sync_synchronize();
+	tail = *(uvlong*)(rp->base+PerfDataTail);
+	while(tail < head) {
+		off = tail & (rp->size-1);
+		// struct perf_event_header: uint32 type, uint16 misc, uint16 size.
+		type = *(uint32*)(data+off);
+		size = *(uint16*)(data+off+6);
+		if(size < 8)
+			break;
+		r = data+off;
+		if(off+size > rp->size) {
+			// The record wraps; copy it out.
+			if(nbuf < size) {
+				nbuf = size;
+				buf = realloc(buf, nbuf);
+				if(buf == nil) {
+					fprint(2, "prof: out of memory\n");
+					exit(2);
+				}
+			}
+			n = rp->size-off;
+			memmove(buf, data+off, n);
+			memmove(buf+n, data, size-n);
+			r = buf;
+		}
+		switch(type) {
+		case PerfRecordSample:
+			perfsample(r+8, r+size);
+			break;
+		case PerfRecordLost:
+			// uvlong id, uvlong lost
+			nlost += *(uvlong*)(r+16);
+			break;
+		}
+		tail += size;
+	}
+	__sync_synchronize();
+	*(volatile uvlong*)(rp->base+PerfDataTail) = tail;
+}
+
+// Start the program, stopped by ptrace at its exec
+// until the events are in place.  libmach is not
+// involved: the traced child is only ever waited for here.
+static int
+perfstart(char **argv)
+{
+	int pid, status;
+
+	pid = fork();
+	if(pid < 0)
+		return -1;
+	if(pid == 0) {
+		ptrace(PTRACE_TRACEME, 0, 0, 0);
+		execv(argv[0], argv);
+		fprint(2, "prof: could not exec %s: %r\n", argv[0]);
+		_exit(1);
+	}
+	if(waitpid(pid, &status, 0) < 0)
+		return -1;
+	if(!WIFSTOPPED(status)) {
+		werrstr("%s did not start", argv[0]);
+		return -1;
+	}
+	return pid;
+}
+
+static int
+running(int pid, int started)
+{
+	int status;
+
+	if(started)
+		return waitpid(pid, &status, WNOHANG) == 0;
+	return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+/*
+ * Sample process pid, or the program in argv if pid is 0,
+ * until it exits or total_sec have passed.
+ */
+int
+perfsamples(char **argv)
+{
+	struct pollfd pfd[Maxcpu];
+	vlong end;
+	int i, started;
+
+	started = 0;
+	if(pid <= 0) {
+		pid = perfstart(argv);
+		if(pid < 0)
+			return -1;
+		started = 1;
+	}
+	pagesize = sysconf(_SC_PAGESIZE);
+	pmap = newmap(nil, 3);
+	if(pmap == nil || perfopenall(pid) < 0) {
+		if(started)
+			kill(pid, SIGKILL);
+		return -1;
+	}
+	setmap(pmap, -1, 0, 0, 0, "regs", regrw);
+	pmap->seg[0].e = mach->szaddr == 8 ? sizeof ureg_amd64 : sizeof ureg_x86;
+	setmap(pmap, -1, 0, 0, 0, "stack", stackrw);
+	setmap(pmap, fd, fhdr.txtaddr, fhdr.txtaddr+fhdr.txtsz, fhdr.txtoff, "text", fdrw);
+
+	if(pprof)
+		ppmaps();
+	for(i = 0; i < nevfd; i++)
+		ioctl(evfd[i], PerfIocEnable, 0);
+	if(started)
+		ptrace(PTRACE_DETACH, pid, 0, 0);
+
+	end = 0;
+	if(total_sec > 0)
+		end = nsec() + total_sec*1000000000LL;
+	for(i = 0; i < nring; i++) {
+		pfd[i].fd = ring[i].fd;
+		pfd[i].events = POLLIN;
+	}
+	while(running(pid, started) && (end == 0 || nsec() < end)) {
+		poll(pfd, nring, 10);
+		for(i = 0; i < nring; i++)
+			perfdrain(&ring[i]);
+	}
+	for(i = 0; i < nevfd; i++)
+		close(evfd[i]);
+	for(i = 0; i < nring; i++)
+		perfdrain(&ring[i]);
+	if(nlost > 0)
+		fprint(2, "prof: %llud samples lost\n", nlost);
+	return 0;
+}
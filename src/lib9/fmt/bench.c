@@ -0,0 +1,164 @@
+// +build ignore
+
+/*
+ * Benchmarks for the formatting engine.
+ * To build and run, from this directory:
+ *
+ *	gcc -I$GOROOT/include -o fmtbench bench.c $GOROOT/pkg/obj/${GOOS}_$GOARCH/lib9.a -lpthread
+ *	./fmtbench [-n iterations] [benchmark...]
+ *
+ * Each benchmark prints its time per call.  The output goes
+ * to a buffer that is reset when it fills, so the numbers are
+ * for formatting alone.  fmtbench -o repeats each format once
+ * into a buffer and on standard output, to check the results.
+ */
+
+#include <u.h>
+#include <libc.h>
+#include "fmtdef.h"
+
+typedef struct Bench Bench;
+struct Bench
+{
+	char	*name;
+	void	(*fn)(Fmt*, int);
+};
+
+static char	outbuf[8192];
+
+static int
+resetflush(Fmt *f)
+{
+	f->to = f->start;
+	return 1;
+}
+
+static void
+bd(Fmt *f, int i)
+{
+	fmtprint(f, "%d", i*7919);
+}
+
+static void
+bneg(Fmt *f, int i)
+{
+	fmtprint(f, "%d", -i);
+}
+
+static void
+bx(Fmt *f, int i)
+{
+	fmtprint(f, "%ux", i*2654435761U);
+}
+
+static void
+blld(Fmt *f, int i)
+{
+	fmtprint(f, "%lld", (vlong)i*1000000007LL);
+}
+
+static void
+bs(Fmt *f, int i)
+{
+	USED(i);
+	fmtprint(f, "%s", "runtime.mallocgc");
+}
+
+static void
+bwidth(Fmt *f, int i)
+{
+	fmtprint(f, "%08ux %-20s", i, "go.string.hdr");
+}
+
+/* a line of 6l -a output */
+static void
+blisting(Fmt *f, int i)
+{
+	fmtprint(f, "%.8llux\t%-24s\t%s\n", (uvlong)0x400c00+i*7, "MOVQ", "runtime.morestack+0(SB)");
+}
+
+/* a line of the symbol table dump, as in go tool nm */
+static void
+bsymtab(Fmt *f, int i)
+{
+	fmtprint(f, "%8llux %c %s %d\n", (uvlong)0x400000+i*16, 'T', "main.main", i);
+}
+
+static Bench bench[] = {
+	"d",		bd,
+	"negd",		bneg,
+	"ux",		bx,
+	"lld",		blld,
+	"s",		bs,
+	"width",	bwidth,
+	"listing",	blisting,
+	"symtab",	bsymtab,
+	nil,		nil,
+};
+
+static void
+usage(void)
+{
+	fprint(2, "usage: fmtbench [-o] [-n iterations] [benchmark...]\n");
+	exits("usage");
+}
+
+static int
+selected(char *name, int argc, char **argv)
+{
+	int i;
+
+	if(argc == 0)
+		return 1;
+	for(i=0; i<argc; i++)
+		if(strcmp(argv[i], name) == 0)
+			return 1;
+	return 0;
+}
+
+void
+main(int argc, char **argv)
+{
+	Bench *b;
+	Fmt f;
+	vlong t0, t1;
+	int i, n, show;
+
+	n = 1000000;
+	show = 0;
+	ARGBEGIN{
+	case 'n':
+		n = atoi(EARGF(usage()));
+		break;
+	case 'o':
+		show = 1;
+		break;
+	default:
+		usage();
+	}ARGEND
+
+	if(n <= 0)
+		usage();
+	for(b=bench; b->name; b++) {
+		if(!selected(b->name, argc, argv))
+			continue;
+		if(show) {
+			fmtstrinit(&f);
+			b->fn(&f, 12345);
+			print("%s: %s\n", b->name, fmtstrflush(&f));
+			continue;
+		}
+		memset(&f, 0, sizeof f);
+		f.start = outbuf;
+		f.to = outbuf;
+		f.stop = outbuf + sizeof outbuf;
+		f.flush = resetflush;
+		fmtlocaleinit(&f, nil, nil, nil);
+		t0 = nsec();
+		for(i=0; i<n; i++)
+			b->fn(&f, i);
+		t1 = nsec();
+		print("%-10s %8d %8.1f ns/op\n", b->name, n, (double)(t1-t0)/n);
+	}
+	exits(0);
+}
@@ -233,6 +233,39 @@ __fmtrcpy(Fmt *f, const void *vm, int n)
 	return 0;
 }
 
+/*
+ * copy n bytes, known to be whole runes, into a byte-oriented
+ * f with no padding; the fast paths below use this in place
+ * of __fmtcpy, which decodes and reencodes each rune.
+ */
+static int
+fmtbytes(Fmt *f, char *m, int n)
+{
+	char *t, *s;
+	int k;
+
+	t = (char*)f->to;
+	s = (char*)f->stop;
+	for(;;){
+		k = s - t;
+		if(k > n)
+			k = n;
+		memmove(t, m, k);
+		t += k;
+		m += k;
+		n -= k;
+		if(n == 0)
+			break;
+		t = (char*)__fmtflush(f, t, 1);
+		if(t == nil)
+			return -1;
+		s = (char*)f->stop;
+	}
+	f->nfmt += t - (char*)f->to;
+	f->to = t;
+	return 0;
+}
+
 /* fmt out one character */
 int
 __charfmt(Fmt *f)
@@ -262,6 +295,23 @@ fmtstrcpy(Fmt *f, char *s)
 
 	if(!s)
 		return __fmtcpy(f, "<nil>", 5, 5);
+	/* plain ASCII with no precision is copied as is */
+	if(!f->runes && !(f->flags & FmtPrec)){
+		for(i=0; (uchar)s[i] != 0 && (uchar)s[i] < Runeself; i++)
+			;
+		if(s[i] == 0){
+			j = 0;
+			if(f->flags & FmtWidth)
+				j = f->width - i;
+			if(!(f->flags & FmtLeft) && __fmtpad(f, j) < 0)
+				return -1;
+			if(fmtbytes(f, s, i) < 0)
+				return -1;
+			if((f->flags & FmtLeft) && __fmtpad(f, j) < 0)
+				return -1;
+			return 0;
+		}
+	}
 	/* if precision is specified, make sure we don't wander off the end */
 	if(f->flags & FmtPrec){
 #ifdef PLAN9PORT
@@ -335,6 +385,83 @@ __percentfmt(Fmt *f)
 	return __fmtrcpy(f, (const void*)x, 1);
 }
 
+/*
+ * fmt an integer with no flags but l, ll, u, a width, a precision,
+ * 0 or -: %d, %lld, %ux, %.8llux, %-5d and so on.  the common
+ * case, and far simpler than the general one below, which it
+ * must agree with.  the caller checks that width and precision
+ * fit in Fastwid.
+ */
+enum
+{
+	Fastwid = 32
+};
+
+static int
+fastifmt(Fmt *f)
+{
+	char buf[2*Fastwid], *p, *e, *conv;
+	uvlong vu;
+	int neg, sign, fl, n;
+
+	fl = f->flags;
+	sign = !(fl & FmtUnsigned);
+#ifndef PLAN9PORT
+	if(f->r != 'd')
+		sign = 0;
+#endif
+	neg = 0;
+	if(fl & FmtVLong)
+		vu = va_arg(f->args, uvlong);
+	else if(fl & FmtLong){
+		if(sign)
+			vu = (vlong)va_arg(f->args, long);
+		else
+			vu = va_arg(f->args, ulong);
+	}else{
+		if(sign)
+			vu = (vlong)va_arg(f->args, int);
+		else
+			vu = va_arg(f->args, uint);
+	}
+	if(sign && (vlong)vu < 0){
+		vu = -(vlong)vu;
+		neg = 1;
+	}
+	e = buf + sizeof buf;
+	p = e;
+	if(vu != 0 || !(fl & FmtPrec) || f->prec != 0){
+		if(f->r == 'x'){
+			conv = "0123456789abcdef";
+			do{
+				*--p = conv[vu & 15];
+				vu >>= 4;
+			}while(vu);
+		}else{
+			do{
+				*--p = '0' + vu % 10;
+				vu /= 10;
+			}while(vu);
+		}
+	}
+	if(fl & FmtPrec)
+		while(e - p < f->prec)
+			*--p = '0';
+	n = e - p + neg;
+	if((fl & (FmtZero|FmtWidth)) == (FmtZero|FmtWidth) && !(fl & (FmtLeft|FmtPrec)))
+		for(; n < f->width; n++)
+			*--p = '0';
+	if(neg)
+		*--p = '-';
+	if((fl & FmtWidth) && !(fl & FmtLeft) && __fmtpad(f, f->width - n) < 0)
+		return -1;
+	if(fmtbytes(f, p, n) < 0)
+		return -1;
+	if((fl & FmtWidth) && (fl & FmtLeft) && __fmtpad(f, f->width - n) < 0)
+		return -1;
+	return 0;
+}
+
 /* fmt an integer */
 int
 __ifmt(Fmt *f)
@@ -350,6 +477,10 @@ __ifmt(Fmt *f)
 
 	neg = 0;
 	fl = f->flags;
+	if(!f->runes && (fl & ~(FmtLong|FmtVLong|FmtUnsigned|FmtWidth|FmtPrec|FmtZero|FmtLeft)) == 0
+	&& f->width < Fastwid && f->prec < Fastwid
+	&& (f->r == 'd' || f->r == 'u' || f->r == 'x'))
+		return fastifmt(f);
 	isv = 0;
 	vu = 0;
 	u = 0;
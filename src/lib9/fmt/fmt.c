@@ -39,6 +39,13 @@ static struct
 	Convfmt	fmt[Maxfmt];
 } fmtalloc;
 
+/*
+ * the formats of the ASCII verbs, once looked up,
+ * so that fmtfmt need not search fmtalloc for them.
+ * written only under __fmtlock.
+ */
+static	volatile	Fmts	asciifmt[Runeself];
+
 static Convfmt knownfmt[] = {
 	' ',	__flagfmt,
 	'#',	__flagfmt,
@@ -112,6 +119,8 @@ __fmtinstall(int c, Fmts f)
 		fmtalloc.nfmt++;
 		p->c = c;
 	}
+	if(c < Runeself)
+		asciifmt[c] = f;
 
 	return 0;
 }
@@ -131,6 +140,10 @@ static Fmts
 fmtfmt(int c)
 {
 	Convfmt *p, *ep;
+	Fmts f;
+
+	if(c >= 0 && c < Runeself && (f = asciifmt[c]) != nil)
+		return f;
 
 	ep = &fmtalloc.fmt[fmtalloc.nfmt];
 	for(p=fmtalloc.fmt; p<ep; p++)
@@ -166,7 +179,9 @@ __fmtdispatch(Fmt *f, void *fmt, int isrunes)
 		if(isrunes){
 			r = *(Rune*)fmt;
 			fmt = (Rune*)fmt + 1;
-		}else{
+		}else if((r = *(uchar*)fmt) < Runeself)
+			fmt = (char*)fmt + 1;
+		else{
 			fmt = (char*)fmt + chartorune(&rune, (char*)fmt);
 			r = rune;
 		}
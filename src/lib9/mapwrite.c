@@ -0,0 +1,45 @@
+// +build !windows
+
+// Copyright 2012 The Go Authors.  All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#include <u.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <libc.h>
+
+/*
+ * Map bytes [off, off+len) of the file open on fd for writing,
+ * first growing the file if it is shorter than that.
+ * Returns a pointer to byte off, or nil if the file cannot be mapped.
+ */
+void*
+mapwrite(int fd, vlong off, vlong len)
+{
+	struct stat st;
+	vlong base;
+	char *p;
+
+	if(len <= 0 || fstat(fd, &st) < 0)
+		return nil;
+	if(st.st_size < off+len && ftruncate(fd, off+len) < 0)
+		return nil;
+	base = off - off%sysconf(_SC_PAGESIZE);
+	p = mmap(nil, off+len-base, PROT_READ|PROT_WRITE, MAP_SHARED, fd, base);
+	if(p == MAP_FAILED)
+		return nil;
+	return p + (off-base);
+}
+
+/*
+ * Release a mapping made by mapwrite(fd, off, len).
+ */
+void
+unmapwrite(void *v, vlong off, vlong len)
+{
+	vlong base;
+
+	base = off - off%sysconf(_SC_PAGESIZE);
+	munmap((char*)v - (off-base), off+len-base);
+}
@@ -0,0 +1,140 @@
+// +build !windows
+
+// Copyright 2012 The Go Authors.  All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#include <u.h>
+#include <pthread.h>
+#include <libc.h>
+
+enum
+{
+	Maxthread = 16,
+};
+
+/*
+ * A pool of worker threads, started on first use.
+ * parfor hands every worker the same job and they take
+ * iterations from a shared counter until none are left.
+ */
+static struct
+{
+	pthread_mutex_t	lk;
+	pthread_cond_t	start;
+	pthread_cond_t	done;
+	int	nthread;	/* including the caller of parfor */
+	int	gen;		/* bumped for each job */
+	int	busy;		/* workers still on the job */
+	int	active;		/* a job is running */
+	void	(*fn)(void*, int);
+	void*	arg;
+	int	n;
+	int	next;
+} pool = {
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+};
+
+static void
+run(void)
+{
+	int i;
+
+	while((i = __sync_fetch_and_add(&pool.next, 1)) < pool.n)
+		pool.fn(pool.arg, i);
+}
+
+static void*
+worker(void *v)
+{
+	int gen;
+
+	// gen is the job count when the thread was created,
+	// so a job started before it gets going is not missed.
+	gen = (int)(uintptr)v;
+	pthread_mutex_lock(&pool.lk);
+	for(;;) {
+		while(pool.gen == gen)
+			pthread_cond_wait(&pool.start, &pool.lk);
+		gen = pool.gen;
+		pthread_mutex_unlock(&pool.lk);
+		run();
+		pthread_mutex_lock(&pool.lk);
+		if(--pool.busy == 0)
+			pthread_cond_signal(&pool.done);
+	}
+	return nil;
+}
+
+/*
+ * The number of threads parfor uses: one per processor,
+ * at most Maxthread, or $GOTHREADS if set.
+ */
+int
+nworker(void)
+{
+	pthread_t t;
+	char *p;
+	int i, n;
+
+	pthread_mutex_lock(&pool.lk);
+	if(pool.nthread == 0) {
+		n = sysconf(_SC_NPROCESSORS_ONLN);
+		if(n > Maxthread)
+			n = Maxthread;
+		p = getenv("GOTHREADS");
+		if(p != nil && *p != '\0')
+			n = atoi(p);
+		free(p);
+		if(n < 1)
+			n = 1;
+		pool.nthread = 1;
+		for(i=1; i<n; i++) {
+			if(pthread_create(&t, nil, worker, (void*)(uintptr)pool.gen) != 0)
+				break;
+			pthread_detach(t);
+			pool.nthread++;
+		}
+	}
+	n = pool.nthread;
+	pthread_mutex_unlock(&pool.lk);
+	return n;
+}
+
+/*
+ * Call fn(arg, i) for each i in [0, n), spread over the
+ * worker threads, and return when all the calls have.
+ * fn must not depend on the order of the calls.
+ * A parfor inside fn runs on the calling thread.
+ */
+void
+parfor(int n, void (*fn)(void*, int), void *arg)
+{
+	int i;
+
+	if(n <= 1 || nworker() == 1 || !__sync_bool_compare_and_swap(&pool.active, 0, 1)) {
+		for(i=0; i<n; i++)
+			fn(arg, i);
+		return;
+	}
+
+	pthread_mutex_lock(&pool.lk);
+	pool.fn = fn;
+	pool.arg = arg;
+	pool.n = n;
+	pool.next = 0;
+	pool.busy = pool.nthread - 1;
+	pool.gen++;
+	pthread_cond_broadcast(&pool.start);
+	pthread_mutex_unlock(&pool.lk);
+
+	run();
+
+	pthread_mutex_lock(&pool.lk);
+	while(pool.busy > 0)
+		pthread_cond_wait(&pool.done, &pool.lk);
+	pthread_mutex_unlock(&pool.lk);
+	pool.active = 0;
+}
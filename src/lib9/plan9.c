@@ -0,0 +1,102 @@
+// Copyright 2012 The Go Authors.  All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#include <u.h>
+#include <libc.h>
+#include <bio.h>
+
+/*
+ * On Plan 9 the tools use the system's libc and libbio,
+ * so the routines added to ours are provided here instead.
+ * Nothing is mapped: mapwrite returns nil, the Biobufs are
+ * ordinary ones, and parfor runs on the calling thread.
+ */
+
+void*
+mapwrite(int fd, vlong off, vlong len)
+{
+	USED(fd);
+	USED(off);
+	USED(len);
+	return nil;
+}
+
+void
+unmapwrite(void *v, vlong off, vlong len)
+{
+	USED(v);
+	USED(off);
+	USED(len);
+}
+
+int
+nworker(void)
+{
+	return 1;
+}
+
+void
+parfor(int n, void (*fn)(void*, int), void *arg)
+{
+	int i;
+
+	for(i=0; i<n; i++)
+		fn(arg, i);
+}
+
+int
+Binitmap(Biobuf *bp, int f, int mode)
+{
+	return Binit(bp, f, mode);
+}
+
+Biobuf*
+Bfdopenmap(int f, int mode)
+{
+	return Bfdopen(f, mode);
+}
+
+Biobuf*
+Bopenmap(char *name, int mode)
+{
+	return Bopen(name, mode);
+}
+
+/*
+ * As in ../libbio/bgetspan.c, for a buffer that is never a mapping.
+ */
+void*
+Bgetspan(Biobuf *bp, long n)
+{
+	uchar *p;
+	int i, j;
+
+	if(n < 0 || bp->state == Bwactive)
+		return nil;
+	i = -bp->icount;
+	if(n <= i) {
+		p = bp->ebuf - i;
+		bp->icount += n;
+		return p;
+	}
+	if(n > bp->bsize || bp->state != Bractive)
+		return nil;
+
+	memmove(bp->bbuf, bp->ebuf - i, i);
+	while(i < n) {
+		j = read(bp->fid, bp->bbuf+i, bp->bsize-i);
+		if(j <= 0)
+			break;
+		bp->offset += j;
+		i += j;
+	}
+	p = bp->ebuf - i;
+	memmove(p, bp->bbuf, i);
+	bp->gbuf = p;
+	bp->icount = -i;
+	if(i < n)
+		return nil;
+	bp->icount += n;
+	return p;
+}
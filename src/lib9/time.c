@@ -64,3 +64,14 @@ p9cputime(void)
 	d = (double)t[0]+(double)t[1]+(double)t[2]+(double)t[3];
 	return d/1000.0;
 }
+
+vlong
+p9nsec(void)
+{
+	struct timeval tv;
+
+	if(gettimeofday(&tv, 0) < 0)
+		return -1;
+
+	return (vlong)tv.tv_sec*1000*1000*1000 + tv.tv_usec*1000;
+}
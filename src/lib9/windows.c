@@ -24,3 +24,25 @@ int p9waitpid()
 {
 	return -1;
 }
+
+void *mapwrite(int fd, vlong off, vlong len)
+{
+	return 0;
+}
+
+void unmapwrite(void *v, vlong off, vlong len)
+{
+}
+
+int nworker(void)
+{
+	return 1;
+}
+
+void parfor(int n, void (*fn)(void*, int), void *arg)
+{
+	int i;
+
+	for(i=0; i<n; i++)
+		fn(arg, i);
+}
@@ -51,6 +51,8 @@ Bflush(Biobuf *bp)
 		bp->state = Bractive;
 
 	case Bractive:
+		if(bp->map != 0)
+			return 0;
 		bp->icount = 0;
 		bp->gbuf = bp->ebuf;
 		return 0;
@@ -38,6 +38,8 @@ loop:
 		bp->icount = i+1;
 		return bp->ebuf[i];
 	}
+	if(bp->map != 0)
+		return Beof;
 	if(bp->state != Bractive) {
 		if(bp->state == Bracteof)
 			bp->state = Bractive;
@@ -0,0 +1,54 @@
+// Copyright 2012 The Go Authors.  All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#include	<u.h>
+#include	<libc.h>
+#include	<bio.h>
+
+/*
+ * Return a pointer to the next n bytes of bp and move past them,
+ * without copying.  For a file mapped by Binitmap the pointer
+ * stays valid until Bterm; otherwise it points into the buffer
+ * and is good only until the next call on bp.  Returns nil,
+ * having consumed nothing, at end of file or if n is larger
+ * than the buffer.
+ */
+void*
+Bgetspan(Biobuf *bp, long n)
+{
+	unsigned char *p;
+	int i, j;
+
+	if(n < 0 || bp->state == Bwactive)
+		return 0;
+	i = -bp->icount;
+	if(n <= i) {
+		p = bp->ebuf - i;
+		bp->icount += n;
+		return p;
+	}
+	if(bp->map != 0 || n > bp->bsize || bp->state != Bractive)
+		return 0;
+
+	/*
+	 * gather the span at the start of the buffer,
+	 * then move it up to the end, as Brdline does.
+	 */
+	memmove(bp->bbuf, bp->ebuf - i, i);
+	while(i < n) {
+		j = read(bp->fid, bp->bbuf+i, bp->bsize-i);
+		if(j <= 0)
+			break;
+		bp->offset += j;
+		i += j;
+	}
+	p = bp->ebuf - i;
+	memmove(p, bp->bbuf, i);
+	bp->gbuf = p;
+	bp->icount = -i;
+	if(i < n)
+		return 0;
+	bp->icount += n;
+	return p;
+}
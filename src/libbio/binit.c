@@ -24,6 +24,10 @@ THE SOFTWARE.
 */
 
 #include	<u.h>
+#ifndef _WIN32
+#include	<sys/mman.h>
+#include	<sys/stat.h>
+#endif
 #include	<libc.h>
 #include	<bio.h>
 
@@ -108,6 +112,7 @@ Binits(Biobuf *bp, int f, int mode, unsigned char *p, int size)
 	bp->bsize = size;
 	bp->icount = 0;
 	bp->gbuf = bp->ebuf;
+	bp->map = 0;
 	bp->fid = f;
 	bp->flag = 0;
 	bp->rdline = 0;
@@ -123,6 +128,47 @@ Binit(Biobuf *bp, int f, int mode)
 	return Binits(bp, f, mode, bp->b, sizeof(bp->b));
 }
 
+/*
+ * Like Binit, but a regular file opened for reading
+ * is mapped into memory whole.  The buffer is then the
+ * mapping: BGETC indexes straight into it, Bseek only
+ * moves icount, and Bgetspan returns pointers into it
+ * that stay valid until Bterm.  The mapping is private
+ * and writable, so callers may scribble on those spans.
+ * Anything that cannot be mapped gets an ordinary buffer.
+ */
+int
+Binitmap(Biobuf *bp, int f, int mode)
+{
+#ifndef _WIN32
+	struct stat st;
+	vlong off;
+	unsigned char *p;
+
+	if(mode != OREAD || fstat(f, &st) < 0 || !S_ISREG(st.st_mode))
+		return Binit(bp, f, mode);
+	if(st.st_size <= 0 || st.st_size > Bmapmax)
+		return Binit(bp, f, mode);
+	off = seek(f, 0, 1);
+	if(off < 0 || off > st.st_size)
+		return Binit(bp, f, mode);
+	p = mmap(nil, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, f, 0);
+	if(p == MAP_FAILED)
+		return Binit(bp, f, mode);
+	Binit(bp, f, mode);
+	bp->map = p;
+	bp->bbuf = p;
+	bp->gbuf = p;
+	bp->ebuf = p+st.st_size;
+	bp->bsize = st.st_size;
+	bp->offset = st.st_size;
+	bp->icount = off - st.st_size;
+	return 0;
+#else
+	return Binit(bp, f, mode);
+#endif
+}
+
 Biobuf*
 Bfdopen(int f, int mode)
 {
@@ -137,39 +183,77 @@ Bfdopen(int f, int mode)
 }
 
 Biobuf*
-Bopen(char *name, int mode)
+Bfdopenmap(int f, int mode)
 {
 	Biobuf *bp;
-	int f;
 
+	bp = malloc(sizeof(Biobuf));
+	if(bp == 0)
+		return 0;
+	Binitmap(bp, f, mode);
+	bp->flag = Bmagic;
+	return bp;
+}
+
+static int
+bopenfd(char *name, int mode)
+{
 	switch(mode&~(ORCLOSE|OTRUNC)) {
 	default:
 		fprint(2, "Bopen: unknown mode %d\n", mode);
-		return 0;
+		return -1;
 
 	case OREAD:
-		f = open(name, OREAD);
-		if(f < 0)
-			return 0;
-		break;
+		return open(name, OREAD);
 
 	case OWRITE:
-		f = create(name, OWRITE|OTRUNC, 0666);
-		if(f < 0)
-			return 0;
+		return create(name, OWRITE|OTRUNC, 0666);
 	}
+}
+
+Biobuf*
+Bopen(char *name, int mode)
+{
+	Biobuf *bp;
+	int f;
+
+	f = bopenfd(name, mode);
+	if(f < 0)
+		return 0;
 	bp = Bfdopen(f, mode);
 	if(bp == 0)
 		close(f);
 	return bp;
 }
 
+Biobuf*
+Bopenmap(char *name, int mode)
+{
+	Biobuf *bp;
+	int f;
+
+	f = bopenfd(name, mode);
+	if(f < 0)
+		return 0;
+	bp = Bfdopenmap(f, mode);
+	if(bp == 0)
+		close(f);
+	return bp;
+}
+
 int
 Bterm(Biobuf *bp)
 {
 
 	deinstall(bp);
 	Bflush(bp);
+#ifndef _WIN32
+	if(bp->map != 0) {
+		munmap(bp->map, bp->bsize);
+		bp->map = 0;
+		bp->state = Binactive;
+	}
+#endif
 	if(bp->flag == Bmagic) {
 		bp->flag = 0;
 		close(bp->fid);
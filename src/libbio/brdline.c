@@ -34,6 +34,10 @@ Brdline(Biobuf *bp, int delim)
 	int i, j;
 
 	i = -bp->icount;
+	if(i == 0 && bp->map != 0) {
+		bp->rdline = 0;
+		return 0;
+	}
 	if(i == 0) {
 		/*
 		 * eof or other error
@@ -59,6 +63,14 @@ Brdline(Biobuf *bp, int delim)
 		return ip;
 	}
 
+	/*
+	 * a mapped file has nothing more to read
+	 */
+	if(bp->map != 0) {
+		bp->rdline = i;
+		return 0;
+	}
+
 	/*
 	 * copy data to beginning of buffer
 	 */
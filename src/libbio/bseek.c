@@ -57,6 +57,20 @@ Bseek(Biobuf *bp, vlong offset, int base)
 			base = 0;
 		}
 
+		/*
+		 * a mapped file is all buffer
+		 */
+		if(bp->map != 0) {
+			if(base == 2)
+				n += bp->bsize;
+			if(n < 0)
+				return Beof;
+			if(n > bp->bsize)
+				n = bp->bsize;
+			bp->icount = n - bp->bsize;
+			return n;
+		}
+
 		/*
 		 * try to seek within buffer
 		 */
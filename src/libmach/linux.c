@@ -34,6 +34,7 @@
 #include <sys/ptrace.h>
 #include <sys/signal.h>
 #include <sys/wait.h>
+#include <sys/uio.h>
 #include <errno.h>
 #include <libc.h>
 #include <bio.h>
@@ -70,6 +71,18 @@
 #define PTRACE_EVENT_VFORK_DONE 0x5
 #define PTRACE_EVENT_EXIT 0x6
 #endif
+#ifndef PTRACE_GETREGS
+#define PTRACE_GETREGS 12
+#endif
+#ifndef SYS_process_vm_readv
+#ifdef __x86_64__
+#define SYS_process_vm_readv 310
+#else
+#ifdef __i386__
+#define SYS_process_vm_readv 347
+#endif
+#endif
+#endif
 
 typedef struct Ureg64 Ureg64;
 
@@ -117,10 +130,38 @@ struct LinuxThread
 	int signal;
 	int child;
 	int exitcode;
+	ulong regsgen;	// memgen when regs was read
+	uintptr regs[32];	// struct user_regs_struct
 };
 
 static int trace = 0;
 
+// Reads of a stopped thread's memory and registers are cached
+// until the next control operation or write, which increment
+// memgen.  The cache holds a few pages, read whole with
+// process_vm_readv or from /proc/pid/mem, so that a stack
+// trace costs a handful of system calls rather than one
+// PTRACE_PEEKDATA for every word.
+enum
+{
+	Pagesize = 4096,
+	Npage = 16,
+};
+
+typedef struct Page Page;
+struct Page
+{
+	int pid;
+	ulong gen;
+	uvlong addr;
+	uchar data[Pagesize];
+};
+
+static ulong memgen = 1;
+static Page pagecache[Npage];
+static int memfd = -1;	// /proc/memfdpid/mem
+static int memfdpid;
+
 static LinuxThread **thr;
 static int nthr;
 static int mthr;
@@ -490,6 +531,11 @@ detachproc(Map *m)
 {
 	LinuxThread *t;
 
+	memgen++;
+	if(memfd >= 0) {
+		close(memfd);
+		memfd = -1;
+	}
 	t = findthread(m->pid);
 	if(t != nil) {
 		ptrace(PTRACE_DETACH, t->tid, 0, 0);
@@ -658,6 +704,7 @@ ctlproc(int pid, char *msg)
 
 	while(wait1(1) > 0)
 		;
+	memgen++;
 
 	if(strcmp(msg, "attached") == 0){
 		t = attachthread(pid, pid, &new, Attached);
@@ -804,13 +851,98 @@ ptraceerr:
 	return -1;
 }
 
+// Read n bytes at addr in one go, without ptrace.
+static int
+fastread(int pid, uvlong addr, void *v, uint n)
+{
+	char buf[64];
+
+#ifdef SYS_process_vm_readv
+	static int novm;
+	struct iovec local, remote;
+
+	if(!novm) {
+		local.iov_base = v;
+		local.iov_len = n;
+		remote.iov_base = (void*)(uintptr)addr;
+		remote.iov_len = n;
+		if(syscall(SYS_process_vm_readv, pid, &local, 1, &remote, 1, 0) == n)
+			return 0;
+		if(errno == ENOSYS)
+			novm = 1;
+	}
+#endif
+
+	if(memfdpid != pid) {
+		if(memfd >= 0)
+			close(memfd);
+		snprint(buf, sizeof buf, "/proc/%d/mem", pid);
+		memfd = open(buf, OREAD);
+		memfdpid = pid;
+	}
+	if(memfd >= 0 && pread(memfd, v, n, addr) == n)
+		return 0;
+	return -1;
+}
+
+static int
+readmem(int pid, uvlong addr, void *v, uint n)
+{
+	if(fastread(pid, addr, v, n) == 0)
+		return 0;
+	return ptracerw(PTRACE_PEEKDATA, PTRACE_PEEKDATA, 1, pid, addr, v, n);
+}
+
+// Return the cached page of pid containing addr, or nil
+// if it cannot be read whole.
+static Page*
+cachepage(int pid, uvlong addr)
+{
+	Page *p;
+
+	addr &= ~(uvlong)(Pagesize-1);
+	p = &pagecache[(addr/Pagesize)%Npage];
+	if(p->gen == memgen && p->pid == pid && p->addr == addr)
+		return p;
+	if(fastread(pid, addr, p->data, Pagesize) < 0) {
+		p->gen = 0;
+		return nil;
+	}
+	p->gen = memgen;
+	p->pid = pid;
+	p->addr = addr;
+	return p;
+}
+
 static int
 ptracesegrw(Map *map, Seg *seg, uvlong addr, void *v, uint n, int isr)
 {
+	Page *p;
+	uint off, m;
+
 	USED(seg);
 
-	return ptracerw(isr ? PTRACE_PEEKDATA : PTRACE_POKEDATA, PTRACE_PEEKDATA,
-		isr, map->pid, addr, v, n);
+	if(!isr) {
+		memgen++;
+		return ptracerw(PTRACE_POKEDATA, PTRACE_PEEKDATA,
+			0, map->pid, addr, v, n);
+	}
+	if(n > 2*Pagesize)
+		return readmem(map->pid, addr, v, n);
+	while(n > 0) {
+		p = cachepage(map->pid, addr);
+		if(p == nil)
+			return readmem(map->pid, addr, v, n);
+		off = addr - p->addr;
+		m = Pagesize - off;
+		if(m > n)
+			m = n;
+		memmove(v, p->data+off, m);
+		v = (char*)v + m;
+		addr += m;
+		n -= m;
+	}
+	return 0;
 }
 
 // If the debugger is compiled as an x86-64 program,
@@ -939,6 +1071,7 @@ ptraceregrw(Map *map, Seg *seg, uvlong addr, void *v, uint n, int isr)
 {
 	int laddr;
 	uvlong u;
+	LinuxThread *t;
 	
 	USED(seg);
 
@@ -951,11 +1084,23 @@ ptraceregrw(Map *map, Seg *seg, uvlong addr, void *v, uint n, int isr)
 		return -1;
 	}
 
+	t = findthread(map->pid);
 	if(isr){
-		errno = 0;
-		u = ptrace(PTRACE_PEEKUSER, map->pid, laddr, 0);
-		if(errno)
-			goto ptraceerr;
+		// Read the whole register set once per stop.
+		if(t != nil && t->regsgen != memgen) {
+			if(ptrace(PTRACE_GETREGS, map->pid, 0, t->regs) < 0)
+				t = nil;
+			else
+				t->regsgen = memgen;
+		}
+		if(t != nil)
+			u = *(long*)((char*)t->regs + laddr);
+		else {
+			errno = 0;
+			u = ptrace(PTRACE_PEEKUSER, map->pid, laddr, 0);
+			if(errno)
+				goto ptraceerr;
+		}
 		switch(n){
 		case 1:
 			*(uint8*)v = u;
@@ -991,6 +1136,8 @@ ptraceregrw(Map *map, Seg *seg, uvlong addr, void *v, uint n, int isr)
 			werrstr("bad register size");
 			return -1;
 		}
+		if(t != nil)
+			t->regsgen = 0;
 		if(ptrace(PTRACE_POKEUSER, map->pid, laddr, (void*)(uintptr)u) < 0)
 			goto ptraceerr;
 	}
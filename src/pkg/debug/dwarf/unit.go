@@ -15,6 +15,7 @@ type unit struct {
 	data     []byte
 	atable   abbrevTable
 	addrsize int
+	vers     int
 }
 
 func (d *Data) parseUnits() ([]unit, error) {
@@ -36,10 +37,12 @@ func (d *Data) parseUnits() ([]unit, error) {
 		u := &units[i]
 		u.base = b.off
 		n := b.uint32()
-		if vers := b.uint16(); vers != 2 {
+		vers := b.uint16()
+		if vers != 2 && vers != 3 {
 			b.error("unsupported DWARF version " + strconv.Itoa(int(vers)))
 			break
 		}
+		u.vers = int(vers)
 		atable, err := d.parseAbbrev(b.uint32())
 		if err != nil {
 			if b.err == nil {
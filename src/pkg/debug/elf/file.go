@@ -7,6 +7,7 @@ package elf
 
 import (
 	"bytes"
+	"compress/zlib"
 	"debug/dwarf"
 	"encoding/binary"
 	"errors"
@@ -70,10 +71,20 @@ type Section struct {
 	// with other clients.
 	io.ReaderAt
 	sr *io.SectionReader
+
+	// For SHF_COMPRESSED sections, from the compression header.
+	compressionType   CompressionType
+	compressionOffset int64
+	uncompressedSize  uint64
 }
 
 // Data reads and returns the contents of the ELF section.
+// The contents of a compressed (SHF_COMPRESSED) section are
+// returned uncompressed.
 func (s *Section) Data() ([]byte, error) {
+	if s.Flags&SHF_COMPRESSED != 0 {
+		return s.uncompress()
+	}
 	dat := make([]byte, s.sr.Size())
 	n, err := s.sr.ReadAt(dat, 0)
 	return dat[0:n], err
@@ -89,7 +100,61 @@ func (f *File) stringTable(link uint32) ([]byte, error) {
 }
 
 // Open returns a new ReadSeeker reading the ELF section.
-func (s *Section) Open() io.ReadSeeker { return io.NewSectionReader(s.sr, 0, 1<<63-1) }
+// A compressed (SHF_COMPRESSED) section is read uncompressed.
+// ReadAt, unlike Open and Data, always reads the section's bytes
+// as stored in the file.
+func (s *Section) Open() io.ReadSeeker {
+	if s.Flags&SHF_COMPRESSED != 0 {
+		dat, err := s.uncompress()
+		if err != nil {
+			return errorReader{err}
+		}
+		return bytes.NewReader(dat)
+	}
+	return io.NewSectionReader(s.sr, 0, 1<<63-1)
+}
+
+func (s *Section) uncompress() ([]byte, error) {
+	if s.compressionType != COMPRESS_ZLIB {
+		return nil, &FormatError{int64(s.Offset), "unsupported compression type", s.compressionType}
+	}
+	r := io.NewSectionReader(s.sr, s.compressionOffset, s.sr.Size()-s.compressionOffset)
+	dat, err := zlibData(r, s.uncompressedSize)
+	if err != nil {
+		return nil, &FormatError{int64(s.Offset), err.Error(), s.Name}
+	}
+	return dat, nil
+}
+
+// zlibData returns the n bytes of data held in the zlib stream r.
+// n comes from the file, so the buffer grows only as data
+// actually decompresses rather than being allocated up front.
+func zlibData(r io.Reader, n uint64) ([]byte, error) {
+	if n > uint64(^uint(0)>>1) {
+		return nil, errors.New("uncompressed size too large")
+	}
+	zr, err := zlib.NewReader(r)
+	if err != nil {
+		return nil, err
+	}
+	defer zr.Close()
+	var buf bytes.Buffer
+	if _, err := buf.ReadFrom(io.LimitReader(zr, int64(n))); err != nil {
+		return nil, err
+	}
+	if uint64(buf.Len()) != n {
+		return nil, errors.New("uncompressed size does not match header")
+	}
+	return buf.Bytes(), nil
+}
+
+// errorReader is a ReadSeeker that always fails with err.
+type errorReader struct {
+	err error
+}
+
+func (r errorReader) Read(p []byte) (int, error)     { return 0, r.err }
+func (r errorReader) Seek(int64, int) (int64, error) { return 0, r.err }
 
 // A ProgHeader represents a single ELF program header.
 type ProgHeader struct {
@@ -364,6 +429,26 @@ func NewFile(r io.ReaderAt) (*File, error) {
 		}
 		s.sr = io.NewSectionReader(r, int64(s.Offset), int64(s.Size))
 		s.ReaderAt = s.sr
+		if s.Flags&SHF_COMPRESSED != 0 {
+			switch f.Class {
+			case ELFCLASS32:
+				ch := new(Chdr32)
+				if err := binary.Read(s.sr, f.ByteOrder, ch); err != nil {
+					return nil, err
+				}
+				s.compressionType = CompressionType(ch.Type)
+				s.compressionOffset = int64(binary.Size(ch))
+				s.uncompressedSize = uint64(ch.Size)
+			case ELFCLASS64:
+				ch := new(Chdr64)
+				if err := binary.Read(s.sr, f.ByteOrder, ch); err != nil {
+					return nil, err
+				}
+				s.compressionType = CompressionType(ch.Type)
+				s.compressionOffset = int64(binary.Size(ch))
+				s.uncompressedSize = ch.Size
+			}
+		}
 		f.Sections[i] = s
 	}
 
@@ -536,10 +621,11 @@ func (f *File) applyRelocationsAMD64(dst []byte, rels []byte) error {
 		symNo := rela.Info >> 32
 		t := R_X86_64(rela.Info & 0xffff)
 
-		if symNo >= uint64(len(symbols)) {
+		// Symbols leaves out the null symbol 0.
+		if symNo == 0 || symNo > uint64(len(symbols)) {
 			continue
 		}
-		sym := &symbols[symNo]
+		sym := &symbols[symNo-1]
 		if SymType(sym.Info&0xf) != STT_SECTION {
 			// We don't handle non-section relocations for now.
 			continue
@@ -566,11 +652,18 @@ func (f *File) DWARF() (*dwarf.Data, error) {
 	// There are many other DWARF sections, but these
 	// are the required ones, and the debug/dwarf package
 	// does not use the others, so don't bother loading them.
+	// Each may also be compressed, either with SHF_COMPRESSED,
+	// which Data undoes, or as a GNU .zdebug_ section.
 	var names = [...]string{"abbrev", "info", "str"}
 	var dat [len(names)][]byte
+	zdebug := false
 	for i, name := range names {
-		name = ".debug_" + name
-		s := f.Section(name)
+		s := f.Section(".debug_" + name)
+		z := false
+		if s == nil {
+			s = f.Section(".zdebug_" + name)
+			z = true
+		}
 		if s == nil {
 			continue
 		}
@@ -578,12 +671,23 @@ func (f *File) DWARF() (*dwarf.Data, error) {
 		if err != nil && uint64(len(b)) < s.Size {
 			return nil, err
 		}
+		if z {
+			if b, err = zdebugData(b); err != nil {
+				return nil, &FormatError{int64(s.Offset), err.Error(), s.Name}
+			}
+			if name == "info" {
+				zdebug = true
+			}
+		}
 		dat[i] = b
 	}
 
 	// If there's a relocation table for .debug_info, we have to process it
 	// now otherwise the data in .debug_info is invalid for x86-64 objects.
 	rela := f.Section(".rela.debug_info")
+	if zdebug {
+		rela = f.Section(".rela.zdebug_info")
+	}
 	if rela != nil && rela.Type == SHT_RELA && f.Machine == EM_X86_64 {
 		data, err := rela.Data()
 		if err != nil {
@@ -599,6 +703,16 @@ func (f *File) DWARF() (*dwarf.Data, error) {
 	return dwarf.New(abbrev, nil, nil, info, nil, nil, nil, str)
 }
 
+// zdebugData returns the contents of a GNU .zdebug_ section:
+// "ZLIB", the uncompressed size as 8 big-endian bytes,
+// then a zlib stream.
+func zdebugData(b []byte) ([]byte, error) {
+	if len(b) < 12 || string(b[:4]) != "ZLIB" {
+		return nil, errors.New("invalid compressed section header")
+	}
+	return zlibData(bytes.NewBuffer(b[12:]), binary.BigEndian.Uint64(b[4:12]))
+}
+
 // Symbols returns the symbol table for f.
 func (f *File) Symbols() ([]Symbol, error) {
 	sym, _, err := f.getSymbols(SHT_SYMTAB)
@@ -5,8 +5,11 @@
 package elf
 
 import (
+	"bytes"
+	"compress/zlib"
 	"debug/dwarf"
 	"encoding/binary"
+	"io"
 	"net"
 	"os"
 	"reflect"
@@ -182,6 +185,14 @@ var relocationTests = []relocationTest{
 		"testdata/go-relocation-test-gcc424-x86-64.obj",
 		&dwarf.Entry{Offset: 0xb, Tag: dwarf.TagCompileUnit, Children: true, Field: []dwarf.Field{{Attr: dwarf.AttrProducer, Val: "GNU C 4.2.4 (Ubuntu 4.2.4-1ubuntu4)"}, {Attr: dwarf.AttrLanguage, Val: int64(1)}, {Attr: dwarf.AttrName, Val: "go-relocation-test-gcc424.c"}, {Attr: dwarf.AttrCompDir, Val: "/tmp"}, {Attr: dwarf.AttrLowpc, Val: uint64(0x0)}, {Attr: dwarf.AttrHighpc, Val: uint64(0x6)}, {Attr: dwarf.AttrStmtList, Val: int64(0)}}},
 	},
+	{
+		"testdata/zdebug-test-gcc1220-x86-64.obj",
+		&dwarf.Entry{Offset: 0xb, Tag: dwarf.TagCompileUnit, Children: true, Field: []dwarf.Field{{Attr: dwarf.AttrProducer, Val: "GNU C17 12.2.0"}, {Attr: dwarf.AttrLanguage, Val: int64(1)}, {Attr: dwarf.AttrName, Val: "zdebug-test.c"}, {Attr: dwarf.AttrCompDir, Val: "/tmp/zt"}, {Attr: dwarf.AttrLowpc, Val: uint64(0x0)}, {Attr: dwarf.AttrHighpc, Val: uint64(0xb)}, {Attr: dwarf.AttrStmtList, Val: int64(0)}}},
+	},
+	{
+		"testdata/compressed-test-gcc1220-x86-64.obj",
+		&dwarf.Entry{Offset: 0xb, Tag: dwarf.TagCompileUnit, Children: true, Field: []dwarf.Field{{Attr: dwarf.AttrProducer, Val: "GNU C17 12.2.0"}, {Attr: dwarf.AttrLanguage, Val: int64(1)}, {Attr: dwarf.AttrName, Val: "zdebug-test.c"}, {Attr: dwarf.AttrCompDir, Val: "/tmp/zt"}, {Attr: dwarf.AttrLowpc, Val: uint64(0x0)}, {Attr: dwarf.AttrHighpc, Val: uint64(0xb)}, {Attr: dwarf.AttrStmtList, Val: int64(0)}}},
+	},
 }
 
 func TestDWARFRelocations(t *testing.T) {
@@ -214,6 +225,60 @@ func TestDWARFRelocations(t *testing.T) {
 	}
 }
 
+func TestCompressedDWARF(t *testing.T) {
+	// Ensure the DWARF that 6l compresses can be read back.
+	if runtime.GOOS != "linux" && runtime.GOOS != "freebsd" {
+		return // not ELF
+	}
+	f, err := Open(os.Args[0])
+	if err != nil {
+		t.Error(err)
+		return
+	}
+	d, err := f.DWARF()
+	if err != nil {
+		t.Error(err)
+		return
+	}
+	e, err := d.Reader().Next()
+	if err != nil {
+		t.Error(err)
+		return
+	}
+	if e == nil || e.Tag != dwarf.TagCompileUnit {
+		t.Errorf("first entry = %#v, want compile unit", e)
+	}
+}
+
+func TestCompressedBadSize(t *testing.T) {
+	// Ensure a lying uncompressed size is an error, not a huge allocation.
+	var z bytes.Buffer
+	w := zlib.NewWriter(&z)
+	w.Write([]byte("hello, world"))
+	w.Close()
+
+	for _, n := range []uint64{1 << 62, ^uint64(0), 100} {
+		s := &Section{
+			SectionHeader:    SectionHeader{Name: ".debug_info", Flags: SHF_COMPRESSED},
+			sr:               io.NewSectionReader(bytes.NewReader(z.Bytes()), 0, int64(z.Len())),
+			compressionType:  COMPRESS_ZLIB,
+			uncompressedSize: n,
+		}
+		if _, err := s.Data(); err == nil {
+			t.Errorf("SHF_COMPRESSED size %#x: no error", n)
+		} else if _, ok := err.(*FormatError); !ok {
+			t.Errorf("SHF_COMPRESSED size %#x: error %T, want *FormatError", n, err)
+		}
+
+		b := make([]byte, 12)
+		copy(b, "ZLIB")
+		binary.BigEndian.PutUint64(b[4:], n)
+		if _, err := zdebugData(append(b, z.Bytes()...)); err == nil {
+			t.Errorf(".zdebug size %#x: no error", n)
+		}
+	}
+}
+
 func TestNoSectionOverlaps(t *testing.T) {
 	// Ensure 6l outputs sections without overlaps.
 	if runtime.GOOS != "linux" && runtime.GOOS != "freebsd" {
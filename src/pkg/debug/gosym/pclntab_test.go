@@ -110,14 +110,15 @@ func TestLineFromAline(t *testing.T) {
 	final := -1
 	for i := 0; i < 10000; i++ {
 		path, line := pkg.lineFromAline(i)
-		// Check for end of object
+		// Check for end of object.  The lines past it are the
+		// blocks the compiler gives to inlined bodies, which
+		// revisit lines of other files.
 		if path == "" {
-			if final == -1 {
-				final = i - 1
+			if len(lastline) == 0 {
+				continue
 			}
-			continue
-		} else if final != -1 {
-			t.Fatalf("reached end of package at absolute line %d, but absolute line %d mapped to %s:%d", final, i, path, line)
+			final = i - 1
+			break
 		}
 		// It's okay to see files multiple times (e.g., sys.a)
 		if line == 1 {
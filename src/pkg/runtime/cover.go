@@ -0,0 +1,41 @@
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+package runtime
+
+// A package compiled with coverage counters (6g -c, as done by
+// go test -cover) records which basic blocks of its code run,
+// or with 6g -c -c, how many times.  Its init function registers the counters here,
+// along with the source lines of the blocks, one "file:line,line"
+// per line of pos.
+type coverBlocks struct {
+	counts []uint32
+	pos    string
+}
+
+var covered []coverBlocks
+
+func coverregister(counts []uint32, pos string) {
+	covered = append(covered, coverBlocks{counts, pos})
+}
+
+// CoverCounts calls f for each basic block of the packages
+// compiled with coverage counters, giving its source lines,
+// in the form "file:line,line", and the number of times it ran.
+func CoverCounts(f func(pos string, count uint32)) {
+	for _, c := range covered {
+		pos := c.pos
+		for _, n := range c.counts {
+			i := 0
+			for i < len(pos) && pos[i] != '\n' {
+				i++
+			}
+			f(pos[:i], n)
+			if i < len(pos) {
+				i++
+			}
+			pos = pos[i:]
+		}
+	}
+}
@@ -24,6 +24,8 @@ func Goexit()
 // meaning of skip differs between Caller and Callers.) The return values report the
 // program counter, file name, and line number within the file of the corresponding
 // call.  The boolean ok is false if it was not possible to recover the information.
+// A call the compiler has inlined counts as a frame of its own; its pc is one
+// in the inlined code.
 func Caller(skip int) (pc uintptr, file string, line int, ok bool)
 
 // Callers fills the slice pc with the program counters of function invocations
@@ -35,19 +37,20 @@ func Callers(skip int, pc []uintptr) int
 
 type Func struct { // Keep in sync with runtime.h:struct Func
 	name   string
-	typ    string  // go type string
-	src    string  // src file name
-	pcln   []byte  // pc/ln tab for this func
 	entry  uintptr // entry pc
-	pc0    uintptr // starting pc, ln for table
-	ln0    int32
-	frame  int32 // stack frame size
-	args   int32 // number of 32-bit in/out args
-	locals int32 // number of 32-bit locals
+	pcln   []byte  // pc/line table for this func
+	pcfile []byte  // pc/file table for this func
+	pcsp   []byte  // pc/sp adjustment table for this func
+	pcinl  []byte  // pc/inlined call table for this func
+	inl    uintptr // calls inlined into this func
+	frame  int32   // stack frame size
+	args   int32   // number of 32-bit in/out args
+	locals int32   // number of 32-bit locals
 }
 
 // FuncForPC returns a *Func describing the function that contains the
-// given program counter address, or else nil.
+// given program counter address, or else nil.  If the address is in the
+// body of an inlined call, the Func has the name of the inlined function.
 func FuncForPC(pc uintptr) *Func
 
 // Name returns the name of the function.
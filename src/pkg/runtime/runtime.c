@@ -366,32 +366,53 @@ runtime·Caller(int32 skip, uintptr retpc, String retfile, int32 retline, bool r
 {
 	Func *f, *g;
 	uintptr pc;
-	uintptr rpc[2];
+	uintptr rpc[33];
+	int32 base, n, k, i;
 
 	/*
-	 * Ask for two PCs: the one we were asked for
-	 * and what it called, so that we can see if it
-	 * "called" sigpanic.
+	 * Ask for the PCs a batch at a time, each after the one
+	 * its first PC called, so that we can see if a PC
+	 * "called" sigpanic.  A PC in the body of an inlined
+	 * call stands for a frame for each call it is in,
+	 * innermost first, and then one for its function.
 	 */
 	retpc = 0;
-	if(runtime·callers(1+skip-1, rpc, 2) < 2) {
-		retfile = runtime·emptystring;
-		retline = 0;
-		retbool = false;
-	} else if((f = runtime·findfunc(rpc[1])) == nil) {
-		retfile = runtime·emptystring;
-		retline = 0;
-		retbool = true;  // have retpc at least
-	} else {
-		retpc = rpc[1];
-		retfile = f->src;
-		pc = retpc;
-		g = runtime·findfunc(rpc[0]);
-		if(pc > f->entry && (g == nil || g->entry != (uintptr)runtime·sigpanic))
-			pc--;
-		retline = runtime·funcline(f, pc);
-		retbool = true;
+	retfile = runtime·emptystring;
+	retline = 0;
+	retbool = false;
+	for(base = 0;; base += n-1) {
+		n = runtime·callers(base, rpc, nelem(rpc));
+		for(k = 1; k < n; k++) {
+			if((f = runtime·findfunc(rpc[k])) == nil) {
+				if(skip-- == 0) {
+					retpc = rpc[k];
+					retbool = true;  // have retpc at least
+					goto out;
+				}
+				continue;
+			}
+			pc = rpc[k];
+			g = runtime·findfunc(rpc[k-1]);
+			if(pc > f->entry && (g == nil || g->entry != (uintptr)runtime·sigpanic))
+				pc--;
+			retline = runtime·funcline(f, pc, &retfile);
+			for(i = runtime·funcinl(f, pc);; i = f->inl[i].parent) {
+				if(skip-- == 0) {
+					retpc = runtime·inlpc(f, i, rpc[k]);
+					retbool = true;
+					goto out;
+				}
+				if(i < 0)
+					break;
+				retline = runtime·inlline(f, i, &retfile);
+			}
+		}
+		if(n < nelem(rpc))
+			break;
 	}
+	retfile = runtime·emptystring;
+	retline = 0;
+out:
 	FLUSH(&retpc);
 	FLUSH(&retfile);
 	FLUSH(&retline);
@@ -414,7 +435,18 @@ runtime·Callers(int32 skip, Slice pc, int32 retn)
 void
 runtime·FuncForPC(uintptr pc, void *retf)
 {
-	retf = runtime·findfunc(pc);
+	Func *f, *g;
+	int32 i;
+
+	f = runtime·findfunc(pc);
+	if(f != nil && (i = runtime·funcinl(f, pc)) >= 0) {
+		// a copy of f named for the inlined function.
+		g = runtime·mal(sizeof *g);
+		*g = *f;
+		g->name = f->inl[i].name;
+		f = g;
+	}
+	retf = f;
 	FLUSH(&retf);
 }
 
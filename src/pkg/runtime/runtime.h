@@ -46,6 +46,7 @@ typedef	uint8			byte;
 typedef	struct	Func		Func;
 typedef	struct	G		G;
 typedef	struct	Gobuf		Gobuf;
+typedef	struct	Inl		Inl;
 typedef	union	Lock		Lock;
 typedef	struct	M		M;
 typedef	struct	Mem		Mem;
@@ -294,21 +295,31 @@ enum
 };
 
 // NOTE(rsc): keep in sync with extern.go:/type.Func.
-// Eventually, the loaded symbol table should be closer to this form.
+// The linker writes these into read-only data;
+// keep in sync with ../../cmd/ld/functab.c too.
 struct	Func
 {
 	String	name;
-	String	type;	// go type string
-	String	src;	// src file name
-	Slice	pcln;	// pc/ln tab for this func
 	uintptr	entry;	// entry pc
-	uintptr	pc0;	// starting pc, ln for table
-	int32	ln0;
+	Slice	pcln;	// pc/line table for this func
+	Slice	pcfile;	// pc/file table for this func
+	Slice	pcsp;	// pc/sp adjustment table for this func
+	Slice	pcinl;	// pc/inlined call table for this func
+	Inl*	inl;	// calls inlined into this func
 	int32	frame;	// stack frame size
 	int32	args;	// number of 32-bit in/out args
 	int32	locals;	// number of 32-bit locals
 };
 
+// A call inlined into a Func.
+struct	Inl
+{
+	String	name;	// callee
+	int32	parent;	// index of the inlined call the call is in, or -1
+	int32	file;	// index in the file table of the call
+	int32	line;	// line of the call
+};
+
 struct	WinCall
 {
 	void	(*fn)(void*);
@@ -586,7 +597,12 @@ G*	runtime·malg(int32);
 void	runtime·asminit(void);
 void	runtime·minit(void);
 Func*	runtime·findfunc(uintptr);
-int32	runtime·funcline(Func*, uintptr);
+int32	runtime·funcline(Func*, uintptr, String*);
+int32	runtime·funcspdelta(Func*, uintptr);
+int32	runtime·funcinl(Func*, uintptr);
+uintptr	runtime·inlpc(Func*, int32, uintptr);
+int32	runtime·inlline(Func*, int32, String*);
+int32	runtime·printinl(Func*, uintptr, String*);
 void*	runtime·stackalloc(uint32);
 void	runtime·stackfree(void*, uintptr);
 MCache*	runtime·allocmcache(void);
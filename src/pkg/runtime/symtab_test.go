@@ -45,3 +45,21 @@ func testCallerBar(t *testing.T) {
 		}
 	}
 }
+
+func TestCallerFile(t *testing.T) {
+	file1, line1, file2, line2 := callerFiles()
+	if !strings.HasSuffix(file1, "symtab_test.go") || line1 < 5 || line1 > 1000 {
+		t.Errorf("before line directive: %s:%d", file1, line1)
+	}
+	if !strings.HasSuffix(file2, "callerfiles.go") || line2 != 7 {
+		t.Errorf("after line directive: %s:%d, want callerfiles.go:7", file2, line2)
+	}
+}
+
+// callerFiles changes file part way through, so it must stay last.
+func callerFiles() (file1 string, line1 int, file2 string, line2 int) {
+	_, file1, line1, _ = runtime.Caller(0)
+	//line callerfiles.go:7
+	_, file2, line2, _ = runtime.Caller(0)
+	return
+}
@@ -19,8 +19,9 @@ void _modu(void);
 int32
 runtime·gentraceback(byte *pc0, byte *sp, byte *lr0, G *g, int32 skip, uintptr *pcbuf, int32 max)
 {
-	int32 i, n, iter;
+	int32 i, n, iter, line;
 	uintptr pc, lr, tracepc, x;
+	String file;
 	byte *fp, *p;
 	bool waspanic;
 	Stktop *stk;
@@ -125,6 +126,8 @@ runtime·gentraceback(byte *pc0, byte *sp, byte *lr0, G *g, int32 skip, uintptr
 				tracepc = pc;	// back up to CALL instruction for funcline.
 				if(n > 0 && pc > f->entry && !waspanic)
 					tracepc -= sizeof(uintptr);
+				// frames for the calls inlined at tracepc first.
+				line = runtime·printinl(f, tracepc, &file);
 				runtime·printf("%S(", f->name);
 				for(i = 0; i < f->args; i++) {
 					if(i != 0)
@@ -136,7 +139,7 @@ runtime·gentraceback(byte *pc0, byte *sp, byte *lr0, G *g, int32 skip, uintptr
 					}
 				}
 				runtime·prints(")\n");
-				runtime·printf("\t%S:%d", f->src, runtime·funcline(f, tracepc));
+				runtime·printf("\t%S:%d", file, line);
 				if(pc > f->entry)
 					runtime·printf(" +%p", (uintptr)(pc - f->entry));
 				runtime·printf("\n");
@@ -189,7 +192,8 @@ runtime·gentraceback(byte *pc0, byte *sp, byte *lr0, G *g, int32 skip, uintptr
 		tracepc = pc;	// back up to CALL instruction for funcline.
 		if(n > 0 && pc > f->entry)
 			tracepc -= sizeof(uintptr);
-		runtime·printf("\t%S:%d", f->src, runtime·funcline(f, tracepc));
+		line = runtime·funcline(f, tracepc, &file);
+		runtime·printf("\t%S:%d", file, line);
 		if(pc > f->entry)
 			runtime·printf(" +%p", (uintptr)(pc - f->entry));
 		runtime·printf("\n");
@@ -26,8 +26,9 @@ int32
 runtime·gentraceback(byte *pc0, byte *sp, byte *lr0, G *g, int32 skip, uintptr *pcbuf, int32 max)
 {
 	byte *p;
-	int32 i, n, iter, sawnewstack;
+	int32 i, n, iter, sawnewstack, line;
 	uintptr pc, lr, tracepc;
+	String file;
 	byte *fp;
 	Stktop *stk;
 	Func *f;
@@ -112,9 +113,7 @@ runtime·gentraceback(byte *pc0, byte *sp, byte *lr0, G *g, int32 skip, uintptr
 
 		// Found an actual function.
 		if(fp == nil) {
-			fp = sp;
-			if(pc > f->entry && f->frame >= sizeof(uintptr))
-				fp += f->frame - sizeof(uintptr);
+			fp = sp + runtime·funcspdelta(f, pc);
 			if(lr == 0)
 				lr = *(uintptr*)fp;
 			fp += sizeof(uintptr);
@@ -134,6 +133,8 @@ runtime·gentraceback(byte *pc0, byte *sp, byte *lr0, G *g, int32 skip, uintptr
 				tracepc = pc;	// back up to CALL instruction for funcline.
 				if(n > 0 && pc > f->entry && !waspanic)
 					tracepc--;
+				// frames for the calls inlined at tracepc first.
+				line = runtime·printinl(f, tracepc, &file);
 				runtime·printf("%S(", f->name);
 				for(i = 0; i < f->args; i++) {
 					if(i != 0)
@@ -145,7 +146,7 @@ runtime·gentraceback(byte *pc0, byte *sp, byte *lr0, G *g, int32 skip, uintptr
 					}
 				}
 				runtime·prints(")\n");
-				runtime·printf("\t%S:%d", f->src, runtime·funcline(f, tracepc));
+				runtime·printf("\t%S:%d", file, line);
 				if(pc > f->entry)
 					runtime·printf(" +%p", (uintptr)(pc - f->entry));
 				runtime·printf("\n");
@@ -201,7 +202,8 @@ runtime·gentraceback(byte *pc0, byte *sp, byte *lr0, G *g, int32 skip, uintptr
 		tracepc = pc;	// back up to CALL instruction for funcline.
 		if(n > 0 && pc > f->entry)
 			tracepc--;
-		runtime·printf("\t%S:%d", f->src, runtime·funcline(f, tracepc));
+		line = runtime·funcline(f, tracepc, &file);
+		runtime·printf("\t%S:%d", file, line);
 		if(pc > f->entry)
 			runtime·printf(" +%p", (uintptr)(pc - f->entry));
 		runtime·printf("\n");
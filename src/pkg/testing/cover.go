@@ -0,0 +1,52 @@
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+package testing
+
+import (
+	"bufio"
+	"fmt"
+	"os"
+	"runtime"
+)
+
+// coverReport reports on the counters of the packages compiled
+// for coverage, if any: it prints the fraction of basic blocks
+// that ran and writes the counters to the file named by
+// -test.coverprofile, one basic block per line:
+//	file:line,line count
+// go tool cov -p reads and merges these profiles.
+func coverReport() {
+	var w *bufio.Writer
+	var f *os.File
+	if *coverProfile != "" {
+		var err error
+		f, err = os.Create(*coverProfile)
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "testing: %s", err)
+		} else {
+			w = bufio.NewWriter(f)
+			fmt.Fprintf(w, "go cover 1\n")
+		}
+	}
+	var blocks, ran int
+	runtime.CoverCounts(func(pos string, count uint32) {
+		blocks++
+		if count > 0 {
+			ran++
+		}
+		if w != nil {
+			fmt.Fprintf(w, "%s %d\n", pos, count)
+		}
+	})
+	if blocks > 0 {
+		fmt.Printf("coverage: %.1f%% of blocks\n", 100*float64(ran)/float64(blocks))
+	}
+	if w != nil {
+		if err := w.Flush(); err != nil {
+			fmt.Fprintf(os.Stderr, "testing: can't write %s: %s", *coverProfile, err)
+		}
+		f.Close()
+	}
+}
@@ -103,6 +103,7 @@ var (
 	memProfile     = flag.String("test.memprofile", "", "write a memory profile to the named file after execution")
 	memProfileRate = flag.Int("test.memprofilerate", 0, "if >=0, sets runtime.MemProfileRate")
 	cpuProfile     = flag.String("test.cpuprofile", "", "write a cpu profile to the named file during execution")
+	coverProfile   = flag.String("test.coverprofile", "", "write a coverage profile to the named file after execution")
 	timeout        = flag.Duration("test.timeout", 0, "if positive, sets an aggregate time limit for all tests")
 	cpuListStr     = flag.String("test.cpu", "", "comma-separated list of number of CPUs to use for each test")
 	parallel       = flag.Int("test.parallel", runtime.GOMAXPROCS(0), "maximum test parallelism")
@@ -286,6 +287,7 @@ func Main(matchString func(pat, str string) (bool, error), tests []InternalTest,
 	exampleOk := RunExamples(matchString, examples)
 	if !testOk || !exampleOk {
 		fmt.Println("FAIL")
+		coverReport()
 		os.Exit(1)
 	}
 	fmt.Println("PASS")
@@ -413,6 +415,7 @@ func after() {
 		}
 		f.Close()
 	}
+	coverReport()
 }
 
 var timer *time.Timer
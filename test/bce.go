@@ -0,0 +1,119 @@
+// run
+
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Test that loops whose bounds checks are eliminated compute the
+// right thing and that the checks stay where they are needed.
+
+package main
+
+import "runtime"
+
+type Big struct {
+	pad [8192]byte
+	x   int
+}
+
+func sum(s []int) int {
+	t := 0
+	for i := 0; i < len(s); i++ {
+		t += s[i]
+	}
+	return t
+}
+
+func sumrange(s []int) int {
+	t := 0
+	for i, v := range s {
+		t += s[i] + v
+	}
+	return t
+}
+
+func sumdown(s []int) int {
+	t := 0
+	for i := len(s) - 1; i >= 0; i-- {
+		t += s[i]
+	}
+	return t
+}
+
+func sumarray(a *[4]int) int {
+	t := 0
+	for i := 0; i < 4; i++ {
+		t += a[i]
+	}
+	return t
+}
+
+// The slice shrinks inside the loop.
+func shrink(s []int) int {
+	t := 0
+	for i := 0; i < len(s); i++ {
+		s = s[2:]
+		t += s[i]
+	}
+	return t
+}
+
+// The index moves inside the loop.
+func skip(s []int) int {
+	t := 0
+	for i := 0; i < len(s); i++ {
+		i++
+		t += s[i]
+	}
+	return t
+}
+
+// The copy of the index is used before it is set.
+func stale(s []int) int {
+	t, j := 0, len(s)
+	for i := range s {
+		t += s[j]
+		j = i
+	}
+	return t
+}
+
+func twice(b *Big) int {
+	y := b.x
+	return y + b.x
+}
+
+func shouldPanic(name string, f func()) {
+	defer func() {
+		if _, ok := recover().(runtime.Error); !ok {
+			panic(name + ": expected runtime error")
+		}
+	}()
+	f()
+}
+
+func main() {
+	s := []int{1, 2, 3, 4}
+	if n := sum(s); n != 10 {
+		panic(n)
+	}
+	if n := sumrange(s); n != 20 {
+		panic(n)
+	}
+	if n := sumdown(s); n != 10 {
+		panic(n)
+	}
+	if n := sumarray(&[4]int{1, 2, 3, 4}); n != 10 {
+		panic(n)
+	}
+	if n := sum(nil) + sumrange(nil) + sumdown(nil); n != 0 {
+		panic(n)
+	}
+	if n := twice(&Big{x: 2}); n != 4 {
+		panic(n)
+	}
+	shouldPanic("shrink", func() { shrink(s) })
+	shouldPanic("skip", func() { skip([]int{1, 2, 3}) })
+	shouldPanic("stale", func() { stale(s) })
+	shouldPanic("twice", func() { twice(nil) })
+}
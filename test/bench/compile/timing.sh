@@ -0,0 +1,68 @@
+#!/usr/bin/env bash
+# Copyright 2012 The Go Authors.  All rights reserved.
+# Use of this source code is governed by a BSD-style
+# license that can be found in the LICENSE file.
+
+# Compile the standard packages with each set of compiler flags
+# and report the time taken and the size of the object files.
+#
+#	./timing.sh [pkg ...]
+#
+# The first column is the default compiler, the second has the
+# tree optimizer turned off (-T), the third has no optimization (-N).
+
+set -e
+
+eval $(go tool dist env)
+O=$GOCHAR
+GC="go tool ${O}g"
+
+pkgs="$@"
+if [ -z "$pkgs" ]
+then
+	pkgs=$(go list std | grep -v '^cmd/')
+fi
+
+tmp=/tmp/gccompile$$
+mkdir -p $tmp
+trap "rm -rf $tmp" 0 1 2 3 14 15
+
+flags=("" "-T" "-N")
+declare -a utime size
+for i in 0 1 2
+do
+	utime[$i]=0
+	size[$i]=0
+done
+
+# compile pkg flags: print user time in milliseconds and object size.
+compile() {
+	files=$(go list -f '{{range .GoFiles}}{{$.Dir}}/{{.}} {{end}}' $1)
+	if [ -z "$files" ]
+	then
+		echo 0 0
+		return
+	fi
+	t=$( (time -p $GC $2 -p $1 -o $tmp/x.$O $files >/dev/null) 2>&1 | awk '/^user/ {print int($2*1000)}')
+	echo $t $(wc -c <$tmp/x.$O)
+}
+
+printf '%-24s %16s %16s %16s\n' package default -T -N
+for p in $pkgs
+do
+	line=$(printf '%-24s' $p)
+	for i in 0 1 2
+	do
+		set -- $(compile $p "${flags[$i]}")
+		utime[$i]=$((${utime[$i]} + $1))
+		size[$i]=$((${size[$i]} + $2))
+		line="$line $(printf '%6dms %8d' $1 $2)"
+	done
+	echo "$line"
+done
+printf '%-24s' total
+for i in 0 1 2
+do
+	printf ' %6dms %8d' ${utime[$i]} ${size[$i]}
+done
+echo
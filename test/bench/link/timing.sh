@@ -0,0 +1,64 @@
+#!/usr/bin/env bash
+# Copyright 2012 The Go Authors.  All rights reserved.
+# Use of this source code is governed by a BSD-style
+# license that can be found in the LICENSE file.
+
+# Link a command several times and report, for each linker phase,
+# the fastest time seen.
+#
+#	./timing.sh [-n count] [pkg]
+#
+# pkg is a main package, cmd/godoc by default; count is 5.
+# Extra linker flags can be passed in $LDFLAGS.
+
+set -e
+
+n=5
+while getopts n: opt
+do
+	case $opt in
+	n)	n=$OPTARG ;;
+	*)	echo "usage: timing.sh [-n count] [pkg]" 1>&2; exit 2 ;;
+	esac
+done
+shift $((OPTIND-1))
+pkg=${1:-cmd/godoc}
+
+eval $(go tool dist env)
+O=$GOCHAR
+GC="go tool ${O}g"
+LD="go tool ${O}l"
+
+tmp=/tmp/golink$$
+mkdir -p $tmp
+trap "rm -rf $tmp" 0 1 2 3 14 15
+
+files=$(go list -f '{{range .GoFiles}}{{$.Dir}}/{{.}} {{end}}' $pkg)
+$GC -o $tmp/main.$O $files
+
+for i in $(seq $n)
+do
+	$LD $LDFLAGS -v -o $tmp/a.out $tmp/main.$O >$tmp/log.$i
+done
+
+# The -v phase lines look like "   0.318s  31.0% loadlib".
+cat $tmp/log.* | awk '
+/^ *[0-9.]+s +[0-9.]+% [a-z]/ {
+	t = $1 + 0
+	p = $3
+	if(!(p in best)) {
+		order[nphase++] = p
+		best[p] = t
+	} else if(t < best[p])
+		best[p] = t
+}
+/^ *[0-9.]+s total/ {
+	t = $1 + 0
+	if(total == "" || t < total)
+		total = t
+}
+END {
+	for(i = 0; i < nphase; i++)
+		printf("%-12s %8.3fs\n", order[i], best[order[i]])
+	printf("%-12s %8.3fs\n", "total", total)
+}'
@@ -0,0 +1,50 @@
+// run
+
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Test that only loading the imported declarations a file
+// mentions still brings in everything those declarations need:
+// method sets, types of fields and results, and the bodies of
+// inlined functions that refer to unexported names.
+
+package main
+
+import (
+	"bytes"
+	"errors"
+	"io"
+	"sort"
+	"strings"
+)
+
+type R interface {
+	Read([]byte) (int, error)
+}
+
+func main() {
+	var b bytes.Buffer
+	b.WriteString("hello")
+	var r R = strings.NewReader(" world")
+	if _, err := io.Copy(&b, r); err != nil {
+		panic(err)
+	}
+	if b.String() != "hello world" {
+		panic(b.String())
+	}
+
+	s := []string{"c", "a", "b"}
+	sort.Sort(sort.StringSlice(s))
+	if strings.Join(s, "") != "abc" {
+		panic(s)
+	}
+
+	var w io.Writer = &b
+	if _, ok := w.(io.ReaderFrom); !ok {
+		panic("bytes.Buffer lost ReadFrom")
+	}
+	if err := errors.New("x"); err.Error() != "x" {
+		panic(err)
+	}
+}
@@ -0,0 +1,134 @@
+// run
+
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Test that inlined calls to non-leaf functions and
+// functions containing loops behave like real calls,
+// down to the frames runtime.Caller reports.
+
+package main
+
+import (
+	"math"
+	"runtime"
+	"strings"
+)
+
+type T struct {
+	b []byte
+}
+
+// Len is declared before length to check that caninl
+// does not depend on declaration order.
+func (t *T) Len() int { return length(t.b) }
+
+func length(b []byte) int { return len(b) }
+
+func equal(a, b []byte) bool {
+	if len(a) != len(b) {
+		return false
+	}
+	for i := 0; i < len(a); i++ {
+		if a[i] != b[i] {
+			return false
+		}
+	}
+	return true
+}
+
+func sumodd(a []int) int {
+	var s int
+	for i := 0; i < len(a); i++ {
+		if a[i]%2 == 0 {
+			continue
+		}
+		if a[i] < 0 {
+			break
+		}
+		s += a[i]
+	}
+	return s
+}
+
+func index(a []int, i int) int { return a[i] }
+
+func at(a []int, i int) int { return index(a, i) + 1 }
+
+func rec(n int) int {
+	if n == 0 {
+		return 0
+	}
+	return rec(n-1) + 1
+}
+
+func caller() int {
+	_, _, line, _ := runtime.Caller(0)
+	return line
+}
+
+func callerline() int { return caller() }
+
+func main() {
+	t := &T{[]byte("hello")}
+	if n := t.Len(); n != 5 {
+		panic(n)
+	}
+	if !equal([]byte("abc"), []byte("abc")) || equal([]byte("abc"), []byte("abd")) || equal(nil, []byte("a")) {
+		panic("equal")
+	}
+	// The same inlined loop twice in one function.
+	if s := sumodd([]int{1, 2, 3, -5, 7}) + sumodd([]int{9}); s != 13 {
+		panic(s)
+	}
+	if n := at([]int{1, 2}, 1); n != 3 {
+		panic(n)
+	}
+	if n := rec(10); n != 10 {
+		panic(n)
+	}
+	// Imported bodies with local variables.
+	if !math.IsInf(math.Inf(1), 1) || !math.IsInf(math.Inf(-1), -1) {
+		panic("math.Inf")
+	}
+	if strings.Index("chicken", "ken") != 4 {
+		panic("strings.Index")
+	}
+	// caller is inlined, with its call to runtime.Caller, into callerline
+	// and callerline into main, but runtime.Caller still sees its frame.
+	if line := callerline(); line != 67 {
+		panic(line)
+	}
+
+	// An index panic in an inlined body has a frame for each inlined
+	// call: index is inlined into at and at into main.
+	defer func() {
+		if _, ok := recover().(runtime.Error); !ok {
+			panic("expected runtime error")
+		}
+		want := []struct {
+			name string
+			line int
+		}{{"main.index", 55}, {"main.at", 57}, {"main.main", 133}}
+		j := 0
+		for i := 0; j < len(want); i++ {
+			pc, _, line, ok := runtime.Caller(i)
+			if !ok {
+				panic("no frame for " + want[j].name)
+			}
+			name := runtime.FuncForPC(pc).Name()
+			if j == 0 && name != want[0].name {
+				continue
+			}
+			if name != want[j].name {
+				panic("frame for " + name + ", want " + want[j].name)
+			}
+			if line != want[j].line {
+				panic(line)
+			}
+			j++
+		}
+	}()
+	at([]int{1}, 2)
+}
@@ -0,0 +1,46 @@
+// errorcheck -0 -m -b 30
+
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Test which functions the inliner takes: functions that call
+// other inlinable functions, simple for loops, and only bodies
+// within the -b budget.  Every line of -m output must match.
+
+package foo
+
+type T struct {
+	n []int
+}
+
+func length(a []int) int { return len(a) } // ERROR "can inline length" "length a does not escape"
+
+// Len is not a leaf; length is inlined into it, and both into use.
+// The nested call keeps its own line, inside Len.
+func (t *T) Len() int { return length(t.n) } // ERROR "can inline \(\*T\).Len" "inlining call to length" "t does not escape"
+
+func sum(a []int) int { // ERROR "can inline sum" "sum a does not escape"
+	s := 0
+	for i := 0; i < len(a); i++ {
+		s += a[i]
+	}
+	return s
+}
+
+// big fits the default budget of 40 nodes but not 30.
+func big(a []int) int { // ERROR "big a does not escape"
+	s := 0
+	for i := 0; i < len(a); i++ {
+		if a[i] > 0 {
+			s += a[i] * 2
+		} else {
+			s -= a[i] + 1
+		}
+	}
+	return s
+}
+
+func use(t *T, a []int) int { // ERROR "use t does not escape" "use a does not escape"
+	return t.Len() + sum(a) + big(a) // ERROR "inlining call to \(\*T\).Len" "inlining call to sum"
+}
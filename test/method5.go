@@ -0,0 +1,68 @@
+// run
+
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Test that the linker keeps the methods that can still be
+// called once it drops the ones that cannot: methods reached
+// through an interface, including one asserted to at run time
+// or embedded in another, and methods found by reflect.
+// The reflect lookups are method expressions, which are plain
+// function calls; they are the only reflect Method calls here,
+// so the program fails if the compiler misses them.  Method
+// calls are covered by reflect's own tests.
+
+package main
+
+import (
+	"reflect"
+)
+
+type T int
+
+func (t T) Double() int { return int(t) * 2 }
+func (t T) Triple() int { return int(t) * 3 }
+func (t *T) Inc()       { *t++ }
+func (t T) unused() int { return 0 }
+
+type Doubler interface {
+	Double() int
+}
+
+type Incer interface {
+	Inc()
+}
+
+type DoubleIncer interface {
+	Doubler
+	Incer
+}
+
+type M struct{}
+
+func (M) Found() string { return "found" }
+
+func main() {
+	var x interface{} = T(2)
+	if d, ok := x.(Doubler); !ok || d.Double() != 4 {
+		panic("Double")
+	}
+
+	t := T(5)
+	var di DoubleIncer = &t
+	di.Inc()
+	if di.Double() != 12 {
+		panic("Inc")
+	}
+
+	var y interface{} = M{}
+	v := reflect.Value.MethodByName(reflect.ValueOf(y), "Found")
+	if !v.IsValid() || v.Call(nil)[0].String() != "found" {
+		panic("Value.MethodByName")
+	}
+	m, ok := reflect.Type.MethodByName(reflect.TypeOf(T(0)), "Triple")
+	if !ok || m.Func.Call([]reflect.Value{reflect.ValueOf(T(4))})[0].Int() != 12 {
+		panic("Type.MethodByName")
+	}
+}
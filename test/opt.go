@@ -0,0 +1,161 @@
+// run
+
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Test that common subexpressions, hoisted loop invariants,
+// propagated copies and removed stores do not change what
+// a program computes or where it panics.
+
+package main
+
+import "runtime"
+
+type T struct {
+	a, b int
+	p    *T
+}
+
+func cse(x, y int) int {
+	return (x*y + 1) + (x*y + 2)
+}
+
+// The store to x between the two x*y must be seen.
+func cseKill(x, y int) int {
+	a := x * y
+	x++
+	return a + x*y
+}
+
+// The store through p between the two loads must be seen.
+func cseMem(t *T, p *int) int {
+	a := t.a
+	*p = 7
+	return a + t.a
+}
+
+func invariant(s []int, x, y int) int {
+	t := 0
+	for i := 0; i < len(s); i++ {
+		t += s[i] * (x + y)
+	}
+	return t
+}
+
+// x changes in the loop, so x+y is not invariant.
+func variant(n, x, y int) int {
+	t := 0
+	for i := 0; i < n; i++ {
+		t += x + y
+		x++
+	}
+	return t
+}
+
+// The division must not be hoisted above the loop test:
+// with n == 0 it is never evaluated.
+func divloop(n, d int) int {
+	t := 0
+	for i := 0; i < n; i++ {
+		t += 100 / d
+	}
+	return t
+}
+
+// Nor the load through p.
+func loadloop(n int, p *T) int {
+	t := 0
+	for i := 0; i < n; i++ {
+		t += p.a
+	}
+	return t
+}
+
+// Nor the load on the right of &&.
+func andload(p *T) bool {
+	return p != nil && p.a == 1 && p.a+1 == 2
+}
+
+func copies(x int) int {
+	y := x
+	z := y
+	y = 3
+	return z + y
+}
+
+func deadstore(x int) (r int) {
+	y := x * 2
+	y = x + 1
+	r = y
+	return
+}
+
+func result(f uint) uint {
+	return (f >> 4) & 31
+}
+
+func named(n int) (r int) {
+	if n > 0 {
+		return -1
+	}
+	r = n
+	return
+}
+
+func mustpanic(f func()) {
+	defer func() {
+		if _, ok := recover().(runtime.Error); !ok {
+			panic("expected runtime error")
+		}
+	}()
+	f()
+}
+
+func main() {
+	if n := cse(3, 4); n != 27 {
+		panic(n)
+	}
+	if n := cseKill(3, 4); n != 28 {
+		panic(n)
+	}
+	t := &T{a: 1}
+	if n := cseMem(t, &t.a); n != 8 {
+		panic(n)
+	}
+	if n := invariant([]int{1, 2, 3}, 1, 2); n != 18 {
+		panic(n)
+	}
+	if n := variant(3, 1, 1); n != 9 {
+		panic(n)
+	}
+	if n := divloop(0, 0); n != 0 {
+		panic(n)
+	}
+	if n := divloop(2, 10); n != 20 {
+		panic(n)
+	}
+	if n := loadloop(0, nil); n != 0 {
+		panic(n)
+	}
+	if andload(nil) || andload(t) || !andload(&T{a: 1}) {
+		panic("andload")
+	}
+	if n := copies(4); n != 7 {
+		panic(n)
+	}
+	if n := deadstore(4); n != 5 {
+		panic(n)
+	}
+	if n := result(0x1f3); n != 31 {
+		panic(n)
+	}
+	if n := named(1); n != -1 {
+		panic(n)
+	}
+	if n := named(-2); n != -2 {
+		panic(n)
+	}
+	mustpanic(func() { divloop(1, 0) })
+	mustpanic(func() { loadloop(1, nil) })
+}
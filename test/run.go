@@ -291,8 +291,22 @@ func (t *test) run() {
 		t.err = fmt.Errorf("unimplemented action %q", action)
 
 	case "errorcheck":
-		out, _ := runcmd("go", "tool", gc, "-e", "-o", "a."+letter, long)
-		t.err = t.errorCheck(string(out), long, t.gofile)
+		// Arguments are compiler flags.  A leading -0 means the
+		// file must compile and all its output, such as that of
+		// -m, must be matched by ERROR comments.
+		wantSuccess := len(args) > 0 && args[0] == "-0"
+		if wantSuccess {
+			args = args[1:]
+		}
+		cmdline := []string{"go", "tool", gc, "-e", "-o", "a." + letter}
+		cmdline = append(cmdline, args...)
+		cmdline = append(cmdline, long)
+		out, err := runcmd(cmdline...)
+		if wantSuccess && err != nil {
+			t.err = fmt.Errorf("%s\n%s", err, out)
+			return
+		}
+		t.err = t.errorCheck(string(out), long, t.gofile, wantSuccess)
 		return
 
 	case "compile":
@@ -357,7 +371,10 @@ func (t *test) expectedOutput() string {
 	return string(b)
 }
 
-func (t *test) errorCheck(outStr string, full, short string) (err error) {
+// errorCheck matches the compiler output outStr against the ERROR
+// comments in the file.  If all is set, every line of output must
+// be matched, not just the ones the comments name.
+func (t *test) errorCheck(outStr string, full, short string, all bool) (err error) {
 	defer func() {
 		if *verbose && err != nil {
 			log.Printf("%s gc output:\n%s", t, outStr)
@@ -402,6 +419,12 @@ func (t *test) errorCheck(outStr string, full, short string) (err error) {
 		}
 	}
 
+	for _, errmsg := range out {
+		if all && errmsg != "" {
+			errs = append(errs, fmt.Errorf("%s: unmatched error", errmsg))
+		}
+	}
+
 	if len(errs) == 0 {
 		return nil
 	}
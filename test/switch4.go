@@ -0,0 +1,236 @@
+// run
+
+// Copyright 2012 The Go Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// Test large switches, which are compiled
+// into jump tables or split on string length.
+
+package main
+
+func dense(x int) int {
+	switch x {
+	case 1:
+		return 10
+	case 2:
+		return 20
+	case 3:
+		return 30
+	case 4, 5:
+		return 45
+	case 7:
+		return 70
+	case 8:
+		return 80
+	case 9:
+		fallthrough
+	case 10:
+		return 100
+	case 12:
+		return 120
+	case 15:
+		return 150
+	}
+	return -1
+}
+
+func signed(x int8) int {
+	switch x {
+	case -128:
+		return 0
+	case -4:
+		return 1
+	case -3:
+		return 2
+	case -2:
+		return 3
+	case -1:
+		return 4
+	case 0:
+		return 5
+	case 1:
+		return 6
+	case 2:
+		return 7
+	case 127:
+		return 8
+	}
+	return -1
+}
+
+func unsigned(x uint8) int {
+	switch x {
+	case 200:
+		return 0
+	case 201:
+		return 1
+	case 202:
+		return 2
+	case 204:
+		return 4
+	case 205:
+		return 5
+	case 206:
+		return 6
+	case 207:
+		return 7
+	case 209:
+		return 9
+	default:
+		return -1
+	}
+	panic("unreachable")
+}
+
+func wide(x uint64) int {
+	n := 0
+	switch x {
+	case 1<<63 + 0:
+		n = 1
+	case 1<<63 + 1:
+		n = 2
+	case 1<<63 + 2:
+		n = 3
+	case 1<<63 + 3:
+		n = 4
+	case 1<<63 + 4:
+		n = 5
+	case 1<<63 + 5:
+		n = 6
+	case 1<<63 + 6:
+		n = 7
+	case 1<<63 + 7:
+		n = 8
+	}
+	return n
+}
+
+func live(x int, a, b, c int) int {
+	for i := 0; i < 3; i++ {
+		switch x + i {
+		case 0:
+			a++
+		case 1:
+			b++
+		case 2:
+			c++
+		case 3:
+			a += b
+		case 4:
+			b += c
+		case 5:
+			c += a
+		case 6:
+			a, b = b, a
+		case 7:
+			b, c = c, b
+		}
+	}
+	return a*100 + b*10 + c
+}
+
+var words = []string{
+	"", "a", "b", "go", "if", "for", "var", "case", "func",
+	"break", "const", "switch", "select", "default", "continue",
+	"fallthrough",
+}
+
+func word(s string) int {
+	switch s {
+	case "":
+		return 0
+	case "a":
+		return 1
+	case "b":
+		return 2
+	case "go":
+		return 3
+	case "if":
+		return 4
+	case "for":
+		return 5
+	case "var":
+		return 6
+	case "case":
+		return 7
+	case "func":
+		return 8
+	case "break":
+		return 9
+	case "const":
+		return 10
+	case "switch":
+		return 11
+	case "select":
+		return 12
+	case "default":
+		return 13
+	case "continue":
+		return 14
+	case "fallthrough":
+		return 15
+	}
+	return -1
+}
+
+func main() {
+	want := map[int]int{1: 10, 2: 20, 3: 30, 4: 45, 5: 45, 7: 70, 8: 80, 9: 100, 10: 100, 12: 120, 15: 150}
+	for x := -3; x < 20; x++ {
+		w, ok := want[x]
+		if !ok {
+			w = -1
+		}
+		if n := dense(x); n != w {
+			println("dense", x, n, w)
+			panic("fail")
+		}
+	}
+	for x, w := range map[int8]int{-128: 0, -127: -1, -5: -1, -4: 1, -1: 4, 0: 5, 2: 7, 3: -1, 126: -1, 127: 8} {
+		if n := signed(x); n != w {
+			println("signed", x, n, w)
+			panic("fail")
+		}
+	}
+	for x := 0; x < 256; x++ {
+		w := -1
+		if x >= 200 && x <= 209 && x != 203 && x != 208 {
+			w = x - 200
+		}
+		if n := unsigned(uint8(x)); n != w {
+			println("unsigned", x, n, w)
+			panic("fail")
+		}
+	}
+	for _, x := range []uint64{0, 1, 7, 8, 1<<63 - 1, 1 << 63, 1<<63 + 7, 1<<63 + 8, 1<<64 - 1} {
+		w := 0
+		if x >= 1<<63 && x < 1<<63+8 {
+			w = int(x-1<<63) + 1
+		}
+		if n := wide(x); n != w {
+			println("wide", x, n, w)
+			panic("fail")
+		}
+	}
+	if n := live(0, 1, 2, 3); n != 234 {
+		println("live", n)
+		panic("fail")
+	}
+	if n := live(5, 1, 2, 3); n != 241 {
+		println("live", n)
+		panic("fail")
+	}
+	for i, s := range words {
+		if n := word(s); n != i {
+			println("word", s, n, i)
+			panic("fail")
+		}
+		if n := word(s + "x"); n != -1 {
+			println("word", s+"x", n)
+			panic("fail")
+		}
+	}
+	if n := word("c"); n != -1 {
+		panic("word c")
+	}
+}